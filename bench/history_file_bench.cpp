@@ -0,0 +1,163 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Append throughput and open time of the service's history file.
+ *
+ * Appends N samples (one state transition per 100000 records, each of which syncs), then re-opens
+ * the file the way the service does after a restart. On Linux the file is evicted from the page
+ * cache first, so the open is cold. Finally the last record is torn and the file is opened again:
+ * recovery must drop exactly that record (exit code 1 otherwise).
+ *
+ * Usage: history_file_bench [records] [path]     (default: 10000000 records, ~560 MB, in the temp dir)
+ */
+
+#include "history_file.h"
+#include "ups_clock.h"
+#include <QDir>
+#include <QFile>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void evictFromPageCache(const QString& path)
+{
+#ifdef Q_OS_LINUX
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (fd >= 0) {
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#else
+    Q_UNUSED(path);
+    std::printf("(page cache not evicted on this platform: the open below is warm)\n");
+#endif
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const qint64 recordCount = argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 10000000;
+    const QString path = argc > 2 ? QString::fromLocal8Bit(argv[2]) : QDir::tempPath() + "/history_file_bench.lhf";
+    QFile::remove(path);
+
+    // 1. Append
+    UpsData sample;
+    sample.state = UpsMonitor::UpsState::OnlineFull;
+    sample.statusCode = UpsMonitor::StatusCode::OnlineFull;
+    sample.setOutputVoltage(230.0);
+    sample.setBatteryVoltage(27.2);
+    sample.setBatteryLevel(100.0);
+    sample.runtimeRemainingSeconds = 1800;
+    std::mt19937 rng(7);
+    const qint64 startNs = UpsClock::nowNs();
+    {
+        HistoryFile file;
+        if (!file.open(path)) {
+            std::fprintf(stderr, "Cannot create %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+            return 1;
+        }
+        const auto start = std::chrono::steady_clock::now();
+        for (qint64 i = 0; i < recordCount; ++i) {
+            sample.timestampNs = startNs + i * 1000000000LL;
+            sample.setInputVoltage(220.0 + rng() % 200 / 10.0);
+            sample.setLoadPercentage(static_cast<int>(20 + rng() % 10));
+            if (i % 100000 == 99999) {
+                sample.state = sample.state == UpsMonitor::UpsState::OnlineFull ? UpsMonitor::UpsState::OnBattery
+                                                                            : UpsMonitor::UpsState::OnlineFull;
+            }
+            file.append(i % 4 == 0 ? QStringLiteral("rack2") : QStringLiteral("primary"), sample);
+        }
+        const double appendSeconds = secondsSince(start);
+        const auto syncStart = std::chrono::steady_clock::now();
+        file.sync();
+        const double syncSeconds = secondsSince(syncStart);
+        std::printf("Append: %lld records in %.2f s = %.1f M records/s (%.0f ns/record), final sync %.2f s\n",
+                    (long long)recordCount, appendSeconds, recordCount / appendSeconds / 1e6,
+                    appendSeconds * 1e9 / recordCount, syncSeconds);
+    }
+    std::printf("File: %.1f MB\n", QFile(path).size() / 1e6);
+
+    // 2. Open after a restart
+    evictFromPageCache(path);
+    {
+        HistoryFile file;
+        const auto start = std::chrono::steady_clock::now();
+        if (!file.open(path)) {
+            std::fprintf(stderr, "Cannot open %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+            return 1;
+        }
+        const double openSeconds = secondsSince(start);
+        std::printf("Open: %lld records in %.3f ms\n", (long long)file.count(), openSeconds * 1e3);
+        if (file.count() != recordCount) {
+            std::fprintf(stderr, "FAIL: expected %lld records\n", (long long)recordCount);
+            return 1;
+        }
+
+        // Random range lookups, as a history query would do them
+        const qint64 firstMs = file.at(0).wallMs;
+        const qint64 spanMs = file.at(file.count() - 1).wallMs - firstMs + 1;
+        const auto lookupStart = std::chrono::steady_clock::now();
+        qint64 checksum = 0;
+        for (int i = 0; i < 100000; ++i) {
+            checksum += file.lowerBound(firstMs + static_cast<qint64>(rng() % spanMs));
+        }
+        std::printf("Lookup: %.0f ns per lowerBound() (checksum %lld)\n", secondsSince(lookupStart) * 1e9 / 100000,
+                    (long long)checksum);
+    }
+
+    // 3. Tear the last record, as a power cut in the middle of a write would
+    {
+        QFile raw(path);
+        if (!raw.open(QIODevice::ReadWrite)
+            || !raw.seek(HistoryFileFormat::HEADER_SIZE + (recordCount - 1) * qint64(sizeof(HistoryFile::Record)) + 20)) {
+            std::fprintf(stderr, "Cannot modify %s\n", qPrintable(path));
+            return 1;
+        }
+        raw.write("\xff\xff\xff\xff", 4);
+    }
+    {
+        HistoryFile file;
+        const auto start = std::chrono::steady_clock::now();
+        file.open(path);
+        std::printf("Recovery: %lld records kept, %lld dropped, in %.3f ms\n", (long long)file.count(),
+                    (long long)file.recoveredTail(), secondsSince(start) * 1e3);
+        if (file.count() != recordCount - 1 || file.recoveredTail() != 1) {
+            std::fprintf(stderr, "FAIL: expected exactly the torn record to be dropped\n");
+            return 1;
+        }
+    }
+
+    QFile::remove(path);
+    return 0;
+}
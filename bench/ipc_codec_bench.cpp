@@ -0,0 +1,178 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Report encode/decode cost of the QDataStream codec (ipc_constants.h) and the binary wire format (ipc_wire.h).
+ *
+ * Encodes N reports the way UpsIpcServer sends them (QDataStream: operator<< into a payload, then the
+ * length-prefixed frame; binary: IpcWire::Encoder), then decodes the stream the way the tray
+ * application reads it. Every 1000th report carries a new error message, so the binary format sends
+ * its strings now and then, like in the service. Each decoded report is compared with the original;
+ * the exit code is 1 on any mismatch.
+ *
+ * Usage: ipc_codec_bench [reports]     (default: 1000000)
+ */
+
+#include "ipc_constants.h"
+#include "ipc_wire.h"
+#include <QByteArray>
+#include <QDataStream>
+#include <QtEndian>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+UpsReport makeReport(size_t i)
+{
+    UpsReport report;
+    report.deviceId = "primary";
+    report.data.timestampNs = qint64(1000000000) + qint64(i) * 1000000;
+    report.data.inputMillivolts = 229000 + int(i % 2000);
+    report.data.outputMillivolts = 230000;
+    report.data.batteryMillivolts = 27300 - int(i % 50);
+    report.data.batteryLevelDeci = 1000;
+    report.data.temperatureDeci = 315;
+    report.data.loadPercentage = 37;
+    report.data.state = UpsMonitor::UpsState::OnlineFull;
+    report.data.statusCode = UpsMonitor::StatusCode::OnlineFull;
+    report.serviceStatus.timestampNs = report.data.timestampNs + 20000;
+    report.serviceStatus.driverLoaded = true;
+    report.serviceStatus.driverInitialized = true;
+    report.serviceStatus.dataCommunicationActive = true;
+    report.serviceStatus.activeDriverName = "NHS Nobreak (serial)";
+    report.serviceStatus.activeComPort = "COM3";
+    report.serviceStatus.lastErrorMessage = QString("Checksum error at frame %1").arg(i / 1000);
+    report.serviceStatus.linkStats.bytesRead = i * 21;
+    report.serviceStatus.linkStats.framesDecoded = i;
+    report.serviceStatus.linkStats.latencyHistogram[7] = i;
+    return report;
+}
+
+bool sameReport(const UpsReport& a, const UpsReport& b)
+{
+    return a.deviceId == b.deviceId && a.data.timestampNs == b.data.timestampNs
+        && a.data.inputMillivolts == b.data.inputMillivolts && a.data.batteryMillivolts == b.data.batteryMillivolts
+        && a.data.state == b.data.state && a.data.statusCode == b.data.statusCode
+        && a.serviceStatus.timestampNs == b.serviceStatus.timestampNs
+        && a.serviceStatus.activeDriverName == b.serviceStatus.activeDriverName
+        && a.serviceStatus.activeComPort == b.serviceStatus.activeComPort
+        && a.serviceStatus.lastErrorMessage == b.serviceStatus.lastErrorMessage
+        && a.serviceStatus.linkStats.bytesRead == b.serviceStatus.linkStats.bytesRead
+        && a.serviceStatus.linkStats.latencyHistogram == b.serviceStatus.linkStats.latencyHistogram;
+}
+
+void print(const char* name, size_t reports, qsizetype bytes, double encodeSeconds, double decodeSeconds)
+{
+    std::printf("%-10s %7.1f bytes/report   encode %7.1f ns/report   decode %7.1f ns/report\n", name,
+                double(bytes) / reports, encodeSeconds * 1e9 / reports, decodeSeconds * 1e9 / reports);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t reports = std::max<size_t>(1000, argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000);
+
+    // Built up front: the report itself is not what is measured
+    std::vector<UpsReport> input;
+    input.reserve(reports);
+    for (size_t i = 0; i < reports; ++i) {
+        input.push_back(makeReport(i));
+    }
+
+    // --- QDataStream codec, as UpsIpcServer::sendReportToClients() and SystemTrayApp read it ---
+    QByteArray legacyStream;
+    auto start = std::chrono::steady_clock::now();
+    for (const UpsReport& report : input) {
+        QByteArray payload;
+        QDataStream out(&payload, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_6_0);
+        out << report;
+        QByteArray packet;
+        QDataStream frame(&packet, QIODevice::WriteOnly);
+        frame.setVersion(QDataStream::Qt_6_0);
+        frame << (quint32)payload.size();
+        packet.append(payload);
+        legacyStream.append(packet);
+    }
+    const double legacyEncode = secondsSince(start);
+
+    size_t mismatches = 0;
+    start = std::chrono::steady_clock::now();
+    qsizetype offset = 0;
+    for (size_t i = 0; i < reports; ++i) {
+        const quint32 blockSize = qFromBigEndian<quint32>(legacyStream.constData() + offset);
+        QDataStream in(QByteArray::fromRawData(legacyStream.constData() + offset + sizeof(quint32), blockSize));
+        in.setVersion(QDataStream::Qt_6_0);
+        UpsReport report;
+        in >> report;
+        offset += sizeof(quint32) + blockSize;
+        if (in.status() != QDataStream::Ok || !sameReport(report, input[i])) ++mismatches;
+    }
+    const double legacyDecode = secondsSince(start);
+    print("QDataStream", reports, legacyStream.size(), legacyEncode, legacyDecode);
+
+    // --- Binary wire format ---
+    IpcWire::Encoder encoder;
+    QByteArray wireStream;
+    start = std::chrono::steady_clock::now();
+    for (const UpsReport& report : input) {
+        encoder.encode(report, wireStream);
+    }
+    const double wireEncode = secondsSince(start);
+
+    IpcWire::Decoder decoder;
+    start = std::chrono::steady_clock::now();
+    offset = 0;
+    size_t decoded = 0;
+    UpsReport report;
+    while (offset < wireStream.size()) {
+        qsizetype consumed = 0;
+        IpcWire::Header header;
+        const IpcWire::Decoder::Result result =
+            decoder.decode(wireStream.constData() + offset, wireStream.size() - offset, consumed, header, report);
+        if (result == IpcWire::Decoder::Result::Invalid || result == IpcWire::Decoder::Result::Incomplete) {
+            ++mismatches;
+            break;
+        }
+        offset += consumed;
+        if (result == IpcWire::Decoder::Result::Report) {
+            if (decoded >= reports || !sameReport(report, input[decoded])) ++mismatches;
+            ++decoded;
+        }
+    }
+    const double wireDecode = secondsSince(start);
+    print("Binary", reports, wireStream.size(), wireEncode, wireDecode);
+    std::printf("Speed-up: encode %.1fx, decode %.1fx; %.0f%% of the bytes\n", legacyEncode / wireEncode,
+                legacyDecode / wireDecode, 100.0 * wireStream.size() / legacyStream.size());
+
+    if (mismatches > 0 || decoded != reports) {
+        std::fprintf(stderr, "FAIL: %zu mismatches, %zu of %zu reports decoded\n", mismatches, decoded, reports);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,533 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Scaling benchmark for Ups_api_library with many UPS units.
+ *
+ * A feeder thread serves N loopback TCP connections and writes one NHS D-record per unit per tick.
+ * Each unit is a BenchDriver (NHS framing via nhs_codec, but a socket instead of a COM port) added
+ * with addDriverInstance(), so the full reactor -> queued signal -> upsReportAvailable path is measured.
+ *
+ * For 1..64 units it compares one shared reactor thread, a small pool and one thread per unit (the
+ * old model) and prints the thread count, context switches per second and report latency percentiles.
+ * Latency runs from the feeder's write() to the upsReportAvailable() handler.
+ *
+ * With --footprint it compares the service's threading models at a UPS's own pace (1 record/s) for
+ * 1 and 16 units: a thread per unit plus dedicated component threads (log writer, history flusher),
+ * against one reactor plus the shared TaskPool. It prints thread count, idle wake-ups per second
+ * (voluntary context switches; the feeder thread adds the same share to both) and resident memory.
+ *
+ * Usage: multi_ups_bench [max units] [records per second per unit]
+ *        multi_ups_bench --footprint [records per second per unit]
+ */
+
+#include "lightups_api.h"
+#include "serial_capture.h"
+#include "nhs_codec.h"
+#include "task_pool.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <tlhelp32.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <fstream>
+#include <string>
+#endif
+
+namespace {
+
+qint64 g_epochNs = 0;
+
+/**
+ * @brief The send stamp travels in the four input-voltage min/max bytes of the D-record.
+ */
+quint32 sendStampUs()
+{
+    return static_cast<quint32>((SerialCapture::monotonicNs() - g_epochNs) / 1000);
+}
+
+int threadCount()
+{
+#ifdef Q_OS_WIN
+    int count = 0;
+    const DWORD pid = GetCurrentProcessId();
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return -1;
+    THREADENTRY32 entry{};
+    entry.dwSize = sizeof(entry);
+    for (BOOL ok = Thread32First(snapshot, &entry); ok; ok = Thread32Next(snapshot, &entry)) {
+        if (entry.th32OwnerProcessID == pid) ++count;
+    }
+    CloseHandle(snapshot);
+    return count;
+#else
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) return std::stoi(line.substr(8));
+    }
+    return -1;
+#endif
+}
+
+qint64 contextSwitches()
+{
+#ifdef Q_OS_WIN
+    return -1; // Not exposed per process without performance counters
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+#endif
+}
+
+qint64 voluntarySwitches()
+{
+#ifdef Q_OS_WIN
+    return -1;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw;
+#endif
+}
+
+qint64 residentKb()
+{
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+    return static_cast<qint64>(counters.WorkingSetSize / 1024);
+#else
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) return std::stoll(line.substr(6));
+    }
+    return -1;
+#endif
+}
+
+/**
+ * @brief A component with a thread of its own, as the log writer and the history flusher had:
+ * it blocks on a condition variable and wakes up for every job.
+ */
+class DedicatedWorker
+{
+public:
+    DedicatedWorker() : m_thread([this]() { run(); }) {}
+
+    ~DedicatedWorker()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+
+    void post(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_wake.notify_one();
+    }
+
+private:
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+            if (m_jobs.empty()) return;
+            std::function<void()> job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<std::function<void()>> m_jobs;
+    bool m_stopping = false;
+    std::thread m_thread;
+};
+
+} // namespace
+
+/**
+ * @brief Writes one D-record per connected unit per tick. Lives in its own thread.
+ */
+class Feeder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Feeder(double rateHz) : m_rateHz(rateHz) {}
+
+    quint16 port() const { return m_port; }
+
+public Q_SLOTS:
+    void start()
+    {
+        m_server = new QTcpServer(this);
+        m_server->listen(QHostAddress::LocalHost);
+        m_port = m_server->serverPort();
+        connect(m_server, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+                socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+                m_clients.append(socket);
+                connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+                    m_clients.removeOne(socket);
+                    socket->deleteLater();
+                });
+            }
+        });
+
+        m_timer = new QTimer(this);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        connect(m_timer, &QTimer::timeout, this, &Feeder::tick);
+        m_timer->start(static_cast<int>(1000.0 / m_rateHz));
+    }
+
+private Q_SLOTS:
+    void tick()
+    {
+        NhsCodec::nhs_data_payload_t payload{};
+        payload.vacinrms_low = 220;
+        payload.vdcmed_low = 136;
+        payload.vacoutrms_low = 220;
+        payload.potrms = 20;
+        payload.tempmed_low = 30;
+        payload.statusval = NhsCodec::StatusBits::BATTERY_CHARGING;
+
+        quint8 frame[NhsCodec::PACKET_LEN_D];
+        for (QTcpSocket *socket : std::as_const(m_clients)) {
+            const quint32 stamp = sendStampUs();
+            payload.vacinrmsmin_low = stamp & 0xFF;
+            payload.vacinrmsmin_high = (stamp >> 8) & 0xFF;
+            payload.vacinrmsmax_low = (stamp >> 16) & 0xFF;
+            payload.vacinrmsmax_high = (stamp >> 24) & 0xFF;
+            const size_t length = NhsCodec::encodeData(payload, frame);
+            socket->write(reinterpret_cast<const char*>(frame), length);
+            socket->flush();
+        }
+    }
+
+private:
+    double m_rateHz;
+    QTcpServer *m_server = nullptr;
+    QTimer *m_timer = nullptr;
+    QList<QTcpSocket*> m_clients;
+    std::atomic<quint16> m_port = 0;
+};
+
+/**
+ * @brief An NHS-framed driver on a TCP socket ("host:port").
+ * The send stamp is forwarded in UpsData::inputMillivolts (in microseconds), which the bench does not use otherwise.
+ */
+class BenchDriver : public IUpsDriver
+{
+    Q_OBJECT
+public:
+    bool initialize(const QString& connectionInfo) override
+    {
+        m_socket = new QTcpSocket(this);
+        connect(m_socket, &QTcpSocket::readyRead, this, &BenchDriver::readData);
+        connect(m_socket, &QTcpSocket::connected, this, &IUpsDriver::initializationSuccess);
+        const QStringList parts = connectionInfo.split(':');
+        m_socket->connectToHost(parts.value(0), parts.value(1).toUShort());
+        return true;
+    }
+
+    QString driverName() const override { return "Bench_Driver"; }
+    IUpsDriver* createInstance() const override { return new BenchDriver(); }
+
+public Q_SLOTS:
+    void stopDriver()
+    {
+        if (m_socket) m_socket->abort();
+    }
+
+private Q_SLOTS:
+    void readData()
+    {
+        const QByteArray bytes = m_socket->readAll();
+        m_decoder.feed(std::span<const quint8>(reinterpret_cast<const quint8*>(bytes.constData()), bytes.size()),
+                       [this](const NhsCodec::Frame& frame) {
+            if (frame.type != NhsCodec::FrameType::Data) return;
+            NhsCodec::pkt_data_t raw{};
+            NhsCodec::decodeData(NhsCodec::toDataPayload(frame.payload.first<sizeof(NhsCodec::nhs_data_payload_t)>()), raw);
+
+            UpsData data;
+            data.state = NhsCodec::STATUS_STATE_TABLE[raw.payload.statusval];
+            data.setOutputVoltage(raw.output_voltage_v);
+            data.setLoadPercentage(raw.power_rms_percent);
+            data.inputMillivolts = static_cast<qint32>(quint32(raw.input_voltage_min_v) | (quint32(raw.input_voltage_max_v) << 16));
+            emit dataReceived(data);
+        });
+    }
+
+private:
+    QTcpSocket *m_socket = nullptr;
+    NhsCodec::FrameDecoder m_decoder;
+};
+
+struct RunResult {
+    int threads = 0;
+    double reportsPerSecond = 0;
+    double contextSwitchesPerSecond = -1;
+    double p50Us = 0;
+    double p99Us = 0;
+    double maxUs = 0;
+};
+
+static void waitFor(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+static RunResult runOnce(quint16 port, int units, int reactorThreads, int measureMs)
+{
+    Ups_api_library library;
+    library.setReactorThreadCount(reactorThreads);
+
+    std::vector<double> latencies;
+    latencies.reserve(size_t(units) * 1024);
+    bool measuring = false;
+    int connected = 0;
+
+    QObject::connect(&library, &Ups_api_library::driverInitSuccess, [&](const QString&) { ++connected; });
+    QObject::connect(&library, &Ups_api_library::upsReportAvailable, [&](const UpsReport& report) {
+        if (!measuring || !report.serviceStatus.dataCommunicationActive) return;
+        const quint32 now = sendStampUs();
+        latencies.push_back(static_cast<double>(now - static_cast<quint32>(report.data.inputMillivolts)));
+    });
+
+    const QString connectionInfo = QString("127.0.0.1:%1").arg(port);
+    for (int i = 0; i < units; ++i) {
+        library.addDriverInstance(QString("ups%1").arg(i), new BenchDriver(), connectionInfo);
+    }
+
+    QElapsedTimer connectTimer;
+    connectTimer.start();
+    while (connected < units && connectTimer.elapsed() < 5000) {
+        waitFor(10);
+    }
+    waitFor(300); // Warm-up
+
+    RunResult result;
+    const qint64 switchesBefore = contextSwitches();
+    QElapsedTimer window;
+    window.start();
+    measuring = true;
+    waitFor(measureMs);
+    measuring = false;
+    const double seconds = window.nsecsElapsed() / 1e9;
+    const qint64 switchesAfter = contextSwitches();
+
+    result.threads = threadCount();
+    result.reportsPerSecond = latencies.size() / seconds;
+    if (switchesBefore >= 0) {
+        result.contextSwitchesPerSecond = (switchesAfter - switchesBefore) / seconds;
+    }
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        result.p50Us = latencies[latencies.size() / 2];
+        result.p99Us = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        result.maxUs = latencies.back();
+    }
+
+    const QStringList ids = library.deviceIds();
+    for (const QString& id : ids) {
+        library.removeDriver(id);
+    }
+    return result;
+}
+
+struct FootprintResult {
+    int threads = 0;
+    double wakeupsPerSecond = -1;
+    qint64 residentKb = -1;
+};
+
+/**
+ * @brief One run with @p units connected, where every report also costs a log line and a history
+ * append, as in the service. @p shared selects one reactor plus TaskPool instead of a reactor per
+ * unit plus one thread per component.
+ */
+static FootprintResult runFootprint(quint16 port, int units, bool shared, int measureMs)
+{
+    Ups_api_library library;
+    library.setReactorThreadCount(shared ? 1 : units);
+
+    // Declared first: the workers below finish their queued jobs when they are destroyed
+    std::atomic<quint64> sink{0};
+
+    // Fresh per run, so the thread count does not include workers of an earlier run
+    std::unique_ptr<TaskPool> pool;
+    std::unique_ptr<DedicatedWorker> logWriter;
+    std::unique_ptr<DedicatedWorker> historyFlusher;
+    if (shared) {
+        pool = std::make_unique<TaskPool>();
+    } else {
+        logWriter = std::make_unique<DedicatedWorker>();
+        historyFlusher = std::make_unique<DedicatedWorker>();
+    }
+    const quint64 logAffinity = TaskPool::affinityKey("log");
+    const quint64 historyAffinity = TaskPool::affinityKey("history");
+
+    int connected = 0;
+    QObject::connect(&library, &Ups_api_library::driverInitSuccess, [&](const QString&) { ++connected; });
+    QObject::connect(&library, &Ups_api_library::upsReportAvailable, [&](const UpsReport& report) {
+        const quint64 value = static_cast<quint64>(report.data.inputMillivolts);
+        auto job = [&sink, value]() { sink.fetch_add(value, std::memory_order_relaxed); };
+        if (shared) {
+            pool->submit(logAffinity, job);
+            pool->submit(historyAffinity, job);
+        } else {
+            logWriter->post(job);
+            historyFlusher->post(job);
+        }
+    });
+
+    const QString connectionInfo = QString("127.0.0.1:%1").arg(port);
+    for (int i = 0; i < units; ++i) {
+        library.addDriverInstance(QString("ups%1").arg(i), new BenchDriver(), connectionInfo);
+    }
+
+    QElapsedTimer connectTimer;
+    connectTimer.start();
+    while (connected < units && connectTimer.elapsed() < 5000) {
+        waitFor(10);
+    }
+    waitFor(1000); // Warm-up: every lazily started thread is running
+
+    FootprintResult result;
+    const qint64 switchesBefore = voluntarySwitches();
+    QElapsedTimer window;
+    window.start();
+    waitFor(measureMs);
+    const double seconds = window.nsecsElapsed() / 1e9;
+    const qint64 switchesAfter = voluntarySwitches();
+
+    result.threads = threadCount();
+    result.residentKb = residentKb();
+    if (switchesBefore >= 0) {
+        result.wakeupsPerSecond = (switchesAfter - switchesBefore) / seconds;
+    }
+
+    const QStringList ids = library.deviceIds();
+    for (const QString& id : ids) {
+        library.removeDriver(id);
+    }
+    if (pool) pool->waitForIdle();
+    return result;
+}
+
+static int footprintMain(quint16 port, double rateHz)
+{
+    std::printf("%.1f records/s per unit, baseline process threads: %d, RSS %lld kB\n",
+                rateHz, threadCount(), static_cast<long long>(residentKb()));
+    std::printf("%6s %-34s %8s %10s %10s\n", "units", "model", "threads", "wakeups/s", "RSS kB");
+
+    for (int units : { 1, 16 }) {
+        for (bool shared : { false, true }) {
+            const FootprintResult r = runFootprint(port, units, shared, 10000);
+            std::printf("%6d %-34s %8d %10.1f %10lld\n", units,
+                        shared ? "1 reactor + task pool" : "reactor per unit + component threads",
+                        r.threads, r.wakeupsPerSecond, static_cast<long long>(r.residentKb));
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const bool footprint = argc > 1 && std::strcmp(argv[1], "--footprint") == 0;
+    const int maxUnits = argc > 1 && !footprint ? std::atoi(argv[1]) : 64;
+    const double rateHz = argc > 2 ? std::atof(argv[2]) : (footprint ? 1.0 : 20.0);
+    g_epochNs = SerialCapture::monotonicNs();
+
+    QThread feederThread;
+    Feeder feeder(rateHz);
+    feeder.moveToThread(&feederThread);
+    feederThread.start();
+    QMetaObject::invokeMethod(&feeder, "start", Qt::BlockingQueuedConnection);
+
+    if (footprint) {
+        const int exitCode = footprintMain(feeder.port(), rateHz);
+        feederThread.quit();
+        feederThread.wait();
+        return exitCode;
+    }
+
+    std::printf("%d records/s per unit, baseline process threads: %d\n", static_cast<int>(rateHz), threadCount());
+    std::printf("%6s %-18s %8s %10s %10s %9s %9s %9s\n",
+                "units", "model", "threads", "reports/s", "ctxsw/s", "p50 us", "p99 us", "max us");
+
+    for (int units = 1; units <= maxUnits; units *= 2) {
+        struct Model { const char* name; int threads; };
+        std::vector<Model> models = { { "shared reactor", 1 } };
+        if (units > 4) models.push_back({ "pool of 4", 4 });
+        if (units > 1) models.push_back({ "thread per unit", units });
+
+        for (const Model& model : models) {
+            const RunResult r = runOnce(feeder.port(), units, model.threads, 2000);
+            std::printf("%6d %-18s %8d %10.0f %10.0f %9.0f %9.0f %9.0f\n",
+                        units, model.name, r.threads, r.reportsPerSecond, r.contextSwitchesPerSecond,
+                        r.p50Us, r.p99Us, r.maxUs);
+            std::fflush(stdout);
+        }
+    }
+
+    feederThread.quit();
+    feederThread.wait();
+    return 0;
+}
+
+#include "multi_ups_bench.moc"
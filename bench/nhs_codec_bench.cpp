@@ -0,0 +1,103 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Throughput benchmark for the NHS codec.
+ *
+ * Encodes a stream of D-records (with an S-record every 64 frames), then measures the
+ * complete decode path: framing, checksum, payload decoding and the status-byte table.
+ *
+ * Usage: nhs_codec_bench [frames]
+ */
+
+#include "nhs_codec.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    const size_t frameCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+
+    // 1. Build the stream
+    std::mt19937 rng(7);
+    std::vector<quint8> stream;
+    stream.reserve(frameCount * NhsCodec::PACKET_LEN_D);
+    quint8 frame[NhsCodec::PACKET_LEN_D];
+    for (size_t i = 0; i < frameCount; ++i) {
+        if (i % 64 == 0) {
+            NhsCodec::nhs_hardware_payload_t hardware{};
+            hardware.undervoltage_220V_byte = 180;
+            hardware.overvoltage_220V_byte = 250;
+            const size_t n = NhsCodec::encodeHardware(hardware, frame);
+            stream.insert(stream.end(), frame, frame + n);
+        }
+        NhsCodec::nhs_data_payload_t payload{};
+        payload.vacinrms_low = static_cast<quint8>(200 + rng() % 40);
+        payload.vdcmed_low = static_cast<quint8>(rng() % 200);
+        payload.vdcmed_high = 1;
+        payload.vacoutrms_low = 220;
+        payload.potrms = static_cast<quint8>(rng() % 100);
+        payload.tempmed_low = 30;
+        payload.statusval = static_cast<quint8>(rng());
+        const size_t n = NhsCodec::encodeData(payload, frame);
+        stream.insert(stream.end(), frame, frame + n);
+    }
+
+    // 2. Decode it in serial-sized chunks
+    constexpr size_t CHUNK_SIZE = 64;
+    NhsCodec::FrameDecoder decoder;
+    NhsCodec::pkt_data_t raw{};
+    size_t stateCount[8] = {};
+    double voltageSum = 0.0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < stream.size(); pos += CHUNK_SIZE) {
+        const size_t len = std::min(CHUNK_SIZE, stream.size() - pos);
+        decoder.feed(std::span<const quint8>(stream.data() + pos, len), [&](const NhsCodec::Frame& f) {
+            if (f.type == NhsCodec::FrameType::Data) {
+                NhsCodec::decodeData(NhsCodec::toDataPayload(f.payload.first<sizeof(NhsCodec::nhs_data_payload_t)>()), raw);
+                ++stateCount[static_cast<int>(NhsCodec::STATUS_STATE_TABLE[raw.payload.statusval])];
+                voltageSum += raw.battery_voltage_v;
+            } else {
+                NhsCodec::decodeHardware(NhsCodec::toHardwarePayload(f.payload.first<sizeof(NhsCodec::nhs_hardware_payload_t)>()), raw);
+            }
+        });
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const NhsCodec::DecoderStats& stats = decoder.stats();
+    std::printf("decoded %llu frames (%llu bytes) in %.3f s\n",
+                static_cast<unsigned long long>(stats.framesDecoded),
+                static_cast<unsigned long long>(stats.bytesIn), seconds);
+    std::printf("  %.0f frames/s, %.1f MB/s, checksum failures %llu, resync bytes %llu\n",
+                stats.framesDecoded / seconds,
+                stats.bytesIn / seconds / (1024.0 * 1024.0),
+                static_cast<unsigned long long>(stats.checksumFailures),
+                static_cast<unsigned long long>(stats.resyncBytesDiscarded));
+    std::printf("  states: critical %zu, on-battery %zu, fault %zu, charging %zu, full %zu (avg %.2f V)\n",
+                stateCount[static_cast<int>(UpsMonitor::UpsState::BatteryCritical)],
+                stateCount[static_cast<int>(UpsMonitor::UpsState::OnBattery)],
+                stateCount[static_cast<int>(UpsMonitor::UpsState::OnlineFault)],
+                stateCount[static_cast<int>(UpsMonitor::UpsState::OnlineCharging)],
+                stateCount[static_cast<int>(UpsMonitor::UpsState::OnlineFull)],
+                voltageSum / std::max<double>(1.0, stateCount[1] + stateCount[2] + stateCount[3] + stateCount[4] + stateCount[5]));
+    return stats.framesDecoded == frameCount + (frameCount + 63) / 64 ? 0 : 1;
+}
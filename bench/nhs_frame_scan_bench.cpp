@@ -0,0 +1,182 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Micro-benchmark for NhsRingBuffer frame extraction.
+ *
+ * Feeds a synthetic byte stream through the ring in serial-sized chunks and reports
+ * frames/s and bytes/s for a clean stream (only valid D-records) and for a
+ * garbage-heavy stream (random noise with plenty of false 0xFF start markers).
+ *
+ * Usage: nhs_frame_scan_bench [megabytes]
+ */
+
+#include "nhs_ring_buffer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Builds a valid frame: FF <len> <type> <payload...> <checksum> FE
+std::vector<uint8_t> makeFrame(uint8_t type, int packetLen, std::mt19937& rng)
+{
+    std::vector<uint8_t> frame(packetLen);
+    frame[0] = NhsRingBuffer::START_MARKER;
+    frame[1] = static_cast<uint8_t>(packetLen);
+    frame[2] = type;
+    for (int i = 3; i < packetLen - 2; ++i) {
+        frame[i] = static_cast<uint8_t>(rng() % 0xF0); // Keep markers out of the payload
+    }
+    frame[packetLen - 2] = NhsRingBuffer::checksum(frame.data(), packetLen - 3);
+    frame[packetLen - 1] = NhsRingBuffer::END_MARKER;
+    return frame;
+}
+
+std::vector<uint8_t> makeStream(size_t targetBytes, double garbageRatio, size_t& validFrames)
+{
+    std::mt19937 rng(42);
+    std::vector<uint8_t> stream;
+    stream.reserve(targetBytes + 64);
+    validFrames = 0;
+
+    while (stream.size() < targetBytes) {
+        if (garbageRatio > 0.0) {
+            // Noise burst; every 8th byte is a start marker and every 16th a plausible length byte
+            const int burst = static_cast<int>(NhsRingBuffer::PACKET_LEN_D * garbageRatio / (1.0 - garbageRatio));
+            for (int i = 0; i < burst; ++i) {
+                uint8_t b = static_cast<uint8_t>(rng());
+                if (i % 8 == 0) b = NhsRingBuffer::START_MARKER;
+                else if (i % 16 == 1) b = NhsRingBuffer::PACKET_LEN_D;
+                stream.push_back(b);
+            }
+        }
+        const std::vector<uint8_t> frame = makeFrame('D', NhsRingBuffer::PACKET_LEN_D, rng);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+        ++validFrames;
+    }
+    return stream;
+}
+
+// The original byte-at-a-time loop from Nhs_driver::readData(), kept as a baseline
+struct LegacyRing {
+    static const int BUFFER_SIZE = 128;
+    static const int BUFFER_MASK = BUFFER_SIZE - 1;
+    uint8_t ring[BUFFER_SIZE] = {};
+    int head = 0;
+    int tail = 0;
+    size_t frames = 0;
+
+    uint8_t checksum(int tailIndex, int length) const
+    {
+        uint16_t sum = 0;
+        for (int i = 1; i <= length; i++) sum += ring[(tailIndex + i) & BUFFER_MASK];
+        return static_cast<uint8_t>(sum & 0xFF);
+    }
+
+    void feed(const uint8_t* data, int length)
+    {
+        for (int i = 0; i < length; ++i) {
+            ring[head] = data[i];
+            head = (head + 1) & BUFFER_MASK;
+        }
+        while (((head - tail) & BUFFER_MASK) >= 9) {
+            if (ring[tail] != 0xFF) { tail = (tail + 1) & BUFFER_MASK; continue; }
+            int packetLen = ring[(tail + 1) & BUFFER_MASK];
+            if (packetLen != 21 && packetLen != 18) { tail = (tail + 1) & BUFFER_MASK; continue; }
+            if (((head - tail) & BUFFER_MASK) < packetLen) break;
+            uint8_t type = ring[(tail + 2) & BUFFER_MASK];
+            const int dataLen = (type == 'D') ? 18 : 15;
+            uint8_t expected = ring[(tail + packetLen - 2) & BUFFER_MASK];
+            uint8_t last = ring[(tail + packetLen - 1) & BUFFER_MASK];
+            if (last == 0xFE && checksum(tail, dataLen) == expected) ++frames;
+            tail = (tail + packetLen) & BUFFER_MASK;
+        }
+    }
+};
+
+struct Result {
+    size_t frames = 0;
+    double seconds = 0.0;
+};
+
+constexpr int CHUNK_SIZE = 64; // Typical size of one serial readyRead() batch
+
+Result runBatched(const std::vector<uint8_t>& stream)
+{
+    NhsRingBuffer ring;
+    Result result;
+    size_t mismatches = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < stream.size(); pos += CHUNK_SIZE) {
+        const uint8_t* src = stream.data() + pos;
+        int remaining = static_cast<int>(std::min<size_t>(CHUNK_SIZE, stream.size() - pos));
+        while (remaining > 0) {
+            const int copied = ring.write(src, remaining);
+            src += copied;
+            remaining -= copied;
+            ring.extractFrames([&](const uint8_t*, int) { ++result.frames; }, [&]() { ++mismatches; });
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+Result runLegacy(const std::vector<uint8_t>& stream)
+{
+    // The legacy ring cannot absorb more than 127 bytes per call, which the 128-byte QSerialPort buffer guaranteed
+    LegacyRing ring;
+    Result result;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < stream.size(); pos += CHUNK_SIZE) {
+        ring.feed(stream.data() + pos, static_cast<int>(std::min<size_t>(CHUNK_SIZE, stream.size() - pos)));
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.frames = ring.frames;
+    return result;
+}
+
+void report(const char* name, const char* variant, const Result& r, size_t bytes, size_t expectedFrames)
+{
+    std::printf("%-14s %-8s %12.0f frames/s %10.1f MB/s   (%zu/%zu frames)\n",
+                name, variant,
+                r.frames / r.seconds,
+                bytes / r.seconds / (1024.0 * 1024.0),
+                r.frames, expectedFrames);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    const size_t bytes = megabytes * 1024 * 1024;
+
+    struct Scenario { const char* name; double garbageRatio; };
+    const Scenario scenarios[] = { { "clean", 0.0 }, { "garbage-heavy", 0.75 } };
+
+    for (const Scenario& scenario : scenarios) {
+        size_t expectedFrames = 0;
+        const std::vector<uint8_t> stream = makeStream(bytes, scenario.garbageRatio, expectedFrames);
+        report(scenario.name, "legacy", runLegacy(stream), stream.size(), expectedFrames);
+        report(scenario.name, "batched", runBatched(stream), stream.size(), expectedFrames);
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Driver discovery with and without the plugin index, for a directory of 50 plugins.
+ *
+ * Copies one plugin library 50 times into a temporary directory and times:
+ *  - legacy: QPluginLoader::metaData() on every file (what the GUI and the service used to do);
+ *  - cold:   PluginIndex::refresh() without an index file (first start after an install);
+ *  - warm:   a new PluginIndex refreshing against an up-to-date index (every later start);
+ *  - touch:  refresh after one plugin was replaced.
+ * The files stay in the page cache, so "cold" means "no index", not "cold disk". The warm run must
+ * reuse every entry and the touch run must rescan exactly one file (exit code 1 otherwise).
+ *
+ * Usage: plugin_index_bench [plugin file] [rounds]     (default: the nhs_driver build output, 5 rounds)
+ */
+
+#include "plugin_index.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLibrary>
+#include <QPluginLoader>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr int PLUGIN_COUNT = 50;
+
+double msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+#ifdef BENCH_PLUGIN_FILE
+    QString source = QStringLiteral(BENCH_PLUGIN_FILE);
+#else
+    QString source;
+#endif
+    if (argc > 1) {
+        source = QString::fromLocal8Bit(argv[1]);
+    }
+    const int rounds = argc > 2 ? std::max(1, atoi(argv[2])) : 5;
+    if (source.isEmpty() || QPluginLoader(source).metaData().isEmpty()) {
+        std::fprintf(stderr, "Usage: plugin_index_bench <plugin file> [rounds] (no usable plugin: '%s')\n",
+                     qPrintable(source));
+        return 1;
+    }
+
+    QTemporaryDir root;
+    const QString pluginDir = root.filePath(QStringLiteral("plugins"));
+    const QString indexPath = root.filePath(QStringLiteral("plugin_index.json"));
+    QDir().mkpath(pluginDir);
+    const QString suffix = QFileInfo(source).suffix();
+    QStringList files;
+    for (int i = 0; i < PLUGIN_COUNT; ++i) {
+        const QString path = QStringLiteral("%1/driver_%2.%3").arg(pluginDir).arg(i, 2, 10, QLatin1Char('0')).arg(suffix);
+        if (!QFile::copy(source, path)) {
+            std::fprintf(stderr, "Cannot copy %s to %s\n", qPrintable(source), qPrintable(path));
+            return 1;
+        }
+        files << path;
+    }
+    std::printf("%d copies of %s (%.1f KB each), %d rounds, median:\n", PLUGIN_COUNT,
+                qPrintable(QFileInfo(source).fileName()), QFileInfo(source).size() / 1024.0, rounds);
+
+    std::vector<double> legacy, cold, warm, touch;
+    int plugins = 0;
+    for (int round = 0; round < rounds; ++round) {
+        auto start = std::chrono::steady_clock::now();
+        int found = 0;
+        for (const QString& path : std::as_const(files)) {
+            if (QLibrary::isLibrary(path) && !QPluginLoader(path).metaData().isEmpty()) {
+                ++found;
+            }
+        }
+        legacy.push_back(msSince(start));
+
+        QFile::remove(indexPath);
+        start = std::chrono::steady_clock::now();
+        {
+            PluginIndex index(pluginDir, indexPath);
+            index.refresh();
+            plugins = index.plugins().size();
+        }
+        cold.push_back(msSince(start));
+
+        start = std::chrono::steady_clock::now();
+        PluginIndex warmIndex(pluginDir, indexPath);
+        warmIndex.refresh();
+        warm.push_back(msSince(start));
+        if (found != PLUGIN_COUNT || plugins != PLUGIN_COUNT || warmIndex.lastRefresh().reused != PLUGIN_COUNT) {
+            std::fprintf(stderr, "FAIL: legacy found %d, index found %d, warm start reused %d of %d\n", found,
+                         plugins, warmIndex.lastRefresh().reused, PLUGIN_COUNT);
+            return 1;
+        }
+
+        // Replace one plugin (new modification time) and let a fresh process pick it up
+        QFile touched(files.at(round % PLUGIN_COUNT));
+        if (!touched.open(QIODevice::ReadWrite)
+            || !touched.setFileTime(QDateTime::currentDateTime().addSecs(60 * (round + 1)), QFileDevice::FileModificationTime)) {
+            std::fprintf(stderr, "Cannot touch %s\n", qPrintable(touched.fileName()));
+            return 1;
+        }
+        touched.close();
+        start = std::chrono::steady_clock::now();
+        PluginIndex touchIndex(pluginDir, indexPath);
+        touchIndex.refresh();
+        touch.push_back(msSince(start));
+        if (touchIndex.lastRefresh().scanned != 1) {
+            std::fprintf(stderr, "FAIL: expected one rescanned plugin, got %d\n", touchIndex.lastRefresh().scanned);
+            return 1;
+        }
+    }
+
+    const double legacyMs = median(legacy);
+    std::printf("  legacy (QPluginLoader per file): %8.2f ms\n", legacyMs);
+    std::printf("  cold   (no index)              : %8.2f ms\n", median(cold));
+    std::printf("  warm   (index up to date)      : %8.2f ms  (%.1fx faster than legacy)\n", median(warm),
+                legacyMs / std::max(median(warm), 1e-3));
+    std::printf("  touch  (one plugin replaced)   : %8.2f ms\n", median(touch));
+    return 0;
+}
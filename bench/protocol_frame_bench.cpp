@@ -0,0 +1,179 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Hand-written vs. generated NHS parser.
+ *
+ * Decodes the same stream (D-records, an S-record every 64 frames and optional garbage) with
+ * NhsCodec::FrameDecoder + decodeData() and with the ProtocolFrame parser generated from
+ * NhsCodec::Protocol. Checks that both produce identical results, then reports the throughput.
+ *
+ * Usage: protocol_frame_bench [frames] [garbage-percent]
+ */
+
+#include "nhs_codec.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct Result {
+    quint64 frames = 0;
+    quint64 checksumFailures = 0;
+    quint64 resyncBytes = 0;
+    quint64 stateCount[8] = {};
+    double voltageSum = 0.0;
+    quint64 hardwareSum = 0;
+    double seconds = 0.0;
+};
+
+constexpr size_t CHUNK_SIZE = 64;
+constexpr int ROUNDS = 5;
+
+std::vector<quint8> buildStream(size_t frameCount, int garbagePercent)
+{
+    std::mt19937 rng(7);
+    std::vector<quint8> stream;
+    stream.reserve(frameCount * NhsCodec::PACKET_LEN_D * 2);
+    quint8 frame[NhsCodec::PACKET_LEN_D];
+    for (size_t i = 0; i < frameCount; ++i) {
+        if (i % 64 == 0) {
+            NhsCodec::nhs_hardware_payload_t hardware{};
+            hardware.undervoltage_220V_byte = static_cast<quint8>(170 + rng() % 20);
+            hardware.overvoltage_220V_byte = 250;
+            const size_t n = NhsCodec::encodeHardware(hardware, frame);
+            stream.insert(stream.end(), frame, frame + n);
+        }
+        if (garbagePercent > 0 && static_cast<int>(rng() % 100) < garbagePercent) {
+            const int noise = 1 + rng() % 12;
+            for (int j = 0; j < noise; ++j) stream.push_back(static_cast<quint8>(rng()));
+        }
+        NhsCodec::nhs_data_payload_t payload{};
+        payload.vacinrms_low = static_cast<quint8>(200 + rng() % 40);
+        payload.vdcmed_low = static_cast<quint8>(rng() % 200);
+        payload.vdcmed_high = 1;
+        payload.vacoutrms_low = 220;
+        payload.potrms = static_cast<quint8>(rng() % 100);
+        payload.tempmed_low = 30;
+        payload.statusval = static_cast<quint8>(rng());
+        const size_t n = NhsCodec::encodeData(payload, frame);
+        stream.insert(stream.end(), frame, frame + n);
+    }
+    return stream;
+}
+
+Result runHandWritten(const std::vector<quint8>& stream)
+{
+    Result result;
+    NhsCodec::FrameDecoder decoder;
+    NhsCodec::pkt_data_t raw{};
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < stream.size(); pos += CHUNK_SIZE) {
+        const size_t len = std::min(CHUNK_SIZE, stream.size() - pos);
+        decoder.feed(std::span<const quint8>(stream.data() + pos, len), [&](const NhsCodec::Frame& f) {
+            if (f.type == NhsCodec::FrameType::Data) {
+                NhsCodec::decodeData(NhsCodec::toDataPayload(f.payload.first<sizeof(NhsCodec::nhs_data_payload_t)>()), raw);
+                ++result.stateCount[static_cast<int>(raw.state)];
+                result.voltageSum += raw.battery_voltage_v;
+            } else {
+                NhsCodec::decodeHardware(NhsCodec::toHardwarePayload(f.payload.first<sizeof(NhsCodec::nhs_hardware_payload_t)>()), raw);
+                result.hardwareSum += raw.uv_220v;
+            }
+        });
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const NhsCodec::DecoderStats& stats = decoder.stats();
+    result.frames = stats.framesDecoded;
+    result.checksumFailures = stats.checksumFailures;
+    result.resyncBytes = stats.resyncBytesDiscarded;
+    return result;
+}
+
+Result runGenerated(const std::vector<quint8>& stream)
+{
+    Result result;
+    NhsCodec::Parser parser;
+    NhsCodec::pkt_data_t raw{};
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < stream.size(); pos += CHUNK_SIZE) {
+        const size_t len = std::min(CHUNK_SIZE, stream.size() - pos);
+        parser.feed(std::span<const quint8>(stream.data() + pos, len), raw, [&](auto frame) {
+            if constexpr (std::is_same_v<decltype(frame), NhsCodec::DataFrame>) {
+                ++result.stateCount[static_cast<int>(raw.state)];
+                result.voltageSum += raw.battery_voltage_v;
+            } else {
+                result.hardwareSum += raw.uv_220v;
+            }
+        });
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const ProtocolFrame::ParserStats& stats = parser.stats();
+    result.frames = stats.framesDecoded;
+    result.checksumFailures = stats.checksumFailures;
+    result.resyncBytes = stats.resyncBytesDiscarded;
+    return result;
+}
+
+bool sameOutput(const Result& a, const Result& b)
+{
+    if (a.frames != b.frames || a.checksumFailures != b.checksumFailures || a.resyncBytes != b.resyncBytes
+        || a.voltageSum != b.voltageSum || a.hardwareSum != b.hardwareSum) {
+        return false;
+    }
+    for (int i = 0; i < 8; ++i) {
+        if (a.stateCount[i] != b.stateCount[i]) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t frameCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+    const int garbagePercent = argc > 2 ? std::atoi(argv[2]) : 0;
+    const std::vector<quint8> stream = buildStream(frameCount, garbagePercent);
+
+    // Interleave the runs and keep the best of each, so frequency scaling hits both alike
+    Result handWritten, generated;
+    double bestHand = 1e9, bestGenerated = 1e9;
+    for (int round = 0; round < ROUNDS; ++round) {
+        handWritten = runHandWritten(stream);
+        generated = runGenerated(stream);
+        bestHand = std::min(bestHand, handWritten.seconds);
+        bestGenerated = std::min(bestGenerated, generated.seconds);
+    }
+
+    const bool identical = sameOutput(handWritten, generated);
+    std::printf("%zu bytes, %llu frames, %d%% garbage, %zu-byte chunks, best of %d\n",
+                stream.size(), static_cast<unsigned long long>(generated.frames), garbagePercent, CHUNK_SIZE, ROUNDS);
+    std::printf("  hand-written: %.3f s, %.1f MB/s\n", bestHand, stream.size() / bestHand / (1024.0 * 1024.0));
+    std::printf("  generated:    %.3f s, %.1f MB/s (%.2fx)\n", bestGenerated, stream.size() / bestGenerated / (1024.0 * 1024.0),
+                bestHand / bestGenerated);
+    std::printf("  outputs %s (checksum failures %llu, resync bytes %llu)\n", identical ? "identical" : "DIFFER",
+                static_cast<unsigned long long>(generated.checksumFailures),
+                static_cast<unsigned long long>(generated.resyncBytes));
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Heap allocations per sample on the driver side of the report pipeline.
+ *
+ * Feeds a steady NHS stream (mains, a short outage, mains again) through the generated parser,
+ * NhsCodec::toUpsData(), the BatteryEstimator and the SampleFilter; forwarded samples are turned
+ * into a UpsReport and published to a ReportSnapshot. After a warm-up every heap allocation is
+ * counted. The exit code is 1 if any remains, so the bench doubles as a regression check
+ * (registered with CTest as sample_alloc_test).
+ *
+ * Scope: "zero heap allocations per sample" is enforced for every stage that runs per sample
+ * EXCEPT the two hand-offs between threads and processes:
+ * - The queued sampleAccepted -> handleDriverData hop from the reactor thread to the API thread.
+ *   Qt allocates one QMetaCallEvent per queued emission (and a copy of the UpsData argument), so
+ *   every forwarded sample costs allocations there. Suppressed samples never reach it.
+ * - The upsReportAvailable fan-out to IPC clients, which encodes into a QByteArray per client.
+ * Both sides of each hop are measured here: the reactor side up to sampleAccepted, and the API
+ * side from the report to ReportSnapshot::publish() (what Ups_api_library::emitUpsReport() does).
+ *
+ * Allocations are counted at malloc level on glibc (this includes Qt's containers), with the
+ * debug CRT allocation hook in MSVC Debug builds, and by replacing operator new elsewhere.
+ *
+ * Usage: sample_alloc_bench [samples]
+ */
+
+#include "nhs_codec.h"
+#include "battery_estimator.h"
+#include "sample_filter.h"
+#include "report_snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+namespace {
+std::atomic<bool> g_counting{false};
+std::atomic<quint64> g_allocations{0};
+
+void countAllocation()
+{
+    if (g_counting.load(std::memory_order_relaxed)) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+}
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+}
+static const char* const COUNTING_METHOD = "malloc (glibc)";
+#elif defined(_MSC_VER) && defined(_DEBUG)
+static int allocHook(int type, void*, size_t, int, long, const unsigned char*, int)
+{
+    if (type == _HOOK_ALLOC || type == _HOOK_REALLOC) countAllocation();
+    return 1; // Let the allocation proceed
+}
+static const char* const COUNTING_METHOD = "debug CRT hook";
+#else
+void* operator new(size_t size)
+{
+    countAllocation();
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+static const char* const COUNTING_METHOD = "operator new (allocations inside Qt are not seen)";
+#endif
+
+namespace {
+
+constexpr qint64 SAMPLE_INTERVAL_NS = 1000000000;  // The UPS sends one D-record per second
+constexpr size_t WARMUP_SAMPLES = 2000;
+
+/**
+ * @brief One D-record per sample: mains with a little jitter, then an outage during the middle tenth.
+ */
+std::vector<quint8> buildStream(size_t samples)
+{
+    std::vector<quint8> stream;
+    stream.reserve(samples * NhsCodec::PACKET_LEN_D);
+    quint8 frame[NhsCodec::PACKET_LEN_D];
+    for (size_t i = 0; i < samples; ++i) {
+        const bool outage = i > samples / 2 && i < samples / 2 + samples / 10;
+        NhsCodec::nhs_data_payload_t payload{};
+        payload.vacinrms_low = outage ? 0 : static_cast<quint8>(220 + (i % 7 == 0 ? 3 : 0));
+        payload.vacoutrms_low = 220;
+        const int decivolts = outage ? 128 - static_cast<int>((i - samples / 2) * 20 / (samples / 10 + 1)) : 136;
+        payload.vdcmed_low = static_cast<quint8>(decivolts);
+        payload.potrms = static_cast<quint8>(30 + i % 3);
+        payload.tempmed_low = 30;
+        payload.statusval = outage ? 0x00 : 0x10;
+        const size_t n = NhsCodec::encodeData(payload, frame);
+        stream.insert(stream.end(), frame, frame + n);
+    }
+    return stream;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const size_t samples = std::max<size_t>(WARMUP_SAMPLES * 2, argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000);
+    const std::vector<quint8> stream = buildStream(samples);
+
+    NhsCodec::Parser parser;
+    NhsCodec::pkt_data_t raw{};
+    BatteryEstimator estimator;
+    SampleFilter filter;
+    ReportSnapshot snapshot;
+
+    UpsReport report;
+    report.deviceId = "bench";
+    report.serviceStatus.driverLoaded = true;
+    report.serviceStatus.driverInitialized = true;
+    report.serviceStatus.dataCommunicationActive = true;
+    report.serviceStatus.activeDriverName = "nhs_driver";
+    report.serviceStatus.activeComPort = "COM3";
+
+    quint64 forwarded = 0;
+    QObject::connect(&filter, &SampleFilter::sampleAccepted, [&](const UpsData& data) {
+        // What Ups_api_library::emitUpsReport() does before the queued fan-out
+        report.data = data;
+        report.serviceStatus.timestampNs = data.timestampNs;
+        snapshot.publish(report);
+        ++forwarded;
+    });
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+    _CrtSetAllocHook(allocHook);
+#endif
+
+    size_t sample = 0;
+    quint64 warmupAllocations = 0;
+    for (size_t pos = 0; pos < stream.size(); pos += NhsCodec::PACKET_LEN_D) {
+        if (sample == WARMUP_SAMPLES) {
+            warmupAllocations = g_allocations.load();
+            g_counting = true;
+        }
+        const qint64 arrivalNs = static_cast<qint64>(sample + 1) * SAMPLE_INTERVAL_NS;
+        parser.feed(std::span<const quint8>(stream.data() + pos, NhsCodec::PACKET_LEN_D), raw, [&](auto) {
+            UpsData data = NhsCodec::toUpsData(raw, arrivalNs);
+            estimator.update(data);
+            filter.process(data);
+        });
+        ++sample;
+    }
+    g_counting = false;
+
+    const quint64 allocations = g_allocations.load() - warmupAllocations;
+    const quint64 measured = samples - WARMUP_SAMPLES;
+    std::printf("%llu samples after %zu warm-up, %llu forwarded, counting via %s\n"
+                "  (excludes the queued reactor -> API thread hop and the IPC fan-out, see the file comment)\n",
+                static_cast<unsigned long long>(measured), WARMUP_SAMPLES,
+                static_cast<unsigned long long>(forwarded), COUNTING_METHOD);
+    std::printf("  sizeof(UpsData) = %zu bytes\n", sizeof(UpsData));
+    std::printf("  heap allocations: %llu (%.4f per sample) -> %s\n", static_cast<unsigned long long>(allocations),
+                double(allocations) / measured, allocations == 0 ? "OK" : "FAIL");
+    return allocations == 0 ? 0 : 1;
+}
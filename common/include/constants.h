@@ -23,7 +23,9 @@
 
 #include <QString>
 #include <QSettings>
+#ifdef Q_OS_WIN
 #include <windows.h>
+#endif
 
 namespace AppConstants {
 
@@ -49,9 +51,47 @@ const QString REG_KEY_SELECTED_DRIVER_FILE = "SelectedDriver";
 // Key for the shutdown delay in seconds (Int)
 const QString REG_KEY_SHUTDOWN_DELAY = "ShutdownDelay";
 
+// Key for the runtime margin in seconds (Int): shut down once the estimated runtime on battery
+// drops to this value, even before the shutdown delay expires. 0 disables it.
+const QString REG_KEY_RUNTIME_MARGIN = "RuntimeMarginSeconds";
+
 // Key for the Power Safe Mode checkbox (Bool)
 const QString REG_KEY_POWER_SAFE_ENABLED = "PowerSafeEnabled";
 
+// Additional UPS units: one subkey per device ID, each with a driver file and a port
+// e.g. Devices\rack2\Driver = "nhs_driver.dll", Devices\rack2\Port = "COM9"
+const QString REG_GROUP_DEVICES = "Devices";
+const QString REG_KEY_DEVICE_DRIVER = "Driver";
+const QString REG_KEY_DEVICE_PORT = "Port";
+
+// Number of reactor threads shared by all drivers (Int, default 1)
+const QString REG_KEY_REACTOR_THREADS = "ReactorThreads";
+
+// A reactor thread that does not run a heartbeat for this long is reported as hung and its
+// units are restarted on another thread (Int, milliseconds, default 5000)
+const QString REG_KEY_HANG_THRESHOLD_MS = "ReactorHangThresholdMs";
+
+// Change-detection filter between the drivers and the report fan-out
+const QString REG_KEY_FILTER_ENABLED = "SampleFilterEnabled";         // Bool, default true
+const QString REG_KEY_FILTER_HEARTBEAT_MS = "SampleFilterHeartbeatMs"; // Int, default 10000
+
+// Auto-detection: probe all serial ports with all serial drivers when the primary UPS is
+// not configured or keeps failing. The winning pair is written to SelectedDriver/SelectedComPort.
+const QString REG_KEY_AUTO_DETECT = "AutoDetect";                     // Bool, default true
+const QString REG_KEY_PROBE_TIMEOUT_MS = "ProbeTimeoutMs";            // Int, deadline of one probe, default 2500
+
+// Battery model used for the state-of-charge and runtime estimates
+const QString REG_KEY_BATTERY_BLOCKS = "BatteryBlocks";               // Int, 12 V blocks in series, 0 = auto
+const QString REG_KEY_FULL_LOAD_RUNTIME = "FullLoadRuntimeSeconds";   // Int, default 300
+
+// On-disk history of all reports (String, path of the file). Default: history.lhf in the service's
+// local application data directory; "off" disables it.
+const QString REG_KEY_HISTORY_FILE = "HistoryFile";
+
+// Device ID of the unit configured with SelectedDriver/SelectedComPort.
+// The shutdown logic and the tray application follow this unit.
+const QString PRIMARY_DEVICE_ID = "primary";
+
 // -------------------------------------------------------------------------
 // Application & Organization Names (QCoreApplication::set*)
 // -------------------------------------------------------------------------
@@ -61,21 +101,37 @@ const QString APP_ORGANIZATION_NAME = "andhoo";
 
 // Application name that determines the path in the Windows Registry
 const QString APP_APPLICATION_NAME = "LightUps";
+
+// Elsewhere the settings are an INI file: <dir>/<organization>/<application>.conf
+// System scope: /etc/andhoo/LightUps.conf, user scope (debug builds): ~/.config/andhoo/LightUps.conf
+const QString SYSTEM_SETTINGS_DIR = "/etc";
+
+/**
+ * @brief Selects the settings backend. Call once at startup, before the first QSettings is created.
+ */
+inline void initSettingsBackend()
+{
+#ifndef Q_OS_WIN
+    QSettings::setPath(QSettings::NativeFormat, QSettings::SystemScope, SYSTEM_SETTINGS_DIR);
+#endif
+}
 }
 
 // namespace AppConstants
 namespace UpsEvents {
-const DWORD ID_SERVICE_INFO    = 100; // Start, Stop, Settings change
-const DWORD ID_POWER_RESTORED  = 200; // AC restored
-const DWORD ID_ON_BATTERY      = 300; // AC lost (Warning)
-const DWORD ID_BATT_CRITICAL   = 400; // System is shutting down (Error)
-const DWORD ID_SERVICE_ERROR   = 900; // Internal errors (e.g. IPC server fails)
+// Event Log message IDs (DWORD on Windows)
+const quint32 ID_SERVICE_INFO    = 100; // Start, Stop, Settings change
+const quint32 ID_POWER_RESTORED  = 200; // AC restored
+const quint32 ID_ON_BATTERY      = 300; // AC lost (Warning)
+const quint32 ID_BATT_CRITICAL   = 400; // System is shutting down (Error)
+const quint32 ID_SERVICE_ERROR   = 900; // Internal errors (e.g. IPC server fails)
 }
 
 struct AppContext {
     bool debugMode = false;
     bool consoleMode = false;
     bool isService = false;
+    QString captureFile;   // --capture <file>: record the raw serial stream
 };
 
 extern AppContext g_context;
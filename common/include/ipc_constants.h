@@ -19,17 +19,63 @@
 #pragma once
 
 #include "ups_report.h" // Necessary to know the structure
+#include "log_categories.h"
 #include <QDataStream>
 #include <QString>
 #include <QMetaEnum>
 #include <QDebug> // <<< ADDED
+#include <algorithm>
 
-// --- PLACE THIS HERE SO IT IS VISIBLE TO ALL FILES ---
-#define IPC_TEST_DEBUG // The definition is now visible everywhere
+// Per-report IPC tracing is opt-in: configure with -DLIGHTUPS_IPC_TEST_DEBUG=ON (defines IPC_TEST_DEBUG)
+// and enable the "lightups.ipc.debug" logging rule.
 
 // The unique name for the local socket/server (must be the same for both apps)
 const QString IPC_SERVER_NAME = "Global\\UPS_MONITOR_SERVICE_V1";
 
+/**
+ * @brief Frame types for clients that sent {COMMAND=HELLO, FRAMES=typed}.
+ *
+ * Typed frames are: quint32 size, quint8 type, payload (the size covers the type byte).
+ * Clients that never say hello keep receiving bare UpsReport frames.
+ * {COMMAND=HELLO, FRAMES=binary} selects the fixed-layout format of ipc_wire.h instead.
+ */
+namespace IpcFrame {
+enum Type : quint8 {
+    Report = 0,     // Payload: UpsReport
+    History = 1,    // Payload: UpsHistory::Series (reply to COMMAND=HISTORY)
+};
+}
+
+/**
+ * @brief Serializes the link counters (fixed layout: 8 counters, then the histogram buckets).
+ */
+inline QDataStream& operator<<(QDataStream& stream, const DriverLinkStats& stats)
+{
+    stream << stats.bytesRead << stats.framesDecoded << stats.checksumFailures << stats.resyncBytesDiscarded
+           << stats.bufferOverruns << stats.handshakeRetries << stats.reconnects << stats.serialErrors;
+    stream << (quint8)DriverLinkStats::LATENCY_BUCKETS;
+    for (quint64 count : stats.latencyHistogram) {
+        stream << count;
+    }
+    return stream;
+}
+
+inline QDataStream& operator>>(QDataStream& stream, DriverLinkStats& stats)
+{
+    stream >> stats.bytesRead >> stats.framesDecoded >> stats.checksumFailures >> stats.resyncBytesDiscarded
+           >> stats.bufferOverruns >> stats.handshakeRetries >> stats.reconnects >> stats.serialErrors;
+    quint8 buckets = 0;
+    stream >> buckets;
+    stats.latencyHistogram.fill(0);
+    for (int i = 0; i < buckets; ++i) {
+        quint64 count = 0;
+        stream >> count;
+        // A sender with more buckets folds its tail into our open-ended last bucket
+        stats.latencyHistogram[std::min(i, DriverLinkStats::LATENCY_BUCKETS - 1)] += count;
+    }
+    return stream;
+}
+
 /**
  * @brief Helper function to serialize a UpsReport structure to a QDataStream.
  * @param stream The output data stream.
@@ -44,24 +90,24 @@ inline QDataStream& operator<<(QDataStream& stream, const UpsReport& report)
 {
 #ifdef IPC_TEST_DEBUG
     // Log the details of the sent report.
-    qDebug() << "IPC DEBUG: Rapport verzonden - Tijd:" << report.data.timestamp.toString("hh:mm:ss")
+    qCDebug(lcUpsIpc) << "IPC DEBUG: Rapport verzonden - Tijd:" << report.data.wallTime().toString("hh:mm:ss")
              << "| Status:" << (int)report.data.state
-             << "| Batterij:" << report.data.batteryLevel << "%";
+             << "| Batterij:" << report.data.batteryLevel() << "%";
 #endif
-    // First the UpsData
-    stream << report.data.timestamp;
+    // First the UpsData (wall times for older readers; the stamps themselves follow at the end)
+    stream << report.data.wallTime();
     stream << (qint32)report.data.state; // Store Enum as integer
-    stream << report.data.inputVoltage;
-    stream << report.data.outputVoltage;
-    stream << report.data.batteryVoltage;
-    stream << report.data.batteryLevel;
-    stream << report.data.temperatureC;
-    stream << report.data.loadPercentage;
-    stream << report.data.BatteryFault;
-    stream << report.data.statusMessage;
+    stream << report.data.inputVoltage();
+    stream << report.data.outputVoltage();
+    stream << report.data.batteryVoltage();
+    stream << report.data.batteryLevel();
+    stream << report.data.temperatureC();
+    stream << (qint32)report.data.loadPercentage;
+    stream << report.data.batteryFault();
+    stream << QString(); // Former status text: the code follows at the end and is translated by the reader
 
     // Then the UpsServiceStatus
-    stream << report.serviceStatus.timestamp;
+    stream << UpsClock::toDateTime(report.serviceStatus.timestampNs);
     stream << report.serviceStatus.driverLoaded;
     stream << report.serviceStatus.driverInitialized;
     stream << report.serviceStatus.dataCommunicationActive;
@@ -69,6 +115,15 @@ inline QDataStream& operator<<(QDataStream& stream, const UpsReport& report)
     stream << report.serviceStatus.activeComPort;
     stream << report.serviceStatus.lastErrorMessage;
 
+    // Added with multi-UPS support: readers parse each block separately, so trailing fields are safe
+    stream << report.deviceId;
+    stream << report.serviceStatus.linkStats;
+    stream << (qint32)report.data.runtimeRemainingSeconds;
+    stream << report.data.timestampNs << report.serviceStatus.timestampNs;
+    stream << (quint8)report.data.statusCode << report.data.flags;
+    stream << report.serviceStatus.linkStats.recoveries << report.serviceStatus.linkStats.lastRecoveryMs
+           << report.serviceStatus.linkStats.maxRecoveryMs;
+
     return stream;
 }
 
@@ -86,22 +141,32 @@ using UpsMonitor::UpsState;
 inline QDataStream& operator>>(QDataStream& stream, UpsReport& report)
 {
     qint32 stateInt; // Use a qint32 to read the enum
+    QDateTime dataTime;
+    QDateTime statusTime;
+    double inputVoltage = 0, outputVoltage = 0, batteryVoltage = 0, batteryLevel = 0, temperatureC = 0;
+    qint32 loadPercentage = 0;
+    bool batteryFault = false;
+    QString statusText;
 
     // First the UpsData
-    stream >> report.data.timestamp;
+    stream >> dataTime;
     stream >> stateInt;
     report.data.state = (UpsState)stateInt; // Cast back to the enum
-    stream >> report.data.inputVoltage;
-    stream >> report.data.outputVoltage;
-    stream >> report.data.batteryVoltage;
-    stream >> report.data.batteryLevel;
-    stream >> report.data.temperatureC;
-    stream >> report.data.loadPercentage;
-    stream >> report.data.BatteryFault;
-    stream >> report.data.statusMessage;
+    stream >> inputVoltage >> outputVoltage >> batteryVoltage >> batteryLevel >> temperatureC;
+    stream >> loadPercentage;
+    stream >> batteryFault;
+    stream >> statusText; // Only older services fill it; the status code is authoritative
+    report.data.setInputVoltage(inputVoltage);
+    report.data.setOutputVoltage(outputVoltage);
+    report.data.setBatteryVoltage(batteryVoltage);
+    report.data.setBatteryLevel(batteryLevel);
+    report.data.setTemperatureC(temperatureC);
+    report.data.setLoadPercentage(loadPercentage);
+    report.data.flags = 0;
+    report.data.setBatteryFault(batteryFault);
 
     // Then the UpsServiceStatus
-    stream >> report.serviceStatus.timestamp;
+    stream >> statusTime;
     stream >> report.serviceStatus.driverLoaded;
     stream >> report.serviceStatus.driverInitialized;
     stream >> report.serviceStatus.dataCommunicationActive;
@@ -109,6 +174,50 @@ inline QDataStream& operator>>(QDataStream& stream, UpsReport& report)
     stream >> report.serviceStatus.activeComPort;
     stream >> report.serviceStatus.lastErrorMessage;
 
+    // Absent in reports from older services: keep the stream usable and fall back to the primary UPS
+    if (!stream.atEnd()) {
+        stream >> report.deviceId;
+    } else {
+        report.deviceId.clear();
+    }
+    if (!stream.atEnd()) {
+        stream >> report.serviceStatus.linkStats;
+    } else {
+        report.serviceStatus.linkStats = DriverLinkStats();
+    }
+    qint32 runtime = -1;
+    if (!stream.atEnd()) {
+        stream >> runtime;
+    }
+    report.data.runtimeRemainingSeconds = runtime;
+
+    // Older services only send wall times: map them onto our own clock
+    if (!stream.atEnd()) {
+        stream >> report.data.timestampNs >> report.serviceStatus.timestampNs;
+    } else {
+        report.data.timestampNs = UpsClock::fromDateTime(dataTime);
+        report.serviceStatus.timestampNs = UpsClock::fromDateTime(statusTime);
+    }
+
+    // Older services send text only: derive the code from the state
+    if (!stream.atEnd()) {
+        quint8 code = 0;
+        stream >> code >> report.data.flags;
+        report.data.statusCode = static_cast<UpsMonitor::StatusCode>(code);
+    } else {
+        report.data.statusCode = UpsMonitor::statusCodeForState(report.data.state);
+    }
+
+    // Recovery metrics: not in the fixed DriverLinkStats block, so they follow here
+    if (!stream.atEnd()) {
+        stream >> report.serviceStatus.linkStats.recoveries >> report.serviceStatus.linkStats.lastRecoveryMs
+               >> report.serviceStatus.linkStats.maxRecoveryMs;
+    } else {
+        report.serviceStatus.linkStats.recoveries = 0;
+        report.serviceStatus.linkStats.lastRecoveryMs = 0;
+        report.serviceStatus.linkStats.maxRecoveryMs = 0;
+    }
+
 #ifdef IPC_TEST_DEBUG
 QString upsStatusName = "UNKNOWN";
 
@@ -121,11 +230,12 @@ QString upsStatusName = "UNKNOWN";
 
     // Log the details of the received report.
     if (stream.status() == QDataStream::Ok) {
-        qDebug() << "IPC DEBUG: Report received - Time:" << report.data.timestamp.toString("hh:mm:ss")
+        qCDebug(lcUpsIpc) << "IPC DEBUG: Report received - Time:" << report.data.wallTime().toString("hh:mm:ss")
         << "| Status:" << upsStatusName
-        << "| Battery:" << report.data.batteryLevel << "%";
+        << "| Latency:" << (report.data.timestampNs > 0 ? (UpsClock::nowNs() - report.data.timestampNs) / 1000 : 0) << "us"
+        << "| Battery:" << report.data.batteryLevel() << "%";
     } else {
-        qDebug() << "IPC DEBUG: Error during deserialization of UpsReport.";
+        qCWarning(lcUpsIpc) << "IPC DEBUG: Error during deserialization of UpsReport.";
     }
 #endif
 
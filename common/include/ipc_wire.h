@@ -0,0 +1,319 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ups_report.h"
+#include "ups_clock.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Binary wire format of the reports, for clients that sent {COMMAND=HELLO, FRAMES=binary}.
+ *
+ * Every message is a fixed 32-byte Header followed by 'length' body bytes. A report is a single
+ * Telemetry message whose body is a trivially copyable TelemetryBody, written and read with one
+ * memcpy. The strings of a unit (device ID, driver, port, last error) travel in a Strings message
+ * only when they change; telemetry refers to them by device index. A client that switches to this
+ * format first receives the strings of every known unit.
+ *
+ * Integers are little endian, the byte order of every platform the service runs on, so the
+ * structures go onto the wire as they are. Newer versions append fields to a body: a reader takes
+ * the part it knows and skips the rest (the header carries the length).
+ *
+ * The magic also tells this format from the QDataStream frames of legacy and typed clients: those
+ * start with a big-endian length, which is never as large as the magic read that way.
+ */
+namespace IpcWire {
+
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "The wire structures are sent as they are in memory");
+
+constexpr quint32 MAGIC = 0x5750554C;           // "LUPW" on the wire
+constexpr quint16 VERSION = 1;
+constexpr quint32 MAX_BODY_SIZE = 16 * 1024 * 1024;
+constexpr quint32 MAX_DEVICES = 4096;
+
+enum Type : quint16 {
+    Telemetry = 1,      // Body: TelemetryBody
+    Strings = 2,        // Body: StringsBody, then its strings as UTF-16
+    History = 3,        // Body: UpsHistory::Series through QDataStream (reply to COMMAND=HISTORY)
+};
+
+struct Header {
+    quint32 magic = MAGIC;
+    quint16 version = VERSION;
+    quint16 type = 0;
+    quint32 length = 0;         // Body bytes following the header
+    quint32 reserved = 0;
+    quint64 sequence = 0;       // Order in which the server encoded its messages (shared by all clients)
+    qint64 timestampNs = 0;     // UpsClock stamp of the moment the message was encoded
+};
+static_assert(sizeof(Header) == 32 && std::is_trivially_copyable_v<Header>, "Header is part of the wire format");
+
+struct TelemetryBody {
+    quint32 device = 0;         // Index bound by the latest Strings message for it
+    quint8 driverLoaded = 0;
+    quint8 driverInitialized = 0;
+    quint8 dataCommunicationActive = 0;
+    quint8 reserved = 0;
+    qint64 statusTimestampNs = 0;
+    UpsData data;
+    DriverLinkStats linkStats;
+};
+static_assert(sizeof(TelemetryBody) == 296 && std::is_trivially_copyable_v<TelemetryBody>,
+              "TelemetryBody is part of the wire format: append new fields at the end");
+
+struct StringsBody {
+    quint32 device = 0;
+    quint16 lengths[4] = {};    // UTF-16 code units of the device ID, driver name, port and last error
+};
+static_assert(sizeof(StringsBody) == 12, "StringsBody is part of the wire format");
+
+/**
+ * @brief The strings of one unit, as the encoder last sent them and the decoder last received them.
+ */
+struct DeviceStrings {
+    QString deviceId;
+    QString driverName;
+    QString port;
+    QString lastError;
+};
+
+/**
+ * @brief Server side: turns reports into messages. One encoder serves all binary clients.
+ */
+class Encoder
+{
+public:
+    /**
+     * @brief Appends the messages for @p report to @p out: its strings if they changed, then its telemetry.
+     */
+    void encode(const UpsReport& report, QByteArray& out)
+    {
+        quint32 device = 0;
+        if (updateStrings(report, device)) {
+            appendStrings(device, out);
+        }
+
+        TelemetryBody body;
+        body.device = device;
+        body.driverLoaded = report.serviceStatus.driverLoaded;
+        body.driverInitialized = report.serviceStatus.driverInitialized;
+        body.dataCommunicationActive = report.serviceStatus.dataCommunicationActive;
+        body.statusTimestampNs = report.serviceStatus.timestampNs;
+        body.data = report.data;
+        body.linkStats = report.serviceStatus.linkStats;
+        append(Telemetry, &body, sizeof(body), out);
+    }
+
+    /**
+     * @brief Only records the strings of @p report (while no binary client is connected).
+     */
+    void track(const UpsReport& report)
+    {
+        quint32 device = 0;
+        updateStrings(report, device);
+    }
+
+    /**
+     * @brief The strings of every known unit, for a client that just switched to this format.
+     */
+    QByteArray stringTable()
+    {
+        QByteArray out;
+        for (quint32 device = 0; device < quint32(m_devices.size()); ++device) {
+            appendStrings(device, out);
+        }
+        return out;
+    }
+
+    /**
+     * @brief One message with an opaque body (e.g. History).
+     */
+    QByteArray message(Type type, const QByteArray& body)
+    {
+        QByteArray out;
+        append(type, body.constData(), quint32(body.size()), out);
+        return out;
+    }
+
+private:
+    bool updateStrings(const UpsReport& report, quint32& device)
+    {
+        const UpsServiceStatus& status = report.serviceStatus;
+        auto it = m_index.constFind(report.deviceId);
+        if (it == m_index.constEnd()) {
+            device = quint32(m_devices.size());
+            m_index.insert(report.deviceId, device);
+            m_devices.append(DeviceStrings{ report.deviceId, status.activeDriverName, status.activeComPort,
+                                            status.lastErrorMessage });
+            return true;
+        }
+        device = it.value();
+        DeviceStrings& strings = m_devices[device];
+        if (strings.driverName == status.activeDriverName && strings.port == status.activeComPort
+            && strings.lastError == status.lastErrorMessage) {
+            return false;
+        }
+        strings.driverName = status.activeDriverName;
+        strings.port = status.activeComPort;
+        strings.lastError = status.lastErrorMessage;
+        return true;
+    }
+
+    void appendStrings(quint32 device, QByteArray& out)
+    {
+        const DeviceStrings& strings = m_devices.at(device);
+        const QString* fields[4] = { &strings.deviceId, &strings.driverName, &strings.port, &strings.lastError };
+        StringsBody body;
+        body.device = device;
+        quint32 length = sizeof(body);
+        for (int i = 0; i < 4; ++i) {
+            body.lengths[i] = quint16(qMin<qsizetype>(fields[i]->size(), 0xFFFF));
+            length += body.lengths[i] * sizeof(char16_t);
+        }
+
+        char* p = append(Strings, &body, sizeof(body), out, length);
+        p += sizeof(body);
+        for (int i = 0; i < 4; ++i) {
+            std::memcpy(p, fields[i]->utf16(), body.lengths[i] * sizeof(char16_t));
+            p += body.lengths[i] * sizeof(char16_t);
+        }
+    }
+
+    /**
+     * @brief Appends a header and @p size bytes of @p body, leaving room for @p length bytes in total.
+     * @return The start of the body in @p out.
+     */
+    char* append(Type type, const void* body, quint32 size, QByteArray& out, quint32 length = 0)
+    {
+        Header header;
+        header.type = type;
+        header.length = qMax(size, length);
+        header.sequence = ++m_sequence;
+        header.timestampNs = UpsClock::nowNs();
+
+        const qsizetype at = out.size();
+        out.resize(at + qsizetype(sizeof(header)) + header.length);
+        char* p = out.data() + at;
+        std::memcpy(p, &header, sizeof(header));
+        if (size > 0) {
+            std::memcpy(p + sizeof(header), body, size);
+        }
+        return p + sizeof(header);
+    }
+
+    QHash<QString, quint32> m_index;    // Device ID -> index into m_devices
+    QList<DeviceStrings> m_devices;
+    quint64 m_sequence = 0;
+};
+
+/**
+ * @brief Client side: turns messages back into reports. One decoder per connection.
+ */
+class Decoder
+{
+public:
+    enum class Result {
+        Incomplete,     // Wait for more bytes
+        Report,         // The report was filled
+        Message,        // Any other message (strings are taken over; the body of e.g. History is the caller's)
+        Invalid,        // Not this format, or a version this client does not know
+    };
+
+    /**
+     * @brief True if @p data starts with a message of this format rather than a QDataStream frame.
+     */
+    static bool isMessage(const char* data, qsizetype size)
+    {
+        quint32 magic = 0;
+        if (size < qsizetype(sizeof(magic))) return false;
+        std::memcpy(&magic, data, sizeof(magic));
+        return magic == MAGIC;
+    }
+
+    /**
+     * @brief Decodes the message at the start of @p data.
+     * @param consumed Set to the size of the message (0 unless it is complete).
+     * @param header Set to the message's header; its body starts sizeof(Header) bytes into @p data.
+     */
+    Result decode(const char* data, qsizetype size, qsizetype& consumed, Header& header, UpsReport& report)
+    {
+        consumed = 0;
+        if (size < qsizetype(sizeof(Header))) return Result::Incomplete;
+        std::memcpy(&header, data, sizeof(Header));
+        if (header.magic != MAGIC || header.version != VERSION || header.length > MAX_BODY_SIZE) {
+            return Result::Invalid;
+        }
+        if (size - qsizetype(sizeof(Header)) < qsizetype(header.length)) return Result::Incomplete;
+        consumed = qsizetype(sizeof(Header)) + header.length;
+        const char* body = data + sizeof(Header);
+
+        if (header.type == Telemetry) {
+            if (header.length < sizeof(TelemetryBody)) return Result::Invalid;
+            TelemetryBody telemetry;
+            std::memcpy(&telemetry, body, sizeof(telemetry));
+            if (telemetry.device >= quint32(m_devices.size())) {
+                return Result::Message; // Strings never received (cannot happen on an intact stream)
+            }
+            const DeviceStrings& strings = m_devices.at(telemetry.device);
+            report.data = telemetry.data;
+            report.deviceId = strings.deviceId;
+            UpsServiceStatus& status = report.serviceStatus;
+            status.timestampNs = telemetry.statusTimestampNs;
+            status.driverLoaded = telemetry.driverLoaded;
+            status.driverInitialized = telemetry.driverInitialized;
+            status.dataCommunicationActive = telemetry.dataCommunicationActive;
+            status.activeDriverName = strings.driverName;     // Shared, not copied
+            status.activeComPort = strings.port;
+            status.lastErrorMessage = strings.lastError;
+            status.linkStats = telemetry.linkStats;
+            return Result::Report;
+        }
+
+        if (header.type == Strings) {
+            if (header.length < sizeof(StringsBody)) return Result::Invalid;
+            StringsBody strings;
+            std::memcpy(&strings, body, sizeof(strings));
+            quint32 length = sizeof(strings);
+            for (quint16 units : strings.lengths) length += units * sizeof(char16_t);
+            if (header.length < length || strings.device >= MAX_DEVICES) return Result::Invalid;
+
+            if (strings.device >= quint32(m_devices.size())) m_devices.resize(strings.device + 1);
+            DeviceStrings& device = m_devices[strings.device];
+            QString* fields[4] = { &device.deviceId, &device.driverName, &device.port, &device.lastError };
+            const char* p = body + sizeof(strings);
+            for (int i = 0; i < 4; ++i) {
+                QString text(strings.lengths[i], Qt::Uninitialized);
+                std::memcpy(text.data(), p, strings.lengths[i] * sizeof(char16_t));
+                *fields[i] = std::move(text);
+                p += strings.lengths[i] * sizeof(char16_t);
+            }
+        }
+        return Result::Message; // History, or a type of a newer service
+    }
+
+private:
+    QList<DeviceStrings> m_devices;
+};
+
+} // namespace IpcWire
@@ -0,0 +1,63 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QLoggingCategory>
+
+/**
+ * @brief Logging categories shared by the service, the API library and the drivers.
+ *
+ * Switch them at runtime with filter rules, e.g. "lightups.driver.frames.debug=true"
+ * (QT_LOGGING_RULES, the service's --log-rules option or the LOG_RULES IPC command).
+ * The chatty categories default to info level, so their debug output costs one branch.
+ *
+ * Defined as inline functions (instead of Q_LOGGING_CATEGORY) so this header can be used by
+ * every binary without a separate definition; Qt's registry applies rules to all instances.
+ */
+inline const QLoggingCategory& lcUpsApi()
+{
+    static const QLoggingCategory category("lightups.api");
+    return category;
+}
+
+inline const QLoggingCategory& lcUpsDriver()
+{
+    static const QLoggingCategory category("lightups.driver");
+    return category;
+}
+
+// One message per received frame
+inline const QLoggingCategory& lcUpsFrames()
+{
+    static const QLoggingCategory category("lightups.driver.frames", QtInfoMsg);
+    return category;
+}
+
+// One message per report sent or received over IPC
+inline const QLoggingCategory& lcUpsIpc()
+{
+    static const QLoggingCategory category("lightups.ipc", QtInfoMsg);
+    return category;
+}
+
+inline const QLoggingCategory& lcUpsService()
+{
+    static const QLoggingCategory category("lightups.service");
+    return category;
+}
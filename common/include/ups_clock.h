@@ -0,0 +1,124 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <QDateTime>
+#include <QtGlobal>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+
+/**
+ * @brief Monotonic timestamps for the report pipeline.
+ *
+ * A stamp is a steady-clock time in nanoseconds, taken once when the bytes of a sample arrive and
+ * carried unchanged through UpsData, UpsReport and IPC. The steady clock is system-wide
+ * (QueryPerformanceCounter on Windows, CLOCK_MONOTONIC elsewhere), so stamps taken in the service and
+ * in the GUI can be subtracted directly. Wall time is only derived where a stamp is shown, logged or
+ * stored, from an anchor (wall clock minus steady clock). A system clock change never moves a stamp, but
+ * the anchor follows it: it is re-measured at most once per second and replaced when the system clock
+ * has moved more than ANCHOR_MAX_DRIFT_MS away from it (NTP corrections, manual changes, resume).
+ */
+namespace UpsClock {
+
+/**
+ * @brief The current stamp. Cheaper than QDateTime::currentDateTime(): no time zone conversion.
+ */
+inline qint64 nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Returns @p stampNs, or the current stamp for samples that carry none (0).
+ */
+inline qint64 stampOrNow(qint64 stampNs)
+{
+    return stampNs > 0 ? stampNs : nowNs();
+}
+
+constexpr qint64 ANCHOR_CHECK_INTERVAL_NS = 1000000000;    // How often the anchor is re-measured
+constexpr qint64 ANCHOR_MAX_DRIFT_MS = 1000;                // Drift that replaces it (above ms jitter)
+
+namespace detail {
+struct AnchorState {
+    std::atomic<qint64> offsetMs;   // Wall clock (ms since the epoch) minus steady clock (ms)
+    std::atomic<qint64> checkedNs;  // Stamp of the last measurement
+};
+
+inline qint64 measureOffsetMs(qint64 stampNs)
+{
+    return QDateTime::currentMSecsSinceEpoch() - stampNs / 1000000;
+}
+
+inline AnchorState& anchorState()
+{
+    static AnchorState state{ measureOffsetMs(nowNs()), nowNs() };
+    return state;
+}
+} // namespace detail
+
+/**
+ * @brief The current anchor: wall time in ms = stamp in ms + this offset. Thread-safe and lock-free;
+ * one caller per ANCHOR_CHECK_INTERVAL_NS pays for reading the system clock.
+ */
+inline qint64 wallOffsetMs()
+{
+    detail::AnchorState& state = detail::anchorState();
+    const qint64 now = nowNs();
+    qint64 checked = state.checkedNs.load(std::memory_order_relaxed);
+    if (now - checked >= ANCHOR_CHECK_INTERVAL_NS
+        && state.checkedNs.compare_exchange_strong(checked, now, std::memory_order_relaxed)) {
+        const qint64 measured = detail::measureOffsetMs(now);
+        if (std::abs(measured - state.offsetMs.load(std::memory_order_relaxed)) > ANCHOR_MAX_DRIFT_MS) {
+            state.offsetMs.store(measured, std::memory_order_relaxed);
+        }
+    }
+    return state.offsetMs.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Wall time of @p stampNs in milliseconds since the epoch (0 for no stamp).
+ */
+inline qint64 toMSecsSinceEpoch(qint64 stampNs)
+{
+    if (stampNs <= 0) return 0;
+    return stampNs / 1000000 + wallOffsetMs();
+}
+
+/**
+ * @brief Local wall time of @p stampNs for display; invalid for no stamp.
+ */
+inline QDateTime toDateTime(qint64 stampNs)
+{
+    return stampNs > 0 ? QDateTime::fromMSecsSinceEpoch(toMSecsSinceEpoch(stampNs)) : QDateTime();
+}
+
+/**
+ * @brief Inverse of toDateTime(), for wall times received from older services.
+ */
+inline qint64 fromDateTime(const QDateTime& wallTime)
+{
+    if (!wallTime.isValid()) return 0;
+    return std::max<qint64>(1, (wallTime.toMSecsSinceEpoch() - wallOffsetMs()) * 1000000);
+}
+
+} // namespace UpsClock
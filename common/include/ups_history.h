@@ -0,0 +1,132 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ups_report.h"
+#include <QDataStream>
+#include <QList>
+#include <QString>
+#include <array>
+
+/**
+ * @brief Types shared by the service's sample history (service/history_store.h) and its IPC query.
+ */
+namespace UpsHistory {
+
+/**
+ * @brief The recorded columns, in the integer units of UpsData.
+ */
+enum Field : int {
+    InputMillivolts,
+    OutputMillivolts,
+    BatteryMillivolts,
+    BatteryLevelDeci,
+    TemperatureDeci,
+    LoadPercent,
+    RuntimeSeconds,     // -1 = unknown, included in the aggregates as is
+    FIELD_COUNT
+};
+
+inline const char* fieldName(int field)
+{
+    static const char* const NAMES[FIELD_COUNT] = {
+        "input_mv", "output_mv", "battery_mv", "battery_level_deci", "temperature_deci", "load_pct", "runtime_s"
+    };
+    return (field >= 0 && field < FIELD_COUNT) ? NAMES[field] : "";
+}
+
+inline std::array<qint32, FIELD_COUNT> fieldsOf(const UpsData& data)
+{
+    return { data.inputMillivolts, data.outputMillivolts, data.batteryMillivolts, data.batteryLevelDeci,
+             data.temperatureDeci, data.loadPercentage, data.runtimeRemainingSeconds };
+}
+
+enum class Tier : quint8 {
+    Raw,        // Every forwarded report (after the SampleFilter)
+    Minute,     // 1-minute rollups
+    Hour,       // 1-hour rollups
+};
+
+/**
+ * @brief Length of a rollup bucket. Buckets are aligned on wall-clock minutes and hours (UTC) when they
+ * open; their start is stored as the UpsClock stamp of that moment.
+ */
+constexpr qint64 bucketNs(Tier tier)
+{
+    return tier == Tier::Minute ? 60LL * 1000000000 : tier == Tier::Hour ? 3600LL * 1000000000 : 0;
+}
+
+/**
+ * @brief Result of a history query, column by column. A raw row is one sample (min == max == mean).
+ */
+struct Series {
+    QString deviceId;
+    Tier tier = Tier::Raw;
+    QList<qint64> startNs;      // UpsClock stamp of the sample, or of the bucket start
+    QList<quint32> samples;     // Samples in the row (1 for raw rows)
+    QList<quint8> stateMask;    // Bit (1 << UpsState) for every state seen in the row
+    std::array<QList<qint32>, FIELD_COUNT> min;
+    std::array<QList<qint32>, FIELD_COUNT> max;
+    std::array<QList<qint32>, FIELD_COUNT> mean;
+
+    qsizetype size() const { return startNs.size(); }
+};
+
+} // namespace UpsHistory
+
+/**
+ * @brief Column-wise serialization; raw series carry one value column per field instead of three.
+ */
+inline QDataStream& operator<<(QDataStream& stream, const UpsHistory::Series& series)
+{
+    stream << series.deviceId << (quint8)series.tier << (quint8)UpsHistory::FIELD_COUNT;
+    stream << series.startNs << series.samples << series.stateMask;
+    for (int field = 0; field < UpsHistory::FIELD_COUNT; ++field) {
+        stream << series.mean[field];
+        if (series.tier != UpsHistory::Tier::Raw) {
+            stream << series.min[field] << series.max[field];
+        }
+    }
+    return stream;
+}
+
+inline QDataStream& operator>>(QDataStream& stream, UpsHistory::Series& series)
+{
+    quint8 tier = 0;
+    quint8 fields = 0;
+    stream >> series.deviceId >> tier >> fields;
+    series.tier = static_cast<UpsHistory::Tier>(tier);
+    stream >> series.startNs >> series.samples >> series.stateMask;
+    for (int field = 0; field < fields; ++field) {
+        // Columns of fields this reader does not know are read and dropped
+        QList<qint32> mean, min, max;
+        stream >> mean;
+        if (series.tier != UpsHistory::Tier::Raw) {
+            stream >> min >> max;
+        } else {
+            min = max = mean;
+        }
+        if (field < UpsHistory::FIELD_COUNT) {
+            series.mean[field] = mean;
+            series.min[field] = min;
+            series.max[field] = max;
+        }
+    }
+    return stream;
+}
@@ -22,12 +22,15 @@
 #include <QDateTime>
 #include <QMetaType>
 #include <QObject>
+#include <array>
+#include <type_traits>
+#include "ups_clock.h"
 
 // --- NAMESPACE VOOR ENUMS ---
 namespace UpsMonitor {
 Q_NAMESPACE
 
-enum class UpsState {
+enum class UpsState : quint8 {
     Unknown,            // Priority 1: Unknown status / IPC Error
     OnlineFull,         // Priority 5: Online, Battery Full/Trickle charging (Vin OK, No Large Current)
     OnlineCharging,     // Priority 4: Online, Battery Charging (Vin OK, Large Current)
@@ -36,36 +39,139 @@ enum class UpsState {
     BatteryCritical,    // Priority 2: Running on Battery, Critically Low (Bit 1 ON)
 };
 Q_ENUM_NS(UpsState)
+
+/**
+ * @brief What the status line says. Samples carry the code; the text is translated where it is shown (ups_status_text.h).
+ */
+enum class StatusCode : quint8 {
+    None,               // No status line
+    Initializing,       // Driver created, nothing received yet
+    WaitingForData,     // Connected, waiting for the first sample
+    NoConnection,       // The API has no data from the driver
+    ConnectionLost,     // The driver lost its port and is recovering
+    OnlineFull,
+    OnlineCharging,
+    InputFault,
+    OnBattery,
+    BatteryCritical,
+    Simulated,          // Test and template drivers
+};
+Q_ENUM_NS(StatusCode)
+
+/**
+ * @brief The status line that belongs to a decoded UPS state.
+ */
+constexpr StatusCode statusCodeForState(UpsState state)
+{
+    switch (state) {
+    case UpsState::BatteryCritical: return StatusCode::BatteryCritical;
+    case UpsState::OnBattery:       return StatusCode::OnBattery;
+    case UpsState::OnlineFault:     return StatusCode::InputFault;
+    case UpsState::OnlineCharging:  return StatusCode::OnlineCharging;
+    case UpsState::OnlineFull:      return StatusCode::OnlineFull;
+    case UpsState::Unknown:         break;
+    }
+    return StatusCode::None;
+}
 }
 // --- END NAMESPACE ---
 
 /**
  * @brief Universal structure for UPS data (combined with critical status).
+ *
+ * Trivially copyable and fixed-size: measurements are stored as integers (millivolts, tenths)
+ * and the status line as a code, so passing a sample around never allocates.
+ * The accessors convert to and from the familiar units.
  */
 struct UpsData {
-    QDateTime timestamp;
-    UpsMonitor::UpsState state = UpsMonitor::UpsState::Unknown; // <--- CHANGE DEFAULT VALUE HERE; // The enumerated status (NEW)
-    double inputVoltage =0.0;        // In Volts (V)
-    double outputVoltage =0.0;       // In Volts (V)
-    double batteryVoltage =0.0;      // In Volts (V)
-    double batteryLevel =0.0;        // In percentage (%)
-    double temperatureC =0.0;        // In degrees Celsius
-    int loadPercentage =0;           // Load in percentage (%)
-    bool BatteryFault = false;       // True if the battery needs replacement
-    QString statusMessage = "Initialiseren..."; // Provide a clear start value; // Short status (e.g., "OK", "Low Battery")
+    static constexpr quint8 FLAG_BATTERY_FAULT = 0x01; // The battery needs replacement
+
+    qint64 timestampNs = 0;          // UpsClock stamp of the bytes this sample was decoded from, 0 = none
+    qint32 inputMillivolts = 0;
+    qint32 outputMillivolts = 0;
+    qint32 batteryMillivolts = 0;
+    qint32 runtimeRemainingSeconds = -1; // Estimated runtime on battery at the present load, -1 = unknown
+    qint16 batteryLevelDeci = 0;     // In 0.1 %; drivers that cannot measure it report -1 % and the API estimates it
+    qint16 temperatureDeci = 0;      // In 0.1 degrees Celsius
+    quint8 loadPercentage = 0;       // Load in percentage (%)
+    UpsMonitor::UpsState state = UpsMonitor::UpsState::Unknown;
+    UpsMonitor::StatusCode statusCode = UpsMonitor::StatusCode::Initializing;
+    quint8 flags = 0;                // FLAG_* bits
+
+    double inputVoltage() const { return inputMillivolts / 1000.0; }
+    double outputVoltage() const { return outputMillivolts / 1000.0; }
+    double batteryVoltage() const { return batteryMillivolts / 1000.0; }
+    double batteryLevel() const { return batteryLevelDeci / 10.0; }
+    double temperatureC() const { return temperatureDeci / 10.0; }
+    bool batteryFault() const { return flags & FLAG_BATTERY_FAULT; }
+
+    void setInputVoltage(double volts) { inputMillivolts = qRound(volts * 1000.0); }
+    void setOutputVoltage(double volts) { outputMillivolts = qRound(volts * 1000.0); }
+    void setBatteryVoltage(double volts) { batteryMillivolts = qRound(volts * 1000.0); }
+    void setBatteryLevel(double percent) { batteryLevelDeci = static_cast<qint16>(qRound(percent * 10.0)); }
+    void setTemperatureC(double celsius) { temperatureDeci = static_cast<qint16>(qRound(celsius * 10.0)); }
+    void setLoadPercentage(int percent) { loadPercentage = static_cast<quint8>(qBound(0, percent, 100)); }
+    void setBatteryFault(bool fault) { flags = static_cast<quint8>(fault ? (flags | FLAG_BATTERY_FAULT) : (flags & ~FLAG_BATTERY_FAULT)); }
+
+    /**
+     * @brief Wall time of the sample, for display only (invalid without a stamp).
+     */
+    QDateTime wallTime() const { return UpsClock::toDateTime(timestampNs); }
+};
+static_assert(std::is_trivially_copyable_v<UpsData>, "UpsData must stay trivially copyable");
+static_assert(sizeof(UpsData) == 32, "UpsData layout changed; keep it compact");
+
+/**
+ * @brief Link health counters of a driver (see IUpsDriver::linkStats()). All counters are totals since the driver started.
+ */
+struct DriverLinkStats {
+    // Bucket i counts latencies in [2^i, 2^(i+1)) microseconds; bucket 0 also holds 0-1 us, the last bucket is open-ended.
+    static constexpr int LATENCY_BUCKETS = 20;
+
+    quint64 bytesRead = 0;              // Raw bytes received from the port
+    quint64 framesDecoded = 0;          // Valid frames
+    quint64 checksumFailures = 0;       // Candidate frames with a bad checksum or end marker
+    quint64 resyncBytesDiscarded = 0;   // Garbage skipped while searching for a frame start
+    quint64 bufferOverruns = 0;         // Reads that hit the receive buffer limit, or a forced ring-buffer flush
+    quint64 handshakeRetries = 0;       // Handshake commands sent beyond the first attempt
+    quint64 reconnects = 0;             // Port re-opened after it had been open before
+    quint64 serialErrors = 0;           // Port errors reported by the OS (disconnects, I/O errors)
+    quint64 recoveries = 0;             // Outages that ended with data flowing again
+    quint64 lastRecoveryMs = 0;         // Time to recover: first failure -> first valid sample
+    quint64 maxRecoveryMs = 0;
+    std::array<quint64, LATENCY_BUCKETS> latencyHistogram{}; // Byte arrival -> dataReceived, in microseconds
+
+    /**
+     * @brief Approximate latency percentile (upper bound of the bucket), in microseconds. 0 if empty.
+     */
+    quint64 latencyPercentileUs(double percentile) const
+    {
+        quint64 total = 0;
+        for (quint64 count : latencyHistogram) total += count;
+        if (total == 0) return 0;
+
+        const quint64 target = static_cast<quint64>(percentile / 100.0 * total);
+        quint64 seen = 0;
+        for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+            seen += latencyHistogram[i];
+            if (seen > target) return quint64(1) << (i + 1);
+        }
+        return quint64(1) << LATENCY_BUCKETS;
+    }
 };
 
 /**
  * @brief Status of the UPS monitoring service (the API layer), including the Driver status.
  */
 struct UpsServiceStatus {
-    QDateTime timestamp;
+    qint64 timestampNs = 0;             // UpsClock stamp of the moment the report was emitted
     bool driverLoaded = false;          // Was the plugin DLL/SO successfully loaded?
     bool driverInitialized = false;     // Was the initialize() method successfully executed?
     bool dataCommunicationActive = false; // Are dataReceived signals currently being received?
     QString activeDriverName;           // Name of the active driver
     QString activeComPort;              // The port being used
     QString lastErrorMessage;           // The most recent critical error
+    DriverLinkStats linkStats;          // Counters of the active driver (zero when no driver runs)
 };
 
 /**
@@ -74,10 +180,12 @@ struct UpsServiceStatus {
 struct UpsReport {
     UpsData data;
     UpsServiceStatus serviceStatus;
+    QString deviceId;                   // The UPS this report belongs to (AppConstants::PRIMARY_DEVICE_ID for the configured unit)
 };
 
 // Register the types for Qt's signal/slot system
 Q_DECLARE_METATYPE(UpsMonitor::UpsState)
 Q_DECLARE_METATYPE(UpsData)
+Q_DECLARE_METATYPE(DriverLinkStats)
 Q_DECLARE_METATYPE(UpsServiceStatus)
 Q_DECLARE_METATYPE(UpsReport)
@@ -0,0 +1,45 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ups_report.h"
+#include <QCoreApplication>
+#include <QString>
+
+/**
+ * @brief The translated status line for @p code. Call it where the text is shown, not per sample.
+ */
+inline QString upsStatusText(UpsMonitor::StatusCode code)
+{
+    using UpsMonitor::StatusCode;
+    switch (code) {
+    case StatusCode::None:            return QString();
+    case StatusCode::Initializing:    return QCoreApplication::translate("UpsStatus", "Initializing...");
+    case StatusCode::WaitingForData:  return QCoreApplication::translate("UpsStatus", "Connected, waiting for data...");
+    case StatusCode::NoConnection:    return QCoreApplication::translate("UpsStatus", "No active connection");
+    case StatusCode::ConnectionLost:  return QCoreApplication::translate("UpsStatus", "USB Connection lost (Recovering...)");
+    case StatusCode::OnlineFull:      return QCoreApplication::translate("UpsStatus", "Online (AC OK, Battery Full/Trickle Charging).");
+    case StatusCode::OnlineCharging:  return QCoreApplication::translate("UpsStatus", "Battery is Actively Charging.");
+    case StatusCode::InputFault:      return QCoreApplication::translate("UpsStatus", "Warning: Input Problem/Network Error.");
+    case StatusCode::OnBattery:       return QCoreApplication::translate("UpsStatus", "On Battery (Power Outage).");
+    case StatusCode::BatteryCritical: return QCoreApplication::translate("UpsStatus", "CRITICAL: Battery Low. Shutdown required.");
+    case StatusCode::Simulated:       return QCoreApplication::translate("UpsStatus", "Template Mode: System OK");
+    }
+    return QString();
+}
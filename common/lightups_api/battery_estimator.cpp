@@ -0,0 +1,161 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "battery_estimator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double PEUKERT_EXPONENT = 1.15;
+constexpr double MIN_EFFECTIVE_LOAD = 0.05;     // Electronics draw something even at "0%" load
+constexpr double FLOAT_VOLTAGE_PER_BLOCK = 13.5;
+constexpr double REST_VOLTAGE_PER_BLOCK = 12.2;
+constexpr double CHARGE_OFFSET_PER_BLOCK = 0.6; // Charger lifts the terminal voltage above the resting curve
+constexpr double SOC_SMOOTHING_MS = 20000.0;    // Time constant of the SoC low-pass filter
+constexpr qint64 DRAIN_WINDOW_MS = 60000;       // Minimum window before the drain rate is re-fitted
+constexpr double DRAIN_WINDOW_MIN_DROP = 2.0;   // ... and minimum SoC drop (%) in that window
+constexpr double DRAIN_LEARN_WEIGHT = 0.3;
+constexpr int MAX_RUNTIME_SECONDS = 24 * 3600;
+
+bool isOnBattery(UpsMonitor::UpsState state)
+{
+    return state == UpsMonitor::UpsState::OnBattery || state == UpsMonitor::UpsState::BatteryCritical;
+}
+} // namespace
+
+double BatteryTables::socFromBlockVoltage(double blockVoltage, double loadPercent)
+{
+    const double load = std::clamp(loadPercent, 0.0, 100.0);
+    const int lower = std::min(static_cast<int>(load / 25.0), LOAD_ROWS - 2);
+    const double weight = (load - lower * 25.0) / 25.0;
+    const auto& a = VOLTAGE_TABLE[lower];
+    const auto& b = VOLTAGE_TABLE[lower + 1];
+
+    // Walk the curve for this load (rows interpolated on the fly); 11 points, so O(1)
+    double previous = a[0] + weight * (b[0] - a[0]);
+    if (blockVoltage <= previous) return 0.0;
+    for (int i = 1; i < SOC_POINTS; ++i) {
+        const double current = a[i] + weight * (b[i] - a[i]);
+        if (blockVoltage < current) {
+            return (i - 1) * 10.0 + 10.0 * (blockVoltage - previous) / (current - previous);
+        }
+        previous = current;
+    }
+    return 100.0;
+}
+
+BatteryEstimator::BatteryEstimator(const BatteryEstimatorConfig& config)
+{
+    setConfig(config);
+}
+
+void BatteryEstimator::setConfig(const BatteryEstimatorConfig& config)
+{
+    m_config = config;
+    m_nominalDrainRate = 100.0 / std::max(1, m_config.fullLoadRuntimeSeconds);
+    m_drainRate = m_nominalDrainRate;
+    m_blocks = std::max(0, m_config.batteryBlocks);
+    m_blocksLocked = m_blocks > 0;
+    resetDrainWindow();
+}
+
+void BatteryEstimator::resetDrainWindow()
+{
+    m_windowOpen = false;
+    m_windowLoadSeconds = 0.0;
+}
+
+void BatteryEstimator::learnDrain(double soc, double effectiveLoad, qint64 nowMs)
+{
+    if (!m_windowOpen) {
+        m_windowOpen = true;
+        m_windowStartMs = nowMs;
+        m_windowStartSoc = soc;
+        m_windowLoadSeconds = 0.0;
+        return;
+    }
+
+    m_windowLoadSeconds += effectiveLoad * (nowMs - m_lastMs) / 1000.0;
+
+    const double drop = m_windowStartSoc - soc;
+    if (nowMs - m_windowStartMs < DRAIN_WINDOW_MS || drop < DRAIN_WINDOW_MIN_DROP || m_windowLoadSeconds <= 0.0) {
+        return;
+    }
+
+    // Observed % per (effective load * second), kept within a sane range of the nominal model
+    const double observed = std::clamp(drop / m_windowLoadSeconds, m_nominalDrainRate / 4.0, m_nominalDrainRate * 4.0);
+    m_drainRate += DRAIN_LEARN_WEIGHT * (observed - m_drainRate);
+
+    m_windowStartMs = nowMs;
+    m_windowStartSoc = soc;
+    m_windowLoadSeconds = 0.0;
+}
+
+void BatteryEstimator::update(UpsData& sample, qint64 nowMs)
+{
+    const bool onBattery = isOnBattery(sample.state);
+    const double voltage = sample.batteryVoltage();
+
+    // Block count: the float voltage on mains is unambiguous, a discharging battery is not
+    if (!m_blocksLocked && voltage > 0.0) {
+        if (!onBattery && sample.state != UpsMonitor::UpsState::Unknown) {
+            m_blocks = std::max(1, static_cast<int>(std::lround(voltage / FLOAT_VOLTAGE_PER_BLOCK)));
+            m_blocksLocked = true;
+        } else if (m_blocks == 0) {
+            m_blocks = std::max(1, static_cast<int>(std::lround(voltage / REST_VOLTAGE_PER_BLOCK)));
+        }
+    }
+
+    // State of charge: reported by the driver, or looked up in the load-compensated tables
+    double soc = sample.batteryLevel();
+    if (soc < 0.0) {
+        if (m_blocks == 0 || voltage <= 0.0) {
+            sample.batteryLevelDeci = 0;
+            sample.runtimeRemainingSeconds = -1;
+            m_lastMs = nowMs;
+            return;
+        }
+        const double blockVoltage = voltage / m_blocks;
+        if (sample.state == UpsMonitor::UpsState::OnlineFull) {
+            soc = 100.0;
+        } else if (sample.state == UpsMonitor::UpsState::OnlineCharging) {
+            soc = std::min(99.0, BatteryTables::socFromBlockVoltage(blockVoltage - CHARGE_OFFSET_PER_BLOCK, 0.0));
+        } else {
+            soc = BatteryTables::socFromBlockVoltage(blockVoltage, onBattery ? sample.loadPercentage : 0.0);
+        }
+
+        if (m_soc >= 0.0 && onBattery) {
+            const double alpha = std::min(1.0, (nowMs - m_lastMs) / SOC_SMOOTHING_MS);
+            soc = m_soc + alpha * (soc - m_soc);
+        }
+        sample.setBatteryLevel(soc);
+    }
+    m_soc = soc;
+
+    const double effectiveLoad = std::pow(std::max(MIN_EFFECTIVE_LOAD, sample.loadPercentage / 100.0), PEUKERT_EXPONENT);
+    if (onBattery) {
+        learnDrain(soc, effectiveLoad, nowMs);
+    } else {
+        resetDrainWindow();
+    }
+    m_lastMs = nowMs;
+
+    // Runtime at the present load; on mains this is what an outage right now would leave
+    const double runtime = soc / (m_drainRate * effectiveLoad);
+    sample.runtimeRemainingSeconds = static_cast<int>(std::min<double>(runtime, MAX_RUNTIME_SECONDS));
+}
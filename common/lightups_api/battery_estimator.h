@@ -0,0 +1,134 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATTERY_ESTIMATOR_H
+#define BATTERY_ESTIMATOR_H
+
+#include "lightups_api_global.h"
+#include "ups_report.h"
+#include <array>
+
+/**
+ * @brief Settings of the BatteryEstimator. The defaults fit a small line-interactive UPS with 12 V lead-acid blocks.
+ */
+struct BatteryEstimatorConfig {
+    int batteryBlocks = 0;              // 12 V blocks in series; 0 = detect from the float voltage
+    int fullLoadRuntimeSeconds = 300;   // Runtime of a full battery at 100% load (starting point of the model)
+};
+
+/**
+ * @brief Voltage -> state-of-charge tables for one 12 V lead-acid block, built at compile time.
+ *
+ * Row 0 is the resting curve (10.5 V = 0%, 11.8 V = 50%, 12.8 V = 100%), the other rows
+ * add the voltage sag at 25/50/75/100% load. The sag grows as the battery empties.
+ */
+namespace BatteryTables {
+constexpr int SOC_POINTS = 11;          // 0, 10, ..., 100 %
+constexpr int LOAD_ROWS = 5;            // 0, 25, 50, 75, 100 % load
+using Table = std::array<std::array<double, SOC_POINTS>, LOAD_ROWS>;
+
+constexpr double restVoltage(double soc)
+{
+    return soc <= 50.0 ? 10.5 + soc * (1.3 / 50.0)
+                       : 11.8 + (soc - 50.0) * (1.0 / 50.0);
+}
+
+constexpr double sagVoltage(double loadPercent, double soc)
+{
+    return (loadPercent / 100.0) * (0.5 + 0.3 * (1.0 - soc / 100.0));
+}
+
+constexpr Table makeTable()
+{
+    Table table{};
+    for (int row = 0; row < LOAD_ROWS; ++row) {
+        for (int i = 0; i < SOC_POINTS; ++i) {
+            const double soc = i * 10.0;
+            table[row][i] = restVoltage(soc) - sagVoltage(row * 25.0, soc);
+        }
+    }
+    return table;
+}
+
+constexpr Table VOLTAGE_TABLE = makeTable();
+
+constexpr bool isMonotonic(const Table& table)
+{
+    for (int row = 0; row < LOAD_ROWS; ++row) {
+        for (int i = 1; i < SOC_POINTS; ++i) {
+            if (table[row][i] <= table[row][i - 1]) return false;
+            if (row > 0 && table[row][i] >= table[row - 1][i]) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isMonotonic(VOLTAGE_TABLE), "SoC curves must rise with charge and drop with load");
+static_assert(VOLTAGE_TABLE[0][0] == 10.5 && VOLTAGE_TABLE[0][SOC_POINTS - 1] == 12.8);
+
+/**
+ * @brief State of charge (0-100 %) of one block at @p blockVoltage under @p loadPercent load.
+ */
+double socFromBlockVoltage(double blockVoltage, double loadPercent);
+} // namespace BatteryTables
+
+/**
+ * @brief Incremental state-of-charge and runtime estimator, O(1) per sample.
+ *
+ * Fills UpsData::batteryLevel when the driver leaves it negative (not measured), and always
+ * fills UpsData::runtimeRemainingSeconds. Runtime follows a Peukert-style drain model
+ * (drain ~ load^1.15) whose rate is re-fitted to the observed discharge during every outage.
+ * Not thread-safe; each driver slot owns one instance in its reactor thread.
+ */
+class UPS_API_LIBRARY_EXPORT BatteryEstimator
+{
+public:
+    explicit BatteryEstimator(const BatteryEstimatorConfig& config = BatteryEstimatorConfig());
+
+    void setConfig(const BatteryEstimatorConfig& config);
+
+    /**
+     * @brief Updates the model with @p sample and writes the estimates into it. @p nowMs is UpsClock time in milliseconds.
+     */
+    void update(UpsData& sample, qint64 nowMs);
+    void update(UpsData& sample) { update(sample, UpsClock::stampOrNow(sample.timestampNs) / 1000000); }
+
+    int batteryBlocks() const { return m_blocks; }
+    double drainRatePerLoad() const { return m_drainRate; } // % SoC per second at 100% load
+
+private:
+    void learnDrain(double soc, double effectiveLoad, qint64 nowMs);
+    void resetDrainWindow();
+
+    BatteryEstimatorConfig m_config;
+
+    int m_blocks = 0;                   // Detected or configured block count, 0 = not known yet
+    bool m_blocksLocked = false;        // Detected on mains (float voltage); provisional otherwise
+    double m_soc = -1.0;                // Smoothed state of charge, -1 = no estimate yet
+    double m_drainRate = 0.0;           // Model rate: % per second at 100% effective load
+    double m_nominalDrainRate = 0.0;
+
+    // Discharge window used to re-fit m_drainRate
+    bool m_windowOpen = false;
+    qint64 m_windowStartMs = 0;
+    double m_windowStartSoc = 0.0;
+    double m_windowLoadSeconds = 0.0;   // Integral of effective load over the window
+    qint64 m_lastMs = 0;
+};
+
+#endif // BATTERY_ESTIMATOR_H
@@ -0,0 +1,174 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "config_store.h"
+#include "constants.h"
+#include "registry_watcher.h"
+#include <QDebug>
+#include <QSettings>
+#include <QThread>
+
+UpsConfig UpsConfig::fromValues(const QVariantMap& values)
+{
+    using namespace AppConstants;
+    UpsConfig config;
+    config.driverFileName = values.value(REG_KEY_SELECTED_DRIVER_FILE).toString();
+    config.comPort = values.value(REG_KEY_SELECTED_COM_PORT).toString();
+
+    // "Devices/<id>/<key>": the keys of a group are adjacent in the sorted map
+    const QString devicePrefix = REG_GROUP_DEVICES + QLatin1Char('/');
+    for (auto it = values.lowerBound(devicePrefix); it != values.constEnd() && it.key().startsWith(devicePrefix); ++it) {
+        const QStringList parts = it.key().split(QLatin1Char('/'));
+        if (parts.size() != 3 || parts.at(1) == PRIMARY_DEVICE_ID) continue;
+        UpsDeviceConfig& device = config.devices[parts.at(1)];
+        if (parts.at(2) == REG_KEY_DEVICE_DRIVER) {
+            device.driverFileName = it.value().toString();
+        } else if (parts.at(2) == REG_KEY_DEVICE_PORT) {
+            device.port = it.value().toString();
+        }
+    }
+
+    config.shutdownDelaySeconds = values.value(REG_KEY_SHUTDOWN_DELAY, 30).toInt();
+    config.powerSafeEnabled = values.value(REG_KEY_POWER_SAFE_ENABLED, false).toBool();
+    config.runtimeMarginSeconds = qMax(0, values.value(REG_KEY_RUNTIME_MARGIN, 0).toInt());
+
+    config.reactorThreads = values.value(REG_KEY_REACTOR_THREADS, 1).toInt();
+    config.hangThresholdMs = values.value(REG_KEY_HANG_THRESHOLD_MS, 5000).toInt();
+    config.filterEnabled = values.value(REG_KEY_FILTER_ENABLED, true).toBool();
+    config.filterHeartbeatMs = qMax(100, values.value(REG_KEY_FILTER_HEARTBEAT_MS, 10000).toInt());
+    config.autoDetect = values.value(REG_KEY_AUTO_DETECT, true).toBool();
+    config.probeTimeoutMs = qMax(500, values.value(REG_KEY_PROBE_TIMEOUT_MS, 2500).toInt());
+    config.batteryBlocks = qMax(0, values.value(REG_KEY_BATTERY_BLOCKS, 0).toInt());
+    config.fullLoadRuntimeSeconds = qMax(10, values.value(REG_KEY_FULL_LOAD_RUNTIME, 300).toInt());
+    config.historyFile = values.value(REG_KEY_HISTORY_FILE).toString();
+    return config;
+}
+
+UpsConfig::Fields UpsConfig::differences(const UpsConfig& other) const
+{
+    Fields fields;
+    fields.setFlag(Field::PrimaryUps, driverFileName != other.driverFileName || comPort != other.comPort);
+    fields.setFlag(Field::Devices, devices != other.devices);
+    fields.setFlag(Field::ShutdownDelay, shutdownDelaySeconds != other.shutdownDelaySeconds);
+    fields.setFlag(Field::PowerSafe, powerSafeEnabled != other.powerSafeEnabled);
+    fields.setFlag(Field::RuntimeMargin, runtimeMarginSeconds != other.runtimeMarginSeconds);
+    fields.setFlag(Field::ReactorThreads, reactorThreads != other.reactorThreads);
+    fields.setFlag(Field::HangThreshold, hangThresholdMs != other.hangThresholdMs);
+    fields.setFlag(Field::SampleFilter, filterEnabled != other.filterEnabled || filterHeartbeatMs != other.filterHeartbeatMs);
+    fields.setFlag(Field::AutoDetect, autoDetect != other.autoDetect || probeTimeoutMs != other.probeTimeoutMs);
+    fields.setFlag(Field::BatteryModel, batteryBlocks != other.batteryBlocks
+                                            || fullLoadRuntimeSeconds != other.fullLoadRuntimeSeconds);
+    fields.setFlag(Field::HistoryFile, historyFile != other.historyFile);
+    return fields;
+}
+
+ConfigStore& ConfigStore::instance()
+{
+    // Never destroyed: components may still read it while the application object goes away
+    static ConfigStore *store = new ConfigStore();
+    return *store;
+}
+
+ConfigStore::ConfigStore()
+    : m_current(std::make_shared<const UpsConfig>())
+{
+    publish(RegistryWatcher::readSettings());
+}
+
+bool ConfigStore::startWatching()
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    if (m_watcher) return true;
+
+    m_watcher = new RegistryWatcher(this);
+    connect(m_watcher, &RegistryWatcher::settingsChanged, this, &ConfigStore::onSettingsChanged);
+    if (!m_watcher->startWatching()) {
+        return false;
+    }
+    // The watcher's baseline is read now: catch up with edits made since the first load
+    reload();
+    return true;
+}
+
+void ConfigStore::stopWatching()
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    delete m_watcher;
+    m_watcher = nullptr;
+}
+
+UpsConfig::Fields ConfigStore::reload()
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    return publish(RegistryWatcher::readSettings());
+}
+
+bool ConfigStore::apply(const QVariantMap& changes, const QStringList& removals)
+{
+    Q_ASSERT(QThread::currentThread() == thread());
+    QSettings settings(AppConstants::SETTINGS_SCOPE, AppConstants::APP_ORGANIZATION_NAME, AppConstants::APP_APPLICATION_NAME);
+    QVariantMap values = m_values;
+    for (auto it = changes.constBegin(); it != changes.constEnd(); ++it) {
+        settings.setValue(it.key(), it.value());
+        values.insert(it.key(), it.value());
+    }
+    for (const QString& key : removals) {
+        settings.remove(key);
+        // Removing a group removes the keys inside it
+        const QString group = key + QLatin1Char('/');
+        values.remove(key);
+        for (auto it = values.lowerBound(group); it != values.end() && it.key().startsWith(group);) {
+            it = values.erase(it);
+        }
+    }
+    settings.sync();
+    if (settings.status() != QSettings::NoError) {
+        qWarning() << "ConfigStore: Cannot write the settings:" << settings.status();
+        reload(); // Some keys may have been written: keep the snapshot equal to the store
+        return false;
+    }
+
+    const UpsConfig::Fields fields = publish(values);
+    qDebug() << "ConfigStore: Applied" << changes.size() << "changes," << removals.size() << "removals; version"
+             << version() << (fields ? "published" : "unchanged");
+    return true;
+}
+
+UpsConfig::Fields ConfigStore::publish(const QVariantMap& values)
+{
+    m_values = values;
+    auto next = std::make_shared<UpsConfig>(UpsConfig::fromValues(values));
+    std::shared_ptr<const UpsConfig> previous = snapshot();
+    const UpsConfig::Fields fields = previous->version == 0 ? ~UpsConfig::Fields() : next->differences(*previous);
+    if (!fields) {
+        return fields; // e.g. our own write coming back through the watcher
+    }
+
+    next->version = previous->version + 1;
+    m_current.store(next, std::memory_order_release);
+    emit changed(ConfigDiff{ previous, next, fields });
+    return fields;
+}
+
+void ConfigStore::onSettingsChanged(const SettingsDiff& diff)
+{
+    const UpsConfig::Fields fields = publish(diff.values);
+    if (fields) {
+        qDebug() << "ConfigStore: Settings changed externally; version" << version();
+    }
+}
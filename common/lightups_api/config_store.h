@@ -0,0 +1,180 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include "lightups_api_global.h"
+#include <QFlags>
+#include <QMap>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <atomic>
+#include <memory>
+
+class RegistryWatcher;
+struct SettingsDiff;
+
+/**
+ * @brief An additional UPS unit ("Devices/<id>/Driver" and "Devices/<id>/Port").
+ */
+struct UpsDeviceConfig {
+    QString driverFileName;
+    QString port;
+
+    bool isComplete() const { return !driverFileName.isEmpty() && !port.isEmpty(); }
+    bool operator==(const UpsDeviceConfig& other) const = default;
+};
+
+/**
+ * @brief One typed, immutable snapshot of all settings (see the keys in constants.h).
+ *
+ * Values are parsed and clamped once, when the snapshot is built, so readers use them as they are.
+ */
+struct UPS_API_LIBRARY_EXPORT UpsConfig {
+    enum class Field : quint32 {
+        PrimaryUps      = 0x0001,   // SelectedDriver, SelectedComPort
+        Devices         = 0x0002,
+        ShutdownDelay   = 0x0004,
+        PowerSafe       = 0x0008,
+        RuntimeMargin   = 0x0010,
+        ReactorThreads  = 0x0020,
+        HangThreshold   = 0x0040,
+        SampleFilter    = 0x0080,   // SampleFilterEnabled, SampleFilterHeartbeatMs
+        AutoDetect      = 0x0100,   // AutoDetect, ProbeTimeoutMs
+        BatteryModel    = 0x0200,   // BatteryBlocks, FullLoadRuntimeSeconds
+        HistoryFile     = 0x0400,
+    };
+    Q_DECLARE_FLAGS(Fields, Field)
+
+    quint64 version = 0;            // 0 = nothing loaded yet; +1 for every published change
+
+    QString driverFileName;
+    QString comPort;
+    QMap<QString, UpsDeviceConfig> devices;     // By device ID, without the primary UPS
+
+    int shutdownDelaySeconds = 30;  // <= 0 disables the shutdown
+    bool powerSafeEnabled = false;
+    int runtimeMarginSeconds = 0;   // 0 = off; only used while shutdownDelaySeconds > 0
+
+    int reactorThreads = 1;
+    int hangThresholdMs = 5000;
+    bool filterEnabled = true;
+    int filterHeartbeatMs = 10000;
+    bool autoDetect = true;
+    int probeTimeoutMs = 2500;
+    int batteryBlocks = 0;
+    int fullLoadRuntimeSeconds = 300;
+    QString historyFile;            // Empty = default location, "off" = disabled
+
+    /**
+     * @brief Builds a snapshot from the flat settings map ("Group/Key" -> value), with defaults.
+     */
+    static UpsConfig fromValues(const QVariantMap& values);
+
+    /**
+     * @brief The fields whose value differs from @p other (the version is not compared).
+     */
+    Fields differences(const UpsConfig& other) const;
+};
+Q_DECLARE_OPERATORS_FOR_FLAGS(UpsConfig::Fields)
+
+/**
+ * @brief One published change: both snapshots and the fields that differ between them.
+ */
+struct ConfigDiff {
+    std::shared_ptr<const UpsConfig> previous;
+    std::shared_ptr<const UpsConfig> current;
+    UpsConfig::Fields fields;
+};
+Q_DECLARE_METATYPE(ConfigDiff)
+
+/**
+ * @brief The process's configuration: the settings store as a versioned, typed snapshot.
+ *
+ * snapshot() returns the current UpsConfig; a new one replaces it atomically, so any thread may
+ * read it without a lock and keeps a consistent view for as long as it holds the pointer.
+ *
+ * Changes come from the settings watcher (edits from outside), reload() and apply(). apply() writes
+ * a set of keys in one go and publishes them as one version, with one changed() notification; when
+ * the watcher then sees that write, the snapshot is unchanged and nothing is published again.
+ * Components subscribe() to the fields they depend on, so e.g. a new shutdown delay never reaches
+ * the drivers.
+ *
+ * Publishing (reload(), apply(), the watcher) happens on the thread that first used instance().
+ */
+class UPS_API_LIBRARY_EXPORT ConfigStore : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief The process-wide store; the first call loads the settings.
+     */
+    static ConfigStore& instance();
+
+    std::shared_ptr<const UpsConfig> snapshot() const { return m_current.load(std::memory_order_acquire); }
+    quint64 version() const { return snapshot()->version; }
+
+    /**
+     * @brief Follows changes made by other processes (registry key or settings file).
+     */
+    bool startWatching();
+    void stopWatching();
+
+    /**
+     * @brief Reads the settings again and publishes them if anything changed.
+     * @return The fields that changed (none if the snapshot is current).
+     */
+    UpsConfig::Fields reload();
+
+    /**
+     * @brief Writes @p changes and removes @p removals, then publishes the result as one version.
+     * The writes themselves are not atomic: if storing fails part of them may have landed, so the
+     * settings are read again and whatever is actually stored is published.
+     * @return false if the settings could not be written.
+     */
+    bool apply(const QVariantMap& changes, const QStringList& removals = QStringList());
+
+    /**
+     * @brief Calls @p slot (in @p context's thread) for every change that touches one of @p fields.
+     */
+    template <typename Functor>
+    QMetaObject::Connection subscribe(UpsConfig::Fields fields, const QObject *context, Functor slot)
+    {
+        return connect(this, &ConfigStore::changed, context, [fields, slot](const ConfigDiff& diff) {
+            if (diff.fields & fields) slot(diff);
+        });
+    }
+
+Q_SIGNALS:
+    void changed(const ConfigDiff& diff);
+
+private:
+    ConfigStore();
+    UpsConfig::Fields publish(const QVariantMap& values);
+    void onSettingsChanged(const SettingsDiff& diff);
+
+    std::atomic<std::shared_ptr<const UpsConfig>> m_current;
+    QVariantMap m_values;           // Raw values behind the current snapshot (publishing thread only)
+    RegistryWatcher *m_watcher = nullptr;
+};
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,105 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "device_node_watcher.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+DeviceNodeWatcher::DeviceNodeWatcher(QObject *parent) : QObject(parent)
+{
+}
+
+DeviceNodeWatcher::~DeviceNodeWatcher()
+{
+    stop();
+}
+
+#ifdef Q_OS_LINUX
+
+bool DeviceNodeWatcher::watch(const QString& devicePath)
+{
+    stop();
+    const QFileInfo node(devicePath);
+    if (!node.isAbsolute()) return false;
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0 || inotify_add_watch(m_inotifyFd, QFile::encodeName(node.absolutePath()).constData(),
+                                             IN_CREATE | IN_ATTRIB | IN_MOVED_TO) < 0) {
+        qDebug() << "DeviceNodeWatcher: Cannot watch" << node.absolutePath();
+        stop();
+        return false;
+    }
+    m_nodeName = QFile::encodeName(node.fileName());
+    m_notifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &DeviceNodeWatcher::onNotified);
+    return true;
+}
+
+void DeviceNodeWatcher::stop()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+    if (m_inotifyFd >= 0) {
+        ::close(m_inotifyFd);
+        m_inotifyFd = -1;
+    }
+}
+
+void DeviceNodeWatcher::onNotified()
+{
+    alignas(inotify_event) char buffer[4096];
+    bool appearedNow = false;
+    ssize_t length = 0;
+    while ((length = ::read(m_inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+            if (event->len > 0 && m_nodeName == event->name) {
+                appearedNow = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+    if (appearedNow) {
+        emit appeared();
+    }
+}
+
+#else
+
+bool DeviceNodeWatcher::watch(const QString& devicePath)
+{
+    Q_UNUSED(devicePath);
+    return false;
+}
+
+void DeviceNodeWatcher::stop()
+{
+}
+
+void DeviceNodeWatcher::onNotified()
+{
+}
+
+#endif
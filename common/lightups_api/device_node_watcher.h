@@ -0,0 +1,58 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DEVICE_NODE_WATCHER_H
+#define DEVICE_NODE_WATCHER_H
+
+#include "lightups_api_global.h"
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+class QSocketNotifier;
+
+/**
+ * @brief Reports when a device node (e.g. /dev/ttyUSB0) appears, so a replugged UPS is reopened
+ * at once instead of at the next retry.
+ *
+ * Linux: inotify on the node's directory, through a QSocketNotifier on the owner's event loop.
+ * appeared() follows both the creation of the node and its attribute change, because udev sets the
+ * permissions just after creating it. Elsewhere watch() returns false and the retries remain.
+ */
+class UPS_API_LIBRARY_EXPORT DeviceNodeWatcher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DeviceNodeWatcher(QObject *parent = nullptr);
+    ~DeviceNodeWatcher() override;
+
+    bool watch(const QString& devicePath);
+    void stop();
+
+Q_SIGNALS:
+    void appeared();
+
+private:
+    void onNotified();
+
+    int m_inotifyFd = -1;
+    QByteArray m_nodeName;
+    QSocketNotifier *m_notifier = nullptr;
+};
+
+#endif // DEVICE_NODE_WATCHER_H
@@ -0,0 +1,142 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "driver_prober.h"
+#include "i_ups_driver.h"
+#include <QDebug>
+#include <QTimer>
+
+DriverProber::DriverProber(DriverReactorPool& reactors, QObject *parent)
+    : QObject(parent)
+    , m_reactors(reactors)
+{
+}
+
+DriverProber::~DriverProber()
+{
+    stopAll();
+}
+
+bool DriverProber::start(const QList<Candidate>& drivers, const QStringList& ports, int timeoutMs)
+{
+    if (isRunning()) return false;
+
+    m_drivers = drivers;
+    m_timeoutMs = timeoutMs;
+    m_clock.start();
+    qDebug() << "DriverProber: Probing" << ports.size() << "port(s) with" << drivers.size() << "driver(s)";
+
+    if (!m_drivers.isEmpty()) {
+        for (const QString& port : ports) {
+            startProbe(port, 0);
+        }
+    }
+    if (!isRunning()) {
+        // Nothing to try: report asynchronously, like a real detection
+        QMetaObject::invokeMethod(this, [this]() { emit finished(false, QString(), QString(), 0); }, Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void DriverProber::cancel()
+{
+    if (!isRunning()) return;
+    stopAll();
+    emit finished(false, QString(), QString(), m_clock.elapsed());
+}
+
+void DriverProber::startProbe(const QString& port, int driverIndex)
+{
+    IUpsDriver *driver = nullptr;
+    for (; driverIndex < m_drivers.size() && !driver; ++driverIndex) {
+        driver = m_drivers[driverIndex].factory->createInstance();
+    }
+    if (!driver) return; // Every driver had its turn on this port
+    --driverIndex;
+
+    const quint64 id = ++m_nextId;
+    Probe probe;
+    probe.port = port;
+    probe.driverIndex = driverIndex;
+    probe.driver = driver;
+    probe.thread = m_reactors.acquire();
+    probe.deadline = new QTimer(this);
+    probe.deadline->setSingleShot(true);
+    connect(probe.deadline, &QTimer::timeout, this, [this, id]() { onProbeResult(id, false); });
+
+    driver->setParent(nullptr);
+    driver->moveToThread(probe.thread);
+    connect(driver, &IUpsDriver::initializationSuccess, this, [this, id]() { onProbeResult(id, true); }, Qt::QueuedConnection);
+    connect(driver, &IUpsDriver::initializationFailure, this, [this, id]() { onProbeResult(id, false); }, Qt::QueuedConnection);
+
+    m_probes.insert(id, probe);
+    probe.deadline->start(m_timeoutMs);
+    QMetaObject::invokeMethod(driver, [driver, port]() { driver->initialize(port); }, Qt::QueuedConnection);
+}
+
+void DriverProber::onProbeResult(quint64 id, bool success)
+{
+    auto it = m_probes.constFind(id);
+    if (it == m_probes.constEnd()) return; // Already stopped: a late signal
+
+    const QString port = it->port;
+    const int driverIndex = it->driverIndex;
+    stopProbe(id);
+
+    if (success) {
+        const QString driverFileName = m_drivers[driverIndex].driverFileName;
+        const qint64 elapsed = m_clock.elapsed();
+        qDebug() << "DriverProber: Found" << driverFileName << "on" << port << "after" << elapsed << "ms";
+        stopAll();
+        emit finished(true, driverFileName, port, elapsed);
+        return;
+    }
+
+    // Give the port to the next driver
+    startProbe(port, driverIndex + 1);
+    if (!isRunning()) {
+        qDebug() << "DriverProber: No UPS found after" << m_clock.elapsed() << "ms";
+        emit finished(false, QString(), QString(), m_clock.elapsed());
+    }
+}
+
+void DriverProber::stopProbe(quint64 id)
+{
+    const Probe probe = m_probes.take(id);
+    if (!probe.driver) return;
+
+    probe.deadline->stop();
+    probe.deadline->deleteLater(); // May be the sender of the current slot
+    disconnect(probe.driver, nullptr, this, nullptr);
+
+    // Stop and delete in the reactor thread that owns the driver's port and timers
+    IUpsDriver *driver = probe.driver;
+    m_reactors.runBlocking(probe.thread, [driver]() {
+        QMetaObject::invokeMethod(driver, "stopDriver", Qt::DirectConnection);
+        delete driver;
+    });
+    m_reactors.release(probe.thread);
+}
+
+void DriverProber::stopAll()
+{
+    const QList<quint64> ids = m_probes.keys();
+    for (quint64 id : ids) {
+        stopProbe(id);
+    }
+}
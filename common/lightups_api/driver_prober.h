@@ -0,0 +1,90 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRIVER_PROBER_H
+#define DRIVER_PROBER_H
+
+#include "lightups_api_global.h"
+#include "driver_reactor_pool.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+class IUpsDriver;
+class QTimer;
+
+/**
+ * @brief Finds the UPS by trying every (port, driver) pair with the driver's own handshake.
+ *
+ * All ports are probed at the same time on the shared reactor threads, so detection takes
+ * about one handshake per driver instead of ports x drivers x timeouts. Drivers on the same
+ * port take turns, because a serial port can only be opened once. A probe succeeds when the
+ * driver emits initializationSuccess() before its deadline; the first success wins and all
+ * other probes are stopped. Use it from the owner thread of the reactor pool.
+ */
+class UPS_API_LIBRARY_EXPORT DriverProber : public QObject
+{
+    Q_OBJECT
+public:
+    struct Candidate {
+        QString driverFileName;         // Reported back on success
+        IUpsDriver *factory = nullptr;  // Root plugin instance; createInstance() makes the probes
+    };
+
+    explicit DriverProber(DriverReactorPool& reactors, QObject *parent = nullptr);
+    ~DriverProber() override;
+
+    /**
+     * @brief Starts probing @p ports with @p drivers. Ignored (returns false) while a detection runs.
+     * @param timeoutMs Deadline of a single probe.
+     */
+    bool start(const QList<Candidate>& drivers, const QStringList& ports, int timeoutMs);
+    void cancel();
+    bool isRunning() const { return !m_probes.isEmpty(); }
+
+Q_SIGNALS:
+    /**
+     * @brief Detection is over: @p found is false if no pair answered (or it was cancelled).
+     */
+    void finished(bool found, const QString& driverFileName, const QString& port, qint64 elapsedMs);
+
+private:
+    struct Probe {
+        QString port;
+        int driverIndex = 0;
+        IUpsDriver *driver = nullptr;
+        QThread *thread = nullptr;
+        QTimer *deadline = nullptr;
+    };
+
+    void startProbe(const QString& port, int driverIndex);
+    void onProbeResult(quint64 id, bool success);
+    void stopProbe(quint64 id);
+    void stopAll();
+
+    DriverReactorPool& m_reactors;
+    QList<Candidate> m_drivers;
+    QHash<quint64, Probe> m_probes;
+    quint64 m_nextId = 0;
+    int m_timeoutMs = 0;
+    QElapsedTimer m_clock;
+};
+
+#endif // DRIVER_PROBER_H
@@ -0,0 +1,323 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "driver_reactor_pool.h"
+#include "ups_clock.h"
+#include <QChildEvent>
+#include <QDebug>
+#include <QEvent>
+#include <QPointer>
+#include <algorithm>
+#include <bit>
+
+/**
+ * @brief Event filter for one watched root and its descendants. The root's label is resolved once,
+ * when the filter is created, so recording a delivery is a handful of atomic stores.
+ */
+class ActivityFilter : public QObject
+{
+public:
+    ActivityFilter(ReactorHealth* health, int labelIndex, QObject* parent)
+        : QObject(parent), m_health(health), m_labelIndex(labelIndex) {}
+
+    void install(QObject* root)
+    {
+        root->installEventFilter(this);
+        const QList<QObject*> children = root->findChildren<QObject*>();
+        for (QObject* child : children) {
+            child->installEventFilter(this);
+        }
+    }
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override
+    {
+        // Ports and timers a driver creates later are watched as well
+        if (event->type() == QEvent::ChildAdded) {
+            QObject* child = static_cast<QChildEvent*>(event)->child();
+            if (child->thread() == thread()) child->installEventFilter(this);
+        }
+        m_health->setActivity(m_labelIndex, watched->metaObject()->className(), event->type(), UpsClock::nowNs());
+        return false;
+    }
+
+private:
+    ReactorHealth* m_health;            // Owned by the pool; outlives this object
+    const int m_labelIndex;
+};
+
+/**
+ * @brief Per-thread helper object: target of the queued calls and owner of the activity filters.
+ */
+class ReactorContext : public QObject
+{
+public:
+    explicit ReactorContext(ReactorHealth* health) : m_health(health) {}
+
+    void watch(QObject* root, const QString& label)
+    {
+        // One filter per root; it goes away with the root (Qt drops deleted filters from every object)
+        ActivityFilter* filter = new ActivityFilter(m_health, m_health->labelIndex(label), this);
+        connect(root, &QObject::destroyed, filter, &QObject::deleteLater);
+        filter->install(root);
+    }
+
+private:
+    ReactorHealth* m_health;            // Owned by the pool; outlives this object
+};
+
+bool ReactorHealth::beginProbe(qint64 nowNs)
+{
+    qint64 idle = 0;
+    return m_probePostedNs.compare_exchange_strong(idle, nowNs, std::memory_order_acq_rel);
+}
+
+void ReactorHealth::endProbe(qint64 nowNs)
+{
+    const qint64 waitNs = std::max<qint64>(0, nowNs - m_probePostedNs.load(std::memory_order_acquire));
+    const quint64 us = static_cast<quint64>(waitNs) / 1000;
+    // Bucket = floor(log2(us)), with 0 and 1 us in bucket 0
+    const int bucket = us < 2 ? 0 : std::min<int>(std::bit_width(us) - 1, LATENCY_BUCKETS - 1);
+    m_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_probes.fetch_add(1, std::memory_order_relaxed);
+    m_lastWaitNs.store(waitNs, std::memory_order_relaxed);
+    qint64 max = m_maxWaitNs.load(std::memory_order_relaxed);
+    while (waitNs > max && !m_maxWaitNs.compare_exchange_weak(max, waitNs, std::memory_order_relaxed)) {
+    }
+    m_probePostedNs.store(0, std::memory_order_release);
+}
+
+std::array<quint64, ReactorHealth::LATENCY_BUCKETS> ReactorHealth::histogram() const
+{
+    std::array<quint64, LATENCY_BUCKETS> histogram{};
+    for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+        histogram[i] = m_histogram[i].load(std::memory_order_relaxed);
+    }
+    return histogram;
+}
+
+int ReactorHealth::labelIndex(const QString& label)
+{
+    const int count = m_labelCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; ++i) {
+        if (m_labels[i] == label) return i;
+    }
+    if (count == LABEL_CAPACITY) {
+        qWarning() << "ReactorHealth: More than" << LABEL_CAPACITY << "labels on" << m_threadName << "- hang reports omit" << label;
+        return -1;
+    }
+    m_labels[count] = label;
+    m_labelCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+ReactorHealth::Activity ReactorHealth::activity() const
+{
+    Activity activity;
+    activity.stampNs = m_activityStampNs.load(std::memory_order_acquire);
+    activity.className = m_activityClass.load(std::memory_order_relaxed);
+    activity.eventType = m_activityEvent.load(std::memory_order_relaxed);
+    const int index = m_activityLabel.load(std::memory_order_relaxed);
+    if (index >= 0 && index < m_labelCount.load(std::memory_order_acquire)) {
+        activity.label = m_labels[index];
+    }
+    return activity;
+}
+
+DriverReactorPool::DriverReactorPool(int threadCount)
+{
+    createReactors(threadCount);
+}
+
+DriverReactorPool::~DriverReactorPool()
+{
+    shutdown();
+}
+
+void DriverReactorPool::createReactors(int threadCount)
+{
+    threadCount = std::max(1, threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        addReactor();
+    }
+}
+
+void DriverReactorPool::addReactor()
+{
+    Reactor reactor;
+    reactor.thread = new QThread();
+    reactor.thread->setObjectName(QString("UpsReactor-%1").arg(m_reactors.size()));
+    reactor.health = std::make_shared<ReactorHealth>(reactor.thread->objectName());
+    m_reactors.append(reactor);
+}
+
+bool DriverReactorPool::setThreadCount(int threadCount)
+{
+    if (std::max(1, threadCount) == m_reactors.size()) return true;
+    for (const Reactor& reactor : std::as_const(m_reactors)) {
+        if (reactor.driverCount > 0) {
+            qWarning() << "DriverReactorPool: Cannot resize while drivers are running.";
+            return false;
+        }
+    }
+    shutdown();
+    createReactors(threadCount);
+    return true;
+}
+
+QThread* DriverReactorPool::acquire()
+{
+    Reactor* best = nullptr;
+    for (Reactor& reactor : m_reactors) {
+        if (reactor.quarantined) continue;
+        if (!best || reactor.driverCount < best->driverCount) best = &reactor;
+    }
+    if (!best) {
+        // Every thread is wedged: the new drivers get a fresh one
+        addReactor();
+        best = &m_reactors.last();
+        qWarning() << "DriverReactorPool: All threads quarantined; adding" << best->thread->objectName();
+    }
+
+    if (!best->thread->isRunning()) {
+        best->context = new ReactorContext(best->health.get());
+        best->context->moveToThread(best->thread);
+        best->thread->start();
+        qDebug() << "DriverReactorPool: Started" << best->thread->objectName();
+    }
+
+    ++best->driverCount;
+    return best->thread;
+}
+
+void DriverReactorPool::release(QThread* thread)
+{
+    if (Reactor* reactor = find(thread)) {
+        reactor->driverCount = std::max(0, reactor->driverCount - 1);
+    }
+}
+
+void DriverReactorPool::runBlocking(QThread* thread, const std::function<void()>& fn)
+{
+    Reactor* reactor = find(thread);
+    if (!reactor || !reactor->context || !thread->isRunning() || QThread::currentThread() == thread) {
+        fn();
+        return;
+    }
+    if (reactor->quarantined) {
+        // Waiting could block the caller forever; fn runs if the thread ever comes back
+        QMetaObject::invokeMethod(reactor->context, fn, Qt::QueuedConnection);
+        return;
+    }
+    QMetaObject::invokeMethod(reactor->context, fn, Qt::BlockingQueuedConnection);
+}
+
+void DriverReactorPool::post(QThread* thread, const std::function<void()>& fn)
+{
+    Reactor* reactor = find(thread);
+    if (!reactor || !reactor->context || !thread->isRunning()) {
+        fn();
+        return;
+    }
+    QMetaObject::invokeMethod(reactor->context, fn, Qt::QueuedConnection);
+}
+
+void DriverReactorPool::sync()
+{
+    // Events are processed in order: once an empty call returned, everything posted before it ran
+    for (const Reactor& reactor : std::as_const(m_reactors)) {
+        if (reactor.context && reactor.thread->isRunning() && !reactor.quarantined) {
+            runBlocking(reactor.thread, []() {});
+        }
+    }
+}
+
+QList<QThread*> DriverReactorPool::runningThreads() const
+{
+    QList<QThread*> threads;
+    for (const Reactor& reactor : m_reactors) {
+        if (reactor.context && reactor.thread->isRunning()) threads.append(reactor.thread);
+    }
+    return threads;
+}
+
+std::shared_ptr<ReactorHealth> DriverReactorPool::health(QThread* thread) const
+{
+    const Reactor* reactor = find(thread);
+    return reactor ? reactor->health : nullptr;
+}
+
+void DriverReactorPool::watch(QThread* thread, QObject* root, const QString& label)
+{
+    Reactor* reactor = find(thread);
+    if (!reactor || !reactor->context) return;
+
+    // Installed in the thread itself: the event filter must live where the events are delivered
+    ReactorContext* context = reactor->context;
+    const QPointer<QObject> guard(root);
+    QMetaObject::invokeMethod(context, [context, guard, label]() {
+        if (guard) context->watch(guard, label);
+    }, Qt::QueuedConnection);
+}
+
+void DriverReactorPool::setQuarantined(QThread* thread, bool quarantined)
+{
+    if (Reactor* reactor = find(thread)) {
+        reactor->quarantined = quarantined;
+    }
+}
+
+bool DriverReactorPool::isQuarantined(QThread* thread) const
+{
+    const Reactor* reactor = find(thread);
+    return reactor && reactor->quarantined;
+}
+
+void DriverReactorPool::shutdown()
+{
+    for (Reactor& reactor : m_reactors) {
+        if (!reactor.thread) continue;
+        if (reactor.thread->isRunning()) {
+            reactor.thread->quit();
+            if (!reactor.thread->wait(3000)) {
+                reactor.thread->terminate();
+                reactor.thread->wait();
+            }
+        }
+        delete reactor.context; // Safe: its thread has stopped
+        delete reactor.thread;
+        reactor = Reactor();
+    }
+    m_reactors.clear();
+}
+
+DriverReactorPool::Reactor* DriverReactorPool::find(QThread* thread)
+{
+    for (Reactor& reactor : m_reactors) {
+        if (reactor.thread == thread) return &reactor;
+    }
+    return nullptr;
+}
+
+const DriverReactorPool::Reactor* DriverReactorPool::find(QThread* thread) const
+{
+    for (const Reactor& reactor : m_reactors) {
+        if (reactor.thread == thread) return &reactor;
+    }
+    return nullptr;
+}
@@ -0,0 +1,196 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRIVER_REACTOR_POOL_H
+#define DRIVER_REACTOR_POOL_H
+
+#include "lightups_api_global.h"
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class ReactorContext;
+
+/**
+ * @brief Liveness data of one reactor thread: written by the thread itself, read by ReactorWatchdog.
+ */
+class UPS_API_LIBRARY_EXPORT ReactorHealth
+{
+public:
+    // Bucket i counts queue waits in [2^i, 2^(i+1)) microseconds, as DriverLinkStats::latencyHistogram
+    static constexpr int LATENCY_BUCKETS = 20;
+    static constexpr int LABEL_CAPACITY = 64;
+
+    /**
+     * @brief The last event delivered to a watched object (the one that is running if the thread hangs).
+     */
+    struct Activity {
+        QString label;                      // Label passed to DriverReactorPool::watch()
+        const char* className = nullptr;    // Class of the receiver
+        int eventType = 0;                  // QEvent::Type
+        qint64 stampNs = 0;                 // UpsClock stamp of the delivery; 0 = nothing seen yet
+    };
+
+    explicit ReactorHealth(const QString& threadName) : m_threadName(threadName) {}
+
+    QString threadName() const { return m_threadName; }
+
+    /**
+     * @brief Heartbeat bookkeeping: beginProbe() on the watchdog's thread, endProbe() on the reactor.
+     * @return false if a heartbeat is still waiting in the queue.
+     */
+    bool beginProbe(qint64 nowNs);
+    void endProbe(qint64 nowNs);
+    qint64 probePostedNs() const { return m_probePostedNs.load(std::memory_order_acquire); }
+
+    quint64 probes() const { return m_probes.load(std::memory_order_relaxed); }
+    qint64 lastWaitNs() const { return m_lastWaitNs.load(std::memory_order_relaxed); }
+    qint64 maxWaitNs() const { return m_maxWaitNs.load(std::memory_order_relaxed); }
+    std::array<quint64, LATENCY_BUCKETS> histogram() const;
+
+    /**
+     * @brief Index of @p label in the label table, added on first use. Reactor thread only.
+     * @return -1 once LABEL_CAPACITY labels are known; the activity is then reported without a label.
+     */
+    int labelIndex(const QString& label);
+
+    /**
+     * @brief Records an event delivery: lock-free, so it can run for every event. Reactor thread only.
+     */
+    void setActivity(int labelIndex, const char* className, int eventType, qint64 stampNs)
+    {
+        m_activityLabel.store(labelIndex, std::memory_order_relaxed);
+        m_activityClass.store(className, std::memory_order_relaxed);
+        m_activityEvent.store(eventType, std::memory_order_relaxed);
+        m_activityStampNs.store(stampNs, std::memory_order_release); // Last: publishes the fields above
+    }
+
+    /**
+     * @brief The last recorded delivery. While the thread runs the fields may belong to a newer event
+     * than the stamp; once it hangs nothing is written anymore, so a hang report is consistent.
+     */
+    Activity activity() const;
+
+private:
+    const QString m_threadName;
+    std::atomic<qint64> m_probePostedNs{0};     // 0 = no heartbeat in flight
+    std::atomic<quint64> m_probes{0};
+    std::atomic<qint64> m_lastWaitNs{0};
+    std::atomic<qint64> m_maxWaitNs{0};
+    std::atomic<quint64> m_histogram[LATENCY_BUCKETS] = {};
+
+    std::array<QString, LABEL_CAPACITY> m_labels;  // Immutable once counted
+    std::atomic<int> m_labelCount{0};
+    std::atomic<int> m_activityLabel{-1};           // Index into m_labels
+    std::atomic<const char*> m_activityClass{nullptr};
+    std::atomic<int> m_activityEvent{0};
+    std::atomic<qint64> m_activityStampNs{0};
+};
+
+/**
+ * @brief A small, fixed set of event-loop threads that host all driver instances.
+ *
+ * Each thread's event dispatcher multiplexes the serial ports, timers and sockets of every driver
+ * assigned to it, so N devices cost N file descriptors instead of N threads. Drivers are placed on
+ * the least loaded thread; threads start on first use. Not thread-safe: use it from the owner thread.
+ *
+ * Each thread keeps a ReactorHealth. A thread that stopped answering can be quarantined: it gets
+ * no new drivers and nobody waits for it anymore, while a replacement thread takes over.
+ */
+class UPS_API_LIBRARY_EXPORT DriverReactorPool
+{
+public:
+    explicit DriverReactorPool(int threadCount = 1);
+    ~DriverReactorPool();
+
+    DriverReactorPool(const DriverReactorPool&) = delete;
+    DriverReactorPool& operator=(const DriverReactorPool&) = delete;
+
+    /**
+     * @brief Changes the number of threads. Only takes effect while no driver is assigned.
+     */
+    bool setThreadCount(int threadCount);
+    int threadCount() const { return m_reactors.size(); }
+
+    /**
+     * @brief Picks the least loaded thread for a new driver (starting it if needed).
+     */
+    QThread* acquire();
+    void release(QThread* thread);
+
+    /**
+     * @brief Runs @p fn on @p thread and waits for it to finish (e.g. to stop and delete a driver there).
+     * A quarantined thread may never return: @p fn is only queued there.
+     */
+    void runBlocking(QThread* thread, const std::function<void()>& fn);
+
+    /**
+     * @brief Queues @p fn on @p thread without waiting (e.g. to retire a driver in the background).
+     */
+    void post(QThread* thread, const std::function<void()>& fn);
+
+    /**
+     * @brief Waits until every thread that is not quarantined has processed the work posted to it so far.
+     */
+    void sync();
+
+    QList<QThread*> runningThreads() const;
+    std::shared_ptr<ReactorHealth> health(QThread* thread) const;
+
+    /**
+     * @brief Records the events delivered to @p root and its descendants in the thread's health,
+     * under @p label (e.g. the device id), so a hang report can name the code that wedged.
+     */
+    void watch(QThread* thread, QObject* root, const QString& label);
+
+    /**
+     * @brief Takes a thread out of service (or back in). acquire() skips a quarantined thread and
+     * starts a replacement if no other thread is left.
+     */
+    void setQuarantined(QThread* thread, bool quarantined);
+    bool isQuarantined(QThread* thread) const;
+
+    /**
+     * @brief Stops all threads. Every driver must have been removed first.
+     */
+    void shutdown();
+
+private:
+    struct Reactor {
+        QThread* thread = nullptr;
+        ReactorContext* context = nullptr;  // Lives in the thread; target for runBlocking() and event filter
+        std::shared_ptr<ReactorHealth> health;
+        int driverCount = 0;
+        bool quarantined = false;
+    };
+
+    void createReactors(int threadCount);
+    void addReactor();
+    Reactor* find(QThread* thread);
+    const Reactor* find(QThread* thread) const;
+
+    QVector<Reactor> m_reactors;
+};
+
+#endif // DRIVER_REACTOR_POOL_H
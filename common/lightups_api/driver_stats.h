@@ -0,0 +1,104 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRIVER_STATS_H
+#define DRIVER_STATS_H
+
+#include "ups_report.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+
+/**
+ * @brief Lock-free counters a driver updates from its own thread and anyone may read.
+ *
+ * Every field is a relaxed atomic: the driver never waits for a reader and a reader never blocks the
+ * driver. A snapshot is therefore not a single consistent cut, which is fine for monitoring.
+ */
+class DriverStats
+{
+public:
+    void addBytesRead(quint64 count) { m_bytesRead.fetch_add(count, std::memory_order_relaxed); }
+    void addFramesDecoded(quint64 count) { m_framesDecoded.fetch_add(count, std::memory_order_relaxed); }
+    void addChecksumFailures(quint64 count) { m_checksumFailures.fetch_add(count, std::memory_order_relaxed); }
+    void addResyncBytesDiscarded(quint64 count) { m_resyncBytesDiscarded.fetch_add(count, std::memory_order_relaxed); }
+    void addBufferOverruns(quint64 count) { m_bufferOverruns.fetch_add(count, std::memory_order_relaxed); }
+    void addHandshakeRetry() { m_handshakeRetries.fetch_add(1, std::memory_order_relaxed); }
+    void addReconnect() { m_reconnects.fetch_add(1, std::memory_order_relaxed); }
+    void addSerialError() { m_serialErrors.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief Records one outage, from the first failure to the first valid sample afterwards.
+     */
+    void recordRecoveryNs(qint64 durationNs)
+    {
+        const quint64 ms = durationNs > 0 ? static_cast<quint64>(durationNs) / 1000000 : 0;
+        m_recoveries.fetch_add(1, std::memory_order_relaxed);
+        m_lastRecoveryMs.store(ms, std::memory_order_relaxed);
+        quint64 max = m_maxRecoveryMs.load(std::memory_order_relaxed);
+        while (ms > max && !m_maxRecoveryMs.compare_exchange_weak(max, ms, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief Records one byte-arrival -> dataReceived latency.
+     */
+    void recordLatencyNs(qint64 latencyNs)
+    {
+        const quint64 us = latencyNs > 0 ? static_cast<quint64>(latencyNs) / 1000 : 0;
+        // Bucket = floor(log2(us)), with 0 and 1 us in bucket 0
+        const int bucket = us < 2 ? 0 : std::min<int>(std::bit_width(us) - 1, DriverLinkStats::LATENCY_BUCKETS - 1);
+        m_latency[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    DriverLinkStats snapshot() const
+    {
+        DriverLinkStats stats;
+        stats.bytesRead = m_bytesRead.load(std::memory_order_relaxed);
+        stats.framesDecoded = m_framesDecoded.load(std::memory_order_relaxed);
+        stats.checksumFailures = m_checksumFailures.load(std::memory_order_relaxed);
+        stats.resyncBytesDiscarded = m_resyncBytesDiscarded.load(std::memory_order_relaxed);
+        stats.bufferOverruns = m_bufferOverruns.load(std::memory_order_relaxed);
+        stats.handshakeRetries = m_handshakeRetries.load(std::memory_order_relaxed);
+        stats.reconnects = m_reconnects.load(std::memory_order_relaxed);
+        stats.serialErrors = m_serialErrors.load(std::memory_order_relaxed);
+        stats.recoveries = m_recoveries.load(std::memory_order_relaxed);
+        stats.lastRecoveryMs = m_lastRecoveryMs.load(std::memory_order_relaxed);
+        stats.maxRecoveryMs = m_maxRecoveryMs.load(std::memory_order_relaxed);
+        for (int i = 0; i < DriverLinkStats::LATENCY_BUCKETS; ++i) {
+            stats.latencyHistogram[i] = m_latency[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+private:
+    std::atomic<quint64> m_bytesRead{0};
+    std::atomic<quint64> m_framesDecoded{0};
+    std::atomic<quint64> m_checksumFailures{0};
+    std::atomic<quint64> m_resyncBytesDiscarded{0};
+    std::atomic<quint64> m_bufferOverruns{0};
+    std::atomic<quint64> m_handshakeRetries{0};
+    std::atomic<quint64> m_reconnects{0};
+    std::atomic<quint64> m_serialErrors{0};
+    std::atomic<quint64> m_recoveries{0};
+    std::atomic<quint64> m_lastRecoveryMs{0};
+    std::atomic<quint64> m_maxRecoveryMs{0};
+    std::atomic<quint64> m_latency[DriverLinkStats::LATENCY_BUCKETS] = {};
+};
+
+#endif // DRIVER_STATS_H
@@ -0,0 +1,379 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "driver_transport.h"
+#include "serial_capture.h"
+#include "device_node_watcher.h"
+#include <QDebug>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QUrlQuery>
+
+namespace {
+// Strips the leading '/' that "scheme:///C:/x" and "serial:///COM7" leave in front of Windows paths
+QString nativeTarget(const QString& path)
+{
+#ifdef Q_OS_WIN
+    if (path.startsWith('/')) return path.mid(1);
+#else
+    static const QRegularExpression drivePath(QStringLiteral("^/[A-Za-z]:[/\\\\]"));
+    if (drivePath.match(path).hasMatch()) return path.mid(1);
+#endif
+    return path;
+}
+
+TransportUri invalid(const QString& error)
+{
+    TransportUri uri;
+    uri.error = error;
+    return uri;
+}
+} // namespace
+
+// ----------------------------------------------------
+// --- TransportUri ---
+// ----------------------------------------------------
+
+TransportUri TransportUri::parse(const QString& connectionInfo)
+{
+    const QString info = connectionInfo.trimmed();
+    if (info.isEmpty()) {
+        return invalid(QObject::tr("Empty connection string"));
+    }
+
+    TransportUri uri;
+
+    // The older capture replay spelling
+    if (CaptureReplayDevice::parseConnectionInfo(info, uri.target, uri.replaySpeed)) {
+        uri.scheme = Scheme::File;
+        uri.explicitScheme = true;
+        return uri;
+    }
+
+    const qsizetype schemeEnd = info.indexOf(QStringLiteral("://"));
+    if (schemeEnd < 0) {
+        // A bare port name such as "COM7" or "/dev/ttyUSB0"
+        uri.scheme = Scheme::Serial;
+        uri.target = info;
+        return uri;
+    }
+
+    const QString scheme = info.left(schemeEnd).toLower();
+    const QString rest = info.mid(schemeEnd + 3);
+    const qsizetype queryStart = rest.indexOf('?');
+    const QString path = queryStart < 0 ? rest : rest.left(queryStart);
+    const QUrlQuery query(queryStart < 0 ? QString() : rest.mid(queryStart + 1));
+    uri.explicitScheme = true;
+
+    if (scheme == QLatin1String("serial") || scheme == QLatin1String("pty")) {
+        uri.scheme = scheme == QLatin1String("serial") ? Scheme::Serial : Scheme::Pty;
+        uri.target = nativeTarget(path);
+        if (uri.target.isEmpty()) {
+            return invalid(QObject::tr("%1:// needs a device, e.g. %1:///dev/ttyUSB0").arg(scheme));
+        }
+#ifdef Q_OS_WIN
+        if (uri.scheme == Scheme::Pty) {
+            return invalid(QObject::tr("Pseudo terminals are not available on this platform"));
+        }
+#endif
+        bool ok = true;
+        if (query.hasQueryItem("baud")) {
+            uri.baudRate = query.queryItemValue("baud").toInt(&ok);
+            if (!ok || uri.baudRate <= 0) return invalid(QObject::tr("Invalid baud rate in %1").arg(info));
+        }
+        if (query.hasQueryItem("data")) {
+            uri.dataBits = query.queryItemValue("data").toInt(&ok);
+            if (!ok || uri.dataBits < 5 || uri.dataBits > 8) return invalid(QObject::tr("Invalid data bits in %1").arg(info));
+        }
+        if (query.hasQueryItem("stop")) {
+            uri.stopBits = query.queryItemValue("stop").toInt(&ok);
+            if (!ok || (uri.stopBits != 1 && uri.stopBits != 2)) return invalid(QObject::tr("Invalid stop bits in %1").arg(info));
+        }
+        uri.parity = query.queryItemValue("parity").toLower();
+        if (!uri.parity.isEmpty() && !QStringList{ "none", "even", "odd", "space", "mark" }.contains(uri.parity)) {
+            return invalid(QObject::tr("Invalid parity in %1").arg(info));
+        }
+        uri.flowControl = query.queryItemValue("flow").toLower();
+        if (!uri.flowControl.isEmpty() && !QStringList{ "none", "hw", "sw" }.contains(uri.flowControl)) {
+            return invalid(QObject::tr("Invalid flow control in %1").arg(info));
+        }
+        return uri;
+    }
+
+    if (scheme == QLatin1String("tcp")) {
+        QString hostPort = path;
+        while (hostPort.endsWith('/')) hostPort.chop(1);
+        const qsizetype colon = hostPort.lastIndexOf(':');
+        bool ok = false;
+        const int port = colon < 0 ? 0 : hostPort.mid(colon + 1).toInt(&ok);
+        if (!ok || port <= 0 || port > 0xFFFF) {
+            return invalid(QObject::tr("tcp:// needs host:port, got %1").arg(info));
+        }
+        uri.scheme = Scheme::Tcp;
+        uri.target = hostPort.left(colon);
+        if (uri.target.startsWith('[') && uri.target.endsWith(']')) {
+            uri.target = uri.target.mid(1, uri.target.size() - 2); // [IPv6]:port
+        }
+        uri.port = static_cast<quint16>(port);
+        if (uri.target.isEmpty()) {
+            return invalid(QObject::tr("tcp:// needs host:port, got %1").arg(info));
+        }
+        return uri;
+    }
+
+    if (scheme == QLatin1String("file")) {
+        uri.scheme = Scheme::File;
+        uri.target = nativeTarget(path);
+        const QString speed = query.queryItemValue("speed");
+        if (speed == QLatin1String("max")) {
+            uri.replaySpeed = 0.0;
+        } else if (!speed.isEmpty()) {
+            bool ok = false;
+            uri.replaySpeed = speed.toDouble(&ok);
+            if (!ok) return invalid(QObject::tr("Invalid replay speed in %1").arg(info));
+        }
+        if (uri.target.isEmpty()) {
+            return invalid(QObject::tr("file:// needs a capture file"));
+        }
+        return uri;
+    }
+
+    return invalid(QObject::tr("Unknown transport '%1' in %2").arg(scheme, info));
+}
+
+// ----------------------------------------------------
+// --- DriverTransport ---
+// ----------------------------------------------------
+
+DriverTransport::DriverTransport(QObject *parent)
+    : QObject(parent)
+{
+}
+
+DriverTransport::~DriverTransport()
+{
+    close();
+}
+
+bool DriverTransport::configure(const QString& connectionInfo, const SerialDefaults& defaults)
+{
+    close();
+    delete m_device;
+    m_device = nullptr;
+    m_serialPort = nullptr;
+    m_socket = nullptr;
+    delete m_nodeWatcher;
+    m_nodeWatcher = nullptr;
+
+    m_defaults = defaults;
+    m_uri = TransportUri::parse(connectionInfo);
+    if (!m_uri.isValid()) {
+        m_errorString = m_uri.error;
+        return false;
+    }
+
+    createDevice();
+    return true;
+}
+
+void DriverTransport::createDevice()
+{
+    switch (m_uri.scheme) {
+    case TransportUri::Scheme::Serial:
+    case TransportUri::Scheme::Pty:
+        m_serialPort = new QSerialPort(this);
+        m_serialPort->setPortName(m_uri.target);
+        m_serialPort->setReadBufferSize(m_defaults.readBufferSize);
+        connect(m_serialPort, &QSerialPort::errorOccurred, this, &DriverTransport::onSerialError);
+        m_device = m_serialPort;
+
+        // A replugged adapter gets its node back: tell the driver instead of waiting for its next retry
+        m_nodeWatcher = new DeviceNodeWatcher(this);
+        if (m_nodeWatcher->watch(m_uri.target)) {
+            connect(m_nodeWatcher, &DeviceNodeWatcher::appeared, this, [this]() {
+                if (!isOpen()) emit deviceAppeared();
+            });
+        } else {
+            delete m_nodeWatcher;
+            m_nodeWatcher = nullptr;
+        }
+        break;
+    case TransportUri::Scheme::Tcp:
+        m_socket = new QTcpSocket(this);
+        connect(m_socket, &QTcpSocket::connected, this, [this]() {
+            m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            emit opened();
+        });
+        connect(m_socket, &QTcpSocket::errorOccurred, this, [this]() {
+            fail(m_socket->errorString(), true);
+        });
+        m_device = m_socket;
+        break;
+    case TransportUri::Scheme::File:
+        m_device = new CaptureReplayDevice(m_uri.target, m_uri.replaySpeed, this);
+        break;
+    case TransportUri::Scheme::Invalid:
+        return;
+    }
+    connect(m_device, &QIODevice::readyRead, this, &DriverTransport::readyRead);
+}
+
+QString DriverTransport::description() const
+{
+    switch (m_uri.scheme) {
+    case TransportUri::Scheme::Serial:
+        return QStringLiteral("serial %1").arg(m_uri.target);
+    case TransportUri::Scheme::Pty:
+        return QStringLiteral("pty %1").arg(m_uri.target);
+    case TransportUri::Scheme::Tcp:
+        return QStringLiteral("tcp %1:%2").arg(m_uri.target).arg(m_uri.port);
+    case TransportUri::Scheme::File:
+        return QStringLiteral("file %1 (speed %2)").arg(m_uri.target,
+                                                        m_uri.replaySpeed > 0 ? QString::number(m_uri.replaySpeed) : QStringLiteral("max"));
+    case TransportUri::Scheme::Invalid:
+        break;
+    }
+    return QStringLiteral("invalid");
+}
+
+bool DriverTransport::open()
+{
+    if (!m_device) {
+        return false;
+    }
+
+    if (m_socket) {
+        if (m_socket->state() == QAbstractSocket::UnconnectedState) {
+            m_socket->connectToHost(m_uri.target, m_uri.port);
+        }
+        return true; // opened() follows from QTcpSocket::connected
+    }
+
+    if (m_device->isOpen()) {
+        return true;
+    }
+
+    if (m_serialPort && m_uri.scheme == TransportUri::Scheme::Serial) {
+        m_serialPort->setBaudRate(m_uri.baudRate > 0 ? m_uri.baudRate : m_defaults.baudRate);
+        m_serialPort->setDataBits(m_uri.dataBits > 0 ? static_cast<QSerialPort::DataBits>(m_uri.dataBits) : m_defaults.dataBits);
+        m_serialPort->setStopBits(m_uri.stopBits == 2 ? QSerialPort::TwoStop
+                                  : m_uri.stopBits == 1 ? QSerialPort::OneStop : m_defaults.stopBits);
+
+        QSerialPort::Parity parity = m_defaults.parity;
+        if (m_uri.parity == QLatin1String("none")) parity = QSerialPort::NoParity;
+        else if (m_uri.parity == QLatin1String("even")) parity = QSerialPort::EvenParity;
+        else if (m_uri.parity == QLatin1String("odd")) parity = QSerialPort::OddParity;
+        else if (m_uri.parity == QLatin1String("space")) parity = QSerialPort::SpaceParity;
+        else if (m_uri.parity == QLatin1String("mark")) parity = QSerialPort::MarkParity;
+        m_serialPort->setParity(parity);
+
+        QSerialPort::FlowControl flow = m_defaults.flowControl;
+        if (m_uri.flowControl == QLatin1String("none")) flow = QSerialPort::NoFlowControl;
+        else if (m_uri.flowControl == QLatin1String("hw")) flow = QSerialPort::HardwareControl;
+        else if (m_uri.flowControl == QLatin1String("sw")) flow = QSerialPort::SoftwareControl;
+        m_serialPort->setFlowControl(flow);
+    }
+
+    if (!m_device->open(QIODevice::ReadWrite)) {
+        m_errorString = m_device->errorString();
+        return false;
+    }
+
+    if (m_serialPort && m_uri.scheme == TransportUri::Scheme::Serial) {
+        // Pseudo terminals have no modem lines
+        m_serialPort->setDataTerminalReady(true);
+        m_serialPort->setRequestToSend(true);
+    }
+    emit opened();
+    return true;
+}
+
+void DriverTransport::close()
+{
+    if (m_socket) {
+        m_socket->abort();
+    } else if (m_device && m_device->isOpen()) {
+        m_device->close();
+    }
+}
+
+bool DriverTransport::isOpen() const
+{
+    if (m_socket) {
+        return m_socket->state() == QAbstractSocket::ConnectedState;
+    }
+    return m_device && m_device->isOpen();
+}
+
+std::span<const quint8> DriverTransport::read()
+{
+    m_lastReadHitLimit = false;
+    if (!m_device) {
+        return {};
+    }
+
+    const qint64 available = m_device->bytesAvailable();
+    if (available <= 0) {
+        return {};
+    }
+    if (m_readBuffer.size() < available) {
+        m_readBuffer.resize(available); // Grows to the largest chunk seen, then stays
+    }
+
+    const qint64 received = m_device->read(m_readBuffer.data(), available);
+    if (received <= 0) {
+        return {};
+    }
+    m_lastReadHitLimit = m_serialPort && m_defaults.readBufferSize > 0 && received >= m_defaults.readBufferSize;
+    return std::span<const quint8>(reinterpret_cast<const quint8*>(m_readBuffer.constData()), static_cast<size_t>(received));
+}
+
+qint64 DriverTransport::write(std::span<const quint8> bytes)
+{
+    if (!m_device) {
+        return -1;
+    }
+    const qint64 written = m_device->write(reinterpret_cast<const char*>(bytes.data()), static_cast<qint64>(bytes.size()));
+    if (written == -1) {
+        m_errorString = m_device->errorString();
+    }
+    if (m_serialPort) {
+        m_serialPort->flush();
+    } else if (m_socket) {
+        m_socket->flush();
+    }
+    return written;
+}
+
+void DriverTransport::onSerialError(QSerialPort::SerialPortError error)
+{
+    if (error == QSerialPort::NoError || error == QSerialPort::TimeoutError) return;
+
+    const bool lost = error == QSerialPort::ResourceError || error == QSerialPort::DeviceNotFoundError;
+    if (lost && m_serialPort->isOpen()) {
+        m_serialPort->close();
+    }
+    fail(m_serialPort->errorString(), lost);
+}
+
+void DriverTransport::fail(const QString& message, bool connectionLost)
+{
+    m_errorString = message;
+    emit errorOccurred(message, connectionLost);
+}
@@ -0,0 +1,161 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRIVER_TRANSPORT_H
+#define DRIVER_TRANSPORT_H
+
+#include "lightups_api_global.h"
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QtSerialPort/QSerialPort>
+#include <span>
+
+class QIODevice;
+class QTcpSocket;
+class DeviceNodeWatcher;
+
+/**
+ * @brief A parsed driver connection string.
+ *
+ * Accepted forms:
+ *   serial:///dev/ttyUSB0?baud=2400&data=8&parity=none&stop=1&flow=none   (serial://COM7 on Windows)
+ *   pty:///dev/pts/3                          (pseudo terminal, e.g. lightups-nhs-sim; line settings are skipped)
+ *   tcp://host:port                           (serial-over-IP servers, raw TCP)
+ *   file://capture.bin?speed=N|max            (capture replay, see serial_capture.h)
+ *   replay:capture.bin?speed=N|max            (older spelling of file://)
+ *   COM7, /dev/ttyUSB0                        (no scheme: serial port with the driver's defaults)
+ */
+struct UPS_API_LIBRARY_EXPORT TransportUri {
+    enum class Scheme { Invalid, Serial, Pty, Tcp, File };
+
+    Scheme scheme = Scheme::Invalid;
+    QString target;                 // Port name, device path, host or file path
+    quint16 port = 0;               // TCP only
+    bool explicitScheme = false;    // false when a bare port name was given
+
+    // Serial line settings: -1 / unset means "use the driver's default"
+    qint32 baudRate = -1;
+    int dataBits = -1;
+    int stopBits = -1;
+    QString parity;                 // none, even, odd, space, mark
+    QString flowControl;            // none, hw, sw
+
+    double replaySpeed = 1.0;       // File only; 0 = as fast as possible
+    QString error;                  // Set when scheme == Invalid
+
+    bool isValid() const { return scheme != Scheme::Invalid; }
+
+    static TransportUri parse(const QString& connectionInfo);
+};
+
+/**
+ * @brief Byte transport used by drivers: hides whether the UPS is behind a serial port,
+ * a pseudo terminal, a TCP socket or a capture file.
+ *
+ * Received bytes are read into one buffer owned by the transport and handed out as a span,
+ * so a driver's read path does not allocate. Opening is asynchronous for TCP: open() starts
+ * the connection and opened() follows once the link is usable (immediately for the others).
+ * Lives in the driver's thread.
+ */
+class UPS_API_LIBRARY_EXPORT DriverTransport : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * @brief Line settings a driver wants on a serial port; the URI may override them.
+     */
+    struct SerialDefaults {
+        qint32 baudRate = QSerialPort::Baud2400;
+        QSerialPort::DataBits dataBits = QSerialPort::Data8;
+        QSerialPort::Parity parity = QSerialPort::NoParity;
+        QSerialPort::StopBits stopBits = QSerialPort::OneStop;
+        QSerialPort::FlowControl flowControl = QSerialPort::NoFlowControl;
+        qint64 readBufferSize = 0;      // QSerialPort read buffer limit, 0 = unlimited
+    };
+
+    explicit DriverTransport(QObject *parent = nullptr);
+    ~DriverTransport() override;
+
+    /**
+     * @brief Selects the endpoint. Returns false (see errorString()) for malformed connection strings.
+     */
+    bool configure(const QString& connectionInfo, const SerialDefaults& defaults = SerialDefaults());
+
+    const TransportUri& uri() const { return m_uri; }
+    QString description() const;
+
+    /**
+     * @brief Starts opening the endpoint. Returns false if that failed immediately.
+     * Calling it while a TCP connection is in progress is a no-op that returns true.
+     */
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    /**
+     * @brief Reads everything available. The span stays valid until the next read() or close().
+     */
+    std::span<const quint8> read();
+
+    /**
+     * @brief True if the last read() returned as much as the device buffer allows (the line outruns us).
+     */
+    bool lastReadHitLimit() const { return m_lastReadHitLimit; }
+
+    qint64 write(std::span<const quint8> bytes);
+
+    QString errorString() const { return m_errorString; }
+
+    /**
+     * @brief The underlying device, for drivers that need device-specific calls. May be null.
+     */
+    QIODevice* device() const { return m_device; }
+
+Q_SIGNALS:
+    void opened();
+    void readyRead();
+
+    /**
+     * @brief A transport error. @p connectionLost means the transport closed itself and must be re-opened.
+     */
+    void errorOccurred(const QString& message, bool connectionLost);
+
+    /**
+     * @brief The device node of a serial port (re)appeared, e.g. after a replug (Linux only).
+     * A driver waiting to reopen the port can do so now.
+     */
+    void deviceAppeared();
+
+private:
+    void createDevice();
+    void onSerialError(QSerialPort::SerialPortError error);
+    void fail(const QString& message, bool connectionLost);
+
+    TransportUri m_uri;
+    SerialDefaults m_defaults;
+    QIODevice *m_device = nullptr;        // One of the devices below, or a CaptureReplayDevice
+    QSerialPort *m_serialPort = nullptr;  // Set for Serial and Pty
+    QTcpSocket *m_socket = nullptr;       // Set for Tcp
+    DeviceNodeWatcher *m_nodeWatcher = nullptr; // Set for Serial and Pty device paths
+    QByteArray m_readBuffer;              // Reused by every read()
+    bool m_lastReadHitLimit = false;
+    QString m_errorString;
+};
+
+#endif // DRIVER_TRANSPORT_H
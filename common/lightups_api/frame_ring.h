@@ -0,0 +1,153 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FRAME_RING_H
+#define FRAME_RING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace ProtocolFrame {
+
+/**
+ * @brief Batched byte ring for frame-oriented serial protocols, shared by NhsRingBuffer and StreamParser.
+ *
+ * Incoming bytes are block-copied into the ring (at most two memcpy calls per chunk).
+ * The first MaxFrameLength bytes of the ring are mirrored behind its end, so every frame
+ * that starts inside the ring is available as ONE contiguous span. This lets the frame
+ * search use memchr (SIMD in every mainstream C runtime) and validation run over a plain
+ * pointer instead of masking every index with BUFFER_MASK.
+ *
+ * The ring only knows the start marker; scan() hands every candidate frame to the protocol.
+ * No Qt dependency, so it can be benchmarked standalone.
+ */
+template <int BufferSize, int MaxFrameLength>
+class MirroredRing
+{
+public:
+    static constexpr int BUFFER_SIZE = BufferSize;       // Must be a power of 2
+    static constexpr int BUFFER_MASK = BufferSize - 1;   // Used for the fast & operation
+    static constexpr int MAX_FRAME_LENGTH = MaxFrameLength;
+
+    static_assert((BufferSize & BUFFER_MASK) == 0, "BufferSize must be a power of 2");
+    static_assert(BufferSize > 2 * MaxFrameLength, "BufferSize must hold at least two frames");
+
+    // What scan()'s inspector decides for the candidate frame at a start marker
+    static constexpr int NEED_MORE = 0;   // Incomplete: wait for more bytes
+    static constexpr int RESYNC = -1;     // Not a frame: drop the start marker and search again
+
+    /** @brief Number of bytes currently buffered. */
+    int size() const { return (m_head - m_tail) & BUFFER_MASK; }
+
+    /** @brief Number of bytes that can still be written (one slot stays empty to tell full from empty). */
+    int freeSpace() const { return BUFFER_MASK - size(); }
+
+    void clear() { m_head = m_tail = 0; }
+
+    /**
+     * @brief Block-copies as many bytes as fit into the ring.
+     * @return The number of bytes actually consumed from @p data.
+     */
+    int write(const uint8_t* data, int length)
+    {
+        const int count = std::min(length, freeSpace());
+        if (count <= 0) return 0;
+
+        const int firstPart = std::min(count, BufferSize - m_head);
+        std::memcpy(&m_buffer[m_head], data, firstPart);
+        if (m_head < MaxFrameLength) {
+            mirror(m_head, firstPart);
+        }
+
+        const int secondPart = count - firstPart;
+        if (secondPart > 0) {
+            std::memcpy(&m_buffer[0], data + firstPart, secondPart);
+            mirror(0, secondPart);
+        }
+
+        m_head = (m_head + count) & BUFFER_MASK;
+        return count;
+    }
+
+    /** @brief Drops @p count bytes from the read side. */
+    void discard(int count) { m_tail = (m_tail + count) & BUFFER_MASK; }
+
+    /**
+     * @brief Walks the buffered bytes from start marker to start marker.
+     *
+     * Bytes before a start marker are skipped. At each marker with at least @p headerBytes
+     * buffered, inspect(const uint8_t* frame, int available) is called: @p frame is contiguous
+     * for MaxFrameLength bytes (of which @p available are valid) and only valid during the call.
+     * It returns the length of a frame to consume it, NEED_MORE to stop until more bytes
+     * arrive, or RESYNC to drop the marker byte (which counts as skipped).
+     * @return The number of bytes skipped.
+     */
+    template <typename InspectFn>
+    int scan(uint8_t startMarker, int headerBytes, InspectFn&& inspect)
+    {
+        int skipped = 0;
+        while (size() >= headerBytes) {
+            // 1. Find the next start marker in the contiguous part of the ring
+            const int contiguous = std::min(size(), BufferSize - m_tail);
+            const uint8_t* base = &m_buffer[m_tail];
+            const void* marker = std::memchr(base, startMarker, contiguous);
+            if (!marker) {
+                skipped += contiguous;
+                discard(contiguous);
+                continue;
+            }
+            const int offset = static_cast<int>(static_cast<const uint8_t*>(marker) - base);
+            if (offset > 0) {
+                skipped += offset;
+                discard(offset);
+                if (size() < headerBytes) break;
+            }
+
+            // 2. Let the protocol judge the candidate (mirror: no masking needed)
+            const int result = inspect(static_cast<const uint8_t*>(&m_buffer[m_tail]), size());
+            if (result == NEED_MORE) break;
+            if (result == RESYNC) {
+                // A false start marker inside garbage must not swallow a real frame that begins within its length
+                ++skipped;
+                discard(1);
+                continue;
+            }
+            discard(result);
+        }
+        return skipped;
+    }
+
+private:
+    // Copies ring bytes [from, from + count) that fall inside the mirrored prefix behind the ring
+    void mirror(int from, int count)
+    {
+        const int end = std::min(from + count, MaxFrameLength);
+        if (end > from) {
+            std::memcpy(&m_buffer[BufferSize + from], &m_buffer[from], end - from);
+        }
+    }
+
+    uint8_t m_buffer[BufferSize + MaxFrameLength] = {};
+    int m_head = 0; // Write index
+    int m_tail = 0; // Read index
+};
+
+} // namespace ProtocolFrame
+
+#endif // FRAME_RING_H
@@ -17,9 +17,33 @@
 */
 
 #include "i_ups_driver.h"
+#include "serial_capture.h"
 
-// This file does not need to contain anything else.
-// The simple fact that this file exists ensures that
-// the CMake/QMake system knows that the MOC output needs to be linked somewhere.
+// Besides the capture helpers below, this file ensures that the CMake/QMake system
+// knows that the MOC output needs to be linked somewhere.
 // The MOC tool will automatically generate moc_i_ups_driver.cpp
 // and compile and link it via this i_ups_driver.cpp file.
+
+IUpsDriver::~IUpsDriver() = default;
+
+bool IUpsDriver::setCaptureFile(const QString& path)
+{
+    if (path.isEmpty()) {
+        m_capture.reset();
+        return true;
+    }
+
+    auto writer = std::make_unique<CaptureWriter>();
+    if (!writer->open(path)) {
+        return false;
+    }
+    m_capture = std::move(writer);
+    return true;
+}
+
+void IUpsDriver::captureReceived(qint64 arrivalNs, const QByteArray& chunk)
+{
+    if (m_capture) {
+        m_capture->writeChunk(arrivalNs, chunk.constData(), chunk.size());
+    }
+}
@@ -20,8 +20,12 @@
 
 #include <QObject>
 #include <QtPlugin>
+#include <memory>
 #include "ups_report.h" // <<< CHANGE: Inclusion of the new combined struct
 #include "lightups_api_global.h"
+#include "driver_stats.h"
+
+class CaptureWriter;
 
 /**
  * @brief The pure abstract interface for all UPS drivers/plugins.
@@ -33,7 +37,7 @@ public:
     // CHANGE: Add an explicit constructor
     explicit IUpsDriver(QObject *parent = nullptr) {}
 
-    virtual ~IUpsDriver() = default;
+    virtual ~IUpsDriver();
 
     /**
      * @brief Initializes communication with the UPS.
@@ -45,6 +49,24 @@ public:
      */
     virtual QString driverName() const = 0;
 
+    /**
+     * @brief Creates a new, uninitialized driver of the same type.
+     * QPluginLoader only ever hands out one root instance per plugin; the API layer uses it as a
+     * factory so several UPS units can share one plugin. The caller owns the returned object.
+     */
+    virtual IUpsDriver* createInstance() const = 0;
+
+    /**
+     * @brief Records every chunk the driver receives into a capture file (see serial_capture.h).
+     * Call before the driver is moved to its worker thread. An empty path stops recording.
+     */
+    bool setCaptureFile(const QString& path);
+
+    /**
+     * @brief Returns the link counters of this driver. Safe to call from any thread; never blocks the driver.
+     */
+    DriverLinkStats linkStats() const { return m_stats.snapshot(); }
+
 Q_SIGNALS: // <--- THE NEW SECTION
     /**
      * @brief Emitted when the driver is successfully initialized.
@@ -56,9 +78,26 @@ Q_SIGNALS: // <--- THE NEW SECTION
      */
     void initializationFailure(const QString& error);
     void dataReceived(const UpsData& data); // This is the data signal.
+
+protected:
+    /**
+     * @brief Drivers pass every received chunk here, exactly as read and before parsing.
+     * @param arrivalNs Monotonic timestamp taken when the chunk was read.
+     */
+    void captureReceived(qint64 arrivalNs, const QByteArray& chunk);
+
+    /**
+     * @brief Counters the driver updates while it runs (see DriverStats).
+     */
+    DriverStats& stats() { return m_stats; }
+
+private:
+    DriverStats m_stats;
+    std::unique_ptr<CaptureWriter> m_capture;
 };
 
 // Register the interface ID for Qt's plugin system
-#define IUpsDriver_iid "com.yourcompany.UpsMonitoring.IUpsDriver/1.0"
+// 1.1: createInstance() (multi-UPS). Plugins built against 1.0 are rejected by qobject_cast.
+#define IUpsDriver_iid "com.yourcompany.UpsMonitoring.IUpsDriver/1.1"
 Q_DECLARE_INTERFACE(IUpsDriver, IUpsDriver_iid)
 
@@ -17,228 +17,798 @@
 */
 
 #include "lightups_api.h"
-#include "registry_watcher.h"
 #include "constants.h"
-#include <QSettings>
 #include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <algorithm>
+#include <QJsonObject>
+#include <QtSerialPort/QSerialPortInfo>
 #include <QDebug>
 #include <QObject>
 
+namespace {
+// Everything else (shutdown delay, power mode, history) belongs to the service, not to the drivers
+constexpr UpsConfig::Fields DRIVER_FIELDS = UpsConfig::Field::PrimaryUps | UpsConfig::Field::Devices
+    | UpsConfig::Field::ReactorThreads | UpsConfig::Field::HangThreshold | UpsConfig::Field::SampleFilter
+    | UpsConfig::Field::AutoDetect | UpsConfig::Field::BatteryModel;
+}
+
 Ups_api_library::Ups_api_library(QObject *parent)
     : QObject(parent)
 {
     qRegisterMetaType<UpsReport>("UpsReport");
 
-    m_recoveryTimer = new QTimer(this);
-    m_recoveryTimer->setSingleShot(true);
-    m_recoveryTimer->setInterval(5000);
+    // The settings watcher reports configuration changes at once; this is only the fallback
+    RecoveryScheduler::Config configBackoff;
+    configBackoff.initialDelayMs = 5000;
+    m_configRecovery = new RecoveryScheduler(configBackoff, this);
+    connect(m_configRecovery, &RecoveryScheduler::retry, this, &Ups_api_library::loadAndStartDriver, Qt::QueuedConnection);
+
+    m_pluginIndex = new PluginIndex(PluginIndex::defaultPluginDir(), QString(), this);
 
-    // FIX: Use a QueuedConnection for the timer to prevent race conditions
-    connect(m_recoveryTimer, &QTimer::timeout, this, &Ups_api_library::loadAndStartDriver, Qt::QueuedConnection);
-    connect(this, &Ups_api_library::driverInitSuccess, this, &Ups_api_library::onDriverInitSuccess);
-    connect(this, &Ups_api_library::driverInitFailure, this, &Ups_api_library::onDriverInitFailure);
+    m_prober = new DriverProber(m_reactors, this);
+    connect(m_prober, &DriverProber::finished, this, &Ups_api_library::onAutoDetectFinished, Qt::QueuedConnection);
+
+    // A wedged driver is found within seconds instead of at shutdown (the 3 s terminate() path)
+    m_watchdog = new ReactorWatchdog(m_reactors, this);
+    connect(m_watchdog, &ReactorWatchdog::hangDetected, this, &Ups_api_library::onReactorHang);
+    connect(m_watchdog, &ReactorWatchdog::hangCleared, this, &Ups_api_library::onReactorRecovered);
+    m_watchdog->start();
 }
 
 Ups_api_library::~Ups_api_library()
 {
-    if (m_recoveryTimer) m_recoveryTimer->stop();
+    if (m_configRecovery) m_configRecovery->cancel();
+    m_watchdog->stop();
+
+    // Configuration changes must not restart drivers that are being torn down
+    if (m_configSubscription) {
+        disconnect(m_configSubscription);
+        ConfigStore::instance().stopWatching();
+    }
 
-    if (m_registryThread) {
-        m_watcher->stopWatching();
-        m_registryThread->quit();
-        m_registryThread->wait(2000);
+    // Stop running probes silently while the reactor threads still exist
+    disconnect(m_prober, nullptr, this, nullptr);
+    delete m_prober;
+    m_prober = nullptr;
+    for (const QString& pluginPath : std::as_const(m_probePlugins)) {
+        releasePlugin(pluginPath);
     }
-    cleanupDriver();
+    m_probePlugins.clear();
+
+    const QStringList ids = m_slots.keys();
+    for (const QString& deviceId : ids) {
+        removeDriver(deviceId);
+    }
+
+    // Let retired drivers finish, then run their queued plugin releases before the threads stop
+    m_reactors.sync();
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+    m_reactors.shutdown();
 }
 
-void Ups_api_library::cleanupDriver()
+Ups_api_library::DriverSlot* Ups_api_library::ensureSlot(const QString& deviceId)
+{
+    DriverSlot*& slot = m_slots[deviceId];
+    if (!slot) {
+        slot = new DriverSlot();
+        slot->deviceId = deviceId;
+        // 1 s after the first failure, then doubling up to a minute (with jitter, so units that
+        // failed together do not retry in lockstep)
+        RecoveryScheduler::Config backoff;
+        backoff.initialDelayMs = 1000;
+        slot->recovery = new RecoveryScheduler(backoff, this);
+        connect(slot->recovery, &RecoveryScheduler::retry, this, [this, deviceId]() { restartSlot(deviceId); }, Qt::QueuedConnection);
+
+        slot->switchTimer = new QTimer(this);
+        slot->switchTimer->setSingleShot(true);
+        slot->switchTimer->setInterval(15000);
+        connect(slot->switchTimer, &QTimer::timeout, this, [this, deviceId]() {
+            if (DriverSlot *current = m_slots.value(deviceId)) abortSwitch(current, tr("New driver delivered no data"));
+        });
+    }
+    return slot;
+}
+
+void Ups_api_library::stopSlot(DriverSlot* slot)
 {
     QMutexLocker locker(&m_cleanupMutex);
-    qDebug() << "UpsApiLibrary: Starting safe cleanup...";
+    qDebug() << "UpsApiLibrary: Starting safe cleanup of" << slot->deviceId;
 
-    if (m_recoveryTimer) m_recoveryTimer->stop();
+    if (slot->recovery) slot->recovery->cancel();
 
     // --- CRITICAL ADDITION FOR GUI UPDATE ---
-    m_currentStatus.driverLoaded = false;
-    m_currentStatus.driverInitialized = false;
-    m_currentStatus.dataCommunicationActive = false;
+    slot->status.driverLoaded = false;
+    slot->status.driverInitialized = false;
+    slot->status.dataCommunicationActive = false;
     // Send an empty report: this tells the GUI that the driver is gone
-    emitUpsReport(UpsData());
+    emitUpsReport(slot, UpsData());
     // --------------------------------------------
 
-    if (m_driver && m_workerThread && m_workerThread->isRunning()) {
-        QMetaObject::invokeMethod(m_driver, "stopDriver", Qt::BlockingQueuedConnection);
-    }
+    if (slot->switchTimer) slot->switchTimer->stop();
+    retireInstance(slot->pending, true);
+    retireInstance(slot->active, true);
+}
 
-    if (m_workerThread) {
-        m_workerThread->quit();
-        if (!m_workerThread->wait(3000)) {
-            m_workerThread->terminate();
-            m_workerThread->wait();
+void Ups_api_library::retireInstance(DriverInstance& instance, bool wait)
+{
+    const DriverInstance retired = std::exchange(instance, DriverInstance());
+    if (retired.driver) {
+        IUpsDriver *driver = retired.driver;
+        SampleFilter *filter = retired.filter;
+        BatteryEstimator *estimator = retired.estimator;
+        // Explicitly disconnect old connections before deleting
+        disconnect(driver, nullptr, this, nullptr);
+        disconnect(filter, nullptr, this, nullptr);
+
+        // Stop and delete in the reactor thread that owns the driver's port and timers;
+        // the thread itself keeps serving the other units.
+        const auto teardown = [driver, filter, estimator]() {
+            QMetaObject::invokeMethod(driver, "stopDriver", Qt::DirectConnection);
+            delete driver;
+            delete filter;
+            delete estimator;
+        };
+
+        if (!wait || m_reactors.isQuarantined(retired.thread)) {
+            // Nobody waits for the old driver (or its thread hangs): its thread slot and plugin are released once it is gone
+            QThread *thread = retired.thread;
+            const QString pluginPath = retired.pluginPath;
+            m_reactors.post(thread, [this, teardown, thread, pluginPath]() {
+                teardown();
+                QMetaObject::invokeMethod(this, [this, thread, pluginPath]() {
+                    m_reactors.release(thread);
+                    if (!pluginPath.isEmpty()) releasePlugin(pluginPath);
+                }, Qt::QueuedConnection);
+            });
+            return;
         }
-        delete m_workerThread;
-        m_workerThread = nullptr;
-    }
 
-    if (m_driver) {
-        // Explicitly disconnect old connections before deleting
-        disconnect(m_driver, nullptr, this, nullptr);
-        delete m_driver;
-        m_driver = nullptr;
+        m_reactors.runBlocking(retired.thread, teardown);
+        m_reactors.release(retired.thread);
     }
 
-    if (m_pluginLoader) {
-        m_pluginLoader->unload();
-        delete m_pluginLoader;
-        m_pluginLoader = nullptr;
+    if (!retired.pluginPath.isEmpty()) {
+        releasePlugin(retired.pluginPath);
     }
 }
 
+void Ups_api_library::removeDriver(const QString& deviceId)
+{
+    DriverSlot *slot = m_slots.value(deviceId);
+    if (!slot) return;
+
+    stopSlot(slot);
+    m_slots.remove(deviceId);
+    delete slot->recovery;
+    delete slot->switchTimer;
+    delete slot;
+}
+
 bool Ups_api_library::loadAndStartDriver()
 {
-    cleanupDriver();
+    // A change of the drivers' fields is applied by onConfigChanged() while reloading
+    if (ConfigStore::instance().reload() & DRIVER_FIELDS) {
+        return m_primaryStarted;
+    }
+    return applyConfiguration(*ConfigStore::instance().snapshot());
+}
+
+bool Ups_api_library::applyConfiguration(const UpsConfig& config)
+{
+    if (m_slots.isEmpty()) {
+        // Only possible while no driver runs; ignored otherwise
+        m_reactors.setThreadCount(config.reactorThreads);
+    }
+
+    m_autoDetectEnabled = config.autoDetect;
+    m_probeTimeoutMs = config.probeTimeoutMs;
 
-    QSettings settings(AppConstants::SETTINGS_SCOPE, AppConstants::APP_ORGANIZATION_NAME, AppConstants::APP_APPLICATION_NAME);
-    settings.sync();
+    if (config.filterEnabled != m_filterConfig.enabled || config.filterHeartbeatMs != m_filterConfig.heartbeatMs) {
+        SampleFilterConfig filterConfig = m_filterConfig;
+        filterConfig.enabled = config.filterEnabled;
+        filterConfig.heartbeatMs = config.filterHeartbeatMs;
+        setSampleFilterConfig(filterConfig);
+    }
+    m_estimatorConfig.batteryBlocks = config.batteryBlocks;
+    m_estimatorConfig.fullLoadRuntimeSeconds = config.fullLoadRuntimeSeconds;
 
-    QString driverFileName = settings.value(AppConstants::REG_KEY_SELECTED_DRIVER_FILE).toString();
-    QString comPort = settings.value(AppConstants::REG_KEY_SELECTED_COM_PORT).toString();
+    ReactorWatchdog::Config watchdogConfig = m_watchdog->config();
+    watchdogConfig.hangThresholdMs = config.hangThresholdMs;
+    m_watchdog->setConfig(watchdogConfig);
 
+    // 1. The primary UPS (the classic single-driver configuration)
+    const QString& driverFileName = config.driverFileName;
+    const QString& comPort = config.comPort;
+
+    bool primaryStarted = true;
     if (driverFileName.isEmpty() || comPort.isEmpty()) {
-        onDriverInitFailure(tr("Missing configuration (Driver/Port)"));
-        return false;
+        DriverSlot *slot = ensureSlot(AppConstants::PRIMARY_DEVICE_ID);
+        stopSlot(slot);
+        slot->driverFileName.clear();
+        slot->connectionInfo.clear();
+        slot->status.lastErrorMessage = tr("Missing configuration (Driver/Port)");
+        emitUpsReport(slot);
+
+        if (autoDetectAllowed()) {
+            qDebug() << "UpsApiLibrary: No UPS configured. Starting auto-detection...";
+            startAutoDetect();
+        }
+
+        // Re-read with backoff (no-op while a retry is pending)
+        m_configRecovery->schedule();
+        primaryStarted = false;
+    } else {
+        m_configRecovery->succeeded();
+        primaryStarted = addDriver(AppConstants::PRIMARY_DEVICE_ID, driverFileName, comPort);
     }
 
-    m_currentStatus.activeDriverName = driverFileName;
-    m_currentStatus.activeComPort = comPort;
+    // 2. Additional units, each in its own subkey ("Devices/<id>/<key>")
+    QSet<QString> configured;
+    for (auto it = config.devices.constBegin(); it != config.devices.constEnd(); ++it) {
+        if (!it.value().isComplete()) {
+            qWarning() << "UpsApiLibrary: Ignoring incomplete device configuration" << it.key();
+            continue;
+        }
+        configured.insert(it.key());
+        addDriver(it.key(), it.value().driverFileName, it.value().port);
+    }
 
-    QString pluginPath = QCoreApplication::applicationDirPath() + "/common/plugins/" + driverFileName;
+    const QStringList running = m_slots.keys();
+    for (const QString& deviceId : running) {
+        if (deviceId != AppConstants::PRIMARY_DEVICE_ID && !configured.contains(deviceId)) {
+            qDebug() << "UpsApiLibrary: Device" << deviceId << "removed from the configuration.";
+            removeDriver(deviceId);
+        }
+    }
 
-    m_pluginLoader = new QPluginLoader(pluginPath, this);
-    QObject *plugin = m_pluginLoader->instance();
+    m_primaryStarted = primaryStarted;
+    return primaryStarted;
+}
 
-    if (!plugin) {
-        onDriverInitFailure(tr("Plugin load failed: %1").arg(m_pluginLoader->errorString()));
-        return false;
+DriverLinkStats Ups_api_library::linkStats(const QString& deviceId) const
+{
+    const DriverSlot *slot = m_slots.value(deviceId);
+    return (slot && slot->active.driver) ? slot->active.driver->linkStats() : DriverLinkStats();
+}
+
+quint64 Ups_api_library::latestReport(const QString& deviceId, UpsReport& report) const
+{
+    const ReportSnapshot *snapshot = m_snapshots.find(deviceId);
+    return snapshot ? snapshot->read(report) : 0;
+}
+
+quint64 Ups_api_library::reportSequence(const QString& deviceId) const
+{
+    const ReportSnapshot *snapshot = m_snapshots.find(deviceId);
+    return snapshot ? snapshot->sequence() : 0;
+}
+
+SampleFilterStats Ups_api_library::filterStats(const QString& deviceId) const
+{
+    const DriverSlot *slot = m_slots.value(deviceId);
+    return (slot && slot->active.filter) ? slot->active.filter->stats() : SampleFilterStats();
+}
+
+void Ups_api_library::setSampleFilterConfig(const SampleFilterConfig& config)
+{
+    m_filterConfig = config;
+    for (DriverSlot *slot : std::as_const(m_slots)) {
+        for (SampleFilter *filter : { slot->active.filter, slot->pending.filter }) {
+            if (!filter) continue;
+            QMetaObject::invokeMethod(filter, [filter, config]() { filter->setConfig(config); }, Qt::QueuedConnection);
+        }
+    }
+}
+
+bool Ups_api_library::startDriver(const QString& driverFileName, const QString& connectionInfo)
+{
+    return addDriver(AppConstants::PRIMARY_DEVICE_ID, driverFileName, connectionInfo);
+}
+
+bool Ups_api_library::addDriver(const QString& deviceId, const QString& driverFileName, const QString& connectionInfo)
+{
+    DriverSlot *slot = ensureSlot(deviceId);
+    const auto runs = [&](const DriverInstance& instance) {
+        return instance.driver && instance.driverFileName == driverFileName && instance.connectionInfo == connectionInfo;
+    };
+    if (runs(slot->pending)) {
+        return true; // Switchover to this configuration is under way
+    }
+    if (runs(slot->active)) {
+        if (slot->pending.driver) {
+            // Switched back before the replacement took over
+            slot->switchTimer->stop();
+            retireInstance(slot->pending, false);
+        }
+        slot->driverFileName = driverFileName;
+        slot->connectionInfo = connectionInfo;
+        return true; // Already running with this configuration
+    }
+
+    slot->driverFileName = driverFileName;
+    slot->connectionInfo = connectionInfo;
+
+    // Make-before-break: a driver that delivers data keeps doing so until its successor does
+    if (slot->active.driver && slot->status.dataCommunicationActive) {
+        return switchSlot(slot);
+    }
+    stopSlot(slot);
+    return startSlot(slot);
+}
+
+bool Ups_api_library::addDriverInstance(const QString& deviceId, IUpsDriver* driver, const QString& connectionInfo)
+{
+    DriverSlot *slot = ensureSlot(deviceId);
+    stopSlot(slot);
+    slot->driverFileName.clear();
+    slot->connectionInfo = connectionInfo;
+    return startSlot(slot, driver);
+}
+
+void Ups_api_library::restartSlot(const QString& deviceId)
+{
+    DriverSlot *slot = m_slots.value(deviceId);
+    if (!slot || slot->driverFileName.isEmpty()) return; // Caller-provided instances are not recreated
+
+    // A failed switchover is retried while the old driver keeps reporting
+    if (slot->active.driver && slot->status.dataCommunicationActive) {
+        if (slot->active.driverFileName != slot->driverFileName || slot->active.connectionInfo != slot->connectionInfo) {
+            switchSlot(slot);
+        }
+        return;
+    }
+
+    stopSlot(slot);
+    startSlot(slot);
+}
+
+bool Ups_api_library::switchSlot(DriverSlot* slot)
+{
+    qDebug() << "UpsApiLibrary: Switching" << slot->deviceId << "to" << slot->driverFileName << "on" << slot->connectionInfo;
+    if (slot->recovery) slot->recovery->cancel();
+    slot->switchTimer->stop();
+
+    // A port opens only once: an instance holding the port we need must let go first.
+    // Without a second port no reports are lost either; the last one stays valid until the new driver delivers.
+    retireInstance(slot->pending, slot->pending.connectionInfo == slot->connectionInfo);
+    if (slot->active.connectionInfo == slot->connectionInfo) {
+        retireInstance(slot->active, true);
     }
 
-    m_driver = qobject_cast<IUpsDriver*>(plugin);
-    if (!m_driver) {
-        onDriverInitFailure(tr("Invalid Interface"));
-        delete plugin;
+    QString error;
+    if (!startInstance(slot, slot->pending, nullptr, error)) {
+        abortSwitch(slot, error);
         return false;
     }
+    slot->switchTimer->start();
+    return true;
+}
 
-    m_driver->setParent(nullptr);
-    m_driver->moveToThread(this->thread());
+void Ups_api_library::promotePending(DriverSlot* slot)
+{
+    slot->switchTimer->stop();
+    retireInstance(slot->active, false);
+    slot->active = std::exchange(slot->pending, DriverInstance());
+    qDebug() << "UpsApiLibrary:" << slot->deviceId << "now served by" << slot->active.driverFileName << "on" << slot->active.connectionInfo;
+
+    slot->status.activeDriverName = slot->active.driverFileName;
+    slot->status.activeComPort = slot->active.connectionInfo;
+    slot->status.driverLoaded = true;
+    slot->status.driverInitialized = true;
+    slot->status.lastErrorMessage.clear();
+    if (slot->deviceId == AppConstants::PRIMARY_DEVICE_ID) m_primaryFailures = 0;
+}
 
-    m_currentStatus.driverLoaded = true;
-    m_workerThread = new QThread(this);
+void Ups_api_library::abortSwitch(DriverSlot* slot, const QString& error)
+{
+    slot->switchTimer->stop();
+    retireInstance(slot->pending, false);
+
+    if (!slot->active.driver) {
+        // The old driver already gave up its port: this is an ordinary failure now
+        slot->status.driverLoaded = false;
+        slot->status.dataCommunicationActive = false;
+        reportFailure(slot, error);
+        return;
+    }
 
-    // Move to worker thread
-    m_driver->moveToThread(m_workerThread);
+    // The old driver keeps reporting; the recovery scheduler retries the switch
+    qWarning() << "UpsApiLibrary: Switchover of" << slot->deviceId << "failed:" << error;
+    slot->status.lastErrorMessage = error;
+    if (slot->recovery) slot->recovery->schedule();
+    emit driverInitFailure(slot->deviceId, error);
+}
 
-    // Connections with QueuedConnection for thread safety to the GUI
-    connect(m_driver, &IUpsDriver::dataReceived, this, &Ups_api_library::handleDriverData, Qt::QueuedConnection);
-    connect(m_driver, &IUpsDriver::initializationFailure, this, &Ups_api_library::driverInitFailure, Qt::QueuedConnection);
-    connect(m_driver, &IUpsDriver::initializationSuccess, this, &Ups_api_library::driverInitSuccess, Qt::QueuedConnection);
+QString Ups_api_library::pluginPathFor(const QString& driverFileName) const
+{
+    return QDir::isAbsolutePath(driverFileName) ? driverFileName : m_pluginIndex->pluginPath(driverFileName);
+}
 
-    connect(m_workerThread, &QThread::started, [this, comPort](){
-        if (m_driver) {
-            m_driver->initialize(comPort);
+IUpsDriver* Ups_api_library::acquireFactory(const QString& pluginPath, QString& error)
+{
+    // Counts as a reference even on failure: every acquire is paired with releasePlugin()
+    PluginRef &plugin = m_plugins[pluginPath];
+    if (!plugin.loader) {
+        plugin.loader = new QPluginLoader(pluginPath, this);
+    }
+    ++plugin.users;
+
+    // The root instance is only a factory: it stays in this thread and is deleted on unload
+    QObject *root = plugin.loader->instance();
+    if (!root) {
+        error = tr("Plugin load failed: %1").arg(plugin.loader->errorString());
+        return nullptr;
+    }
+
+    IUpsDriver *factory = qobject_cast<IUpsDriver*>(root);
+    if (!factory) {
+        error = tr("Invalid Interface");
+    }
+    return factory;
+}
+
+IUpsDriver* Ups_api_library::createDriver(const QString& driverFileName, QString& pluginPath, QString& error)
+{
+    pluginPath = pluginPathFor(driverFileName);
+
+    IUpsDriver *factory = acquireFactory(pluginPath, error);
+    if (!factory) {
+        return nullptr;
+    }
+
+    IUpsDriver *driver = factory->createInstance();
+    if (!driver) {
+        error = tr("Driver %1 cannot create instances").arg(driverFileName);
+    }
+    return driver;
+}
+
+void Ups_api_library::releasePlugin(const QString& pluginPath)
+{
+    auto it = m_plugins.find(pluginPath);
+    if (it == m_plugins.end()) return;
+
+    if (--it->users <= 0) {
+        it->loader->unload();
+        delete it->loader;
+        m_plugins.erase(it);
+    }
+}
+
+bool Ups_api_library::startSlot(DriverSlot* slot, IUpsDriver* driver)
+{
+    slot->status.activeDriverName = driver ? driver->driverName() : slot->driverFileName;
+    slot->status.activeComPort = slot->connectionInfo;
+
+    QString error;
+    if (!startInstance(slot, slot->active, driver, error)) {
+        reportFailure(slot, error);
+        return false;
+    }
+    slot->status.driverLoaded = true;
+    return true;
+}
+
+bool Ups_api_library::startInstance(DriverSlot* slot, DriverInstance& instance, IUpsDriver* driver, QString& error)
+{
+    instance = DriverInstance();
+    instance.driverFileName = slot->driverFileName;
+    instance.connectionInfo = slot->connectionInfo;
+
+    if (!driver) {
+        driver = createDriver(slot->driverFileName, instance.pluginPath, error);
+        if (!driver) {
+            retireInstance(instance, true); // Drops the plugin reference
+            return false;
         }
-    });
+    }
+
+    driver->setParent(nullptr);
+
+    const QString capturePath = captureFileFor(slot->deviceId);
+    if (!capturePath.isEmpty() && !driver->setCaptureFile(capturePath)) {
+        qWarning() << "UpsApiLibrary: Raw capture disabled, cannot write" << capturePath;
+    }
+
+    instance.driver = driver;
+    instance.thread = m_reactors.acquire();
+    const QString deviceId = slot->deviceId;
+    const quint64 generation = instance.generation = ++slot->generation;
+
+    // Move to the reactor thread, together with the estimator and the filter that screens its samples
+    SampleFilter *filter = instance.filter = new SampleFilter(m_filterConfig);
+    BatteryEstimator *estimator = instance.estimator = new BatteryEstimator(m_estimatorConfig);
+    driver->moveToThread(instance.thread);
+    filter->moveToThread(instance.thread);
+    m_reactors.watch(instance.thread, driver, deviceId); // Names the unit in a hang report
+
+    // Direct hop into estimator and filter: suppressed samples are dropped in the reactor thread.
+    // Accepted samples continue with QueuedConnection for thread safety to the GUI.
+    connect(driver, &IUpsDriver::dataReceived, filter, [filter, estimator](const UpsData& data) {
+        UpsData sample = data;
+        estimator->update(sample);
+        filter->process(sample);
+    }, Qt::DirectConnection);
+    connect(filter, &SampleFilter::sampleAccepted, this, [this, deviceId, generation](const UpsData& data) {
+        handleDriverData(deviceId, generation, data);
+    }, Qt::QueuedConnection);
+    connect(driver, &IUpsDriver::initializationFailure, this, [this, deviceId, generation](const QString& error) {
+        onDriverInitFailure(deviceId, generation, error);
+    }, Qt::QueuedConnection);
+    connect(driver, &IUpsDriver::initializationSuccess, this, [this, deviceId, generation]() {
+        onDriverInitSuccess(deviceId, generation);
+    }, Qt::QueuedConnection);
+
+    // The reactor thread is already running: queue initialize() into its event loop
+    const QString connectionInfo = instance.connectionInfo;
+    QMetaObject::invokeMethod(driver, [driver, connectionInfo]() {
+        driver->initialize(connectionInfo);
+    }, Qt::QueuedConnection);
 
-    m_workerThread->start();
     return true;
 }
 
-void Ups_api_library::onDriverInitFailure(const QString& error)
+QString Ups_api_library::captureFileFor(const QString& deviceId) const
 {
-    m_currentStatus.driverInitialized = false;
-    m_currentStatus.lastErrorMessage = error;
-    emitUpsReport();
+    if (m_captureFile.isEmpty() || deviceId == AppConstants::PRIMARY_DEVICE_ID) {
+        return m_captureFile;
+    }
+    const QFileInfo info(m_captureFile);
+    const QString name = info.completeBaseName() + "." + deviceId
+                         + (info.suffix().isEmpty() ? QString() : "." + info.suffix());
+    return info.dir().filePath(name);
+}
+
+void Ups_api_library::reportFailure(DriverSlot* slot, const QString& error)
+{
+    slot->status.driverInitialized = false;
+    slot->status.lastErrorMessage = error;
+    emitUpsReport(slot);
+
+    // A primary UPS that keeps failing is probably configured with the wrong port or driver
+    if (slot->deviceId == AppConstants::PRIMARY_DEVICE_ID && ++m_primaryFailures >= 3 && autoDetectAllowed()) {
+        qDebug() << "UpsApiLibrary: Primary UPS failed" << m_primaryFailures << "times. Starting auto-detection...";
+        emit driverInitFailure(slot->deviceId, error);
+        startAutoDetect();
+        return;
+    }
 
-    // FIX: Start the timer only if it is not already running to prevent 'spamming'
-    if (m_recoveryTimer && !m_recoveryTimer->isActive()) {
-        qDebug() << "UpsApiLibrary: Starting recovery timer...";
-        m_recoveryTimer->start();
+    // Backoff: no-op while a retry is already pending, so repeated failures do not pile up
+    if (slot->recovery && !slot->recovery->isPending()) {
+        slot->recovery->schedule();
+        qDebug() << "UpsApiLibrary: Recovery attempt" << slot->recovery->attempts() << "for" << slot->deviceId << "scheduled";
     }
+    emit driverInitFailure(slot->deviceId, error);
 }
 
-void Ups_api_library::onDriverInitSuccess()
+void Ups_api_library::onDriverInitFailure(const QString& deviceId, quint64 generation, const QString& error)
 {
-    m_currentStatus.driverInitialized = true;
-    m_currentStatus.lastErrorMessage.clear();
-    if (m_recoveryTimer) m_recoveryTimer->stop(); // Stop recovery on success
+    DriverSlot *slot = m_slots.value(deviceId);
+    if (!slot) return;
+    if (slot->pending.driver && slot->pending.generation == generation) {
+        abortSwitch(slot, error);
+        return;
+    }
+    if (slot->active.generation != generation) return; // Signal from a driver that was already replaced
+
+    reportFailure(slot, error);
+}
+
+void Ups_api_library::onDriverInitSuccess(const QString& deviceId, quint64 generation)
+{
+    DriverSlot *slot = m_slots.value(deviceId);
+    if (!slot) return;
+    if (slot->pending.driver && slot->pending.generation == generation) {
+        // Not promoted yet: the old driver stays the source until the new one delivers data
+        qDebug() << "UpsApiLibrary: Replacement driver for" << deviceId << "initialized, waiting for data...";
+        return;
+    }
+    if (slot->active.generation != generation) return;
+
+    slot->status.driverInitialized = true;
+    slot->status.lastErrorMessage.clear();
+    if (deviceId == AppConstants::PRIMARY_DEVICE_ID) m_primaryFailures = 0;
+    if (slot->recovery) slot->recovery->cancel(); // The backoff is only reset once data flows
 
     // We do not emit a report yet, or we flag it as 'not active'
-    m_currentStatus.dataCommunicationActive = false;
-    emitUpsReport();
+    slot->status.dataCommunicationActive = false;
+    emitUpsReport(slot);
+    emit driverInitSuccess(deviceId);
 }
 
-void Ups_api_library::handleDriverData(const UpsData& data)
+void Ups_api_library::handleDriverData(const QString& deviceId, quint64 generation, const UpsData& data)
 {
+    DriverSlot *slot = m_slots.value(deviceId);
+    if (!slot) return;
+    if (slot->pending.driver && slot->pending.generation == generation) {
+        if (data.state == UpsMonitor::UpsState::Unknown) return;
+        promotePending(slot); // First valid sample: the replacement takes over
+    } else if (slot->active.generation != generation) {
+        return;
+    }
+
     // Once this slot is called, we know the driver has processed a valid D-record.
-    m_currentStatus.dataCommunicationActive = true;
-    emitUpsReport(data);
+    // The first real sample after a driver restart ends the outage
+    if (slot->recovery && slot->recovery->isRecovering() && data.state != UpsMonitor::UpsState::Unknown) {
+        const quint64 ms = static_cast<quint64>(slot->recovery->succeeded() / 1000000);
+        ++slot->recoveries;
+        slot->lastRecoveryMs = ms;
+        slot->maxRecoveryMs = std::max(slot->maxRecoveryMs, ms);
+        qDebug() << "UpsApiLibrary:" << deviceId << "recovered after" << ms << "ms";
+    }
+    slot->status.dataCommunicationActive = true;
+    emitUpsReport(slot, data);
 }
 
-void Ups_api_library::emitUpsReport(const UpsData& data)
+void Ups_api_library::emitUpsReport(DriverSlot* slot, const UpsData& data)
 {
-    m_currentStatus.timestamp = QDateTime::currentDateTime();
+    slot->status.timestampNs = UpsClock::nowNs();
+    // Relaxed atomic reads: never waits for the reactor thread
+    slot->status.linkStats = slot->active.driver ? slot->active.driver->linkStats() : DriverLinkStats();
+    // Driver restarts add to the driver's own reconnects; a restarted driver starts counting from zero
+    DriverLinkStats& stats = slot->status.linkStats;
+    if (stats.recoveries == 0) stats.lastRecoveryMs = slot->lastRecoveryMs;
+    stats.recoveries += slot->recoveries;
+    stats.maxRecoveryMs = std::max(stats.maxRecoveryMs, slot->maxRecoveryMs);
     UpsReport report;
-    report.serviceStatus = m_currentStatus;
+    report.deviceId = slot->deviceId;
+    report.serviceStatus = slot->status;
     report.data = data;
 
     // If communication is not active (e.g., during init or after cleanup), we overwrite the data with safe 'Unknown' values for the GUI/Tray.
-    if (!m_currentStatus.dataCommunicationActive) {
-        report.data.statusMessage = tr("No active connection");
-        report.data.batteryLevel = 0;
-        report.data.state = UpsMonitor::UpsState::Unknown;
-        report.data.inputVoltage = 0;
-        report.data.outputVoltage = 0;
-        report.data.batteryVoltage = 0;
-        report.data.temperatureC = 0;
-        report.data.loadPercentage = 0;
-        report.data.timestamp = QDateTime::currentDateTime();
-        report.data.BatteryFault = false;
+    if (!slot->status.dataCommunicationActive) {
+        report.data = UpsData(); // Unknown state, zero readings, unknown runtime
+        report.data.statusCode = UpsMonitor::StatusCode::NoConnection;
+        report.data.timestampNs = slot->status.timestampNs;
     }
 
+    if (ReportSnapshot *snapshot = m_snapshots.acquire(slot->deviceId)) {
+        snapshot->publish(report);
+    }
     emit upsReportAvailable(report);
 }
 
-void Ups_api_library::startService()
+void Ups_api_library::onReactorHang(QThread* thread, ReactorHangReport report)
+{
+    QList<DriverSlot*> affected;
+    for (DriverSlot *slot : std::as_const(m_slots)) {
+        if (slot->active.thread == thread || slot->pending.thread == thread) {
+            affected.append(slot);
+            report.deviceIds.append(slot->deviceId);
+        }
+    }
+    qCritical().noquote() << "UpsApiLibrary: Reactor thread hang:" << report.toString();
+    emit reactorHang(report);
+
+    // Quarantine first: the restarted units land on a live thread and nobody waits for the stuck one.
+    // Their old drivers are deleted there if it ever comes back.
+    m_reactors.setQuarantined(thread, true);
+    const QString error = tr("Driver thread did not respond for %1 s; driver restarted").arg(report.stalledMs / 1000);
+    for (DriverSlot *slot : std::as_const(affected)) {
+        stopSlot(slot);
+        slot->status.lastErrorMessage = error;
+        if (slot->driverFileName.isEmpty()) {
+            emitUpsReport(slot); // Caller-provided instances are not recreated
+            continue;
+        }
+        startSlot(slot);
+    }
+}
+
+void Ups_api_library::onReactorRecovered(QThread* thread, qint64 stalledMs)
+{
+    qWarning() << "UpsApiLibrary:" << thread->objectName() << "responds again after" << stalledMs << "ms";
+    m_reactors.setQuarantined(thread, false);
+}
+
+bool Ups_api_library::autoDetectAllowed() const
 {
-    // Registry watcher setup (simplified for stability)
-    if (!m_watcher) {
-        m_registryThread = new QThread(this);
-        m_watcher = new RegistryWatcher();
-        m_watcher->moveToThread(m_registryThread);
+    constexpr qint64 AUTO_DETECT_INTERVAL_MS = 60000;
+    return m_autoDetectEnabled && !m_prober->isRunning()
+           && (!m_lastAutoDetect.isValid() || m_lastAutoDetect.elapsed() >= AUTO_DETECT_INTERVAL_MS);
+}
 
-        connect(m_watcher, &RegistryWatcher::settingsChanged, this, &Ups_api_library::onRegistryChanged);
-        m_registryThread->start();
-        QMetaObject::invokeMethod(m_watcher, "startWatching", Qt::QueuedConnection, Q_ARG(QString, ""));
+bool Ups_api_library::startAutoDetect()
+{
+    if (m_prober->isRunning()) return false;
+    m_lastAutoDetect.start();
+
+    // The primary UPS may hold the very port we need to probe
+    if (DriverSlot *primary = m_slots.value(AppConstants::PRIMARY_DEVICE_ID)) {
+        if (primary->recovery) primary->recovery->cancel();
+        if (primary->active.driver || primary->pending.driver) stopSlot(primary);
     }
 
-    loadAndStartDriver();
+    // Candidates: every plugin that talks to a serial port (portType in its metadata)
+    QList<DriverProber::Candidate> candidates;
+    m_pluginIndex->refresh();
+    const QList<PluginIndex::Entry> plugins = m_pluginIndex->plugins();
+    for (const PluginIndex::Entry& plugin : plugins) {
+        if (plugin.pluginMetaData().value("portType").toString() != QLatin1String("serial")) continue;
+        const QString& file = plugin.fileName;
+        const QString pluginPath = m_pluginIndex->pluginPath(file);
+
+        QString error;
+        IUpsDriver *factory = acquireFactory(pluginPath, error);
+        m_probePlugins << pluginPath;
+        if (!factory) {
+            qWarning() << "UpsApiLibrary: Skipping" << file << "for auto-detection:" << error;
+            continue;
+        }
+        candidates.append({ file, factory });
+    }
+
+    // Ports other units are using stay untouched
+    QSet<QString> busy;
+    for (const DriverSlot *slot : std::as_const(m_slots)) {
+        if (slot->active.driver) busy.insert(slot->active.connectionInfo);
+        if (slot->pending.driver) busy.insert(slot->pending.connectionInfo);
+    }
+    QStringList ports;
+    const QList<QSerialPortInfo> available = QSerialPortInfo::availablePorts();
+    for (const QSerialPortInfo& info : available) {
+        if (!busy.contains(info.portName())) ports << info.portName();
+    }
+
+    return m_prober->start(candidates, ports, m_probeTimeoutMs);
 }
 
-void Ups_api_library::onRegistryChanged()
+void Ups_api_library::onAutoDetectFinished(bool found, const QString& driverFileName, const QString& port, qint64 elapsedMs)
 {
-    QSettings settings(AppConstants::SETTINGS_SCOPE,
-                       AppConstants::APP_ORGANIZATION_NAME,
-                       AppConstants::APP_APPLICATION_NAME);
-    settings.sync();
+    for (const QString& pluginPath : std::as_const(m_probePlugins)) {
+        releasePlugin(pluginPath);
+    }
+    m_probePlugins.clear();
 
-    QString newDriver = settings.value(AppConstants::REG_KEY_SELECTED_DRIVER_FILE).toString();
-    QString newPort = settings.value(AppConstants::REG_KEY_SELECTED_COM_PORT).toString();
+    if (found) {
+        qDebug() << "UpsApiLibrary: Auto-detected" << driverFileName << "on" << port << "in" << elapsedMs << "ms";
+        m_primaryFailures = 0;
+    } else {
+        qDebug() << "UpsApiLibrary: Auto-detection found no UPS in" << elapsedMs << "ms";
+    }
+
+    // Storing the pair publishes it, and onConfigChanged() starts it
+    ConfigStore& config = ConfigStore::instance();
+    const quint64 version = config.version();
+    if (found && !config.apply({ { AppConstants::REG_KEY_SELECTED_DRIVER_FILE, driverFileName },
+                                 { AppConstants::REG_KEY_SELECTED_COM_PORT, port } })) {
+        qWarning() << "UpsApiLibrary: Cannot store the detected UPS.";
+    }
 
-    // CHECK: Is the driver or the port actually different from what is currently running?
-    if (newDriver != m_currentStatus.activeDriverName || newPort != m_currentStatus.activeComPort) {
-        qDebug() << "UpsApiLibrary: Hardware settings changed. Restarting driver...";
+    emit autoDetectFinished(found, driverFileName, port);
+
+    // Nothing new was published: resume retrying the stored configuration
+    if (config.version() == version) {
         loadAndStartDriver();
-    } else {
-        qDebug() << "UpsApiLibrary: Only logical settings changed. No driver restart required.";
     }
 }
+
+void Ups_api_library::startService()
+{
+    // Configuration changes: event driven on our own thread (registry key or settings file)
+    if (!m_configSubscription) {
+        m_configSubscription = ConfigStore::instance().subscribe(DRIVER_FIELDS, this, [this](const ConfigDiff& diff) {
+            onConfigChanged(diff);
+        });
+        ConfigStore::instance().startWatching();
+    }
+
+    // Keeps the shared index current after an upgrade; the GUI then reads it without scanning
+    m_pluginIndex->refresh();
+    const PluginIndex::RefreshStats indexStats = m_pluginIndex->lastRefresh();
+    qDebug() << "UpsApiLibrary: Plugin index:" << indexStats.files << "files," << indexStats.scanned << "scanned in"
+             << indexStats.elapsedUs << "us";
+
+    loadAndStartDriver();
+}
+
+void Ups_api_library::onConfigChanged(const ConfigDiff& diff)
+{
+    // addDriver() only restarts units whose driver or port actually changed
+    qDebug() << "UpsApiLibrary: Configuration version" << diff.current->version
+             << "concerns the drivers. Re-applying device configuration...";
+    applyConfiguration(*diff.current);
+}
@@ -21,13 +21,25 @@
 
 #include "lightups_api_global.h"
 #include "i_ups_driver.h"
-#include "registry_watcher.h"
+#include "config_store.h"
+#include "driver_reactor_pool.h"
+#include "sample_filter.h"
+#include "battery_estimator.h"
+#include "driver_prober.h"
+#include "report_snapshot.h"
+#include "recovery_scheduler.h"
+#include "reactor_watchdog.h"
+#include "plugin_index.h"
 #include "ups_report.h"
 #include <QObject>
 #include <QThread>
 #include <QPluginLoader>
 #include <QTimer>
 #include <QMutex>
+#include <QMap>
+#include <QHash>
+#include <QStringList>
+#include <QElapsedTimer>
 
 class UPS_API_LIBRARY_EXPORT Ups_api_library : public QObject
 {
@@ -38,34 +50,200 @@ public:
 
     void startService();
 
+    /**
+     * @brief Loads @p driverFileName (a file name in common/plugins or an absolute path)
+     * and starts it with @p connectionInfo as the primary UPS, bypassing the stored configuration.
+     * Used by tools such as the capture replayer.
+     */
+    bool startDriver(const QString& driverFileName, const QString& connectionInfo);
+
+    /**
+     * @brief Starts (or restarts) a driver for the UPS identified by @p deviceId.
+     * Every report it produces carries @p deviceId. All drivers share the reactor threads.
+     */
+    bool addDriver(const QString& deviceId, const QString& driverFileName, const QString& connectionInfo);
+
+    /**
+     * @brief Same as addDriver(), but with a driver object created by the caller instead of a plugin.
+     * The library takes ownership of @p driver. Intended for benchmarks and embedding.
+     */
+    bool addDriverInstance(const QString& deviceId, IUpsDriver* driver, const QString& connectionInfo);
+
+    /**
+     * @brief Stops and removes the driver for @p deviceId (a final "driver gone" report is sent).
+     */
+    void removeDriver(const QString& deviceId);
+
+    QStringList deviceIds() const { return m_slots.keys(); }
+
+    /**
+     * @brief Probes every serial port with every serial driver plugin at once (see DriverProber).
+     * The primary UPS is stopped while probing. On success the pair is stored as the primary
+     * configuration and started; autoDetectFinished() reports the outcome either way.
+     * @return false if a detection is already running.
+     */
+    bool startAutoDetect();
+    bool isAutoDetecting() const { return m_prober->isRunning(); }
+
+    /**
+     * @brief Current link counters of the driver for @p deviceId (zero if it does not run).
+     */
+    DriverLinkStats linkStats(const QString& deviceId) const;
+
+    /**
+     * @brief Copies the latest report of @p deviceId into @p report, without the event loop.
+     * Wait-free and safe from any thread; meant for pull-style consumers such as metrics or CLI queries.
+     * @return Sequence number of the report (0 if none was published yet). It grows with every report.
+     */
+    quint64 latestReport(const QString& deviceId, UpsReport& report) const;
+
+    /**
+     * @brief Sequence number of the latest report of @p deviceId: a cheap "did anything change?" check.
+     */
+    quint64 reportSequence(const QString& deviceId) const;
+
+    /**
+     * @brief Counters of the change-detection filter of @p deviceId (zero if no driver runs).
+     */
+    SampleFilterStats filterStats(const QString& deviceId) const;
+
+    /**
+     * @brief Deadbands and heartbeat for all units. Applies to running drivers as well.
+     */
+    void setSampleFilterConfig(const SampleFilterConfig& config);
+    SampleFilterConfig sampleFilterConfig() const { return m_filterConfig; }
+
+    /**
+     * @brief Battery model for the state-of-charge and runtime estimates. Used by drivers started from now on.
+     */
+    void setBatteryEstimatorConfig(const BatteryEstimatorConfig& config) { m_estimatorConfig = config; }
+
+    /**
+     * @brief Number of threads that serve all drivers (default 1). Takes effect while no driver runs.
+     */
+    bool setReactorThreadCount(int count) { return m_reactors.setThreadCount(count); }
+    int reactorThreadCount() const { return m_reactors.threadCount(); }
+
+    /**
+     * @brief Heartbeat latency and hang counters per reactor thread.
+     */
+    QList<ReactorWatchdog::ThreadStats> reactorStats() const { return m_watchdog->stats(); }
+
+    /**
+     * @brief Records the raw bytes of every driver started from now on into @p path.
+     * Units other than the primary one write to "<name>.<deviceId>.<suffix>".
+     */
+    void setCaptureFile(const QString& path) { m_captureFile = path; }
+
 Q_SIGNALS:
     void upsReportAvailable(const UpsReport& report);
-    void driverInitSuccess();
-    void driverInitFailure(const QString& error);
+    void driverInitSuccess(const QString& deviceId);
+    void driverInitFailure(const QString& deviceId, const QString& error);
+    void autoDetectFinished(bool found, const QString& driverFileName, const QString& port);
+
+    /**
+     * @brief A reactor thread stopped responding; its units are being restarted on another thread.
+     */
+    void reactorHang(const ReactorHangReport& report);
 
 private Q_SLOTS:
-    void handleDriverData(const UpsData& data);
-    void onDriverInitSuccess();
-    void onDriverInitFailure(const QString& error);
-    bool loadAndStartDriver(); // Now a slot for safe restarts
-    void onRegistryChanged(); // The intermediate step
+    bool loadAndStartDriver(); // Applies the stored configuration (also used for safe restarts)
+    void onConfigChanged(const ConfigDiff& diff); // Only subscribed to the fields of the drivers
 
 private:
-    void cleanupDriver();
-    void emitUpsReport(const UpsData& data = UpsData());
+    /**
+     * @brief One running driver together with the pipeline that screens its samples.
+     */
+    struct DriverInstance {
+        IUpsDriver *driver = nullptr;
+        SampleFilter *filter = nullptr; // Lives next to the driver in its reactor thread
+        BatteryEstimator *estimator = nullptr; // Runs in the reactor thread, before the filter
+        QThread *thread = nullptr;     // Reactor thread serving this driver
+        QString pluginPath;            // Empty for driver objects passed to addDriverInstance()
+        QString driverFileName;
+        QString connectionInfo;
+        quint64 generation = 0;        // Queued signals of other generations are dropped
+    };
+
+    /**
+     * @brief Everything the library keeps per UPS unit.
+     *
+     * A configuration change is make-before-break: the new driver runs as 'pending' next to the
+     * active one and only takes over once it delivered its first valid sample.
+     */
+    struct DriverSlot {
+        QString deviceId;
+        QString driverFileName;        // Configured driver; empty for addDriverInstance()
+        QString connectionInfo;        // Configured port
+        DriverInstance active;         // Source of the reports
+        DriverInstance pending;        // Replacement being brought up
+        RecoveryScheduler *recovery = nullptr; // Restarts a failed driver with backoff
+        QTimer *switchTimer = nullptr; // Deadline for the pending driver to deliver data
+        quint64 generation = 0;        // Incremented per started instance
+        UpsServiceStatus status;
+        quint64 recoveries = 0;        // Driver restarts that ended with data flowing again
+        quint64 lastRecoveryMs = 0;
+        quint64 maxRecoveryMs = 0;
+    };
+
+    struct PluginRef {
+        QPluginLoader *loader = nullptr;
+        int users = 0;
+    };
+
+    bool applyConfiguration(const UpsConfig& config);
+    DriverSlot* ensureSlot(const QString& deviceId);
+    bool startSlot(DriverSlot* slot, IUpsDriver* driver = nullptr);
+    void stopSlot(DriverSlot* slot);
+    void restartSlot(const QString& deviceId);
+    bool switchSlot(DriverSlot* slot);
+    void promotePending(DriverSlot* slot);
+    void abortSwitch(DriverSlot* slot, const QString& error);
+    bool startInstance(DriverSlot* slot, DriverInstance& instance, IUpsDriver* driver, QString& error);
+    void retireInstance(DriverInstance& instance, bool wait);
+    IUpsDriver* createDriver(const QString& driverFileName, QString& pluginPath, QString& error);
+    IUpsDriver* acquireFactory(const QString& pluginPath, QString& error);
+    void releasePlugin(const QString& pluginPath);
+    QString pluginPathFor(const QString& driverFileName) const;
+    bool autoDetectAllowed() const;
+    void onAutoDetectFinished(bool found, const QString& driverFileName, const QString& port, qint64 elapsedMs);
+    QString captureFileFor(const QString& deviceId) const;
+
+    void handleDriverData(const QString& deviceId, quint64 generation, const UpsData& data);
+    void onDriverInitSuccess(const QString& deviceId, quint64 generation);
+    void onDriverInitFailure(const QString& deviceId, quint64 generation, const QString& error);
+    void reportFailure(DriverSlot* slot, const QString& error);
+    void emitUpsReport(DriverSlot* slot, const UpsData& data = UpsData());
+    void onReactorHang(QThread* thread, ReactorHangReport report);
+    void onReactorRecovered(QThread* thread, qint64 stalledMs);
 
     // Hardware/Driver components
-    IUpsDriver *m_driver = nullptr;
-    QPluginLoader *m_pluginLoader = nullptr;
-    QThread *m_workerThread = nullptr;
+    QMap<QString, DriverSlot*> m_slots;
+    QHash<QString, PluginRef> m_plugins;   // Keyed by plugin path, shared by all units using it
+    ReportSnapshotTable m_snapshots;       // Latest report per unit, for readers in other threads
+    DriverReactorPool m_reactors;
+    SampleFilterConfig m_filterConfig;
+    BatteryEstimatorConfig m_estimatorConfig;
+
+    // Auto-detection
+    DriverProber *m_prober = nullptr;
+    QStringList m_probePlugins;            // Plugin references held while probing
+    QElapsedTimer m_lastAutoDetect;        // Rate limit: opening every port is intrusive
+    bool m_autoDetectEnabled = true;
+    int m_probeTimeoutMs = 2500;
+    int m_primaryFailures = 0;             // Consecutive init failures of the primary UPS
 
     // Monitoring components
-    RegistryWatcher *m_watcher = nullptr;
-    QThread *m_registryThread = nullptr;
-    QTimer *m_recoveryTimer = nullptr;
+    QMetaObject::Connection m_configSubscription; // Set once the service runs
+    bool m_primaryStarted = false;         // Result of the last applyConfiguration()
+    RecoveryScheduler *m_configRecovery = nullptr; // Re-reads the configuration while it is incomplete
+    ReactorWatchdog *m_watchdog = nullptr; // Restarts the units of a reactor thread that hangs
+    PluginIndex *m_pluginIndex = nullptr;  // Plugin metadata without opening every library
+
+    // Raw serial capture (empty = disabled)
+    QString m_captureFile;
 
-    // Status & Thread safety
-    UpsServiceStatus m_currentStatus;
+    // Thread safety
     QMutex m_cleanupMutex;
 };
 
@@ -0,0 +1,200 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "plugin_index.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QLibrary>
+#include <QPluginLoader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+
+PluginIndex::PluginIndex(const QString& pluginDir, const QString& indexPath, QObject *parent)
+    : QObject(parent)
+    , m_pluginDir(QDir::cleanPath(QDir(pluginDir).absolutePath()))
+    , m_indexPath(indexPath)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(DEBOUNCE_MS);
+    connect(&m_debounce, &QTimer::timeout, this, [this]() {
+        if (refresh()) emit changed();
+    });
+}
+
+PluginIndex::~PluginIndex() = default;
+
+QString PluginIndex::defaultPluginDir()
+{
+    return QCoreApplication::applicationDirPath() + "/common/plugins";
+}
+
+QStringList PluginIndex::indexCandidates() const
+{
+    if (!m_indexPath.isEmpty()) return { m_indexPath };
+
+    // Shared copy first; the cache copy is for processes that may not write the installation
+    QStringList candidates = { QFileInfo(m_pluginDir).dir().filePath("plugin_index.json") };
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (!cacheDir.isEmpty()) candidates.append(cacheDir + "/plugin_index.json");
+    return candidates;
+}
+
+bool PluginIndex::load()
+{
+    const QStringList candidates = indexCandidates();
+    for (const QString& path : candidates) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) continue;
+
+        const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+        if (root.value("version").toInt() != FORMAT_VERSION || root.value("directory").toString() != m_pluginDir) {
+            continue; // Another format or another installation
+        }
+
+        const QJsonArray files = root.value("files").toArray();
+        for (const QJsonValue& value : files) {
+            const QJsonObject object = value.toObject();
+            Entry entry;
+            entry.fileName = object.value("file").toString();
+            entry.size = object.value("size").toInteger();
+            entry.modifiedMs = object.value("modified").toInteger();
+            entry.metaData = object.value("metaData").toObject();
+            if (!entry.fileName.isEmpty()) m_entries.insert(entry.fileName, entry);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool PluginIndex::save() const
+{
+    QStringList names = m_entries.keys();
+    std::sort(names.begin(), names.end());
+    QJsonArray files;
+    for (const QString& name : std::as_const(names)) {
+        const Entry entry = m_entries.value(name);
+        QJsonObject object;
+        object.insert("file", entry.fileName);
+        object.insert("size", entry.size);
+        object.insert("modified", entry.modifiedMs);
+        if (!entry.metaData.isEmpty()) object.insert("metaData", entry.metaData);
+        files.append(object);
+    }
+    QJsonObject root;
+    root.insert("version", FORMAT_VERSION);
+    root.insert("directory", m_pluginDir);
+    root.insert("files", files);
+    const QByteArray bytes = QJsonDocument(root).toJson(QJsonDocument::Compact);
+
+    // Written aside and renamed: a reader never sees half an index
+    const QStringList candidates = indexCandidates();
+    for (const QString& path : candidates) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QSaveFile file(path);
+        if (file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size() && file.commit()) {
+            return true;
+        }
+    }
+    qWarning() << "PluginIndex: Cannot save the plugin index; the next start scans the plugins again.";
+    return false;
+}
+
+bool PluginIndex::refresh()
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_loaded) {
+        load();
+        m_loaded = true;
+    }
+
+    RefreshStats stats;
+    bool dirty = false;
+    QHash<QString, Entry> current;
+
+    // One directory listing: the size and time come with it, no file is opened
+    const QFileInfoList infos = QDir(m_pluginDir).entryInfoList(QDir::Files, QDir::Name);
+    stats.files = infos.size();
+    for (const QFileInfo& info : infos) {
+        const QString fileName = info.fileName();
+        const qint64 modifiedMs = info.lastModified().toMSecsSinceEpoch();
+
+        const auto known = m_entries.constFind(fileName);
+        if (known != m_entries.constEnd() && known->size == info.size() && known->modifiedMs == modifiedMs) {
+            current.insert(fileName, *known);
+            ++stats.reused;
+            continue;
+        }
+
+        Entry entry;
+        entry.fileName = fileName;
+        entry.size = info.size();
+        entry.modifiedMs = modifiedMs;
+        if (QLibrary::isLibrary(info.filePath())) {
+            entry.metaData = QPluginLoader(info.filePath()).metaData(); // Reads the file, does not load it
+        }
+        current.insert(fileName, entry);
+        ++stats.scanned;
+        dirty = true;
+    }
+
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (!current.contains(it.key())) ++stats.removed;
+    }
+    dirty = dirty || stats.removed > 0;
+    m_entries = std::move(current);
+
+    if (dirty) save();
+    stats.elapsedUs = timer.nsecsElapsed() / 1000;
+    m_lastRefresh = stats;
+    return dirty;
+}
+
+QList<PluginIndex::Entry> PluginIndex::plugins() const
+{
+    QList<Entry> result;
+    for (const Entry& entry : m_entries) {
+        if (!entry.metaData.isEmpty()) result.append(entry);
+    }
+    std::sort(result.begin(), result.end(), [](const Entry& a, const Entry& b) { return a.fileName < b.fileName; });
+    return result;
+}
+
+void PluginIndex::setWatching(bool enabled)
+{
+    if (!enabled) {
+        delete m_watcher;
+        m_watcher = nullptr;
+        m_debounce.stop();
+        return;
+    }
+    if (m_watcher) return;
+
+    // Copying a plugin fires several changes: one refresh once it settled
+    m_watcher = new QFileSystemWatcher(this);
+    m_watcher->addPath(m_pluginDir);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, &m_debounce, qOverload<>(&QTimer::start));
+}
@@ -0,0 +1,118 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLUGIN_INDEX_H
+#define PLUGIN_INDEX_H
+
+#include "lightups_api_global.h"
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+class QFileSystemWatcher;
+
+/**
+ * @brief On-disk index of the driver plugins' metadata, shared by the GUI and the service.
+ *
+ * Reading a plugin's JSON metadata means opening and scanning the whole library. The index
+ * remembers it per file, keyed by size and modification time, so a startup with unchanged plugins
+ * only lists the directory. refresh() reads just the files that are new or changed and drops the
+ * ones that are gone. The index is stored next to the plugin directory (written by the service,
+ * which may write there); a process that cannot write it keeps its own copy in its cache location.
+ *
+ * With setWatching(true) the directory is watched and changed() follows a debounced refresh.
+ * Not thread-safe: use it from the owner thread.
+ */
+class UPS_API_LIBRARY_EXPORT PluginIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr int FORMAT_VERSION = 1;
+    static constexpr int DEBOUNCE_MS = 250;
+
+    struct Entry {
+        QString fileName;
+        qint64 size = 0;
+        qint64 modifiedMs = 0;
+        QJsonObject metaData;       // QPluginLoader::metaData(); empty if the file is no plugin
+
+        /**
+         * @brief The plugin's own metadata (the "MetaData" object: displayName, portType, ...).
+         */
+        QJsonObject pluginMetaData() const { return metaData.value(QLatin1String("MetaData")).toObject(); }
+    };
+
+    struct RefreshStats {
+        int files = 0;              // Files in the directory
+        int reused = 0;             // Taken from the index
+        int scanned = 0;            // Metadata read from the file
+        int removed = 0;            // Gone since the last refresh
+        qint64 elapsedUs = 0;
+    };
+
+    /**
+     * @brief @p indexPath empty = next to @p pluginDir, falling back to the cache location.
+     */
+    explicit PluginIndex(const QString& pluginDir = defaultPluginDir(), const QString& indexPath = QString(),
+                         QObject *parent = nullptr);
+    ~PluginIndex() override;
+
+    /**
+     * @brief The installation's plugin directory (common/plugins next to the executable).
+     */
+    static QString defaultPluginDir();
+
+    /**
+     * @brief Brings the index up to date with the directory and saves it if anything changed.
+     * @return true if an entry was added, changed or removed.
+     */
+    bool refresh();
+
+    /**
+     * @brief Every file that is a plugin, sorted by file name.
+     */
+    QList<Entry> plugins() const;
+    Entry entry(const QString& fileName) const { return m_entries.value(fileName); }
+    QString pluginDir() const { return m_pluginDir; }
+    QString pluginPath(const QString& fileName) const { return m_pluginDir + QLatin1Char('/') + fileName; }
+
+    RefreshStats lastRefresh() const { return m_lastRefresh; }
+
+    void setWatching(bool enabled);
+
+Q_SIGNALS:
+    void changed();
+
+private:
+    QStringList indexCandidates() const;
+    bool load();
+    bool save() const;
+
+    QString m_pluginDir;
+    QString m_indexPath;            // Explicit index path (empty = candidates)
+    QHash<QString, Entry> m_entries;
+    bool m_loaded = false;
+    RefreshStats m_lastRefresh;
+    QFileSystemWatcher *m_watcher = nullptr;
+    QTimer m_debounce;
+};
+
+#endif // PLUGIN_INDEX_H
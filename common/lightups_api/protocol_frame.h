@@ -0,0 +1,387 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PROTOCOL_FRAME_H
+#define PROTOCOL_FRAME_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include "frame_ring.h"
+
+/**
+ * @brief Declarative description of byte-oriented UPS protocols, compiled into specialized parsers.
+ *
+ * A driver describes its framing once (a Layout: start/end marker, length byte, type byte,
+ * checksum rule) and every frame as a list of fields (offset, width, endianness, scale factor,
+ * status bits, lookup tables). Protocol<> and StreamParser<> turn that description into a
+ * zero-allocation parser: all offsets, lengths and field conversions are template parameters,
+ * so nothing is interpreted at runtime.
+ *
+ * Example (the NHS protocol is the reference user, see nhs_codec.h):
+ * @code
+ * constexpr ProtocolFrame::Layout LAYOUT{ .startMarker = 0xFF, .endMarker = 0xFE };
+ * using Status = ProtocolFrame::Frame<'D', 16,
+ *     ProtocolFrame::Field<&Out::inputVoltage, 0, 2>,
+ *     ProtocolFrame::Scaled<&Out::batteryVoltage, 2, 2, ProtocolFrame::Endian::Little, ProtocolFrame::Scale{1, 10}>,
+ *     ProtocolFrame::Bit<&Out::onBattery, 14, 0>>;
+ * ProtocolFrame::StreamParser<ProtocolFrame::Protocol<LAYOUT, Status>> parser;
+ * parser.feed(bytes, out, [](auto frame) { ... });  // decltype(frame) is the frame type that matched
+ * @endcode
+ *
+ * Like nhs_ring_buffer.h this header has no Qt dependency, so it can be benchmarked standalone.
+ */
+namespace ProtocolFrame {
+
+enum class Endian { Little, Big };
+
+enum class ChecksumRule {
+    None,
+    Sum8,   // Low byte of the sum of the covered bytes
+    Xor8,   // XOR of the covered bytes
+};
+
+enum class LengthRule {
+    TotalFrame,   // The length byte counts the whole frame, markers included
+    Payload,      // The length byte counts the payload only
+};
+
+/**
+ * @brief Framing shared by all frames of a protocol: [start][header...][payload][checksum][end].
+ */
+struct Layout {
+    uint8_t startMarker = 0xFF;
+    int endMarker = -1;                           // -1 = no end marker
+    int lengthOffset = 1;                         // Position of the length byte inside the header
+    LengthRule lengthRule = LengthRule::TotalFrame;
+    int typeOffset = 2;                           // Position of the type byte, -1 = frames differ by length only
+    int headerLength = 3;                         // Bytes before the payload, start marker included
+    ChecksumRule checksum = ChecksumRule::Sum8;
+    int checksumFrom = 1;                         // First covered byte; coverage ends before the checksum byte
+
+    constexpr int trailerLength() const
+    {
+        return (checksum != ChecksumRule::None ? 1 : 0) + (endMarker >= 0 ? 1 : 0);
+    }
+};
+
+/**
+ * @brief Rational scale factor applied to a raw integer (value = raw * num / den).
+ */
+struct Scale {
+    int64_t num = 1;
+    int64_t den = 1;
+};
+
+namespace detail {
+template <typename M> struct MemberPointer;
+template <typename C, typename T> struct MemberPointer<T C::*> { using Class = C; using Type = T; };
+
+template <auto Member>
+using MemberType = typename MemberPointer<decltype(Member)>::Type;
+
+template <size_t Width, Endian E>
+constexpr uint64_t readUnsigned(const uint8_t* p)
+{
+    static_assert(Width >= 1 && Width <= 8, "Fields are 1 to 8 bytes wide");
+    uint64_t value = 0;
+    for (size_t i = 0; i < Width; ++i) {
+        const size_t shift = (E == Endian::Little ? i : Width - 1 - i) * 8;
+        value |= static_cast<uint64_t>(p[i]) << shift;
+    }
+    return value;
+}
+} // namespace detail
+
+/**
+ * @brief Unsigned integer of @p Width bytes at payload @p Offset, stored into @p Member.
+ */
+template <auto Member, size_t Offset, size_t Width = sizeof(detail::MemberType<Member>), Endian E = Endian::Little>
+struct Field {
+    static constexpr size_t END = Offset + Width;
+
+    template <typename Out>
+    static constexpr void decode(const uint8_t* payload, Out& out)
+    {
+        out.*Member = static_cast<detail::MemberType<Member>>(detail::readUnsigned<Width, E>(payload + Offset));
+    }
+};
+
+/**
+ * @brief Like Field, converted to engineering units with a rational scale factor.
+ */
+template <auto Member, size_t Offset, size_t Width, Endian E, Scale S>
+struct Scaled {
+    static_assert(S.den != 0, "Scale denominator must not be zero");
+    static constexpr size_t END = Offset + Width;
+
+    template <typename Out>
+    static constexpr void decode(const uint8_t* payload, Out& out)
+    {
+        using T = detail::MemberType<Member>;
+        out.*Member = static_cast<T>(detail::readUnsigned<Width, E>(payload + Offset)) * static_cast<T>(S.num) / static_cast<T>(S.den);
+    }
+};
+
+/**
+ * @brief One bit (0 = LSB) of the byte at payload @p Offset, stored as bool.
+ */
+template <auto Member, size_t Offset, int BitIndex>
+struct Bit {
+    static_assert(BitIndex >= 0 && BitIndex < 8, "Bit index must address a single byte");
+    static constexpr size_t END = Offset + 1;
+
+    template <typename Out>
+    static constexpr void decode(const uint8_t* payload, Out& out)
+    {
+        out.*Member = ((payload[Offset] >> BitIndex) & 1) != 0;
+    }
+};
+
+/**
+ * @brief The byte at payload @p Offset, mapped through a constexpr lookup table (e.g. status byte -> state).
+ */
+template <auto Member, size_t Offset, const auto& Table>
+struct Mapped {
+    static_assert(std::size(Table) >= 256, "Lookup tables must cover every byte value");
+    static constexpr size_t END = Offset + 1;
+
+    template <typename Out>
+    static constexpr void decode(const uint8_t* payload, Out& out)
+    {
+        out.*Member = Table[payload[Offset]];
+    }
+};
+
+/**
+ * @brief Copies sizeof(Member) payload bytes from @p Offset verbatim (packed raw structs).
+ */
+template <auto Member, size_t Offset>
+struct Raw {
+    using T = detail::MemberType<Member>;
+    static_assert(std::is_trivially_copyable_v<T>, "Raw fields must be trivially copyable");
+    static constexpr size_t END = Offset + sizeof(T);
+
+    template <typename Out>
+    static constexpr void decode(const uint8_t* payload, Out& out)
+    {
+        std::array<uint8_t, sizeof(T)> bytes{};
+        std::copy_n(payload + Offset, sizeof(T), bytes.begin());
+        out.*Member = std::bit_cast<T>(bytes);
+    }
+};
+
+/**
+ * @brief One frame type: its type byte (-1 when the layout has none), payload size and fields.
+ */
+template <int TypeId, size_t PayloadLength, typename... Fields>
+struct Frame {
+    static constexpr int TYPE = TypeId;
+    static constexpr size_t PAYLOAD_LENGTH = PayloadLength;
+    static_assert(((Fields::END <= PayloadLength) && ...), "A field reaches beyond the payload");
+
+    template <typename Out>
+    static constexpr void decode(const uint8_t* payload, Out& out)
+    {
+        (Fields::decode(payload, out), ...);
+    }
+};
+
+/**
+ * @brief A complete protocol: layout plus frame types. All members are compile-time constants.
+ */
+template <Layout L, typename... Frames>
+struct Protocol {
+    static_assert(sizeof...(Frames) > 0, "A protocol needs at least one frame type");
+    static_assert(L.lengthOffset > 0 && L.lengthOffset < L.headerLength, "The length byte must be part of the header");
+    static_assert(L.typeOffset < L.headerLength, "The type byte must be part of the header");
+    static_assert(L.checksumFrom >= 0 && L.checksumFrom <= L.headerLength, "Checksum coverage must start inside the header");
+
+    static constexpr Layout LAYOUT = L;
+
+    template <typename F>
+    static constexpr int frameLength() { return L.headerLength + static_cast<int>(F::PAYLOAD_LENGTH) + L.trailerLength(); }
+
+    static constexpr int MAX_FRAME_LENGTH = std::max({ frameLength<Frames>()... });
+    static constexpr int MIN_FRAME_LENGTH = std::min({ frameLength<Frames>()... });
+    static_assert(L.lengthRule != LengthRule::TotalFrame || MAX_FRAME_LENGTH <= 0xFF, "Frame length must fit the length byte");
+
+    /**
+     * @brief Total frame length announced by a length byte, or 0 if no frame type has that length.
+     */
+    static constexpr int lengthFromByte(uint8_t value) { return LENGTH_TABLE[value]; }
+
+    /**
+     * @brief Checks the end marker and the checksum of a complete, contiguous frame.
+     */
+    static constexpr bool validate(const uint8_t* frame, int length)
+    {
+        int checksumPos = length;
+        if constexpr (L.endMarker >= 0) {
+            if (frame[length - 1] != static_cast<uint8_t>(L.endMarker)) return false;
+            checksumPos = length - 1;
+        }
+        if constexpr (L.checksum == ChecksumRule::None) {
+            return true;
+        } else {
+            --checksumPos;
+            unsigned int sum = 0;
+            for (int i = L.checksumFrom; i < checksumPos; ++i) {
+                if constexpr (L.checksum == ChecksumRule::Sum8) sum += frame[i];
+                else sum ^= frame[i];
+            }
+            return static_cast<uint8_t>(sum & 0xFF) == frame[checksumPos];
+        }
+    }
+
+    /**
+     * @brief Decodes a validated frame into @p out and calls onFrame(FrameType{}) for the matching type.
+     * @return false if no frame type matches the type byte/length combination.
+     */
+    template <typename Out, typename FrameFn>
+    static constexpr bool dispatch(const uint8_t* frame, int length, Out& out, FrameFn&& onFrame)
+    {
+        return (dispatchOne<Frames>(frame, length, out, onFrame) || ...);
+    }
+
+private:
+    template <typename F, typename Out, typename FrameFn>
+    static constexpr bool dispatchOne(const uint8_t* frame, int length, Out& out, FrameFn& onFrame)
+    {
+        if (length != frameLength<F>()) return false;
+        if constexpr (L.typeOffset >= 0 && F::TYPE >= 0) {
+            if (frame[L.typeOffset] != static_cast<uint8_t>(F::TYPE)) return false;
+        }
+        F::decode(frame + L.headerLength, out);
+        onFrame(F{});
+        return true;
+    }
+
+    static constexpr std::array<int, 256> makeLengthTable()
+    {
+        std::array<int, 256> table{};
+        const int overhead = L.lengthRule == LengthRule::TotalFrame ? 0 : L.headerLength + L.trailerLength();
+        for (const int length : { frameLength<Frames>()... }) {
+            const int byte = length - overhead;
+            if (byte >= 0 && byte <= 0xFF) table[byte] = length;
+        }
+        return table;
+    }
+
+    static constexpr std::array<int, 256> LENGTH_TABLE = makeLengthTable();
+};
+
+/**
+ * @brief Counters maintained by StreamParser (same meaning as NhsCodec::DecoderStats).
+ */
+struct ParserStats {
+    uint64_t bytesIn = 0;
+    uint64_t framesDecoded = 0;
+    uint64_t checksumFailures = 0;
+    uint64_t resyncBytesDiscarded = 0;
+    uint64_t unknownFrames = 0;
+    uint64_t bufferOverruns = 0;
+};
+
+/**
+ * @brief Incremental stream parser generated from a Protocol: feed arbitrary chunks, receive decoded frames.
+ *
+ * The bytes are kept in a MirroredRing (the same ring NhsRingBuffer uses), so every frame is
+ * validated and decoded as one contiguous span.
+ */
+template <typename P, int BufferSize = 128>
+class StreamParser
+{
+public:
+    static constexpr int MAX_FRAME_LENGTH = P::MAX_FRAME_LENGTH;
+    using Ring = MirroredRing<BufferSize, MAX_FRAME_LENGTH>;
+
+    /**
+     * @brief Ingests @p bytes, decodes every complete frame into @p out and calls onFrame(FrameType{}) after each.
+     * @return The number of frames delivered by this call.
+     */
+    template <typename Out, typename FrameFn>
+    int feed(std::span<const uint8_t> bytes, Out& out, FrameFn&& onFrame)
+    {
+        int delivered = 0;
+        const uint8_t* src = bytes.data();
+        int remaining = static_cast<int>(bytes.size());
+        m_stats.bytesIn += bytes.size();
+
+        while (remaining > 0) {
+            const int copied = m_ring.write(src, remaining);
+            src += copied;
+            remaining -= copied;
+
+            delivered += extractFrames(out, onFrame);
+
+            if (copied == 0) {
+                // Cannot happen with a valid frame size, but never spin on a full ring.
+                ++m_stats.bufferOverruns;
+                m_stats.resyncBytesDiscarded += m_ring.size();
+                reset();
+            }
+        }
+        return delivered;
+    }
+
+    void reset() { m_ring.clear(); }
+
+    const ParserStats& stats() const { return m_stats; }
+
+private:
+    static constexpr Layout L = P::LAYOUT;
+
+    template <typename Out, typename FrameFn>
+    int extractFrames(Out& out, FrameFn& onFrame)
+    {
+        int delivered = 0;
+        m_stats.resyncBytesDiscarded += m_ring.scan(L.startMarker, L.lengthOffset + 1, [&](const uint8_t* frame, int available) {
+            // A start marker only counts when it is followed by a known length byte
+            const int length = P::lengthFromByte(frame[L.lengthOffset]);
+            if (length == 0) return Ring::RESYNC;
+            if (available < length) return Ring::NEED_MORE; // Wait for the rest of the frame
+
+            // Validate and decode the frame as one contiguous span
+            if (!P::validate(frame, length)) {
+                ++m_stats.checksumFailures;
+                return Ring::RESYNC;
+            }
+            if (P::dispatch(frame, length, out, onFrame)) {
+                ++m_stats.framesDecoded;
+                ++delivered;
+            } else {
+                ++m_stats.unknownFrames;
+            }
+            return length;
+        });
+        return delivered;
+    }
+
+    Ring m_ring;
+    ParserStats m_stats;
+};
+
+} // namespace ProtocolFrame
+
+#endif // PROTOCOL_FRAME_H
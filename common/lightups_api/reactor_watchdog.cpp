@@ -0,0 +1,130 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "reactor_watchdog.h"
+#include "ups_clock.h"
+#include <QEvent>
+#include <QMetaEnum>
+
+QString ReactorHangReport::toString() const
+{
+    return QString("thread=%1 devices=%2 stalled_ms=%3 last_event=%4 receiver=%5 label=%6 busy_ms=%7")
+        .arg(threadName, deviceIds.isEmpty() ? QString("-") : deviceIds.join(','))
+        .arg(stalledMs)
+        .arg(lastEvent.isEmpty() ? QString("-") : lastEvent,
+             lastReceiver.isEmpty() ? QString("-") : lastReceiver,
+             lastLabel.isEmpty() ? QString("-") : lastLabel)
+        .arg(busyMs);
+}
+
+ReactorWatchdog::ReactorWatchdog(DriverReactorPool& reactors, QObject *parent)
+    : QObject(parent), m_reactors(reactors)
+{
+    m_timer.setInterval(m_config.probeIntervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &ReactorWatchdog::tick);
+}
+
+void ReactorWatchdog::setConfig(const Config& config)
+{
+    m_config = config;
+    m_config.probeIntervalMs = qMax(100, m_config.probeIntervalMs);
+    m_config.hangThresholdMs = qMax(m_config.probeIntervalMs, m_config.hangThresholdMs);
+    m_timer.setInterval(m_config.probeIntervalMs);
+}
+
+void ReactorWatchdog::start()
+{
+    m_timer.start();
+}
+
+void ReactorWatchdog::stop()
+{
+    m_timer.stop();
+    m_states.clear();
+}
+
+QList<ReactorWatchdog::ThreadStats> ReactorWatchdog::stats() const
+{
+    QList<ThreadStats> result;
+    const QList<QThread*> threads = m_reactors.runningThreads();
+    for (QThread* thread : threads) {
+        const std::shared_ptr<ReactorHealth> health = m_reactors.health(thread);
+        if (!health) continue;
+        const State state = m_states.value(thread);
+        const bool current = state.health == health;
+
+        ThreadStats stats;
+        stats.threadName = health->threadName();
+        stats.probes = health->probes();
+        stats.hangs = current ? state.hangs : 0;
+        stats.hung = current && state.hung;
+        stats.lastWaitUs = health->lastWaitNs() / 1000;
+        stats.maxWaitUs = health->maxWaitNs() / 1000;
+        stats.waitHistogram = health->histogram();
+        result.append(stats);
+    }
+    return result;
+}
+
+void ReactorWatchdog::tick()
+{
+    const QList<QThread*> threads = m_reactors.runningThreads();
+    for (auto it = m_states.begin(); it != m_states.end();) {
+        it = threads.contains(it.key()) ? std::next(it) : m_states.erase(it);
+    }
+
+    const qint64 nowNs = UpsClock::nowNs();
+    const qint64 thresholdNs = qint64(m_config.hangThresholdMs) * 1000000;
+    for (QThread* thread : threads) {
+        std::shared_ptr<ReactorHealth> health = m_reactors.health(thread);
+        if (!health) continue;
+        State& state = m_states[thread];
+        if (state.health != health) {
+            state = State(); // A new thread at the address of a stopped one
+            state.health = health;
+        }
+
+        if (health->beginProbe(nowNs)) {
+            if (state.hung) {
+                state.hung = false;
+                emit hangCleared(thread, health->lastWaitNs() / 1000000);
+            }
+            m_reactors.post(thread, [health]() { health->endProbe(UpsClock::nowNs()); });
+            continue;
+        }
+
+        const qint64 stalledNs = nowNs - health->probePostedNs();
+        if (state.hung || stalledNs < thresholdNs) continue;
+
+        state.hung = true;
+        ++state.hangs;
+
+        ReactorHangReport report;
+        report.threadName = health->threadName();
+        report.stalledMs = stalledNs / 1000000;
+        const ReactorHealth::Activity activity = health->activity();
+        if (activity.stampNs > 0) {
+            report.lastLabel = activity.label;
+            report.lastReceiver = QString::fromLatin1(activity.className);
+            const char* eventName = QMetaEnum::fromType<QEvent::Type>().valueToKey(activity.eventType);
+            report.lastEvent = eventName ? QString::fromLatin1(eventName) : QString::number(activity.eventType);
+            report.busyMs = (nowNs - activity.stampNs) / 1000000;
+        }
+        emit hangDetected(thread, report);
+    }
+}
@@ -0,0 +1,107 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef REACTOR_WATCHDOG_H
+#define REACTOR_WATCHDOG_H
+
+#include "lightups_api_global.h"
+#include "driver_reactor_pool.h"
+#include <QHash>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <array>
+#include <memory>
+
+/**
+ * @brief What a wedged reactor thread was doing when the watchdog gave up on it.
+ */
+struct UPS_API_LIBRARY_EXPORT ReactorHangReport {
+    QString threadName;
+    QStringList deviceIds;          // Units served by the thread (filled in by Ups_api_library)
+    QString lastLabel;              // Label of the object tree that got the last event (usually a device id)
+    QString lastReceiver;           // Class of the receiver
+    QString lastEvent;              // QEvent::Type name, e.g. "Timer" or "MetaCall" (a queued slot)
+    qint64 stalledMs = 0;           // How long the heartbeat has been waiting in the queue
+    qint64 busyMs = -1;             // How long ago the last event was delivered (-1 = none seen)
+
+    /**
+     * @brief One key=value line for the log.
+     */
+    QString toString() const;
+};
+
+/**
+ * @brief Heartbeat monitor for the reactor threads.
+ *
+ * Every interval it queues a probe into each reactor thread (at most one in flight per thread). The
+ * time a probe waits until the thread runs it is the queueing latency every slot on that thread sees
+ * right now; it goes into the thread's ReactorHealth histogram. A probe still waiting after the hang
+ * threshold means the thread is stuck in one slot: hangDetected() is emitted once, with the last
+ * event that was delivered there. hangCleared() follows if the thread ever runs the probe.
+ * Lives in the owner thread of the pool.
+ */
+class UPS_API_LIBRARY_EXPORT ReactorWatchdog : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config {
+        int probeIntervalMs = 1000;
+        int hangThresholdMs = 5000;
+    };
+
+    struct ThreadStats {
+        QString threadName;
+        quint64 probes = 0;
+        quint64 hangs = 0;
+        qint64 lastWaitUs = 0;
+        qint64 maxWaitUs = 0;
+        bool hung = false;
+        std::array<quint64, ReactorHealth::LATENCY_BUCKETS> waitHistogram{};   // Microseconds, log2 buckets
+    };
+
+    explicit ReactorWatchdog(DriverReactorPool& reactors, QObject *parent = nullptr);
+
+    void setConfig(const Config& config);
+    Config config() const { return m_config; }
+
+    void start();
+    void stop();
+
+    QList<ThreadStats> stats() const;
+
+Q_SIGNALS:
+    void hangDetected(QThread* thread, const ReactorHangReport& report);
+    void hangCleared(QThread* thread, qint64 stalledMs);
+
+private:
+    struct State {
+        std::shared_ptr<ReactorHealth> health;
+        quint64 hangs = 0;
+        bool hung = false;
+    };
+
+    void tick();
+
+    DriverReactorPool& m_reactors;
+    Config m_config;
+    QTimer m_timer;
+    QHash<QThread*, State> m_states;
+};
+
+#endif // REACTOR_WATCHDOG_H
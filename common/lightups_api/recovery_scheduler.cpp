@@ -0,0 +1,71 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "recovery_scheduler.h"
+#include "ups_clock.h"
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cmath>
+
+RecoveryScheduler::RecoveryScheduler(const Config& config, QObject *parent)
+    : QObject(parent)
+    , m_config(config)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &RecoveryScheduler::retry);
+}
+
+int RecoveryScheduler::backoffDelayMs(const Config& config, int attempt, double random)
+{
+    const double base = std::min<double>(config.maxDelayMs,
+                                         config.initialDelayMs * std::pow(config.factor, std::min(attempt, 62)));
+    return std::max(1, static_cast<int>(base * (1.0 - config.jitter * random)));
+}
+
+void RecoveryScheduler::schedule()
+{
+    if (m_outageStartNs == 0) {
+        m_outageStartNs = UpsClock::nowNs();
+    }
+    if (m_timer.isActive()) return;
+
+    m_timer.start(backoffDelayMs(m_config, m_attempts, QRandomGenerator::global()->generateDouble()));
+    ++m_attempts;
+}
+
+void RecoveryScheduler::retryNow()
+{
+    if (m_outageStartNs == 0) {
+        m_outageStartNs = UpsClock::nowNs();
+    }
+    m_timer.start(0);
+}
+
+void RecoveryScheduler::cancel()
+{
+    m_timer.stop();
+}
+
+qint64 RecoveryScheduler::succeeded()
+{
+    m_timer.stop();
+    m_attempts = 0;
+    const qint64 outageNs = m_outageStartNs > 0 ? UpsClock::nowNs() - m_outageStartNs : 0;
+    m_outageStartNs = 0;
+    return outageNs;
+}
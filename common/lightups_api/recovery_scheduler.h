@@ -0,0 +1,89 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef RECOVERY_SCHEDULER_H
+#define RECOVERY_SCHEDULER_H
+
+#include "lightups_api_global.h"
+#include <QObject>
+#include <QTimer>
+
+/**
+ * @brief Retries a failed connection with capped exponential backoff and jitter.
+ *
+ * The first retry follows quickly (a USB hiccup is over in well under a second); every further
+ * failure doubles the delay up to the cap, so a dead port is not hammered forever. The jitter
+ * spreads the retries of several units that failed together (e.g. one USB hub). retryNow() skips
+ * the wait when something tells us the device is back. The time from the first failure to
+ * succeeded() is the time to recover.
+ * Lives in the thread of its owner; retry() is emitted there.
+ */
+class UPS_API_LIBRARY_EXPORT RecoveryScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config {
+        int initialDelayMs = 500;
+        int maxDelayMs = 60000;
+        double factor = 2.0;
+        double jitter = 0.5;    // A delay is drawn from [base * (1 - jitter), base]
+    };
+
+    explicit RecoveryScheduler(const Config& config, QObject *parent = nullptr);
+
+    /**
+     * @brief Schedules the next attempt after the backoff delay. No-op while one is pending.
+     * The first call after succeeded() marks the start of the outage.
+     */
+    void schedule();
+
+    /**
+     * @brief Attempts at once (on the next event loop pass); the backoff itself is kept.
+     */
+    void retryNow();
+
+    /**
+     * @brief Drops the pending attempt; the backoff and the outage start are kept.
+     */
+    void cancel();
+
+    /**
+     * @brief Ends the outage: resets the backoff and returns the time to recover in ns (0 if none).
+     */
+    qint64 succeeded();
+
+    bool isPending() const { return m_timer.isActive(); }
+    bool isRecovering() const { return m_outageStartNs > 0; }
+    int attempts() const { return m_attempts; }
+
+    /**
+     * @brief The delay before attempt @p attempt (0-based), for a uniform @p random in [0, 1).
+     */
+    static int backoffDelayMs(const Config& config, int attempt, double random);
+
+Q_SIGNALS:
+    void retry();
+
+private:
+    Config m_config;
+    QTimer m_timer;
+    int m_attempts = 0;
+    qint64 m_outageStartNs = 0;
+};
+
+#endif // RECOVERY_SCHEDULER_H
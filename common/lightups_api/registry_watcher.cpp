@@ -17,76 +17,194 @@
 */
 
 #include "registry_watcher.h"
-#include <QCoreApplication>
 #include <QDebug>
-#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
 #include "constants.h"
 
 #ifdef Q_OS_WIN
+#include <QWinEventNotifier>
+#else
+#include <QSocketNotifier>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <cerrno>
+#include <unistd.h>
+#endif
 
 RegistryWatcher::RegistryWatcher(QObject *parent) : QObject(parent)
 {
-    // Create a handle that the Windows API can signal
-    m_eventHandle = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(DEBOUNCE_MS);
+    connect(&m_debounceTimer, &QTimer::timeout, this, &RegistryWatcher::emitDiff);
+}
+
+RegistryWatcher::~RegistryWatcher()
+{
+    stopWatching();
 }
 
-void RegistryWatcher::startWatching(const QString& registryPath)
+QVariantMap RegistryWatcher::readSettings()
 {
-    if (m_watching) {
+    QSettings settings(AppConstants::SETTINGS_SCOPE, AppConstants::APP_ORGANIZATION_NAME, AppConstants::APP_APPLICATION_NAME);
+    settings.sync();
+
+    QVariantMap values;
+    const QStringList keys = settings.allKeys();
+    for (const QString& key : keys) {
+        values.insert(key, settings.value(key));
+    }
+    return values;
+}
+
+void RegistryWatcher::onNotified()
+{
+#ifdef Q_OS_WIN
+    // Re-arm first, so a change during the debounce interval is not lost
+    ResetEvent(m_eventHandle);
+    RegNotifyChangeKeyValue(m_hKey, TRUE, REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_CHANGE_NAME, m_eventHandle, TRUE);
+#elif defined(Q_OS_LINUX)
+    // Drain the queue: only the name of the file matters, not the individual events
+    alignas(inotify_event) char buffer[4096];
+    bool relevant = false;
+    ssize_t length = 0;
+    while ((length = ::read(m_inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+            if (event->len > 0 && m_fileName == QString::fromLocal8Bit(event->name)) {
+                relevant = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+    if (!relevant) return;
+#endif
+    m_debounceTimer.start(); // Restarted by every write of a burst
+}
+
+void RegistryWatcher::emitDiff()
+{
+    SettingsDiff diff;
+    diff.values = readSettings();
+    for (auto it = diff.values.constBegin(); it != diff.values.constEnd(); ++it) {
+        const auto previous = m_values.constFind(it.key());
+        if (previous == m_values.constEnd() || previous.value() != it.value()) {
+            diff.changed.append(it.key());
+        }
+    }
+    for (auto it = m_values.constBegin(); it != m_values.constEnd(); ++it) {
+        if (!diff.values.contains(it.key())) {
+            diff.removed.append(it.key());
+        }
+    }
+    m_values = diff.values;
+
+    if (diff.isEmpty()) return; // e.g. the file was rewritten with the same content
+    qDebug() << "RegistryWatcher: Settings changed:" << diff.changed << "removed:" << diff.removed;
+    emit settingsChanged(diff);
+}
+
+#ifdef Q_OS_WIN
+
+bool RegistryWatcher::startWatching()
+{
+    if (m_notifier) {
         qDebug() << "RegistryWatcher: Already started.";
-        return;
+        return true;
     }
 
     // Determine the root key based on the scope from constants.h
     HKEY rootKey = (AppConstants::SETTINGS_SCOPE == QSettings::UserScope) ? HKEY_CURRENT_USER : HKEY_LOCAL_MACHINE;
-
-    // Build the path
     QString subKey = "Software\\" + AppConstants::APP_ORGANIZATION_NAME + "\\" + AppConstants::APP_APPLICATION_NAME;
 
-    // Use the dynamic rootKey instead of HKEY_CURRENT_USER
     if (RegOpenKeyEx(rootKey, (const wchar_t*)subKey.utf16(), 0, KEY_NOTIFY, &m_hKey) != ERROR_SUCCESS) {
         qDebug() << "RegistryWatcher: Cannot open registry key:" << subKey;
-        return;
+        m_hKey = nullptr;
+        return false;
     }
 
-    m_watching = true;
+    // A handle that the registry signals; the event loop waits for it, not a thread of ours
+    m_eventHandle = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    m_values = readSettings();
+    RegNotifyChangeKeyValue(m_hKey, TRUE, REG_NOTIFY_CHANGE_LAST_SET | REG_NOTIFY_CHANGE_NAME, m_eventHandle, TRUE);
+    m_notifier = new QWinEventNotifier(m_eventHandle, this);
+    connect(m_notifier, &QWinEventNotifier::activated, this, &RegistryWatcher::onNotified);
+
     qDebug() << "RegistryWatcher: Started monitoring registry changes.";
+    return true;
+}
 
-    // This loop waits asynchronously for changes
-    while (m_watching) {
+void RegistryWatcher::stopWatching()
+{
+    m_debounceTimer.stop();
+    delete m_notifier;
+    m_notifier = nullptr;
+    if (m_hKey) {
+        RegCloseKey(m_hKey); // Also cancels the pending notification
+        m_hKey = nullptr;
+    }
+    if (m_eventHandle) {
+        CloseHandle(m_eventHandle);
+        m_eventHandle = nullptr;
+    }
+}
 
-        // Asynchronously notify of changes
-        RegNotifyChangeKeyValue(m_hKey, TRUE, REG_NOTIFY_CHANGE_LAST_SET, m_eventHandle, TRUE);
+#elif defined(Q_OS_LINUX)
 
-        // Wait until the event occurs or stop is requested
-        if (WaitForSingleObject(m_eventHandle, INFINITE) == WAIT_OBJECT_0) {
-            if (m_watching) {
-                // Event occurred AND we are still watching (not stopped)
-                qDebug() << "RegistryWatcher: Settings change detected!";
-                emit settingsChanged();
-            }
-            // Reset the event for the next iteration
-            ResetEvent(m_eventHandle);
-        }
-        // Small sleep; however, WaitForSingleObject already handles blocking until an event occurs.
-        QThread::msleep(100);
+bool RegistryWatcher::startWatching()
+{
+    if (m_notifier) {
+        qDebug() << "RegistryWatcher: Already started.";
+        return true;
     }
 
-    if (m_hKey) {
-        RegCloseKey(m_hKey);
-        m_hKey = nullptr;
+    // Watch the directory: QSettings (and most editors) replace the file instead of writing into it
+    const QFileInfo file(QSettings(AppConstants::SETTINGS_SCOPE, AppConstants::APP_ORGANIZATION_NAME,
+                                   AppConstants::APP_APPLICATION_NAME).fileName());
+    QDir().mkpath(file.absolutePath());
+    m_fileName = file.fileName();
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0 || inotify_add_watch(m_inotifyFd, QFile::encodeName(file.absolutePath()).constData(),
+                                             IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE) < 0) {
+        qWarning() << "RegistryWatcher: Cannot watch" << file.absolutePath() << ":" << qt_error_string(errno);
+        stopWatching();
+        return false;
     }
-    CloseHandle(m_eventHandle);
-    m_eventHandle = nullptr;
-    qDebug() << "RegistryWatcher: Monitoring stopped.";
+
+    m_values = readSettings();
+    m_notifier = new QSocketNotifier(m_inotifyFd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &RegistryWatcher::onNotified);
+
+    qDebug() << "RegistryWatcher: Started monitoring" << file.absoluteFilePath();
+    return true;
 }
 
 void RegistryWatcher::stopWatching()
 {
-    m_watching = false;
-    if (m_eventHandle) {
-        SetEvent(m_eventHandle); // Interrupt WaitForSingleObject immediately
+    m_debounceTimer.stop();
+    delete m_notifier;
+    m_notifier = nullptr;
+    if (m_inotifyFd >= 0) {
+        ::close(m_inotifyFd); // Also removes the watch
+        m_inotifyFd = -1;
     }
 }
 
-#endif // Q_OS_WIN
+#else
+
+bool RegistryWatcher::startWatching()
+{
+    qDebug() << "RegistryWatcher: Not supported on this platform; settings changes need a restart.";
+    return false;
+}
+
+void RegistryWatcher::stopWatching()
+{
+    m_debounceTimer.stop();
+}
+
+#endif
@@ -20,29 +20,90 @@
 #define REGISTRY_WATCHER_H
 
 #include <QObject>
+#include <QStringList>
+#include <QStringView>
+#include <QTimer>
+#include <QVariantMap>
+#include <algorithm>
 
-// Only required for Windows functionality
 #ifdef Q_OS_WIN
 #include <qt_windows.h>
+class QWinEventNotifier;
+#else
+class QSocketNotifier;
+#endif
 
+/**
+ * @brief What changed in the settings since the previous notification.
+ */
+struct SettingsDiff {
+    QVariantMap values;     // Every key after the change (so receivers need not read the settings again)
+    QStringList changed;    // Added or modified keys
+    QStringList removed;
+
+    bool isEmpty() const { return changed.isEmpty() && removed.isEmpty(); }
+
+    /**
+     * @brief True if @p keyOrGroup itself or any key inside that group (e.g. "Devices") changed.
+     */
+    bool touches(QStringView keyOrGroup) const
+    {
+        auto matches = [keyOrGroup](const QString& key) {
+            return key == keyOrGroup || (key.startsWith(keyOrGroup) && key.size() > keyOrGroup.size()
+                                         && key.at(keyOrGroup.size()) == QLatin1Char('/'));
+        };
+        return std::any_of(changed.begin(), changed.end(), matches)
+            || std::any_of(removed.begin(), removed.end(), matches);
+    }
+};
+
+/**
+ * @brief Watches the settings store and reports changes as a SettingsDiff.
+ *
+ * Windows: the registry key, through RegNotifyChangeKeyValue and a QWinEventNotifier.
+ * Linux: the settings file (see AppConstants::initSettingsBackend()), through inotify on its
+ * directory, so the atomic replace QSettings and most editors do is seen as well.
+ * Both run on the event loop of the thread that owns the watcher: no thread of its own, no polling.
+ * A burst of writes (QSettings writes key by key) is debounced into one notification.
+ */
 class RegistryWatcher : public QObject
 {
     Q_OBJECT
 public:
+    static constexpr int DEBOUNCE_MS = 250;
+
     explicit RegistryWatcher(QObject *parent = nullptr);
+    ~RegistryWatcher() override;
 
-public Q_SLOTS:
-    void startWatching(const QString& registryPath);
+    /**
+     * @brief Takes the current settings as the baseline and starts watching.
+     */
+    bool startWatching();
     void stopWatching();
 
+    /**
+     * @brief All settings as one flat map ("Group/Key" -> value).
+     */
+    static QVariantMap readSettings();
+
 Q_SIGNALS:
-    void settingsChanged();
+    void settingsChanged(const SettingsDiff& diff);
 
 private:
-    std::atomic<bool> m_watching = false;
+    void onNotified();
+    void emitDiff();
+
+    QTimer m_debounceTimer;
+    QVariantMap m_values;
+#ifdef Q_OS_WIN
     HANDLE m_eventHandle = nullptr;
     HKEY m_hKey = nullptr;
+    QWinEventNotifier *m_notifier = nullptr;
+#else
+    int m_inotifyFd = -1;
+    QString m_fileName;     // Name of the settings file inside the watched directory
+    QSocketNotifier *m_notifier = nullptr;
+#endif
 };
 
-#endif // Q_OS_WIN
 #endif // REGISTRY_WATCHER_H
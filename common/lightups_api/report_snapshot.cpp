@@ -0,0 +1,88 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "report_snapshot.h"
+#include <QDebug>
+#include <thread>
+
+void ReportSnapshot::publish(const UpsReport& report)
+{
+    const quint64 sequence = m_sequence.load(std::memory_order_relaxed) + 1;
+
+    // 1. Fill the side no reader can reach and send new readers there
+    const int published = m_published.load(std::memory_order_relaxed);
+    const int spare = 1 - published;
+    m_reports[spare] = report;
+    m_sequences[spare] = sequence;
+    m_published.store(spare);
+
+    // 2. Flip the reader counter; readers still on the old side drain from both counters
+    const int version = m_version.load(std::memory_order_relaxed);
+    waitForReaders(1 - version);
+    m_version.store(1 - version);
+    waitForReaders(version);
+
+    // 3. Nobody reads the old side anymore: bring it up to date for the next publish
+    m_reports[published] = report;
+    m_sequences[published] = sequence;
+    m_sequence.store(sequence, std::memory_order_release);
+}
+
+quint64 ReportSnapshot::read(UpsReport& report) const
+{
+    const int version = m_version.load();
+    m_readers[version].fetch_add(1);
+    const int side = m_published.load();
+    report = m_reports[side];
+    const quint64 sequence = m_sequences[side];
+    m_readers[version].fetch_sub(1, std::memory_order_release);
+    return sequence;
+}
+
+void ReportSnapshot::waitForReaders(int version) const
+{
+    // Readers only copy one report: this spins for microseconds at most
+    while (m_readers[version].load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+ReportSnapshot* ReportSnapshotTable::acquire(const QString& deviceId)
+{
+    const int count = m_count.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; ++i) {
+        if (m_entries[i].deviceId == deviceId) return &m_entries[i].snapshot;
+    }
+    if (count == CAPACITY) {
+        qWarning() << "ReportSnapshotTable: No snapshot for" << deviceId << "- more than" << CAPACITY << "devices.";
+        return nullptr;
+    }
+
+    m_entries[count].deviceId = deviceId;
+    m_count.store(count + 1, std::memory_order_release);
+    return &m_entries[count].snapshot;
+}
+
+const ReportSnapshot* ReportSnapshotTable::find(const QString& deviceId) const
+{
+    const int count = m_count.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        if (m_entries[i].deviceId == deviceId) return &m_entries[i].snapshot;
+    }
+    return nullptr;
+}
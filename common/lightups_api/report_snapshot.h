@@ -0,0 +1,101 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORT_SNAPSHOT_H
+#define REPORT_SNAPSHOT_H
+
+#include "lightups_api_global.h"
+#include "ups_report.h"
+#include <QString>
+#include <array>
+#include <atomic>
+
+/**
+ * @brief The latest report of one UPS, readable from any thread without locks or the event loop.
+ *
+ * Left-right scheme: the writer keeps two copies. Readers announce themselves on a version counter
+ * and copy the side that is currently published, which is wait-free. The writer fills the other
+ * side, publishes it, waits until no reader remains on the old side and then brings that side up
+ * to date as well. A seqlock is not an option here: UpsReport holds QStrings, which must never be
+ * copied while being overwritten. One writer thread only.
+ */
+class UPS_API_LIBRARY_EXPORT ReportSnapshot
+{
+public:
+    ReportSnapshot() = default;
+    ReportSnapshot(const ReportSnapshot&) = delete;
+    ReportSnapshot& operator=(const ReportSnapshot&) = delete;
+
+    /**
+     * @brief Publishes @p report. Only waits for readers that are copying the previous report.
+     */
+    void publish(const UpsReport& report);
+
+    /**
+     * @brief Copies the latest report into @p report. Wait-free; safe from any thread.
+     * @return Its sequence number, 0 if nothing was published yet.
+     */
+    quint64 read(UpsReport& report) const;
+
+    /**
+     * @brief Sequence number of the latest report: compare it to see whether anything changed.
+     */
+    quint64 sequence() const { return m_sequence.load(std::memory_order_acquire); }
+
+private:
+    void waitForReaders(int version) const;
+
+    std::array<UpsReport, 2> m_reports;
+    std::array<quint64, 2> m_sequences{};
+    std::atomic<int> m_published{0};               // Side readers copy from
+    std::atomic<int> m_version{0};                 // Reader counter new readers register on
+    mutable std::array<std::atomic<int>, 2> m_readers{};
+    std::atomic<quint64> m_sequence{0};
+};
+
+/**
+ * @brief Fixed set of snapshots, one per device. Lookups are safe from any thread while the owner
+ * thread adds devices; entries are never removed, so a removed device keeps its last report.
+ */
+class UPS_API_LIBRARY_EXPORT ReportSnapshotTable
+{
+public:
+    static constexpr int CAPACITY = 32;
+
+    /**
+     * @brief The snapshot of @p deviceId, created on first use. Owner thread only.
+     * @return nullptr once CAPACITY devices are known.
+     */
+    ReportSnapshot* acquire(const QString& deviceId);
+
+    /**
+     * @brief The snapshot of @p deviceId, or nullptr. Safe from any thread.
+     */
+    const ReportSnapshot* find(const QString& deviceId) const;
+
+private:
+    struct Entry {
+        QString deviceId;                          // Immutable once the entry is counted
+        ReportSnapshot snapshot;
+    };
+
+    std::array<Entry, CAPACITY> m_entries;
+    std::atomic<int> m_count{0};
+};
+
+#endif // REPORT_SNAPSHOT_H
@@ -0,0 +1,100 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sample_filter.h"
+#include <cmath>
+
+SampleFilter::SampleFilter(const SampleFilterConfig& config, QObject *parent)
+    : QObject(parent)
+    , m_config(config)
+{
+}
+
+void SampleFilter::setConfig(const SampleFilterConfig& config)
+{
+    m_config = config;
+    m_hasForwarded = false; // Forward the next sample so the new deadbands start from a fresh reference
+}
+
+SampleFilterStats SampleFilter::stats() const
+{
+    SampleFilterStats stats;
+    stats.received = m_received.load(std::memory_order_relaxed);
+    stats.stateChanges = m_stateChanges.load(std::memory_order_relaxed);
+    stats.deadbandExceeded = m_deadbandExceeded.load(std::memory_order_relaxed);
+    stats.heartbeats = m_heartbeats.load(std::memory_order_relaxed);
+    stats.forwarded = stats.stateChanges + stats.deadbandExceeded + stats.heartbeats;
+    stats.suppressed = stats.received > stats.forwarded ? stats.received - stats.forwarded : 0;
+    return stats;
+}
+
+SampleFilter::Decision SampleFilter::decide(const UpsData& sample, qint64 nowMs) const
+{
+    if (!m_config.enabled || !m_hasForwarded) {
+        return Decision::StateChange;
+    }
+
+    const UpsData& last = m_lastForwarded;
+    if (sample.state != last.state || sample.flags != last.flags || sample.statusCode != last.statusCode) {
+        return Decision::StateChange;
+    }
+
+    const auto moved = [](double now, double before, double deadband) {
+        return std::fabs(now - before) > deadband;
+    };
+    if (moved(sample.inputVoltage(), last.inputVoltage(), m_config.inputVoltage)
+        || moved(sample.outputVoltage(), last.outputVoltage(), m_config.outputVoltage)
+        || moved(sample.batteryVoltage(), last.batteryVoltage(), m_config.batteryVoltage)
+        || moved(sample.batteryLevel(), last.batteryLevel(), m_config.batteryLevel)
+        || moved(sample.temperatureC(), last.temperatureC(), m_config.temperatureC)
+        || std::abs(sample.loadPercentage - last.loadPercentage) > m_config.loadPercentage
+        || std::abs(sample.runtimeRemainingSeconds - last.runtimeRemainingSeconds) > m_config.runtimeSeconds) {
+        return Decision::Deadband;
+    }
+
+    if (nowMs - m_lastForwardMs >= m_config.heartbeatMs) {
+        return Decision::Heartbeat;
+    }
+    return Decision::Suppress;
+}
+
+void SampleFilter::process(const UpsData& sample)
+{
+    m_received.fetch_add(1, std::memory_order_relaxed);
+
+    // The sample's own arrival stamp: no clock read per sample
+    const qint64 nowMs = UpsClock::stampOrNow(sample.timestampNs) / 1000000;
+    switch (decide(sample, nowMs)) {
+    case Decision::Suppress:
+        return;
+    case Decision::StateChange:
+        m_stateChanges.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Decision::Deadband:
+        m_deadbandExceeded.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case Decision::Heartbeat:
+        m_heartbeats.fetch_add(1, std::memory_order_relaxed);
+        break;
+    }
+
+    m_lastForwarded = sample;
+    m_hasForwarded = true;
+    m_lastForwardMs = nowMs;
+    emit sampleAccepted(sample);
+}
@@ -0,0 +1,102 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include "lightups_api_global.h"
+#include "ups_report.h"
+#include <QObject>
+#include <atomic>
+
+/**
+ * @brief Deadbands and heartbeat for the SampleFilter. A deadband of 0 forwards every change of that field.
+ */
+struct SampleFilterConfig {
+    bool enabled = true;
+    double inputVoltage = 2.0;        // V
+    double outputVoltage = 2.0;       // V
+    double batteryVoltage = 0.1;      // V
+    double batteryLevel = 1.0;        // %
+    double temperatureC = 0.5;        // degrees Celsius
+    int loadPercentage = 2;           // %
+    int runtimeSeconds = 30;          // s
+    int heartbeatMs = 10000;          // Forward at least one sample per interval, even if nothing changed
+};
+
+/**
+ * @brief Counters of one SampleFilter (totals since the driver started).
+ */
+struct SampleFilterStats {
+    quint64 received = 0;             // Samples emitted by the driver
+    quint64 forwarded = 0;            // Samples passed on to Ups_api_library
+    quint64 suppressed = 0;           // received - forwarded
+    quint64 stateChanges = 0;         // Forwarded because state, flags or status code changed
+    quint64 deadbandExceeded = 0;     // Forwarded because a numeric field moved beyond its deadband
+    quint64 heartbeats = 0;           // Forwarded because the heartbeat interval expired
+};
+
+/**
+ * @brief Change-detection stage between a driver and the report fan-out.
+ *
+ * Lives in the driver's reactor thread and is connected directly to IUpsDriver::dataReceived,
+ * so suppressed samples never cross threads. A sample is forwarded when the state changes,
+ * when a numeric field moves beyond its deadband relative to the last forwarded sample,
+ * or when the heartbeat interval has passed since the last forwarded sample.
+ */
+class UPS_API_LIBRARY_EXPORT SampleFilter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SampleFilter(const SampleFilterConfig& config = SampleFilterConfig(), QObject *parent = nullptr);
+
+    /**
+     * @brief Replaces the configuration. Call from the filter's thread (or queue it there).
+     */
+    void setConfig(const SampleFilterConfig& config);
+
+    /**
+     * @brief Safe to call from any thread.
+     */
+    SampleFilterStats stats() const;
+
+    /**
+     * @brief The decision itself, without side effects. @p nowMs is UpsClock time in milliseconds.
+     */
+    enum class Decision { Suppress, StateChange, Deadband, Heartbeat };
+    Decision decide(const UpsData& sample, qint64 nowMs) const;
+
+public Q_SLOTS:
+    void process(const UpsData& sample);
+
+Q_SIGNALS:
+    void sampleAccepted(const UpsData& sample);
+
+private:
+    SampleFilterConfig m_config;
+    UpsData m_lastForwarded;
+    bool m_hasForwarded = false;
+    qint64 m_lastForwardMs = 0;
+
+    std::atomic<quint64> m_received{0};
+    std::atomic<quint64> m_stateChanges{0};
+    std::atomic<quint64> m_deadbandExceeded{0};
+    std::atomic<quint64> m_heartbeats{0};
+};
+
+#endif // SAMPLE_FILTER_H
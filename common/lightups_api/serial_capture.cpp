@@ -0,0 +1,259 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "serial_capture.h"
+#include "ups_clock.h"
+#include <QtEndian>
+#include <QUrlQuery>
+#include <QDebug>
+#include <cstring>
+#include <limits>
+
+qint64 SerialCapture::monotonicNs()
+{
+    return UpsClock::nowNs();
+}
+
+// ----------------------------------------------------
+// --- CaptureWriter ---
+// ----------------------------------------------------
+
+CaptureWriter::~CaptureWriter()
+{
+    close();
+}
+
+bool CaptureWriter::open(const QString& path)
+{
+    close();
+    m_file.setFileName(path);
+
+    // A driver restart (recovery, settings change) continues the existing capture
+    const bool append = m_file.exists() && m_file.size() >= SerialCapture::HEADER_SIZE;
+    if (!m_file.open(append ? QIODevice::Append : QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "CaptureWriter: Cannot open" << path << ":" << m_file.errorString();
+        return false;
+    }
+
+    if (!append) {
+        char header[SerialCapture::HEADER_SIZE] = {};
+        std::memcpy(header, SerialCapture::MAGIC, sizeof(SerialCapture::MAGIC));
+        qToLittleEndian<quint16>(SerialCapture::VERSION, header + 8);
+        m_file.write(header, sizeof(header));
+        m_file.flush();
+    }
+    m_lastNs = -1;
+    qDebug() << "CaptureWriter: Recording raw serial data to" << path << (append ? "(appending)" : "");
+    return true;
+}
+
+void CaptureWriter::close()
+{
+    if (m_file.isOpen()) {
+        m_file.flush();
+        m_file.close();
+    }
+}
+
+void CaptureWriter::writeChunk(qint64 arrivalNs, const char* data, qint64 length)
+{
+    if (!m_file.isOpen() || length <= 0) return;
+
+    const qint64 deltaUs = (m_lastNs < 0) ? 0 : (arrivalNs - m_lastNs) / 1000;
+    m_lastNs = arrivalNs;
+
+    // Chunks larger than 64 KiB are split; the continuation chunks get a delta of 0
+    quint32 delta = static_cast<quint32>(qBound<qint64>(0, deltaUs, std::numeric_limits<quint32>::max()));
+    while (length > 0) {
+        const quint16 part = static_cast<quint16>(qMin<qint64>(length, std::numeric_limits<quint16>::max()));
+        char chunkHeader[SerialCapture::CHUNK_HEADER_SIZE];
+        qToLittleEndian<quint32>(delta, chunkHeader);
+        qToLittleEndian<quint16>(part, chunkHeader + 4);
+        m_file.write(chunkHeader, sizeof(chunkHeader));
+        m_file.write(data, part);
+        data += part;
+        length -= part;
+        delta = 0;
+    }
+
+    // Flush per chunk: a capture is most valuable right before a crash
+    m_file.flush();
+}
+
+// ----------------------------------------------------
+// --- CaptureReader ---
+// ----------------------------------------------------
+
+bool CaptureReader::open(const QString& path)
+{
+    m_file.close();
+    m_file.setFileName(path);
+    m_offsetNs = 0;
+    m_error.clear();
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    char header[SerialCapture::HEADER_SIZE];
+    if (m_file.read(header, sizeof(header)) != sizeof(header)
+        || std::memcmp(header, SerialCapture::MAGIC, sizeof(SerialCapture::MAGIC)) != 0) {
+        m_error = QStringLiteral("Not a LightUps capture file");
+        m_file.close();
+        return false;
+    }
+
+    const quint16 version = qFromLittleEndian<quint16>(header + 8);
+    if (version != SerialCapture::VERSION) {
+        m_error = QStringLiteral("Unsupported capture version %1").arg(version);
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+bool CaptureReader::next(SerialCapture::Chunk& chunk)
+{
+    char chunkHeader[SerialCapture::CHUNK_HEADER_SIZE];
+    if (m_file.read(chunkHeader, sizeof(chunkHeader)) != sizeof(chunkHeader)) {
+        return false;
+    }
+
+    const quint32 deltaUs = qFromLittleEndian<quint32>(chunkHeader);
+    const quint16 length = qFromLittleEndian<quint16>(chunkHeader + 4);
+
+    chunk.data = m_file.read(length);
+    if (chunk.data.size() != length) {
+        m_error = QStringLiteral("Truncated chunk at end of capture");
+        return false;
+    }
+
+    m_offsetNs += qint64(deltaUs) * 1000;
+    chunk.offsetNs = m_offsetNs;
+    return true;
+}
+
+// ----------------------------------------------------
+// --- CaptureReplayDevice ---
+// ----------------------------------------------------
+
+CaptureReplayDevice::CaptureReplayDevice(const QString& path, double speed, QObject *parent)
+    : QIODevice(parent), m_path(path), m_speed(speed)
+{
+    m_timer.setSingleShot(true);
+    connect(&m_timer, &QTimer::timeout, this, &CaptureReplayDevice::deliverDue);
+}
+
+bool CaptureReplayDevice::parseConnectionInfo(const QString& connectionInfo, QString& path, double& speed)
+{
+    static const QString prefix = QStringLiteral("replay:");
+    if (!connectionInfo.startsWith(prefix)) return false;
+
+    const QString rest = connectionInfo.mid(prefix.size());
+    const qsizetype queryStart = rest.indexOf('?');
+    path = (queryStart < 0) ? rest : rest.left(queryStart);
+    speed = 1.0;
+
+    if (queryStart >= 0) {
+        const QString speedValue = QUrlQuery(rest.mid(queryStart + 1)).queryItemValue("speed");
+        if (speedValue == "max") {
+            speed = 0.0;
+        } else if (!speedValue.isEmpty()) {
+            bool ok = false;
+            const double value = speedValue.toDouble(&ok);
+            if (ok) speed = value;
+        }
+    }
+    return !path.isEmpty();
+}
+
+bool CaptureReplayDevice::open(OpenMode mode)
+{
+    if (!m_reader.open(m_path)) {
+        setErrorString(m_reader.errorString());
+        return false;
+    }
+    // Always open unbuffered: the data is already in memory chunk by chunk
+    if (!QIODevice::open(mode | QIODevice::Unbuffered)) {
+        return false;
+    }
+
+    m_pending.clear();
+    m_hasNext = m_reader.next(m_next);
+    m_clock.start();
+    scheduleNext();
+    return true;
+}
+
+void CaptureReplayDevice::close()
+{
+    m_timer.stop();
+    m_reader.close();
+    m_pending.clear();
+    m_hasNext = false;
+    QIODevice::close();
+}
+
+qint64 CaptureReplayDevice::readData(char *data, qint64 maxSize)
+{
+    const qint64 count = qMin<qint64>(maxSize, m_pending.size());
+    std::memcpy(data, m_pending.constData(), count);
+    m_pending.remove(0, count);
+    return count;
+}
+
+qint64 CaptureReplayDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    // Commands (such as the NHS S-command) are accepted and dropped: the capture already contains the replies
+    return maxSize;
+}
+
+void CaptureReplayDevice::scheduleNext()
+{
+    if (!m_hasNext) {
+        emit replayFinished();
+        return;
+    }
+
+    if (m_speed <= 0.0) {
+        // Max speed: one chunk per event loop pass, so the driver processes in between
+        m_timer.start(0);
+        return;
+    }
+
+    const qint64 dueNs = static_cast<qint64>(m_next.offsetNs / m_speed);
+    const qint64 waitMs = (dueNs - m_clock.nsecsElapsed()) / 1000000;
+    m_timer.start(static_cast<int>(qBound<qint64>(0, waitMs, std::numeric_limits<int>::max())));
+}
+
+void CaptureReplayDevice::deliverDue()
+{
+    if (!isOpen()) return;
+
+    // Deliver every chunk that is due (at most one at max speed)
+    const qint64 elapsedNs = m_clock.nsecsElapsed();
+    do {
+        m_pending.append(m_next.data);
+        m_hasNext = m_reader.next(m_next);
+    } while (m_hasNext && m_speed > 0.0 && static_cast<qint64>(m_next.offsetNs / m_speed) <= elapsedNs);
+
+    emit readyRead();
+    scheduleNext();
+}
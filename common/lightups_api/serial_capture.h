@@ -0,0 +1,156 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SERIAL_CAPTURE_H
+#define SERIAL_CAPTURE_H
+
+#include "lightups_api_global.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <QTimer>
+
+/**
+ * @brief Compact binary capture of the raw byte stream a UPS sends.
+ *
+ * File layout (all integers little-endian):
+ *   Header (16 bytes): "LUPSCAP" + '\0', quint16 version, quint16 reserved, quint32 reserved
+ *   Chunk  (6 + n bytes): quint32 delta in microseconds since the previous chunk,
+ *                         quint16 length n, followed by the n raw bytes
+ *
+ * Deltas saturate at ~71 minutes, which is far longer than any driver timeout.
+ * Re-opening an existing capture appends to it; the first chunk after a restart gets a delta of 0.
+ */
+namespace SerialCapture {
+constexpr char MAGIC[8] = { 'L', 'U', 'P', 'S', 'C', 'A', 'P', '\0' };
+constexpr quint16 VERSION = 1;
+constexpr int HEADER_SIZE = 16;
+constexpr int CHUNK_HEADER_SIZE = 6;
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds (UpsClock::nowNs()).
+ */
+UPS_API_LIBRARY_EXPORT qint64 monotonicNs();
+
+struct Chunk {
+    qint64 offsetNs = 0;   // Time since the first chunk of the capture
+    QByteArray data;
+};
+}
+
+/**
+ * @brief Appends timestamped chunks to a capture file. Not thread-safe: use it from the driver thread.
+ */
+class UPS_API_LIBRARY_EXPORT CaptureWriter
+{
+public:
+    CaptureWriter() = default;
+    ~CaptureWriter();
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString errorString() const { return m_file.errorString(); }
+
+    /**
+     * @brief Records one chunk as it was received.
+     * @param arrivalNs Monotonic arrival timestamp (SerialCapture::monotonicNs()).
+     */
+    void writeChunk(qint64 arrivalNs, const char* data, qint64 length);
+
+private:
+    QFile m_file;
+    qint64 m_lastNs = -1;
+};
+
+/**
+ * @brief Sequential reader for capture files.
+ */
+class UPS_API_LIBRARY_EXPORT CaptureReader
+{
+public:
+    bool open(const QString& path);
+    void close() { m_file.close(); }
+    QString errorString() const { return m_error; }
+
+    /**
+     * @brief Reads the next chunk. Returns false at the end of the file or on a truncated chunk.
+     */
+    bool next(SerialCapture::Chunk& chunk);
+
+private:
+    QFile m_file;
+    qint64 m_offsetNs = 0;
+    QString m_error;
+};
+
+/**
+ * @brief A read-only QIODevice that plays a capture file back with its original timing.
+ *
+ * The device behaves like a serial port for drivers: readyRead() fires for every chunk,
+ * and written bytes (commands) are accepted and discarded. A speed of 1.0 reproduces the
+ * recorded timing, N plays N times faster and 0 (or less) plays as fast as the event loop allows.
+ */
+class UPS_API_LIBRARY_EXPORT CaptureReplayDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    explicit CaptureReplayDevice(const QString& path, double speed = 1.0, QObject *parent = nullptr);
+
+    /**
+     * @brief Parses a "replay:<path>[?speed=N|max]" connection string.
+     * @return false if @p connectionInfo is not a replay connection string.
+     */
+    static bool parseConnectionInfo(const QString& connectionInfo, QString& path, double& speed);
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override { return m_pending.size() + QIODevice::bytesAvailable(); }
+
+    QString capturePath() const { return m_path; }
+
+Q_SIGNALS:
+    /**
+     * @brief Emitted once after the last chunk has been delivered.
+     */
+    void replayFinished();
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private Q_SLOTS:
+    void deliverDue();
+
+private:
+    void scheduleNext();
+
+    QString m_path;
+    double m_speed = 1.0;
+    CaptureReader m_reader;
+    SerialCapture::Chunk m_next;
+    bool m_hasNext = false;
+    QByteArray m_pending;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+};
+
+#endif // SERIAL_CAPTURE_H
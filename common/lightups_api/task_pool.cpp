@@ -0,0 +1,240 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "task_pool.h"
+#include <QThread>
+#include <algorithm>
+
+namespace {
+constexpr int MAX_WORKERS = 64;
+constexpr int STRAND_BATCH = 32;    // Tasks a strand runs before it queues itself again
+
+thread_local TaskPool* t_pool = nullptr;
+thread_local int t_worker = -1;
+}
+
+TaskPool::TaskPool(int maxThreads)
+    : m_maxThreads(std::clamp(maxThreads > 0 ? maxThreads : QThread::idealThreadCount(), 1, MAX_WORKERS))
+    , m_workers(new Worker[m_maxThreads])
+{
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    const int started = m_started.load(std::memory_order_acquire);
+    for (int i = 0; i < started; ++i) {
+        if (m_workers[i].thread.joinable()) {
+            m_workers[i].thread.join();
+        }
+    }
+}
+
+TaskPool& TaskPool::global()
+{
+    static TaskPool* pool = new TaskPool();
+    return *pool;
+}
+
+quint64 TaskPool::affinityKey(const char* name)
+{
+    // FNV-1a: the key only has to be stable for the lifetime of the process
+    quint64 hash = 14695981039346656037ull;
+    for (const char* c = name; *c; ++c) {
+        hash = (hash ^ static_cast<quint8>(*c)) * 1099511628211ull;
+    }
+    return hash ? hash : 1;
+}
+
+void TaskPool::submit(Task task)
+{
+    push(std::move(task));
+}
+
+void TaskPool::submit(quint64 affinity, Task task)
+{
+    if (affinity == 0) {
+        push(std::move(task));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_strandsMutex);
+        Strand& strand = m_strands[affinity];
+        strand.tasks.push_back(std::move(task));
+        if (strand.scheduled) return; // The running strand picks it up
+        strand.scheduled = true;
+    }
+    push([this, affinity]() { runStrand(affinity); });
+}
+
+void TaskPool::waitForIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_queued == 0 && m_running == 0; });
+}
+
+TaskPool::Stats TaskPool::stats() const
+{
+    Stats result;
+    result.executed = m_executed.load(std::memory_order_relaxed);
+    result.stolen = m_stolen.load(std::memory_order_relaxed);
+    result.wakeups = m_wakeups.load(std::memory_order_relaxed);
+    result.threads = m_started.load(std::memory_order_relaxed);
+    return result;
+}
+
+void TaskPool::push(Task task)
+{
+    const int self = t_pool == this ? t_worker : -1;
+
+    // Counted and queued under one lock: a thief cannot take a task before it is counted
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (self >= 0) {
+        std::lock_guard<std::mutex> workerLock(m_workers[self].mutex);
+        m_workers[self].tasks.push_back(std::move(task));
+    } else {
+        m_inbox.push_back(std::move(task));
+    }
+    ++m_queued;
+
+    if (m_parked > 0) {
+        m_wake.notify_one();
+    } else if (m_started.load(std::memory_order_relaxed) < m_maxThreads) {
+        startWorker(); // Every worker is busy: grow towards the core count
+    }
+}
+
+void TaskPool::startWorker()
+{
+    // Called with m_mutex held
+    const int index = m_started.load(std::memory_order_relaxed);
+    m_workers[index].thread = std::thread([this, index]() { run(index); });
+    m_started.store(index + 1, std::memory_order_release);
+}
+
+bool TaskPool::take(int self, Task& task)
+{
+    bool found = false;
+
+    // Own deque first, newest task first: its data is most likely still in cache
+    {
+        std::lock_guard<std::mutex> lock(m_workers[self].mutex);
+        if (!m_workers[self].tasks.empty()) {
+            task = std::move(m_workers[self].tasks.back());
+            m_workers[self].tasks.pop_back();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_inbox.empty()) {
+            task = std::move(m_inbox.front());
+            m_inbox.pop_front();
+            --m_queued;
+            ++m_running;
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another worker: the owner keeps working on the newest ones
+    const int started = m_started.load(std::memory_order_acquire);
+    for (int i = 1; !found && i < started; ++i) {
+        Worker& victim = m_workers[(self + i) % started];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_stolen.fetch_add(1, std::memory_order_relaxed);
+            found = true;
+        }
+    }
+
+    if (found) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_queued;
+        ++m_running;
+    }
+    return found;
+}
+
+void TaskPool::run(int self)
+{
+    t_pool = this;
+    t_worker = self;
+
+    Task task;
+    for (;;) {
+        if (take(self, task)) {
+            task();
+            task = nullptr;
+            m_executed.fetch_add(1, std::memory_order_relaxed);
+            finished();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_queued > 0) {
+            // Another worker took the task but has not counted it yet
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        if (m_stopping) return;
+
+        ++m_parked;
+        m_wake.wait(lock, [this]() { return m_queued > 0 || m_stopping; });
+        --m_parked;
+        m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TaskPool::runStrand(quint64 affinity)
+{
+    for (int i = 0; i < STRAND_BATCH; ++i) {
+        Task task;
+        {
+            std::lock_guard<std::mutex> lock(m_strandsMutex);
+            auto it = m_strands.find(affinity);
+            if (it->second.tasks.empty()) {
+                m_strands.erase(it);
+                return;
+            }
+            task = std::move(it->second.tasks.front());
+            it->second.tasks.pop_front();
+        }
+        task();
+    }
+
+    // Still busy: queue up again behind the others instead of holding this worker
+    push([this, affinity]() { runStrand(affinity); });
+}
+
+void TaskPool::finished()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_running;
+    if (m_queued == 0 && m_running == 0) {
+        m_idle.notify_all();
+    }
+}
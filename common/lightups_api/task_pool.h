@@ -0,0 +1,140 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include "lightups_api_global.h"
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Work-stealing pool for the service's background work (flushing, formatting, analysis).
+ *
+ * It complements DriverReactorPool: the reactor threads own the I/O (ports, sockets, timers) and
+ * never block, while blocking or CPU-bound work goes here instead of into a thread of its own.
+ *
+ * Each worker has its own deque: tasks submitted from a worker go to its back and are taken LIFO
+ * (cache-warm), tasks from other threads go to a shared inbox, and a worker that runs dry steals
+ * from the front of the others. Workers start on demand up to the machine's core count and park
+ * on a condition variable when there is nothing to do, so an idle pool costs no wake-ups at all.
+ *
+ * Stateful work passes an affinity key: tasks with the same key run one at a time and in
+ * submission order (a strand), so they need no locking of their own. Thread-safe.
+ */
+class UPS_API_LIBRARY_EXPORT TaskPool
+{
+public:
+    using Task = std::function<void()>;
+
+    struct Stats {
+        quint64 executed = 0;
+        quint64 stolen = 0;         // Tasks taken from another worker's deque
+        quint64 wakeups = 0;        // Times a parked worker was woken
+        int threads = 0;            // Workers started so far
+    };
+
+    /**
+     * @brief @p maxThreads 0 = QThread::idealThreadCount().
+     */
+    explicit TaskPool(int maxThreads = 0);
+
+    /**
+     * @brief Runs everything still queued, then joins the workers.
+     */
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * @brief The pool shared by all components of the process. It is never destroyed: parked
+     * workers are harmless at exit, and joining threads from static destructors is not.
+     */
+    static TaskPool& global();
+
+    /**
+     * @brief A stable affinity key for a component name (never 0).
+     */
+    static quint64 affinityKey(const char* name);
+
+    void submit(Task task);
+
+    /**
+     * @brief Runs @p task after every earlier task with the same @p affinity, never concurrently
+     * with one. An @p affinity of 0 is the same as submit(task).
+     */
+    void submit(quint64 affinity, Task task);
+
+    /**
+     * @brief Waits until nothing is queued or running. Must not be called from a task.
+     */
+    void waitForIdle();
+
+    int maxThreadCount() const { return m_maxThreads; }
+    Stats stats() const;
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    struct Strand {
+        std::deque<Task> tasks;
+        bool scheduled = false;     // A runner is queued or running
+    };
+
+    void push(Task task);
+    bool take(int self, Task& task);
+    void run(int self);
+    void runStrand(quint64 affinity);
+    void startWorker();
+    void finished();
+
+    const int m_maxThreads;
+    std::unique_ptr<Worker[]> m_workers;   // Fixed array: started workers never move
+    std::atomic<int> m_started{0};
+
+    std::mutex m_mutex;                     // Guards the inbox, the counters below and parking
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<Task> m_inbox;
+    int m_queued = 0;                       // In the inbox or any worker deque
+    int m_running = 0;
+    int m_parked = 0;
+    bool m_stopping = false;
+
+    std::mutex m_strandsMutex;
+    std::unordered_map<quint64, Strand> m_strands;
+
+    std::atomic<quint64> m_executed{0};
+    std::atomic<quint64> m_stolen{0};
+    std::atomic<quint64> m_wakeups{0};
+};
+
+#endif // TASK_POOL_H
@@ -0,0 +1,85 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nhs_codec.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace NhsCodec {
+
+size_t encodeFrame(quint8 type, std::span<const quint8> payload, std::span<quint8> out)
+{
+    const size_t packetLen = HEADER_LEN + payload.size() + TRAILER_LEN;
+    if (packetLen > 0xFF || out.size() < packetLen) {
+        return 0;
+    }
+
+    out[0] = NhsRingBuffer::START_MARKER;
+    out[1] = static_cast<quint8>(packetLen);
+    out[2] = type;
+    if (!payload.empty()) {
+        std::memcpy(&out[HEADER_LEN], payload.data(), payload.size());
+    }
+    out[packetLen - 2] = NhsRingBuffer::checksum(out.data(), static_cast<int>(packetLen) - 3);
+    out[packetLen - 1] = NhsRingBuffer::END_MARKER;
+    return packetLen;
+}
+
+size_t encodeData(const nhs_data_payload_t& payload, std::span<quint8> out)
+{
+    return encodeFrame(TYPE_DATA, std::span<const quint8>(reinterpret_cast<const quint8*>(&payload), sizeof(payload)), out);
+}
+
+size_t encodeHardware(const nhs_hardware_payload_t& payload, std::span<quint8> out)
+{
+    return encodeFrame(TYPE_HARDWARE, std::span<const quint8>(reinterpret_cast<const quint8*>(&payload), sizeof(payload)), out);
+}
+
+std::span<const quint8> handshakeCommand()
+{
+    // FF 09 53 03 00 00 00 5F FE
+    static const std::array<quint8, 9> command = [] {
+        std::array<quint8, 9> cmd{};
+        const quint8 payload[] = { 0x03, 0x00, 0x00, 0x00 };
+        encodeFrame(TYPE_HARDWARE, payload, cmd);
+        return cmd;
+    }();
+    return command;
+}
+
+UpsData toUpsData(const pkt_data_t& raw, qint64 arrivalNs)
+{
+    UpsData data;
+    data.timestampNs = arrivalNs;
+    data.inputMillivolts = raw.input_voltage_v * 1000;
+    data.outputMillivolts = raw.output_voltage_v * 1000;
+    data.batteryMillivolts = le16(raw.payload.vdcmed_low, raw.payload.vdcmed_high) * 100; // Sent in 0.1 V
+    // A corrupt reading above 3276 degrees must saturate, not wrap into a negative temperature
+    data.temperatureDeci = static_cast<qint16>(std::min<int>(raw.temperature_c * 10, std::numeric_limits<qint16>::max()));
+    data.setLoadPercentage(raw.power_rms_percent);
+    data.setBatteryLevel(-1.0);
+    data.setBatteryFault(raw.s_battery_low); // We use 'low' as 'fault' here, as before.
+
+    // The status byte -> state mapping is a compile-time table; the text is looked up where it is shown
+    data.state = raw.state;
+    data.statusCode = UpsMonitor::statusCodeForState(raw.state);
+    return data;
+}
+
+} // namespace NhsCodec
@@ -0,0 +1,431 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NHS_CODEC_H
+#define NHS_CODEC_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <span>
+#include "ups_report.h"
+#include "nhs_ring_buffer.h"
+#include "protocol_frame.h"
+
+/**
+ * @brief Transport-independent codec for the NHS serial protocol.
+ *
+ * Bytes go in as spans, decoded frames come out. Nothing in here knows about
+ * QSerialPort, QTimer or threads, so the codec can be reused by the driver, the
+ * simulator and the benchmarks alike.
+ */
+namespace NhsCodec {
+
+// Bits in the statusval (byte)
+namespace StatusBits {
+constexpr quint8 FREQUENCY_ASYNC       = 0x01;  // Bit 0
+constexpr quint8 BATTERY_LOW_CRITICAL  = 0x02;  // Bit 1
+// constexpr quint8 BIT_2_UNKNOWN         = 0x04;  // Bit 2
+constexpr quint8 INVERTER_ACTIVE       = 0x08;  // Bit 3
+constexpr quint8 BATTERY_CHARGING      = 0x10;  // Bit 4
+// constexpr quint8 BIT_5_UNKNOWN         = 0x20;  // Bit 5
+// constexpr quint8 BIT_6_UNKNOWN         = 0x40;  // Bit 6
+constexpr quint8 BATTERY_FLOW_ACTIVE   = 0x80;  // Bit 7
+}
+
+constexpr int PACKET_LEN_D = NhsRingBuffer::PACKET_LEN_D; // Total length FF..FE
+constexpr int PACKET_LEN_S = NhsRingBuffer::PACKET_LEN_S; // Total length FF..FE
+constexpr int HEADER_LEN = 3;  // FF, length, type
+constexpr int TRAILER_LEN = 2; // checksum, FE
+
+constexpr quint8 TYPE_DATA = 'D';
+constexpr quint8 TYPE_HARDWARE = 'S';
+
+// Ensure the compiler packs the structs (required for the NHS protocol)
+#pragma pack(push, 1)
+
+// The 16 bytes of the Realtime Status data-payload (Type 'D')
+typedef struct {
+    quint8 vacinrms_low;
+    quint8 vacinrms_high;
+    quint8 vdcmed_low;
+    quint8 vdcmed_high;
+    quint8 potrms;
+    quint8 vacinrmsmin_low;
+    quint8 vacinrmsmin_high;
+    quint8 vacinrmsmax_low;
+    quint8 vacinrmsmax_high;
+    quint8 vacoutrms_low;
+    quint8 vacoutrms_high;
+    quint8 tempmed_low;
+    quint8 tempmed_high;
+    quint8 icarregrms;
+    quint8 statusval;
+    quint8 unknown_status;
+} nhs_data_payload_t;
+
+// The 13 bytes of the core hardware data-payload (Type 'S')
+typedef struct {
+    quint8 unknown_id_byte_1;
+    quint8 unknown_id_byte_2;
+    quint8 unknown_id_byte_3;
+    quint8 unknown_id_byte_4;
+    quint8 unknown_id_byte_5;
+
+    quint8 undervoltage_127V_byte;
+    quint8 overvoltage_127V_byte;
+    quint8 undervoltage_220V_byte;
+    quint8 overvoltage_220V_byte;
+
+    quint8 output_voltage_byte;
+    quint8 input_voltage_byte;
+    quint8 unknown_byte_6;
+    quint8 unknown_byte_7;
+} nhs_hardware_payload_t;
+
+#pragma pack(pop)
+
+// The payload layouts are fixed by the frame lengths; fail the build if they ever drift apart.
+static_assert(sizeof(nhs_data_payload_t) == PACKET_LEN_D - HEADER_LEN - TRAILER_LEN, "D payload layout mismatch");
+static_assert(sizeof(nhs_hardware_payload_t) == PACKET_LEN_S - HEADER_LEN - TRAILER_LEN, "S payload layout mismatch");
+static_assert(offsetof(nhs_data_payload_t, statusval) == 14, "statusval must be payload byte 14");
+static_assert(offsetof(nhs_hardware_payload_t, undervoltage_220V_byte) == 7, "220V thresholds must start at payload byte 7");
+
+// Structure to store the parsed data
+typedef struct {
+    // Raw payloads
+    nhs_data_payload_t payload;
+    nhs_hardware_payload_t hardware_payload;
+
+    // Parsed and converted values
+    quint16 input_voltage_v;
+    float battery_voltage_v;
+    quint16 output_voltage_v;
+    quint16 temperature_c;
+    quint8 power_rms_percent;
+    quint16 input_voltage_min_v;
+    quint16 input_voltage_max_v;
+    UpsMonitor::UpsState state;     // statusval through STATUS_STATE_TABLE
+
+    // All 8 status flags
+    bool s_battery_mode;            // Bit 0
+    bool s_battery_low;             // Bit 1
+    bool s_network_failure;         // Bit 2
+    bool s_fast_network_failure;    // Bit 3
+    bool s_220_in;                  // Bit 4
+    bool s_220_out;                 // Bit 5
+    bool s_bypass_on;               // Bit 6
+    bool s_charger_on;              // Bit 7
+
+    quint8 uv_220v;
+    quint8 ov_220v;
+} pkt_data_t;
+
+enum class FrameType : quint8 {
+    Data,       // 'D' realtime status
+    Hardware,   // 'S' hardware info (handshake reply)
+};
+
+/**
+ * @brief A validated frame. The payload points into the decoder's ring and is only
+ * valid during the frame callback.
+ */
+struct Frame {
+    FrameType type;
+    std::span<const quint8> payload;
+};
+
+// ----------------------------------------------------
+// --- COMPILE-TIME DECODING ---
+// ----------------------------------------------------
+
+constexpr quint16 le16(quint8 low, quint8 high) { return static_cast<quint16>(low | (high << 8)); }
+
+/**
+ * @brief Maps a status byte to a UpsState. Order of the checks is the priority.
+ */
+constexpr UpsMonitor::UpsState stateFromStatusByte(quint8 statusVal)
+{
+    using UpsMonitor::UpsState;
+    // 1. Critical (Bit 1)
+    if (statusVal & StatusBits::BATTERY_LOW_CRITICAL) return UpsState::BatteryCritical;
+    // 2. On Battery (Mains Power Lost: !Bit 4)
+    if (!(statusVal & StatusBits::BATTERY_CHARGING)) return UpsState::OnBattery;
+    // 3. Online Fault (Frequency not in sync: Bit 0)
+    if (statusVal & StatusBits::FREQUENCY_ASYNC) return UpsState::OnlineFault;
+    // 4. Actively Charging (Online AND Large Current: Bit 7)
+    if (statusVal & StatusBits::BATTERY_FLOW_ACTIVE) return UpsState::OnlineCharging;
+    // 5. Online Full (Lowest Priority)
+    return UpsState::OnlineFull;
+}
+
+constexpr std::array<UpsMonitor::UpsState, 256> makeStatusTable()
+{
+    std::array<UpsMonitor::UpsState, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        table[i] = stateFromStatusByte(static_cast<quint8>(i));
+    }
+    return table;
+}
+
+// The full status byte -> UpsState mapping, built by the compiler
+inline constexpr std::array<UpsMonitor::UpsState, 256> STATUS_STATE_TABLE = makeStatusTable();
+
+static_assert(STATUS_STATE_TABLE[0x12] == UpsMonitor::UpsState::BatteryCritical);
+static_assert(STATUS_STATE_TABLE[0x00] == UpsMonitor::UpsState::OnBattery);
+static_assert(STATUS_STATE_TABLE[0x11] == UpsMonitor::UpsState::OnlineFault);
+static_assert(STATUS_STATE_TABLE[0x90] == UpsMonitor::UpsState::OnlineCharging);
+static_assert(STATUS_STATE_TABLE[0x10] == UpsMonitor::UpsState::OnlineFull);
+
+constexpr nhs_data_payload_t toDataPayload(std::span<const quint8, sizeof(nhs_data_payload_t)> bytes)
+{
+    std::array<quint8, sizeof(nhs_data_payload_t)> raw{};
+    for (size_t i = 0; i < raw.size(); ++i) raw[i] = bytes[i];
+    return std::bit_cast<nhs_data_payload_t>(raw);
+}
+
+constexpr nhs_hardware_payload_t toHardwarePayload(std::span<const quint8, sizeof(nhs_hardware_payload_t)> bytes)
+{
+    std::array<quint8, sizeof(nhs_hardware_payload_t)> raw{};
+    for (size_t i = 0; i < raw.size(); ++i) raw[i] = bytes[i];
+    return std::bit_cast<nhs_hardware_payload_t>(raw);
+}
+
+/**
+ * @brief Decodes a 'D' payload into the converted fields of @p out.
+ */
+constexpr void decodeData(const nhs_data_payload_t& payload, pkt_data_t& out)
+{
+    out.payload = payload;
+
+    // Bit-shifting and conversion to readable values
+    out.input_voltage_v = le16(payload.vacinrms_low, payload.vacinrms_high);
+    out.output_voltage_v = le16(payload.vacoutrms_low, payload.vacoutrms_high);
+    out.battery_voltage_v = le16(payload.vdcmed_low, payload.vdcmed_high) / 10.0f;
+    out.temperature_c = le16(payload.tempmed_low, payload.tempmed_high);
+    out.power_rms_percent = payload.potrms;
+    out.input_voltage_min_v = le16(payload.vacinrmsmin_low, payload.vacinrmsmin_high);
+    out.input_voltage_max_v = le16(payload.vacinrmsmax_low, payload.vacinrmsmax_high);
+
+    // Reading status bits
+    const quint8 status_byte = payload.statusval;
+    out.state = STATUS_STATE_TABLE[status_byte];
+    out.s_battery_mode = (status_byte & (1 << 0));
+    out.s_battery_low = (status_byte & (1 << 1));
+    out.s_network_failure = (status_byte & (1 << 2));
+    out.s_fast_network_failure = (status_byte & (1 << 3));
+    out.s_220_in = (status_byte & (1 << 4));
+    out.s_220_out = (status_byte & (1 << 5));
+    out.s_bypass_on = (status_byte & (1 << 6));
+    out.s_charger_on = (status_byte & (1 << 7));
+}
+
+/**
+ * @brief Decodes an 'S' payload into the hardware fields of @p out.
+ */
+constexpr void decodeHardware(const nhs_hardware_payload_t& payload, pkt_data_t& out)
+{
+    out.hardware_payload = payload;
+    out.uv_220v = payload.undervoltage_220V_byte;
+    out.ov_220v = payload.overvoltage_220V_byte;
+}
+
+/**
+ * @brief Converts the decoded 'D' fields of @p raw into a sample stamped with @p arrivalNs. Never allocates.
+ * The protocol has no charge level: batteryLevel is -1 and the API estimates it (BatteryEstimator).
+ */
+UpsData toUpsData(const pkt_data_t& raw, qint64 arrivalNs);
+
+// ----------------------------------------------------
+// --- ENCODING (commands, simulators, benchmarks) ---
+// ----------------------------------------------------
+
+/**
+ * @brief Builds a complete frame (FF len type payload checksum FE) into @p out.
+ * @return The number of bytes written, or 0 if @p out is too small.
+ */
+size_t encodeFrame(quint8 type, std::span<const quint8> payload, std::span<quint8> out);
+
+size_t encodeData(const nhs_data_payload_t& payload, std::span<quint8> out);
+size_t encodeHardware(const nhs_hardware_payload_t& payload, std::span<quint8> out);
+
+/**
+ * @brief The 9-byte S command (FF0953030000005FFE) that starts the handshake.
+ */
+std::span<const quint8> handshakeCommand();
+
+// ----------------------------------------------------
+// --- STREAM DECODER ---
+// ----------------------------------------------------
+
+/**
+ * @brief Counters maintained by the FrameDecoder.
+ */
+struct DecoderStats {
+    quint64 bytesIn = 0;            // Bytes fed into the decoder
+    quint64 framesDecoded = 0;      // Frames with valid checksum and a known type/length pair
+    quint64 checksumFailures = 0;   // Candidate frames that failed the end marker or checksum
+    quint64 resyncBytesDiscarded = 0; // Bytes skipped while searching for a frame start
+    quint64 unknownFrames = 0;      // Valid frames with an unexpected type/length combination
+    quint64 bufferOverruns = 0;     // Forced ring flushes because no frame could be extracted from a full ring
+};
+
+/**
+ * @brief Incremental stream decoder: feed arbitrary chunks, receive complete frames.
+ */
+class FrameDecoder
+{
+public:
+    /**
+     * @brief Ingests @p bytes and calls onFrame(const Frame&) for every decoded frame.
+     * @return The number of frames delivered by this call.
+     */
+    template <typename FrameFn>
+    int feed(std::span<const quint8> bytes, FrameFn&& onFrame)
+    {
+        int delivered = 0;
+        const quint8* src = bytes.data();
+        int remaining = static_cast<int>(bytes.size());
+        m_stats.bytesIn += bytes.size();
+
+        // Ingest in batches: block-copy what fits, drain all complete frames, repeat.
+        while (remaining > 0) {
+            const int copied = m_ring.write(src, remaining);
+            src += copied;
+            remaining -= copied;
+
+            m_stats.resyncBytesDiscarded += m_ring.extractFrames(
+                [&](const quint8* frame, int packetLen) {
+                    Frame decoded;
+                    if (!classify(frame, packetLen, decoded)) {
+                        ++m_stats.unknownFrames;
+                        return;
+                    }
+                    ++m_stats.framesDecoded;
+                    ++delivered;
+                    onFrame(decoded);
+                },
+                [&]() { ++m_stats.checksumFailures; });
+
+            if (copied == 0) {
+                // Cannot happen with a valid frame size, but never spin on a full ring.
+                ++m_stats.bufferOverruns;
+                m_stats.resyncBytesDiscarded += m_ring.size();
+                m_ring.clear();
+            }
+        }
+        return delivered;
+    }
+
+    void reset() { m_ring.clear(); }
+
+    const DecoderStats& stats() const { return m_stats; }
+
+private:
+    static bool classify(const quint8* frame, int packetLen, Frame& out)
+    {
+        const quint8 type = frame[2];
+        if (type == TYPE_DATA && packetLen == PACKET_LEN_D) {
+            out = { FrameType::Data, std::span<const quint8>(frame + HEADER_LEN, sizeof(nhs_data_payload_t)) };
+            return true;
+        }
+        if (type == TYPE_HARDWARE && packetLen == PACKET_LEN_S) {
+            out = { FrameType::Hardware, std::span<const quint8>(frame + HEADER_LEN, sizeof(nhs_hardware_payload_t)) };
+            return true;
+        }
+        return false;
+    }
+
+    NhsRingBuffer m_ring;
+    DecoderStats m_stats;
+};
+
+// ----------------------------------------------------
+// --- DECLARATIVE PROTOCOL (generated parser) ---
+// ----------------------------------------------------
+
+/**
+ * @brief The NHS protocol described for ProtocolFrame: FF len type payload checksum FE,
+ * len counts the whole frame, the checksum is the byte sum from len up to the payload end.
+ */
+inline constexpr ProtocolFrame::Layout PROTOCOL_LAYOUT{
+    .startMarker = NhsRingBuffer::START_MARKER,
+    .endMarker = NhsRingBuffer::END_MARKER,
+    .lengthOffset = 1,
+    .lengthRule = ProtocolFrame::LengthRule::TotalFrame,
+    .typeOffset = 2,
+    .headerLength = HEADER_LEN,
+    .checksum = ProtocolFrame::ChecksumRule::Sum8,
+    .checksumFrom = 1,
+};
+
+namespace Fields {
+using ProtocolFrame::Frame;
+using ProtocolFrame::Raw;
+using ProtocolFrame::Field;
+using ProtocolFrame::Scaled;
+using ProtocolFrame::Mapped;
+using ProtocolFrame::Bit;
+using ProtocolFrame::Endian;
+using ProtocolFrame::Scale;
+using P = nhs_data_payload_t;
+using H = nhs_hardware_payload_t;
+
+// Realtime Status (Type 'D'): the generated counterpart of decodeData()
+using DataFrame = Frame<TYPE_DATA, sizeof(P),
+    Raw<&pkt_data_t::payload, 0>,
+    Field<&pkt_data_t::input_voltage_v, offsetof(P, vacinrms_low), 2>,
+    Field<&pkt_data_t::output_voltage_v, offsetof(P, vacoutrms_low), 2>,
+    Scaled<&pkt_data_t::battery_voltage_v, offsetof(P, vdcmed_low), 2, Endian::Little, Scale{1, 10}>,
+    Field<&pkt_data_t::temperature_c, offsetof(P, tempmed_low), 2>,
+    Field<&pkt_data_t::power_rms_percent, offsetof(P, potrms), 1>,
+    Field<&pkt_data_t::input_voltage_min_v, offsetof(P, vacinrmsmin_low), 2>,
+    Field<&pkt_data_t::input_voltage_max_v, offsetof(P, vacinrmsmax_low), 2>,
+    Mapped<&pkt_data_t::state, offsetof(P, statusval), STATUS_STATE_TABLE>,
+    Bit<&pkt_data_t::s_battery_mode, offsetof(P, statusval), 0>,
+    Bit<&pkt_data_t::s_battery_low, offsetof(P, statusval), 1>,
+    Bit<&pkt_data_t::s_network_failure, offsetof(P, statusval), 2>,
+    Bit<&pkt_data_t::s_fast_network_failure, offsetof(P, statusval), 3>,
+    Bit<&pkt_data_t::s_220_in, offsetof(P, statusval), 4>,
+    Bit<&pkt_data_t::s_220_out, offsetof(P, statusval), 5>,
+    Bit<&pkt_data_t::s_bypass_on, offsetof(P, statusval), 6>,
+    Bit<&pkt_data_t::s_charger_on, offsetof(P, statusval), 7>>;
+
+// Hardware Info (Type 'S', handshake reply): the generated counterpart of decodeHardware()
+using HardwareFrame = Frame<TYPE_HARDWARE, sizeof(H),
+    Raw<&pkt_data_t::hardware_payload, 0>,
+    Field<&pkt_data_t::uv_220v, offsetof(H, undervoltage_220V_byte), 1>,
+    Field<&pkt_data_t::ov_220v, offsetof(H, overvoltage_220V_byte), 1>>;
+} // namespace Fields
+
+using DataFrame = Fields::DataFrame;
+using HardwareFrame = Fields::HardwareFrame;
+using Protocol = ProtocolFrame::Protocol<PROTOCOL_LAYOUT, DataFrame, HardwareFrame>;
+
+static_assert(Protocol::frameLength<DataFrame>() == PACKET_LEN_D, "D frame length mismatch");
+static_assert(Protocol::frameLength<HardwareFrame>() == PACKET_LEN_S, "S frame length mismatch");
+static_assert(Protocol::MAX_FRAME_LENGTH == NhsRingBuffer::MAX_PACKET_LEN);
+
+/**
+ * @brief Generated stream parser: decodes straight into a pkt_data_t and reports the frame type.
+ */
+using Parser = ProtocolFrame::StreamParser<Protocol, NhsRingBuffer::BUFFER_SIZE>;
+
+} // namespace NhsCodec
+
+#endif // NHS_CODEC_H
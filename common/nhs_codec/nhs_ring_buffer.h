@@ -0,0 +1,89 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NHS_RING_BUFFER_H
+#define NHS_RING_BUFFER_H
+
+#include <cstdint>
+#include "frame_ring.h"
+
+/**
+ * @brief Batched ring buffer and frame extractor for the NHS serial protocol.
+ *
+ * The ring itself (block copies, mirrored prefix, memchr search) is ProtocolFrame::MirroredRing,
+ * which the generated StreamParser uses as well; this class adds the NHS frame rules: a known
+ * length byte, the end marker and the 8-bit sum.
+ *
+ * This header deliberately has no Qt dependency so it can be benchmarked standalone.
+ */
+class NhsRingBuffer : public ProtocolFrame::MirroredRing<128, 21> // 128-byte ring, frames up to 21 bytes
+{
+public:
+    static constexpr int PACKET_LEN_D = 21;   // Total length FF..FE
+    static constexpr int PACKET_LEN_S = 18;   // Total length FF..FE
+    static constexpr int MAX_PACKET_LEN = PACKET_LEN_D;
+    static_assert(MAX_PACKET_LEN == MAX_FRAME_LENGTH, "The ring must mirror the longest frame");
+
+    static constexpr uint8_t START_MARKER = 0xFF;
+    static constexpr uint8_t END_MARKER = 0xFE;
+
+    /**
+     * @brief Sums the bytes [1 .. length] of a contiguous frame (the 0xFF start byte is skipped).
+     */
+    static uint8_t checksum(const uint8_t* frame, int length)
+    {
+        unsigned int sum = 0;
+        for (int i = 1; i <= length; ++i) {
+            sum += frame[i];
+        }
+        return static_cast<uint8_t>(sum & 0xFF);
+    }
+
+    static bool isValidLength(uint8_t length) { return length == PACKET_LEN_D || length == PACKET_LEN_S; }
+
+    /**
+     * @brief Extracts every complete frame currently in the ring.
+     *
+     * @param onFrame    Called as onFrame(const uint8_t* frame, int length) for each frame
+     *                   whose end marker and checksum are valid. The pointer is only valid
+     *                   during the call.
+     * @param onMismatch Called as onMismatch() when a candidate frame fails validation.
+     * @return The number of bytes that were skipped while searching for a frame start.
+     */
+    template <typename FrameFn, typename MismatchFn>
+    int extractFrames(FrameFn&& onFrame, MismatchFn&& onMismatch)
+    {
+        return scan(START_MARKER, 2, [&](const uint8_t* frame, int available) {
+            // A start marker only counts when it is followed by a known length byte
+            const int packetLen = frame[1];
+            if (!isValidLength(frame[1])) return RESYNC;
+            if (available < packetLen) return NEED_MORE; // Wait for the rest of the frame
+
+            // Validate the frame as one contiguous span
+            const uint8_t expectedChecksum = frame[packetLen - 2];
+            if (frame[packetLen - 1] == END_MARKER && checksum(frame, packetLen - 3) == expectedChecksum) {
+                onFrame(frame, packetLen);
+                return packetLen;
+            }
+            onMismatch();
+            return RESYNC;
+        });
+    }
+};
+
+#endif // NHS_RING_BUFFER_H
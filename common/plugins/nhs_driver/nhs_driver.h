@@ -19,102 +19,14 @@
 #ifndef NHS_DRIVER_H
 #define NHS_DRIVER_H
 
-#include <QtSerialPort/QSerialPort>
 #include <QByteArray>
 #include <QString>
 #include <QTimer>
 #include <QDebug>
 #include "i_ups_driver.h"
-
-// Ensure the compiler packs the structs (required for the NHS protocol)
-// The empty struct resolves a compiler bug/quirk with the pragma stack.
-typedef struct {} dummy_struct_for_compiler_quirk;
-
-// nhs_driver.h or a separate header file (ups_status_bits.h)
-namespace NhsStatusBits {
-// Bits in the statusval (byte)
-const quint8 FREQUENCY_ASYNC       = 0x01;  // Bit 0
-const quint8 BATTERY_LOW_CRITICAL  = 0x02;  // Bit 1
-// const quint8 BIT_2_UNKNOWN         = 0x04;  // Bit 2
-const quint8 INVERTER_ACTIVE       = 0x08;  // Bit 3
-const quint8 BATTERY_CHARGING      = 0x10;  // Bit 4
-// const quint8 BIT_5_UNKNOWN         = 0x20;  // Bit 5
-// const quint8 BIT_6_UNKNOWN         = 0x40;  // Bit 6
-const quint8 BATTERY_FLOW_ACTIVE   = 0x80;  // Bit 7
-}
-
-#pragma pack(push, 1)
-
-// The 16 bytes of the Realtime Status data-payload (Type 'D')
-
-    typedef struct {
-    quint8 vacinrms_low;
-    quint8 vacinrms_high;
-    quint8 vdcmed_low;
-    quint8 vdcmed_high;
-    quint8 potrms;
-    quint8 vacinrmsmin_low;
-    quint8 vacinrmsmin_high;
-    quint8 vacinrmsmax_low;
-    quint8 vacinrmsmax_high;
-    quint8 vacoutrms_low;
-    quint8 vacoutrms_high;
-    quint8 tempmed_low;
-    quint8 tempmed_high;
-    quint8 icarregrms;
-    quint8 statusval;
-    quint8 unknown_status;
-} nhs_data_payload_t;
-
-// The 14 bytes of the core hardware data-payload (Type 'S')
-typedef struct {
-    quint8 unknown_id_byte_1;
-    quint8 unknown_id_byte_2;
-    quint8 unknown_id_byte_3;
-    quint8 unknown_id_byte_4;
-    quint8 unknown_id_byte_5;
-
-    quint8 undervoltage_127V_byte;
-    quint8 overvoltage_127V_byte;
-    quint8 undervoltage_220V_byte;
-    quint8 overvoltage_220V_byte;
-
-    quint8 output_voltage_byte;
-    quint8 input_voltage_byte;
-    quint8 unknown_byte_6;
-    quint8 unknown_byte_7;
-} nhs_hardware_payload_t;
-
-// Global structure to store the raw parsed data
-typedef struct {
-    // Raw payloads
-    nhs_data_payload_t payload;
-    nhs_hardware_payload_t hardware_payload;
-
-    // Parsed and converted values
-    quint16 input_voltage_v;
-    float battery_voltage_v;
-    quint16 output_voltage_v;
-    quint16 temperature_c;
-    quint8 power_rms_percent;
-    quint16 input_voltage_min_v;
-    quint16 input_voltage_max_v;
-
-    // --- New: All 8 status flags ---
-    bool s_battery_mode;            // Bit 0 (already present)
-    bool s_battery_low;             // Bit 1 (NEW)
-    bool s_network_failure;         // Bit 2 (already present)
-    bool s_fast_network_failure;    // Bit 3 (NEW)
-    bool s_220_in;                  // Bit 4 (NEW)
-    bool s_220_out;                 // Bit 5 (NEW)
-    bool s_bypass_on;               // Bit 6 (NEW)
-    bool s_charger_on;              // Bit 7 (NEW)
-
-    quint8 uv_220v;
-    quint8 ov_220v;
-
-} pkt_data_t;
-#pragma pack(pop)
+#include "driver_transport.h"
+#include "recovery_scheduler.h"
+#include "nhs_codec.h"
 
 class  Nhs_driver: public IUpsDriver
 {
@@ -127,30 +39,30 @@ public:
     ~Nhs_driver(); // <--- NEW: Explicit destructor
     bool initialize(const QString& connectionInfo) override;
     QString driverName() const override;
+    IUpsDriver* createInstance() const override { return new Nhs_driver(); }
 
 public Q_SLOTS: // <--- NEW: Slot to stop the driver cleanly from outside
     void stopDriver();
 
 private Q_SLOTS:
     // Slots for asynchronous communication
-    void readData();               // Triggered by QSerialPort::readyRead
+    void readData();               // Triggered by QIODevice::readyRead
     void onMonitorTimeout();       // <<< NEW: Slot for data loss monitoring/restart
-    void handleSerialError(QSerialPort::SerialPortError error);
+    void onTransportOpened();
+    void onTransportError(const QString& message, bool connectionLost);
 
 private:
     QString m_portName;
-    QSerialPort *m_serialPort = nullptr;
+    DriverTransport *m_transport = nullptr; // Serial port, pty, TCP socket or capture replay (from the URI)
     QTimer *m_monitorTimer = nullptr;
-    pkt_data_t m_latestRawData;
+    RecoveryScheduler *m_reopen = nullptr;  // Backoff for reopening a lost port
+    NhsCodec::pkt_data_t m_latestRawData = {};
     UpsData m_latestUpsData;               // The data returned by fetchData()
     bool m_initialSDataReceived = false;   // Has the stream already provided D-data?
     void sendInitiatorCommand();
 
-    // Helper Functions (converted from main.c)
-    quint8 calculate_checksum_ring(int tail_index, int length);
-    bool parse_packet_ring(int tail_index, int packetLen);
-    UpsData convertRawToUpsData();
-    int calculateBatteryLevelFromVoltage(double voltage) const;
+    // Protocol handling is delegated to the transport-independent codec
+    void handleFrame(NhsCodec::FrameType type);
 
     // New variables for the handshake logic
     int m_retryCount = 0;             // How many times have we tried the S-command?
@@ -161,15 +73,15 @@ private:
     const int HANDSHAKE_TIMEOUT = 1500; // 1.5 seconds waiting for response
     const int MONITOR_TIMEOUT = 3000;   // Normal timeout during operation
 
-    // Ring buffer configuration
-    static const int BUFFER_SIZE = 128;             // Must be a power of 2
-    static const int BUFFER_MASK = BUFFER_SIZE - 1; // Used for the fast & operation
-    uint8_t m_ringBuffer[BUFFER_SIZE];              // The actual buffer
-    int m_head = 0;                                 // Write index
-    int m_tail = 0;                                 // Read index
+    // Stream parser generated from NhsCodec::Protocol (ring buffer, framing, checksum and field decoding)
+    NhsCodec::Parser m_parser;
+
+    // Link statistics
+    qint64 m_chunkArrivalNs = 0;      // Arrival time of the chunk being decoded (latency histogram)
+    bool m_portOpenedBefore = false;  // Distinguishes reconnects from the first open
 
-    void closePort(); // New method
     bool tryOpenPort();
+    void reopenPort();
 };
 
 #endif // NHS_DRIVER_H
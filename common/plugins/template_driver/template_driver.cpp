@@ -24,8 +24,8 @@ Template_driver::Template_driver(QObject *parent)
 {
     // We initialize the data with safe values
     m_latestData.state = UpsMonitor::UpsState::Unknown;
-    m_latestData.inputVoltage = 0;
-    m_latestData.statusMessage = tr("Initializing...");
+    m_latestData.inputMillivolts = 0;
+    m_latestData.statusCode = UpsMonitor::StatusCode::Initializing;
 }
 
 Template_driver::~Template_driver()
@@ -63,18 +63,19 @@ void Template_driver::finishInitialization()
 void Template_driver::generateMockData()
 {
     // Fill the struct with guaranteed safe values
-    m_latestData.timestamp = QDateTime::currentDateTime();
+    m_latestData.timestampNs = UpsClock::nowNs();
     m_latestData.state = UpsMonitor::UpsState::OnlineFull; // ALWAYS SAFE
-    m_latestData.inputVoltage = SAFE_VOLTAGE;
-    m_latestData.outputVoltage = SAFE_VOLTAGE;
-    m_latestData.batteryVoltage = 13.6;
-    m_latestData.batteryLevel = SAFE_BATTERY;
-    m_latestData.temperatureC = 25.0;
-    m_latestData.loadPercentage = 15;
-    m_latestData.BatteryFault = false;
-    m_latestData.statusMessage = tr("Template Mode: System OK");
+    m_latestData.setInputVoltage(SAFE_VOLTAGE);
+    m_latestData.setOutputVoltage(SAFE_VOLTAGE);
+    m_latestData.setBatteryVoltage(13.6);
+    m_latestData.setBatteryLevel(SAFE_BATTERY);
+    m_latestData.setTemperatureC(25.0);
+    m_latestData.setLoadPercentage(15);
+    m_latestData.setBatteryFault(false);
+    m_latestData.statusCode = UpsMonitor::StatusCode::Simulated;
 
     // Send to the API layer
+    stats().addFramesDecoded(1);
     emit dataReceived(m_latestData);
 }
 
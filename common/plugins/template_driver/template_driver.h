@@ -40,6 +40,7 @@ public:
     bool initialize(const QString& connectionInfo) override;
     // UpsData fetchData() override;
     QString driverName() const override { return "Template_Mock_Driver"; }
+    IUpsDriver* createInstance() const override { return new Template_driver(); }
 
 public Q_SLOTS:
     void stopDriver();
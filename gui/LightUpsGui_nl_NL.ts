@@ -3,46 +3,11 @@
 <TS version="2.1" language="nl_NL" sourcelanguage="en">
 <context>
     <name>Nhs_driver</name>
-    <message>
-        <location filename="../common/plugins/nhs_driver/nhs_driver.cpp" line="186"/>
-        <source>CRITICAL: Battery Low. Shutdown required.</source>
-        <translation type="unfinished"></translation>
-    </message>
-    <message>
-        <location filename="../common/plugins/nhs_driver/nhs_driver.cpp" line="191"/>
-        <source>On Battery (Power Outage).</source>
-        <translation type="unfinished"></translation>
-    </message>
-    <message>
-        <location filename="../common/plugins/nhs_driver/nhs_driver.cpp" line="196"/>
-        <source>Warning: Input Problem/Network Error.</source>
-        <translation type="unfinished"></translation>
-    </message>
-    <message>
-        <location filename="../common/plugins/nhs_driver/nhs_driver.cpp" line="201"/>
-        <source>Battery is Actively Charging.</source>
-        <translation type="unfinished"></translation>
-    </message>
-    <message>
-        <location filename="../common/plugins/nhs_driver/nhs_driver.cpp" line="206"/>
-        <source>Online (AC OK, Battery Full/Trickle Charging).</source>
-        <translation type="unfinished"></translation>
-    </message>
-    <message>
-        <location filename="../common/plugins/nhs_driver/nhs_driver.cpp" line="273"/>
-        <source>Connected, waiting for data...</source>
-        <translation type="unfinished"></translation>
-    </message>
     <message>
         <location filename="../common/plugins/nhs_driver/nhs_driver.cpp" line="377"/>
         <source>Handshake failed: No S-record received after %1 attempts.</source>
         <translation type="unfinished"></translation>
     </message>
-    <message>
-        <location filename="../common/plugins/nhs_driver/nhs_driver.cpp" line="435"/>
-        <source>USB Connection lost (Recovering...)</source>
-        <translation type="unfinished"></translation>
-    </message>
 </context>
 <context>
     <name>SystemTrayApp</name>
@@ -197,19 +162,6 @@ Battery: %2 V</source>
         <translation type="unfinished"></translation>
     </message>
 </context>
-<context>
-    <name>Template_driver</name>
-    <message>
-        <location filename="../common/plugins/template_driver/template_driver.cpp" line="28"/>
-        <source>Initializing...</source>
-        <translation type="unfinished"></translation>
-    </message>
-    <message>
-        <location filename="../common/plugins/template_driver/template_driver.cpp" line="75"/>
-        <source>Template Mode: System OK</source>
-        <translation type="unfinished"></translation>
-    </message>
-</context>
 <context>
     <name>UpsMonitorCore</name>
     <message>
@@ -253,6 +205,59 @@ Battery: %2 V</source>
         <translation type="unfinished"></translation>
     </message>
 </context>
+<context>
+    <name>UpsStatus</name>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="33"/>
+        <source>Initializing...</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="34"/>
+        <source>Connected, waiting for data...</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="35"/>
+        <source>No active connection</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="36"/>
+        <source>USB Connection lost (Recovering...)</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="37"/>
+        <source>Online (AC OK, Battery Full/Trickle Charging).</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="38"/>
+        <source>Battery is Actively Charging.</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="39"/>
+        <source>Warning: Input Problem/Network Error.</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="40"/>
+        <source>On Battery (Power Outage).</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="41"/>
+        <source>CRITICAL: Battery Low. Shutdown required.</source>
+        <translation type="unfinished"></translation>
+    </message>
+    <message>
+        <location filename="../common/include/ups_status_text.h" line="42"/>
+        <source>Template Mode: System OK</source>
+        <translation type="unfinished"></translation>
+    </message>
+</context>
 <context>
     <name>UpsStatusWindow</name>
     <message>
@@ -403,11 +408,6 @@ Battery: %2 V</source>
         <source>Invalid Interface</source>
         <translation type="unfinished"></translation>
     </message>
-    <message>
-        <location filename="../common/lightups_api/lightups_api.cpp" line="196"/>
-        <source>No active connection</source>
-        <translation type="unfinished"></translation>
-    </message>
 </context>
 <context>
     <name>WindowsService</name>
@@ -86,6 +86,7 @@ int main(int argc, char *argv[])
     }
     QCoreApplication::setOrganizationName(AppConstants::APP_ORGANIZATION_NAME);
     QCoreApplication::setApplicationName(AppConstants::APP_APPLICATION_NAME);
+    AppConstants::initSettingsBackend();
     QCoreApplication::addLibraryPath(QCoreApplication::applicationDirPath());
 
     SystemTrayApp trayApp(&a); // Create an instance of our structured application
@@ -23,7 +23,6 @@
 #include <QWidget>
 #include <QGuiApplication>
 #include <QScreen>
-#include <QPluginLoader>
 #include <QDir>
 #include <QMessageBox>
 #include <QSerialPortInfo>
@@ -32,9 +31,12 @@
 #include <QJsonValue>
 #include <QTimer>
 #include <QDataStream>
+#include <QtEndian>
 #include "constants.h"
 #include "ipc_constants.h"
 #include "ups_report.h"
+#include "ups_status_text.h"
+#include "config_store.h"
 
 SystemTrayApp::SystemTrayApp(QApplication *app, QObject *parent)
     // ==========================================================
@@ -63,7 +65,13 @@ SystemTrayApp::SystemTrayApp(QApplication *app, QObject *parent)
     m_lastReport = UpsReport(); // Initialize the last report
     createTrayIcon();
     createTrayMenu();
+    // The shared index spares us opening every plugin; a plugin added or replaced later shows up by itself
+    m_pluginIndex = new PluginIndex(PluginIndex::defaultPluginDir(), QString(), this);
+    connect(m_pluginIndex, &PluginIndex::changed, this, &SystemTrayApp::loadAvailableDriversMetadata);
+    m_pluginIndex->setWatching(true);
     loadAvailableDriversMetadata();
+    // The service writes the settings; the status window reads them from the store's snapshot
+    ConfigStore::instance().startWatching();
     m_statusWindow = new UpsStatusWindow();
     m_statusWindow->hide();
 
@@ -138,7 +146,10 @@ void SystemTrayApp::socketConnected()
 {
     qDebug() << "SystemTrayApp: Connection to IPC server SUCCESSFUL.";
     m_reconnectTimer->stop();
-    m_nextBlockSize = 0; // Reset the buffer size
+    m_receiveBuffer.clear();
+    m_wireDecoder = IpcWire::Decoder();
+    // Ask for the binary report format; an older service ignores this and keeps sending QDataStream frames
+    sendCommand({ { "COMMAND", "HELLO" }, { "FRAMES", "binary" } });
     if (m_trayIcon && m_trayIcon->isVisible()) {
         m_trayIcon->showMessage(
             tr("Connection Restored"),
@@ -155,7 +166,7 @@ void SystemTrayApp::socketConnected()
 void SystemTrayApp::socketDisconnected()
 {
     qDebug() << "SystemTrayApp: Connection to IPC server lost. Retrying in 5 seconds...";
-    m_nextBlockSize = 0;
+    m_receiveBuffer.clear();
 
     // 1. Reset the Service Status (Communication error)
     m_lastReport.serviceStatus.dataCommunicationActive = false;
@@ -180,37 +191,80 @@ void SystemTrayApp::socketDisconnected()
 
 void SystemTrayApp::socketReadyRead()
 {
-    QDataStream in(m_localSocket);
-    in.setVersion(QDataStream::Qt_6_0);
-
-    for (;;) {
-        // 1. Read the block size (if not already done)
-        if (m_nextBlockSize == 0) {
-            if (m_localSocket->bytesAvailable() < (qint64)sizeof(quint32))
-                break;
+    m_receiveBuffer.append(m_localSocket->readAll());
+    qsizetype offset = 0;
+    {
+        // Shared: stays valid whatever the report handlers do (a disconnect clears m_receiveBuffer).
+        // Scoped, so the reference is dropped again before remove() below, which then works in place
+        // instead of detaching a deep copy of the unparsed bytes.
+        const QByteArray buffer = m_receiveBuffer;
+        const char *data = buffer.constData();
+        const qsizetype size = buffer.size();
+
+        while (size - offset >= (qsizetype)sizeof(quint32)) {
+            // 1. Binary messages (services that accepted our HELLO)
+            if (IpcWire::Decoder::isMessage(data + offset, size - offset)) {
+                qsizetype consumed = 0;
+                IpcWire::Header header;
+                UpsReport report;
+                const IpcWire::Decoder::Result result = m_wireDecoder.decode(data + offset, size - offset, consumed, header, report);
+                if (result == IpcWire::Decoder::Result::Incomplete) break;
+                if (result == IpcWire::Decoder::Result::Invalid) {
+                    qDebug() << "SystemTrayApp: Unsupported IPC message (version" << header.version << "); data dropped.";
+                    offset = size;
+                    break;
+                }
+                offset += consumed;
+                if (result == IpcWire::Decoder::Result::Report) {
+                    handleUpsReport(report);
+                }
+                continue;
+            }
 
-            in >> m_nextBlockSize;
+            // 2. QDataStream frames: block size, then the report (older services, and until our HELLO is handled)
+            const quint32 blockSize = qFromBigEndian<quint32>(data + offset);
+            if (size - offset - (qsizetype)sizeof(quint32) < (qsizetype)blockSize)
+                break; // Wait until the entire block is received
+
+            // Parse the block on its own so fields added by newer services are skipped
+            QDataStream blockIn(QByteArray::fromRawData(data + offset + sizeof(quint32), blockSize));
+            blockIn.setVersion(QDataStream::Qt_6_0);
+            offset += sizeof(quint32) + blockSize;
+            UpsReport report;
+            // The operator>>(QDataStream&, UpsReport&) reads the data into the struct
+            blockIn >> report;
+
+            // Check if reading succeeded
+            if (blockIn.status() == QDataStream::Ok) {
+                handleUpsReport(report); // Process the received report
+            } else {
+                qDebug() << "SystemTrayApp: QDataStream error while reading the report.";
+            }
         }
+    }
+    if (m_receiveBuffer.size() >= offset) {
+        m_receiveBuffer.remove(0, offset);
+    }
+}
 
-        // 2. Wait until the entire block is received
-        if (m_localSocket->bytesAvailable() < m_nextBlockSize)
-            break;
+bool SystemTrayApp::sendCommand(const QMap<QString, QString> &command)
+{
+    if (!m_localSocket || m_localSocket->state() != QLocalSocket::ConnectedState) return false;
 
-        // 3. Read the data
-        UpsReport report;
-        // The operator>>(QDataStream&, UpsReport&) reads the data into the struct
-        in >> report;
+    QByteArray payload;
+    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
+    payloadStream.setVersion(QDataStream::Qt_6_0);
+    payloadStream << command;
 
-        // Check if reading succeeded
-        if (in.status() == QDataStream::Ok) {
-            handleUpsReport(report); // Process the received report
-            m_nextBlockSize = 0; // Reset for the next block
-        } else {
-            qDebug() << "SystemTrayApp: QDataStream error while reading the report.";
-            m_nextBlockSize = 0;
-            break;
-        }
-    }
+    // Size + Payload, like every command the service reads
+    QByteArray finalBlock;
+    QDataStream out(&finalBlock, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << (quint32)payload.size();
+    finalBlock.append(payload);
+    m_localSocket->write(finalBlock);
+    m_localSocket->flush();
+    return true;
 }
 
 void SystemTrayApp::socketError(QLocalSocket::LocalSocketError socketError)
@@ -288,6 +342,11 @@ void SystemTrayApp::trayIconActivated(QSystemTrayIcon::ActivationReason reason)
  */
 void SystemTrayApp::handleUpsReport(const UpsReport &report)
 {
+    // The tray follows the primary UPS; additional units are monitored by the service only
+    if (!report.deviceId.isEmpty() && report.deviceId != AppConstants::PRIMARY_DEVICE_ID) {
+        return;
+    }
+
     // Check if we are switching from AC power to battery
     if (m_lastReport.data.state != UpsMonitor::UpsState::OnBattery &&
         report.data.state == UpsMonitor::UpsState::OnBattery) {
@@ -396,18 +455,15 @@ void SystemTrayApp::createTrayMenu()
 void SystemTrayApp::loadAvailableDriversMetadata()
 {
     m_driverMetadata.clear();
-    // Search in the plugins folder
-    QDir pluginsDir(QCoreApplication::applicationDirPath() + "/common/plugins");
-    for (const QString &fileName : pluginsDir.entryList(QDir::Files)) {
-        QPluginLoader loader(pluginsDir.absoluteFilePath(fileName));
-        QJsonObject metaData = loader.metaData();
-        if (!metaData.isEmpty() && metaData.contains("MetaData")) {
-            QJsonObject pluginContent = metaData["MetaData"].toObject();
-            if (pluginContent.contains("displayName")) {
-                // Save the filename so we know which .dll to load
-                pluginContent["driverFileName"] = fileName;
-                m_driverMetadata.insert(fileName, pluginContent);
-            }
+    // Search in the plugins folder (through the index: only new or changed files are opened)
+    m_pluginIndex->refresh();
+    const QList<PluginIndex::Entry> plugins = m_pluginIndex->plugins();
+    for (const PluginIndex::Entry &plugin : plugins) {
+        QJsonObject pluginContent = plugin.pluginMetaData();
+        if (pluginContent.contains("displayName")) {
+            // Save the filename so we know which .dll to load
+            pluginContent["driverFileName"] = plugin.fileName;
+            m_driverMetadata.insert(plugin.fileName, pluginContent);
         }
     }
 }
@@ -419,33 +475,13 @@ void SystemTrayApp::loadAvailableDriversMetadata()
  */
 void SystemTrayApp::notifyService(const QString &key, const QString &value)
 {
-    // 1. Safety check on the socket
-    if (!m_localSocket || m_localSocket->state() != QLocalSocket::ConnectedState) {
-        qDebug() << "SystemTrayApp: Cannot send config: IPC not connected.";
-        return;
-    }
-
-    // 2. Create the payload (the actual data)
-    QByteArray payload;
-    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
-    payloadStream.setVersion(QDataStream::Qt_6_0); // Or 5_15, as long as the service version is the same
     QMap<QString, QString> command;
     command.insert("COMMAND", "CONFIG_UPDATE");
     command.insert(key, value);
-    payloadStream << command;
-
-    // 3. Create the final packet (Size + Payload)
-    QByteArray finalBlock;
-    QDataStream out(&finalBlock, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_0);
-
-    // payload size, then the payload itself
-    out << (quint32)payload.size();
-    finalBlock.append(payload);
-
-    // 4. Send
-    m_localSocket->write(finalBlock);
-    m_localSocket->flush();
+    if (!sendCommand(command)) {
+        qDebug() << "SystemTrayApp: Cannot send config: IPC not connected.";
+        return;
+    }
     qDebug() << "SystemTrayApp: Config-update sent via IPC:" << key << "=" << value;
 }
 
@@ -524,9 +560,9 @@ void SystemTrayApp::updateTrayIconTooltip()
     }
 
     // 0. CHECK B: WAITING FOR INITIAL DATA
-    // If we are connected or connecting, but the timestamp is invalid (default status).
+    // If we are connected or connecting, but no report has been stamped yet (default status).
     if (m_localSocket->state() == QLocalSocket::ConnectingState ||
-        !m_lastReport.data.timestamp.isValid())
+        m_lastReport.data.timestampNs == 0)
     {
         m_trayIcon->setToolTip(tr("UPS Monitor: Connecting or waiting for initial data..."));
         return;
@@ -552,76 +588,63 @@ void SystemTrayApp::updateTrayIconTooltip()
     else if (data.state == UpsState::BatteryCritical) {
         // This is the critical status based on the flag (Bit 1)
         tooltip = tr("🔴 CRITICAL ERROR: Battery Low\nShutdown Required!\nBattery Voltage: %1 V")
-                      .arg(data.batteryVoltage, 0, 'f', 1);
+                      .arg(data.batteryVoltage(), 0, 'f', 1);
     }
     // 3. UPS Running on Battery (OnBattery)
     else if (data.state == UpsState::OnBattery) {
         // Notification, voltage and charge
         tooltip = QString(tr("🔋 Power Loss Detected!\nBattery Voltage: %1 V\nRemaining Charge: %2 %%"))
-                      .arg(data.batteryVoltage, 0, 'f', 1)
-                      .arg(data.batteryLevel, 0, 'f', 1);
+                      .arg(data.batteryVoltage(), 0, 'f', 1)
+                      .arg(data.batteryLevel(), 0, 'f', 1);
+        if (data.runtimeRemainingSeconds >= 0) {
+            tooltip += tr("\nEstimated Runtime: %1 min %2 s")
+                           .arg(data.runtimeRemainingSeconds / 60)
+                           .arg(data.runtimeRemainingSeconds % 60, 2, 10, QLatin1Char('0'));
+        }
 
     }
     // 4. Online Warning (Frequency Not In Sync)
     else if (data.state == UpsState::OnlineFault) {
         // Specifically for Frequency Async issues
         tooltip = tr("⚠️ Warning: UPS Frequency not in sync with mains!\nInput: %1 V\nBattery: %2 V")
-                      .arg(data.inputVoltage, 0, 'f', 1)
-                      .arg(data.batteryVoltage, 0, 'f', 1);
+                      .arg(data.inputVoltage(), 0, 'f', 1)
+                      .arg(data.batteryVoltage(), 0, 'f', 1);
     }
     // 5. Battery is Charging
     else if (data.state == UpsState::OnlineCharging) {
         tooltip = QString(tr("✅ Battery Charging\nInput: %1 V\nBattery: %2 V"))
-                      .arg(data.inputVoltage, 0, 'f', 1)
-                      .arg(data.batteryVoltage, 0, 'f', 1);
+                      .arg(data.inputVoltage(), 0, 'f', 1)
+                      .arg(data.batteryVoltage(), 0, 'f', 1);
 
     }
     // 6. Online Normal
     else if (data.state == UpsState::OnlineFull) {
         tooltip = QString(tr("✅ On Main Power (Online)\nInput: %1 V\nBattery: %2 V"))
-                      .arg(data.inputVoltage, 0, 'f', 1)
-                      .arg(data.batteryVoltage, 0, 'f', 1);
+                      .arg(data.inputVoltage(), 0, 'f', 1)
+                      .arg(data.batteryVoltage(), 0, 'f', 1);
     }
     // 7. Other Statuses (Fallback)
     else {
         // Catches any other unknown statuses (such as an unknown Fault code)
         tooltip = QString(tr("☝ Status: %1\n(Voltage: %2 V)"))
-                      .arg(data.statusMessage)
-                      .arg(data.batteryVoltage, 0, 'f', 1);
+                      .arg(upsStatusText(data.statusCode))
+                      .arg(data.batteryVoltage(), 0, 'f', 1);
     }
     m_trayIcon->setToolTip(tooltip);
 }
 
 void SystemTrayApp::sendFullConfiguration(const QString &driver, const QString &port, int delay, bool powerSafe)
 {
-    if (!m_localSocket || m_localSocket->state() != QLocalSocket::ConnectedState) {
-        qDebug() << "SystemTrayApp: IPC not connected.";
-        return;
-    }
-
-    // 1. Create the payload with ALL data
-    QByteArray payload;
-    QDataStream payloadStream(&payload, QIODevice::WriteOnly);
-    payloadStream.setVersion(QDataStream::Qt_6_0);
+    // All settings in one CONFIG_UPDATE, so the service restarts the driver once
     QMap<QString, QString> command;
     command.insert("COMMAND", "CONFIG_UPDATE");
-    // We now add both settings to the same map
     command.insert(AppConstants::REG_KEY_SELECTED_DRIVER_FILE, driver);
     command.insert(AppConstants::REG_KEY_SELECTED_COM_PORT, port);
-    // NEW: Add the new settings to the IPC packet
     command.insert(AppConstants::REG_KEY_SHUTDOWN_DELAY, QString::number(delay));
     command.insert(AppConstants::REG_KEY_POWER_SAFE_ENABLED, powerSafe ? "true" : "false");
-    payloadStream << command;
-
-    // 2. Construct packet (Header with size + Payload)
-    QByteArray finalBlock;
-    QDataStream out(&finalBlock, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_0);
-    out << (quint32)payload.size();
-    finalBlock.append(payload);
-
-    // 3. Send
-    m_localSocket->write(finalBlock);
-    m_localSocket->flush();
+    if (!sendCommand(command)) {
+        qDebug() << "SystemTrayApp: IPC not connected.";
+        return;
+    }
     qDebug() << "SystemTrayApp: Full configuration sent:" << driver << "on" << port;
 }
@@ -37,6 +37,8 @@
 #include <QPointer>
 #include <QMessageBox>
 #include "upsstatuswindow.h"
+#include "plugin_index.h"
+#include "ipc_wire.h"
 
 class SystemTrayApp : public QObject
 {
@@ -64,9 +66,11 @@ private:
     UpsIconManager *m_iconManager = nullptr;
     QLocalSocket *m_localSocket = nullptr;
     QTimer *m_reconnectTimer = nullptr;
-    quint32 m_nextBlockSize = 0;
+    QByteArray m_receiveBuffer;             // Bytes from the service not parsed yet
+    IpcWire::Decoder m_wireDecoder;         // Device strings of the current connection
     UpsStatusWindow *m_statusWindow = nullptr;
     QHash<QString, QJsonObject> m_driverMetadata;
+    PluginIndex *m_pluginIndex = nullptr;   // Watches the plugin directory
     UpsReport m_lastReport;
     UpsMonitor::UpsState determineRequiredIconStatus() const;
     void updateTrayIconStatus();
@@ -75,6 +79,7 @@ private:
     void createTrayMenu();
     void loadAvailableDriversMetadata();
     void notifyService(const QString &key, const QString &value);
+    bool sendCommand(const QMap<QString, QString> &command);
     void sendFullConfiguration(const QString &driver, const QString &port, int delay, bool powerSafe);
 };
 
@@ -19,7 +19,8 @@
 #include "upsstatuswindow.h"
 #include "ui_upsstatuswindow.h"
 #include "constants.h"
-#include <QSettings>
+#include "ups_status_text.h"
+#include "config_store.h"
 #include <QDateTime>
 #include <QMetaEnum>
 #include <QScrollBar>
@@ -54,21 +55,14 @@ void UpsStatusWindow::closeEvent(QCloseEvent *event) {
 }
 
 void UpsStatusWindow::loadSettings() {
-    // Open the registry where the service writes the settings
-    QSettings settings(AppConstants::SETTINGS_SCOPE,
-                       AppConstants::APP_ORGANIZATION_NAME,
-                       AppConstants::APP_APPLICATION_NAME);
+    // The settings the service writes, as of the latest change the watcher reported
+    const std::shared_ptr<const UpsConfig> config = ConfigStore::instance().snapshot();
 
-    // Load Shutdown Delay (default to 0 if not found)
-    int delay = settings.value(AppConstants::REG_KEY_SHUTDOWN_DELAY, 0).toInt();
-    ui->m_shutdownDelaySpinBox->setValue(delay);
+    ui->m_shutdownDelaySpinBox->setValue(config->shutdownDelaySeconds);
+    ui->m_powerSafeCheckBox->setChecked(config->powerSafeEnabled);
 
-    // Load Power Safe Mode (default to false if not found)
-    bool isEnabled = settings.value(AppConstants::REG_KEY_POWER_SAFE_ENABLED, false).toBool();
-    ui->m_powerSafeCheckBox->setChecked(isEnabled);
-
-    QString savedDriverFile = settings.value(AppConstants::REG_KEY_SELECTED_DRIVER_FILE).toString();
-    QString savedPort = settings.value(AppConstants::REG_KEY_SELECTED_COM_PORT).toString();
+    const QString& savedDriverFile = config->driverFileName;
+    const QString& savedPort = config->comPort;
 
     // Find the index based on the hidden data (the filename)
     int driverIndex = ui->m_driverComboBox->findData(savedDriverFile);
@@ -108,16 +102,18 @@ void UpsStatusWindow::updateReport(const UpsReport &report) {
     ui->m_statusLabel->setText(upsStateToString(data.state));
 
     // Update Voltages
-    ui->m_inputVoltageLabel->setText(QString::number(data.inputVoltage, 'f', 1) + " V");
-    ui->m_outputVoltageLabel->setText(QString::number(data.outputVoltage, 'f', 1) + " V");
-    ui->m_batteryVoltageLabel->setText(QString::number(data.batteryVoltage, 'f', 1) + " V");
+    ui->m_inputVoltageLabel->setText(QString::number(data.inputVoltage(), 'f', 1) + " V");
+    ui->m_outputVoltageLabel->setText(QString::number(data.outputVoltage(), 'f', 1) + " V");
+    ui->m_batteryVoltageLabel->setText(QString::number(data.batteryVoltage(), 'f', 1) + " V");
 
     // Service Status
     ui->m_activeDriverNameLabel->setText(service.activeDriverName.isEmpty() ? tr("None") : service.activeDriverName);
     ui->m_activeComPortLabel->setText(service.activeComPort.isEmpty() ? tr("N/A") : service.activeComPort);
-    if (!data.statusMessage.isEmpty()) {
-        QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss");
-        QString logEntry = QString("[%1] %2").arg(timestamp, data.statusMessage);
+    const QString statusText = upsStatusText(data.statusCode); // Translated here, not per sample
+    if (!statusText.isEmpty()) {
+        const QDateTime sampleTime = data.wallTime();
+        QString timestamp = (sampleTime.isValid() ? sampleTime : QDateTime::currentDateTime()).toString("hh:mm:ss");
+        QString logEntry = QString("[%1] %2").arg(timestamp, statusText);
 
         // Add text without rewriting the entire buffer
         ui->m_rawDataLog->appendPlainText(logEntry);
@@ -0,0 +1,269 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "async_logger.h"
+#include "ups_clock.h"
+#include "task_pool.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+const quint64 DRAIN_AFFINITY = TaskPool::affinityKey("AsyncLogger");
+}
+
+AsyncLogger& AsyncLogger::instance()
+{
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    stop();
+}
+
+void AsyncLogger::start()
+{
+    if (m_running.exchange(true)) return;
+    m_batch.reserve(64 * 1024);
+    qInstallMessageHandler(&AsyncLogger::messageHandler);
+}
+
+void AsyncLogger::stop()
+{
+    if (!m_running.exchange(false)) return;
+
+    // One last drain behind the queued ones: the affinity key keeps it the only consumer
+    scheduleDrain();
+    for (int pending = m_pendingDrains.load(); pending != 0; pending = m_pendingDrains.load()) {
+        m_pendingDrains.wait(pending);
+    }
+    // Messages from now on (e.g. static destructors) are written synchronously by messageHandler()
+}
+
+void AsyncLogger::messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg)
+{
+    AsyncLogger& logger = instance();
+    if (type == QtFatalMsg || !logger.m_running.load(std::memory_order_acquire)) {
+        // Qt aborts right after a fatal message: it must not wait in a queue
+        if (type != QtDebugMsg || logger.m_debugEnabled.load(std::memory_order_relaxed)) {
+            writeSync(type, msg);
+        }
+        return;
+    }
+    logger.log(type, context.category, msg);
+}
+
+void AsyncLogger::log(QtMsgType type, const char* categoryName, const QString& msg)
+{
+    // If debug mode is off, suppress debug messages
+    if (type == QtDebugMsg && !m_debugEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    const qint64 nowNs = UpsClock::nowNs();
+    const int category = categoryIndex(categoryName ? categoryName : "default");
+    if (type != QtCriticalMsg && !admit(m_categories[category], nowNs)) {
+        return;
+    }
+
+    Ring* ring = threadRing();
+    if (!ring) {
+        m_ringDrops.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const quint32 head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= RING_CAPACITY) {
+        m_ringDrops.fetch_add(1, std::memory_order_relaxed); // Writer is behind: never block the producer
+        return;
+    }
+
+    Record& record = ring->records[head & (RING_CAPACITY - 1)];
+    const int length = std::min<int>(msg.size(), TEXT_CAPACITY);
+    record.stampNs = nowNs;
+    record.length = static_cast<quint16>(length);
+    record.type = static_cast<quint8>(type);
+    record.category = static_cast<quint8>(category);
+    std::memcpy(record.text, msg.utf16(), length * sizeof(char16_t));
+    ring->head.store(head + 1, std::memory_order_release);
+
+    // Only the first record after the last drain started pays for a task (pairs with drain())
+    if (!m_signaled.exchange(true, std::memory_order_seq_cst)) {
+        scheduleDrain();
+    }
+}
+
+AsyncLogger::Ring* AsyncLogger::threadRing()
+{
+    thread_local Ring* t_ring = nullptr;
+    thread_local bool t_registered = false;
+    if (t_registered) return t_ring;
+
+    QMutexLocker locker(&m_ringsMutex);
+    t_registered = true;
+    const int count = m_ringCount.load(std::memory_order_relaxed);
+    if (count >= MAX_THREADS) return nullptr;
+
+    m_rings.push_back(std::make_unique<Ring>());
+    t_ring = m_rings.back().get();
+    m_ringTable[count] = t_ring;
+    m_ringCount.store(count + 1, std::memory_order_release);
+    return t_ring;
+}
+
+int AsyncLogger::categoryIndex(const char* name)
+{
+    // Fast path: pointer comparison against the categories seen so far
+    const int count = m_categoryCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        if (m_categories[i].name.load(std::memory_order_relaxed) == name) return i;
+    }
+
+    // Same category name from another module (inline categories live once per binary)
+    QMutexLocker locker(&m_categoriesMutex);
+    const int current = m_categoryCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < current; ++i) {
+        if (std::strcmp(m_categories[i].name.load(std::memory_order_relaxed), name) == 0) return i;
+    }
+    if (current >= MAX_CATEGORIES) return MAX_CATEGORIES - 1; // Shares the last budget
+
+    m_categories[current].name.store(name, std::memory_order_relaxed);
+    m_categoryCount.store(current + 1, std::memory_order_release);
+    return current;
+}
+
+bool AsyncLogger::admit(Category& category, qint64 nowNs)
+{
+    const int limit = m_rateLimit.load(std::memory_order_relaxed);
+    if (limit <= 0) return true;
+
+    // Fixed one-second windows; a racing reset at a window edge only lets a few extra messages through
+    const qint64 second = nowNs / 1000000000;
+    qint64 window = category.windowSecond.load(std::memory_order_relaxed);
+    if (window != second && category.windowSecond.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+        category.windowCount.store(0, std::memory_order_relaxed);
+    }
+
+    if (category.windowCount.fetch_add(1, std::memory_order_relaxed) < static_cast<quint32>(limit)) {
+        return true;
+    }
+    category.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void AsyncLogger::scheduleDrain()
+{
+    m_pendingDrains.fetch_add(1, std::memory_order_relaxed);
+    TaskPool::global().submit(DRAIN_AFFINITY, [this]() {
+        drain();
+        if (m_pendingDrains.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_pendingDrains.notify_all();
+        }
+    });
+}
+
+void AsyncLogger::drain()
+{
+    // Records pushed after this point queue another drain, so none is left behind. A plain store
+    // could be reordered after the ring scan below (store-load): a producer would then still see
+    // the flag set and skip scheduling while this drain misses its record. As a seq_cst
+    // read-modify-write, the reset is ordered with the producer's exchange in log(): either the
+    // producer sees false and queues a drain, or its head store is visible to the scan.
+    m_signaled.exchange(false, std::memory_order_seq_cst);
+    while (drainOnce(m_batch)) {
+        appendSuppressed(m_batch);
+        std::fwrite(m_batch.constData(), 1, m_batch.size(), stderr);
+        std::fflush(stderr);
+        m_batch.resize(0); // Keeps the capacity for the next batch
+    }
+}
+
+bool AsyncLogger::drainOnce(QByteArray& batch)
+{
+    bool any = false;
+    const int count = m_ringCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        Ring* ring = m_ringTable[i];
+        quint32 tail = ring->tail.load(std::memory_order_relaxed);
+        const quint32 head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            appendRecord(batch, ring->records[tail & (RING_CAPACITY - 1)]);
+            any = true;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+    }
+    return any;
+}
+
+void AsyncLogger::appendRecord(QByteArray& batch, const Record& record)
+{
+    appendLine(batch, record.stampNs, static_cast<QtMsgType>(record.type),
+               QStringView(record.text, record.length));
+}
+
+void AsyncLogger::appendSuppressed(QByteArray& batch)
+{
+    const qint64 nowNs = UpsClock::nowNs();
+    const int count = m_categoryCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        const quint64 suppressed = m_categories[i].suppressed.exchange(0, std::memory_order_relaxed);
+        if (suppressed > 0) {
+            const QString text = QString("%1 messages suppressed in category '%2' (rate limit)")
+                                     .arg(suppressed).arg(QString::fromLatin1(m_categories[i].name.load(std::memory_order_relaxed)));
+            appendLine(batch, nowNs, QtWarningMsg, text);
+        }
+    }
+
+    const quint64 drops = m_ringDrops.load(std::memory_order_relaxed);
+    if (drops != m_reportedRingDrops) {
+        appendLine(batch, nowNs, QtWarningMsg, QString("%1 messages dropped (log queue full)").arg(drops - m_reportedRingDrops));
+        m_reportedRingDrops = drops;
+    }
+}
+
+void AsyncLogger::appendLine(QByteArray& batch, qint64 stampNs, QtMsgType type, QStringView text)
+{
+    const char* typeStr = "INFO ";
+    switch (type) {
+    case QtDebugMsg:    typeStr = "DEBUG"; break;
+    case QtWarningMsg:  typeStr = "WARN "; break;
+    case QtCriticalMsg: typeStr = "ERROR"; break;
+    case QtFatalMsg:    typeStr = "FATAL"; break;
+    default:            typeStr = "INFO "; break;
+    }
+
+    batch += '[';
+    batch += UpsClock::toDateTime(stampNs).toString("yyyy-MM-dd hh:mm:ss.zzz").toLatin1();
+    batch += "] ";
+    batch += typeStr;
+    batch += ": ";
+    batch += text.toLocal8Bit();
+    batch += '\n';
+}
+
+void AsyncLogger::writeSync(QtMsgType type, const QString& msg)
+{
+    QByteArray line;
+    appendLine(line, UpsClock::nowNs(), type, msg);
+    std::fwrite(line.constData(), 1, line.size(), stderr);
+    std::fflush(stderr);
+}
@@ -0,0 +1,137 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QMutex>
+#include <QByteArray>
+#include <atomic>
+#include <vector>
+#include <memory>
+
+/**
+ * @brief Asynchronous Qt message handler for the service.
+ *
+ * Logging threads (main, reactors, pool workers) only copy the message into a fixed-size binary
+ * record and push it into their own single-producer/single-consumer ring: no formatting, no locale
+ * conversion and no I/O. The first record after an idle period queues a drain task on the shared
+ * TaskPool, which formats everything the rings hold and writes it to stderr in one batch. The drain
+ * tasks share an affinity key, so there is still exactly one consumer at a time.
+ *
+ * Each logging category gets a per-second message budget; what exceeds it is dropped and reported
+ * as a summary line, so enabling debug categories in production cannot flood the writer.
+ * A full ring also drops (and counts) instead of blocking the producer.
+ */
+class AsyncLogger
+{
+public:
+    static constexpr int TEXT_CAPACITY = 250;        // UTF-16 code units per record (longer messages are truncated)
+    static constexpr int RING_CAPACITY = 256;        // Records per thread; must be a power of 2
+    static constexpr int MAX_CATEGORIES = 32;
+    static constexpr int MAX_THREADS = 128;          // Threads beyond this drop their messages
+    static constexpr int DEFAULT_RATE_LIMIT = 200;   // Messages per second per category
+
+    static AsyncLogger& instance();
+
+    /**
+     * @brief Installs the Qt message handler.
+     */
+    void start();
+
+    /**
+     * @brief Writes everything still queued; later messages are written synchronously. Safe to call twice.
+     */
+    void stop();
+
+    void setDebugEnabled(bool enabled) { m_debugEnabled.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * @brief Messages per second per category (0 = unlimited).
+     */
+    void setRateLimit(int messagesPerSecond) { m_rateLimit.store(messagesPerSecond, std::memory_order_relaxed); }
+
+    quint64 droppedCount() const { return m_ringDrops.load(std::memory_order_relaxed); }
+
+    static void messageHandler(QtMsgType type, const QMessageLogContext& context, const QString& msg);
+
+private:
+    struct Record {
+        qint64 stampNs;                // UpsClock stamp; converted to wall time by the drain task
+        quint16 length;
+        quint8 type;
+        quint8 category;
+        char16_t text[TEXT_CAPACITY];
+    };
+    static_assert(sizeof(Record) == 512, "Record layout changed; keep it compact");
+
+    /**
+     * @brief SPSC ring owned by one producer thread; the drain task is the only consumer.
+     */
+    struct alignas(64) Ring {
+        alignas(64) std::atomic<quint32> head{0};   // Written by the producer
+        alignas(64) std::atomic<quint32> tail{0};   // Written by the consumer
+        Record records[RING_CAPACITY];
+    };
+
+    struct alignas(64) Category {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<qint64> windowSecond{0};
+        std::atomic<quint32> windowCount{0};
+        std::atomic<quint64> suppressed{0};
+    };
+
+    AsyncLogger() = default;
+    ~AsyncLogger();
+
+    void log(QtMsgType type, const char* category, const QString& msg);
+    Ring* threadRing();
+    int categoryIndex(const char* name);
+    bool admit(Category& category, qint64 nowNs);
+    void scheduleDrain();
+    void drain();
+    bool drainOnce(QByteArray& batch);
+    void appendRecord(QByteArray& batch, const Record& record);
+    void appendSuppressed(QByteArray& batch);
+    static void appendLine(QByteArray& batch, qint64 stampNs, QtMsgType type, QStringView text);
+    static void writeSync(QtMsgType type, const QString& msg);
+
+    std::atomic<bool> m_debugEnabled{false};
+    std::atomic<int> m_rateLimit{DEFAULT_RATE_LIMIT};
+    std::atomic<quint64> m_ringDrops{0};
+    quint64 m_reportedRingDrops = 0;     // Drain task only
+
+    // Rings are never freed while the logger lives: a record may outlive its producer thread
+    QMutex m_ringsMutex;                 // Only taken when a thread logs for the first time
+    std::vector<std::unique_ptr<Ring>> m_rings;
+    std::atomic<int> m_ringCount{0};
+    Ring* m_ringTable[MAX_THREADS] = {};  // Lock-free view for the drain task
+
+    QMutex m_categoriesMutex;            // Only taken when a category logs for the first time
+    Category m_categories[MAX_CATEGORIES];
+    std::atomic<int> m_categoryCount{0};
+
+    QByteArray m_batch;                  // Drain task only
+    std::atomic<int> m_pendingDrains{0};
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_signaled{false};  // A drain is queued that has not started reading yet
+};
+
+#endif // ASYNC_LOGGER_H
@@ -0,0 +1,435 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "history_file.h"
+#include "ups_clock.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace HistoryFileFormat;
+
+namespace {
+constexpr qint64 RECORD_SIZE = sizeof(HistoryFile::Record);
+constexpr qint64 STATE_SCAN_LIMIT = 16384;  // Records read back on open to find each device's last state
+
+qint64 fileSizeFor(qint64 capacity)
+{
+    return HEADER_SIZE + capacity * RECORD_SIZE;
+}
+
+bool isBlank(const HistoryFile::Record& record)
+{
+    static const HistoryFile::Record zero{};
+    return std::memcmp(&record, &zero, sizeof(zero)) == 0;
+}
+}
+
+HistoryFile::~HistoryFile()
+{
+    close();
+}
+
+bool HistoryFile::open(const QString& path, bool readOnly)
+{
+    close();
+    m_readOnly = readOnly;
+    m_error.clear();
+    m_file.setFileName(path);
+
+    if (!readOnly) {
+        QDir().mkpath(QFileInfo(path).absolutePath());
+    }
+    if (!m_file.open(readOnly ? QIODevice::ReadOnly : QIODevice::ReadWrite)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    if (size == 0 && !readOnly) {
+        // New file: preallocate the first block; the fresh pages read as zero (blank records)
+        if (!m_file.resize(fileSizeFor(GROW_RECORDS)) || !map(GROW_RECORDS)) {
+            m_error = m_error.isEmpty() ? m_file.errorString() : m_error;
+            close();
+            return false;
+        }
+        Header* h = header();
+        std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+        h->version = VERSION;
+        h->recordSize = RECORD_SIZE;
+        h->committed = 0;
+        h->segmentStart = 0;
+        flush(0, sizeof(Header));
+    } else {
+        if (size < HEADER_SIZE || !map((size - HEADER_SIZE) / RECORD_SIZE)) {
+            m_error = m_error.isEmpty() ? QStringLiteral("Not a LightUps history file") : m_error;
+            close();
+            return false;
+        }
+        const Header* h = header();
+        if (std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) != 0 || h->version != VERSION || h->recordSize != RECORD_SIZE) {
+            m_error = QStringLiteral("Not a LightUps history file (or an unsupported version)");
+            close();
+            return false;
+        }
+    }
+
+    recover();
+    return true;
+}
+
+void HistoryFile::close()
+{
+    if (m_map) {
+        waitForFlushes();
+        if (!m_readOnly) {
+            commit(unsyncedFrom(), m_count);
+        }
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_capacity = 0;
+    m_count = 0;
+    m_synced = 0;
+    m_recoveredTail = 0;
+    m_segmentStart = 0;
+    m_deviceIndex.clear();
+}
+
+bool HistoryFile::map(qint64 capacity)
+{
+    m_map = m_file.map(0, fileSizeFor(capacity));
+    if (!m_map) {
+        m_error = m_file.errorString();
+        m_capacity = 0;
+        return false;
+    }
+    m_capacity = capacity;
+    return true;
+}
+
+bool HistoryFile::grow()
+{
+    // The mapping cannot outgrow the file: unmap, extend, map again
+    waitForFlushes();
+    const qint64 capacity = m_capacity;
+    m_file.unmap(m_map);
+    m_map = nullptr;
+    if (!m_file.resize(fileSizeFor(capacity + GROW_RECORDS))) {
+        m_error = m_file.errorString(); // e.g. disk full: keep what we have
+        map(capacity);
+        return false;
+    }
+    return map(capacity + GROW_RECORDS) || map(capacity);
+}
+
+void HistoryFile::recover()
+{
+    const Record* all = records();
+
+    // The committed count is only written after its records were flushed, so its last record must be valid
+    qint64 count = std::min<qint64>(header()->committed, m_capacity);
+    if (count > 0 && !isValid(all[count - 1], count - 1)) {
+        qWarning() << "HistoryFile: Committed record count is not trustworthy; scanning" << m_file.fileName();
+        count = 0;
+    }
+    const qint64 committed = count;
+
+    // The header page may have been written back before the record that starts its segment
+    m_segmentStart = static_cast<qint64>(header()->segmentStart);
+    if (m_segmentStart > 0
+        && (m_segmentStart >= committed || all[m_segmentStart].wallMs >= all[m_segmentStart - 1].wallMs)) {
+        m_segmentStart = std::max<qint64>(committed - 1, 0);
+        while (m_segmentStart > 0 && all[m_segmentStart].wallMs >= all[m_segmentStart - 1].wallMs) {
+            --m_segmentStart;
+        }
+    }
+
+    // Records written after the last sync() survive a crash of the service, not always a power cut
+    while (count < m_capacity && isValid(all[count], count)) {
+        if (count > 0 && all[count].wallMs < all[count - 1].wallMs) {
+            m_segmentStart = count;    // A clock step the header did not get to record
+        }
+        ++count;
+    }
+    m_count = count;
+    m_synced = committed;
+
+    // Blank the torn remains, or a stale record after them could later pass as the next one
+    qint64 tail = count;
+    while (tail < m_capacity && !isBlank(all[tail])) {
+        if (!m_readOnly) {
+            std::memset(&records()[tail], 0, RECORD_SIZE);
+        }
+        ++tail;
+    }
+    m_recoveredTail = tail - count;
+    if (m_recoveredTail > 0) {
+        qWarning() << "HistoryFile: Dropped" << m_recoveredTail << "incomplete record(s) at the end of" << m_file.fileName();
+    }
+
+    // The next record of each device is a transition if its state differs from the last one on file
+    m_lastState.fill(-1);
+    for (qint64 i = m_count - 1; i >= 0 && i >= m_count - STATE_SCAN_LIMIT; --i) {
+        const Record& record = all[i];
+        if (record.device < MAX_DEVICES && m_lastState[record.device] < 0) {
+            m_lastState[record.device] = record.state;
+        }
+    }
+
+    if (!m_readOnly) {
+        if (m_recoveredTail > 0) {
+            flush(HEADER_SIZE + m_count * RECORD_SIZE, m_recoveredTail * RECORD_SIZE);
+        }
+        sync();
+    }
+}
+
+bool HistoryFile::isValid(const Record& record, qint64 index)
+{
+    return record.sequence == static_cast<quint64>(index + 1)
+        && record.crc == crc32(&record, offsetof(Record, crc));
+}
+
+bool HistoryFile::append(const QString& deviceId, const UpsData& data)
+{
+    if (!m_map || m_readOnly) return false;
+
+    const int device = deviceIndex(deviceId);
+    if (device < 0) return false;
+    if (m_count == m_capacity && !grow()) return false;
+
+    // Build the record aside and copy it in one go: the CRC covers the final bytes
+    Record record{};
+    record.sequence = m_count + 1;
+    // UpsClock re-anchors when the system clock moves, so this follows the clock the user sees
+    record.wallMs = UpsClock::toMSecsSinceEpoch(UpsClock::stampOrNow(data.timestampNs));
+    bool clockStep = false;
+    if (m_count > m_segmentStart) {
+        const qint64 previousMs = at(m_count - 1).wallMs;
+        if (record.wallMs < previousMs - CLOCK_STEP_MS) {
+            clockStep = true;
+        } else {
+            record.wallMs = std::max(record.wallMs, previousMs); // Keep the segment sorted for lowerBound()
+        }
+    }
+    const std::array<qint32, UpsHistory::FIELD_COUNT> values = UpsHistory::fieldsOf(data);
+    std::copy(values.begin(), values.end(), record.fields);
+    record.device = static_cast<quint8>(device);
+    record.state = static_cast<quint8>(data.state);
+    record.statusCode = static_cast<quint8>(data.statusCode);
+    record.flags = data.flags;
+
+    const bool transition = m_lastState[device] != record.state;
+    record.kind = transition ? Transition : Sample;
+    m_lastState[device] = record.state;
+
+    record.crc = crc32(&record, offsetof(Record, crc));
+    std::memcpy(&records()[m_count], &record, sizeof(record));
+    if (clockStep) {
+        qWarning() << "HistoryFile: Wall clock stepped back" << (at(m_count - 1).wallMs - record.wallMs)
+                   << "ms; starting a new segment at record" << m_count;
+        m_segmentStart = m_count;
+        header()->segmentStart = m_count;
+    }
+    ++m_count;
+
+    if (transition || clockStep) {
+        sync();
+    }
+    return true;
+}
+
+bool HistoryFile::sync()
+{
+    if (!m_map || m_readOnly) return false;
+    const qint64 from = unsyncedFrom();
+    const qint64 to = m_count;
+    if (from == to) return true;
+
+    if (!m_executor) {
+        const bool ok = commit(from, to);
+        m_synced = ok ? to : from;
+        return ok;
+    }
+
+    m_synced = to;
+    m_flushesInFlight.fetch_add(1, std::memory_order_relaxed);
+    m_executor([this, from, to]() {
+        // An earlier flush failed: cover its records too, or the committed count would vouch for them
+        qint64 failed = m_failedFrom.load(std::memory_order_relaxed);
+        const qint64 start = failed >= 0 ? std::min(failed, from) : from;
+        if (commit(start, to)) {
+            m_failedFrom.compare_exchange_strong(failed, -1, std::memory_order_relaxed);
+        } else {
+            // The next sync() starts again from here
+            while ((failed < 0 || start < failed)
+                   && !m_failedFrom.compare_exchange_weak(failed, start, std::memory_order_relaxed)) {
+            }
+        }
+        if (m_flushesInFlight.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_flushesInFlight.notify_all();
+        }
+    });
+    return true;
+}
+
+void HistoryFile::setFlushExecutor(Executor executor)
+{
+    waitForFlushes();
+    m_executor = std::move(executor);
+}
+
+void HistoryFile::waitForFlushes()
+{
+    for (int inFlight = m_flushesInFlight.load(std::memory_order_acquire); inFlight != 0;
+         inFlight = m_flushesInFlight.load(std::memory_order_acquire)) {
+        m_flushesInFlight.wait(inFlight);
+    }
+}
+
+qint64 HistoryFile::unsyncedFrom()
+{
+    const qint64 failed = m_failedFrom.exchange(-1, std::memory_order_relaxed);
+    return failed >= 0 ? std::min(failed, m_synced) : m_synced;
+}
+
+bool HistoryFile::commit(qint64 from, qint64 to)
+{
+    if (from == to) return true;
+
+    // Records first, then the count that vouches for them
+    bool ok = flush(HEADER_SIZE + from * RECORD_SIZE, (to - from) * RECORD_SIZE);
+    header()->committed = to;
+    ok = flush(0, sizeof(Header)) && ok;
+    if (!ok) {
+        qWarning() << "HistoryFile: Flushing" << m_file.fileName() << "failed";
+    }
+    return ok;
+}
+
+bool HistoryFile::flush(qint64 offset, qint64 size)
+{
+    if (size <= 0) return true;
+#ifdef Q_OS_WIN
+    // FlushViewOfFile() only starts the write-back; FlushFileBuffers() waits for it
+    if (!FlushViewOfFile(m_map + offset, static_cast<SIZE_T>(size))) return false;
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(m_file.handle()))) != 0;
+#else
+    static const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    const qint64 aligned = offset - offset % pageSize;
+    return msync(m_map + aligned, static_cast<size_t>(size + offset - aligned), MS_SYNC) == 0;
+#endif
+}
+
+qint64 HistoryFile::lowerBound(qint64 wallMs) const
+{
+    const Record* all = records();
+    qint64 low = m_segmentStart;
+    qint64 high = m_count;
+    while (low < high) {
+        const qint64 middle = low + (high - low) / 2;
+        if (all[middle].wallMs < wallMs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int HistoryFile::deviceIndex(const QString& deviceId)
+{
+    const auto cached = m_deviceIndex.constFind(deviceId);
+    if (cached != m_deviceIndex.constEnd()) return cached.value();
+
+    QByteArray id = deviceId.toUtf8().left(DEVICE_ID_SIZE - 1);
+    Header* h = header();
+    for (int i = 0; i < MAX_DEVICES; ++i) {
+        DeviceEntry& entry = h->devices[i];
+        if (entry.id[0] == '\0') {
+            // Free entry: the device gets it for the lifetime of the file
+            std::memset(entry.id, 0, sizeof(entry.id));
+            std::memcpy(entry.id, id.constData(), id.size());
+            entry.crc = crc32(entry.id, sizeof(entry.id));
+            m_deviceIndex.insert(deviceId, i);
+            return i;
+        }
+        if (entry.crc == crc32(entry.id, sizeof(entry.id)) && qstrncmp(entry.id, id.constData(), sizeof(entry.id)) == 0) {
+            m_deviceIndex.insert(deviceId, i);
+            return i;
+        }
+    }
+    qWarning() << "HistoryFile: Device table full; not recording" << deviceId;
+    m_deviceIndex.insert(deviceId, -1);
+    return -1;
+}
+
+QString HistoryFile::deviceId(int device) const
+{
+    if (!m_map || device < 0 || device >= MAX_DEVICES) return QString();
+    const DeviceEntry& entry = header()->devices[device];
+    if (entry.id[0] == '\0' || entry.crc != crc32(entry.id, sizeof(entry.id))) return QString();
+    return QString::fromUtf8(entry.id, qstrnlen(entry.id, sizeof(entry.id)));
+}
+
+int HistoryFile::deviceCount() const
+{
+    int count = 0;
+    while (count < MAX_DEVICES && !deviceId(count).isEmpty()) {
+        ++count;
+    }
+    return count;
+}
+
+quint32 HistoryFile::crc32(const void* data, qsizetype size)
+{
+    // CRC-32 (IEEE 802.3, reflected), the one zlib and most tools compute
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    const quint8* bytes = static_cast<const quint8*>(data);
+    quint32 crc = 0xFFFFFFFFu;
+    for (qsizetype i = 0; i < size; ++i) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
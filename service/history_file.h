@@ -0,0 +1,190 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ups_history.h"
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <array>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Append-only, memory-mapped archive of the reports the service broadcasts.
+ *
+ * File layout (native byte order; the file is not meant to move between machines):
+ *   Header (4096 bytes): "LUPSHIS" + '\0', quint32 version, quint32 record size, quint64 committed
+ *                        record count (a hint, see below), quint32 reserved, then 32 device entries
+ *                        of 64 bytes (UTF-8 id, zero padded, with a CRC-32 of the id), then quint64
+ *                        index of the first record of the current segment (see below)
+ *   Records (56 bytes each, from offset 4096): see HistoryFile::Record
+ *
+ * Records are written into the mapping in place and each one ends in a CRC-32 over the rest, so a
+ * torn record is detected. open() trusts the committed count only after checking that record, then
+ * scans forward over the records written after the last sync(). Opening never reads more than the
+ * header and the tail, whatever the size of the file, and the mapping stays file-backed: the pages
+ * read are clean and the kernel can drop them at any time.
+ *
+ * Samples reach the disk at sync() (or whenever the kernel writes the pages back); state
+ * transitions are synced immediately, because an outage may end in a power cut. With a flush
+ * executor the flushes run there instead, so the caller never waits for the disk.
+ *
+ * Records carry the wall time of their sample. Within a segment it never decreases, so lowerBound()
+ * can bisect it; small reorderings (reports of different devices crossing, under CLOCK_STEP_MS) are
+ * evened out. When the system clock steps back further, the next record starts a new segment and
+ * keeps its real wall time. The segment start is synced immediately too.
+ * Not thread-safe: use it from the service's main thread.
+ */
+namespace HistoryFileFormat {
+constexpr char MAGIC[8] = { 'L', 'U', 'P', 'S', 'H', 'I', 'S', '\0' };
+constexpr quint32 VERSION = 1;
+constexpr qint64 HEADER_SIZE = 4096;
+constexpr int MAX_DEVICES = 32;
+constexpr int DEVICE_ID_SIZE = 60;
+constexpr qint64 GROW_RECORDS = 65536;     // The file grows in steps of ~3.5 MB
+constexpr qint64 CLOCK_STEP_MS = 2000;     // A larger step back of the wall time starts a new segment
+}
+
+class HistoryFile
+{
+public:
+    using Executor = std::function<void(std::function<void()>)>;
+
+    enum Kind : quint8 {
+        Sample = 0,
+        Transition = 1,     // First record of a device after its state changed
+    };
+
+    struct Record {
+        quint64 sequence;                           // Index + 1; 0 = never written
+        qint64 wallMs;                              // Milliseconds since the epoch; sorted within a segment
+        qint32 fields[UpsHistory::FIELD_COUNT];     // UpsHistory::Field order
+        quint8 device;                              // Index into the device table
+        quint8 kind;
+        quint8 state;                               // UpsMonitor::UpsState
+        quint8 statusCode;                          // UpsMonitor::StatusCode
+        quint8 flags;                               // UpsData::flags
+        quint8 reserved[3];
+        quint32 crc;                                // CRC-32 of all bytes before it
+    };
+    static_assert(sizeof(Record) == 56, "The record layout is part of the file format");
+
+    HistoryFile() = default;
+    ~HistoryFile();
+    HistoryFile(const HistoryFile&) = delete;
+    HistoryFile& operator=(const HistoryFile&) = delete;
+
+    /**
+     * @brief Opens or creates @p path and recovers the records written before a crash.
+     * Read-only opens validate the same way but never write (e.g. while the service has it open).
+     */
+    bool open(const QString& path, bool readOnly = false);
+    void close();
+    bool isOpen() const { return m_map != nullptr; }
+    QString errorString() const { return m_error; }
+
+    /**
+     * @brief Appends one report. Skipped (false) when the file is closed or read-only, or the device
+     * table is full.
+     */
+    bool append(const QString& deviceId, const UpsData& data);
+
+    /**
+     * @brief Flushes the written records and then the committed count to the disk.
+     * With a flush executor it only queues the flush (a failed one is retried by the next sync()).
+     */
+    bool sync();
+
+    /**
+     * @brief Runs the flushes of sync() on @p executor, which must run them one at a time and in
+     * order (e.g. TaskPool with an affinity key). An empty executor flushes on the caller's thread.
+     */
+    void setFlushExecutor(Executor executor);
+
+    /**
+     * @brief Waits for the queued flushes. close() and growing the file do this themselves.
+     */
+    void waitForFlushes();
+
+    qint64 count() const { return m_count; }
+    const Record& at(qint64 index) const { return records()[index]; }
+
+    /**
+     * @brief First record of the current segment with wallMs >= @p wallMs (count() if none).
+     * Records before segmentStart() were written before the system clock stepped back.
+     */
+    qint64 lowerBound(qint64 wallMs) const;
+    qint64 segmentStart() const { return m_segmentStart; }
+
+    QString deviceId(int device) const;
+    int deviceCount() const;
+
+    /**
+     * @brief Records dropped by the last open() because they were torn or never completed.
+     */
+    qint64 recoveredTail() const { return m_recoveredTail; }
+
+    static quint32 crc32(const void* data, qsizetype size);
+
+private:
+    struct DeviceEntry {
+        char id[HistoryFileFormat::DEVICE_ID_SIZE];
+        quint32 crc;
+    };
+
+    struct Header {
+        char magic[8];
+        quint32 version;
+        quint32 recordSize;
+        quint64 committed;
+        quint32 reserved;
+        DeviceEntry devices[HistoryFileFormat::MAX_DEVICES];
+        quint64 segmentStart;       // Zero in files that never saw a clock step
+    };
+    static_assert(sizeof(Header) <= HistoryFileFormat::HEADER_SIZE, "The header must fit its page");
+
+    Header* header() const { return reinterpret_cast<Header*>(m_map); }
+    Record* records() const { return reinterpret_cast<Record*>(m_map + HistoryFileFormat::HEADER_SIZE); }
+    static bool isValid(const Record& record, qint64 index);
+
+    bool map(qint64 capacity);
+    bool grow();
+    void recover();
+    int deviceIndex(const QString& deviceId);
+    bool flush(qint64 offset, qint64 size);
+    bool commit(qint64 from, qint64 to);
+    qint64 unsyncedFrom();
+
+    QFile m_file;
+    uchar* m_map = nullptr;
+    bool m_readOnly = false;
+    qint64 m_capacity = 0;          // Records that fit in the current mapping
+    qint64 m_count = 0;
+    qint64 m_synced = 0;            // Records on disk, or handed to the flush executor
+    qint64 m_recoveredTail = 0;
+    qint64 m_segmentStart = 0;      // First record of the current segment
+    std::array<qint16, HistoryFileFormat::MAX_DEVICES> m_lastState{};   // -1 = no record yet
+    QHash<QString, int> m_deviceIndex;
+    QString m_error;
+
+    Executor m_executor;
+    std::atomic<int> m_flushesInFlight{0};
+    std::atomic<qint64> m_failedFrom{-1};  // First record of a failed background flush (-1 = none)
+};
@@ -0,0 +1,242 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "history_store.h"
+#include "ups_clock.h"
+#include <algorithm>
+#include <limits>
+
+using UpsHistory::FIELD_COUNT;
+using UpsHistory::Tier;
+
+// ----------------------------------------------------
+// --- Ring ---
+// ----------------------------------------------------
+
+HistoryStore::Ring::Ring(int capacity, bool aggregated)
+    : m_capacity(std::max(1, capacity))
+{
+    startNs.resize(m_capacity);
+    samples.resize(m_capacity);
+    stateMask.resize(m_capacity);
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        mean[field].resize(m_capacity);
+        if (aggregated) {
+            min[field].resize(m_capacity);
+            max[field].resize(m_capacity);
+        }
+    }
+}
+
+int HistoryStore::Ring::push()
+{
+    const int index = m_head;
+    m_head = (m_head + 1) % m_capacity;
+    m_size = std::min(m_size + 1, m_capacity);
+    return index;
+}
+
+int HistoryStore::Ring::lowerBound(qint64 stampNs) const
+{
+    // Rows are appended in time order, so the ring is sorted from its oldest row on
+    int low = 0;
+    int high = m_size;
+    while (low < high) {
+        const int middle = (low + high) / 2;
+        if (startNs[slot(middle)] < stampNs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// ----------------------------------------------------
+// --- Bucket ---
+// ----------------------------------------------------
+
+void HistoryStore::Bucket::add(const Values& values, quint8 stateBit)
+{
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        min[field] = samples == 0 ? values[field] : std::min(min[field], values[field]);
+        max[field] = samples == 0 ? values[field] : std::max(max[field], values[field]);
+        sum[field] += values[field];
+    }
+    stateMask |= stateBit;
+    ++samples;
+}
+
+HistoryStore::Values HistoryStore::Bucket::mean() const
+{
+    Values result{};
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        result[field] = samples ? static_cast<qint32>(sum[field] / static_cast<qint64>(samples)) : 0;
+    }
+    return result;
+}
+
+// ----------------------------------------------------
+// --- HistoryStore ---
+// ----------------------------------------------------
+
+HistoryStore::Device::Device(const Capacity& capacity)
+    : raw(capacity.raw, false)
+    , minute(capacity.minute, true)
+    , hour(capacity.hour, true)
+{
+}
+
+HistoryStore::HistoryStore(const Capacity& capacity)
+    : m_capacity(capacity)
+{
+}
+
+HistoryStore::~HistoryStore() = default;
+
+void HistoryStore::record(const UpsReport& report)
+{
+    const UpsData& data = report.data;
+    if (!report.serviceStatus.dataCommunicationActive || data.state == UpsMonitor::UpsState::Unknown || data.timestampNs <= 0) {
+        return;
+    }
+
+    std::shared_ptr<Device>& device = m_devices[report.deviceId];
+    if (!device) {
+        device = std::make_shared<Device>(m_capacity);
+    }
+    if (data.timestampNs <= device->lastNs) {
+        return; // Out of order (e.g. a replaced driver): the rings must stay sorted
+    }
+    device->lastNs = data.timestampNs;
+
+    const Values values = UpsHistory::fieldsOf(data);
+    const quint8 stateBit = static_cast<quint8>(1u << static_cast<int>(data.state));
+
+    // Raw tier: one slot per column
+    Ring& raw = device->raw;
+    const int slot = raw.push();
+    raw.startNs[slot] = data.timestampNs;
+    raw.samples[slot] = 1;
+    raw.stateMask[slot] = stateBit;
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        raw.mean[field][slot] = values[field];
+    }
+
+    // Rollups: a sample in a new bucket closes the previous one
+    roll(device->minute, device->currentMinute, UpsHistory::bucketNs(Tier::Minute), data.timestampNs);
+    roll(device->hour, device->currentHour, UpsHistory::bucketNs(Tier::Hour), data.timestampNs);
+    device->currentMinute.add(values, stateBit);
+    device->currentHour.add(values, stateBit);
+}
+
+void HistoryStore::roll(Ring& ring, Bucket& bucket, qint64 bucketNs, qint64 stampNs)
+{
+    // Buckets start on wall-clock minutes and hours (UTC); the stamp of that wall time is the row start
+    const qint64 wallNs = stampNs + UpsClock::wallOffsetMs() * 1000000;
+    qint64 startNs = stampNs - wallNs % bucketNs;
+    if (startNs <= bucket.startNs) {
+        // The anchor moved back (system clock change): finish the bucket on its own grid, the ring must stay sorted
+        if (stampNs < bucket.startNs + bucketNs) return;
+        startNs = stampNs - (stampNs - bucket.startNs) % bucketNs;
+    }
+
+    if (bucket.startNs >= 0 && bucket.samples > 0) {
+        const int slot = ring.push();
+        const Values mean = bucket.mean();
+        ring.startNs[slot] = bucket.startNs;
+        ring.samples[slot] = bucket.samples;
+        ring.stateMask[slot] = bucket.stateMask;
+        for (int field = 0; field < FIELD_COUNT; ++field) {
+            ring.min[field][slot] = bucket.min[field];
+            ring.max[field][slot] = bucket.max[field];
+            ring.mean[field][slot] = mean[field];
+        }
+    }
+    bucket = Bucket();
+    bucket.startNs = startNs;
+}
+
+UpsHistory::Series HistoryStore::query(const QString& deviceId, Tier tier, qint64 fromNs, qint64 toNs) const
+{
+    UpsHistory::Series series;
+    series.deviceId = deviceId;
+    series.tier = tier;
+
+    const std::shared_ptr<Device> device = m_devices.value(deviceId);
+    if (!device || toNs < fromNs) return series;
+
+    const Ring& ring = tier == Tier::Minute ? device->minute : tier == Tier::Hour ? device->hour : device->raw;
+    const int first = ring.lowerBound(fromNs);
+    const int last = ring.lowerBound(toNs == std::numeric_limits<qint64>::max() ? toNs : toNs + 1);
+    appendRows(ring, first, last, series);
+
+    if (tier != Tier::Raw) {
+        const Bucket& current = tier == Tier::Minute ? device->currentMinute : device->currentHour;
+        if (current.samples > 0 && current.startNs >= fromNs && current.startNs <= toNs) {
+            appendBucket(current, series);
+        }
+    }
+    return series;
+}
+
+void HistoryStore::appendRows(const Ring& ring, int first, int last, UpsHistory::Series& out)
+{
+    const int count = last - first;
+    if (count <= 0) return;
+
+    const bool aggregated = !ring.min[0].empty();
+    out.startNs.reserve(out.size() + count + 1);
+
+    // At most two contiguous runs per column: up to the end of the storage, then from its start
+    int row = first;
+    while (row < last) {
+        const int begin = ring.slot(row);
+        const int run = std::min(last - row, ring.m_capacity - begin);
+        const int end = begin + run;
+
+        out.startNs.append(QList<qint64>(ring.startNs.begin() + begin, ring.startNs.begin() + end));
+        out.samples.append(QList<quint32>(ring.samples.begin() + begin, ring.samples.begin() + end));
+        out.stateMask.append(QList<quint8>(ring.stateMask.begin() + begin, ring.stateMask.begin() + end));
+        for (int field = 0; field < FIELD_COUNT; ++field) {
+            const std::vector<qint32>& mean = ring.mean[field];
+            out.mean[field].append(QList<qint32>(mean.begin() + begin, mean.begin() + end));
+            if (aggregated) {
+                out.min[field].append(QList<qint32>(ring.min[field].begin() + begin, ring.min[field].begin() + end));
+                out.max[field].append(QList<qint32>(ring.max[field].begin() + begin, ring.max[field].begin() + end));
+            } else {
+                out.min[field].append(QList<qint32>(mean.begin() + begin, mean.begin() + end));
+                out.max[field].append(QList<qint32>(mean.begin() + begin, mean.begin() + end));
+            }
+        }
+        row += run;
+    }
+}
+
+void HistoryStore::appendBucket(const Bucket& bucket, UpsHistory::Series& out)
+{
+    const Values mean = bucket.mean();
+    out.startNs.append(bucket.startNs);
+    out.samples.append(bucket.samples);
+    out.stateMask.append(bucket.stateMask);
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        out.min[field].append(bucket.min[field]);
+        out.max[field].append(bucket.max[field]);
+        out.mean[field].append(mean[field]);
+    }
+}
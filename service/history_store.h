@@ -0,0 +1,122 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ups_history.h"
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Memory-bounded, in-memory history of the reports the service broadcasts.
+ *
+ * Three tiers per device: every forwarded report (raw), 1-minute and 1-hour rollups with min/max/mean
+ * per field. The store is fed from Ups_api_library::upsReportAvailable, i.e. after the SampleFilter:
+ * the raw tier holds state changes, moves beyond a deadband and heartbeats, not every driver sample,
+ * and the rollups aggregate those. Disable the filter for full-rate history.
+ *
+ * Each tier is a fixed-capacity ring in structure-of-arrays layout: appending writes one slot per
+ * column, and a range scan copies contiguous runs of each column. The oldest rows are overwritten
+ * once a ring is full. Not thread-safe: use it from the service's main thread.
+ */
+class HistoryStore
+{
+public:
+    struct Capacity {
+        int raw = 3600;         // One hour at one report per second
+        int minute = 1440;      // One day
+        int hour = 720;         // 30 days
+    };
+
+    explicit HistoryStore(const Capacity& capacity = Capacity());
+    ~HistoryStore();
+
+    /**
+     * @brief Records a report. Reports without data (no connection, waiting for data) are skipped.
+     */
+    void record(const UpsReport& report);
+
+    /**
+     * @brief Rows of @p tier whose start lies in [@p fromNs, @p toNs] (UpsClock stamps).
+     * The rollup tiers include the bucket that is still being filled.
+     */
+    UpsHistory::Series query(const QString& deviceId, UpsHistory::Tier tier, qint64 fromNs, qint64 toNs) const;
+
+    QStringList deviceIds() const { return m_devices.keys(); }
+
+private:
+    using Values = std::array<qint32, UpsHistory::FIELD_COUNT>;
+
+    /**
+     * @brief Fixed-capacity ring, one vector per column. Raw rings only use the mean columns.
+     */
+    struct Ring {
+        Ring(int capacity, bool aggregated);
+
+        int push();                                     // Slot for a new row (overwrites the oldest)
+        int slot(int row) const { return (m_head - m_size + row + m_capacity) % m_capacity; }
+        int lowerBound(qint64 startNs) const;           // First row starting at or after startNs
+
+        int m_capacity = 0;
+        int m_head = 0;                                 // Next slot to write
+        int m_size = 0;
+        std::vector<qint64> startNs;
+        std::vector<quint32> samples;
+        std::vector<quint8> stateMask;
+        std::array<std::vector<qint32>, UpsHistory::FIELD_COUNT> min;
+        std::array<std::vector<qint32>, UpsHistory::FIELD_COUNT> max;
+        std::array<std::vector<qint32>, UpsHistory::FIELD_COUNT> mean;
+    };
+
+    /**
+     * @brief The rollup bucket that is still being filled.
+     */
+    struct Bucket {
+        qint64 startNs = -1;                            // -1 = empty
+        quint32 samples = 0;
+        quint8 stateMask = 0;
+        Values min{};
+        Values max{};
+        std::array<qint64, UpsHistory::FIELD_COUNT> sum{};
+
+        void add(const Values& values, quint8 stateBit);
+        Values mean() const;
+    };
+
+    struct Device {
+        explicit Device(const Capacity& capacity);
+
+        Ring raw;
+        Ring minute;
+        Ring hour;
+        Bucket currentMinute;
+        Bucket currentHour;
+        qint64 lastNs = 0;
+    };
+
+    static void roll(Ring& ring, Bucket& bucket, qint64 bucketNs, qint64 stampNs);
+    static void appendRows(const Ring& ring, int first, int last, UpsHistory::Series& out);
+    static void appendBucket(const Bucket& bucket, UpsHistory::Series& out);
+
+    Capacity m_capacity;
+    QHash<QString, std::shared_ptr<Device>> m_devices;
+};
@@ -20,12 +20,14 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QStringList>
+#include <QLoggingCategory>
 
 #include "lightups_api.h"
 #include "ups_ipc_server.h"
 #include "constants.h"
 #include "ups_monitor_service.h"
 #include "windows_service.h"
+#include "async_logger.h"
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -34,37 +36,6 @@
 // Initialize the global context defined in constants.h
 AppContext g_context;
 
-/**
- * @brief Custom message handler to format output and filter based on debug flag.
- */
-void myMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg) {
-    Q_UNUSED(context);
-
-    // If debug mode is off, suppress debug messages
-    if (type == QtDebugMsg && !g_context.debugMode) {
-        return;
-    }
-
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz");
-    QByteArray localMsg = msg.toLocal8Bit();
-
-    const char* typeStr = "INFO";
-    switch (type) {
-    case QtDebugMsg:    typeStr = "DEBUG"; break;
-    case QtWarningMsg:  typeStr = "WARN "; break;
-    case QtCriticalMsg: typeStr = "ERROR"; break;
-    case QtFatalMsg:    typeStr = "FATAL"; break;
-    default:            typeStr = "INFO "; break;
-    }
-
-    // Print to stderr for console visibility
-    fprintf(stderr, "[%s] %s: %s\n",
-            timestamp.toUtf8().constData(),
-            typeStr,
-            localMsg.constData());
-    fflush(stderr);
-}
-
 int main(int argc, char *argv[]) {
     // 1. Parse command line arguments
     QStringList args;
@@ -76,11 +47,26 @@ int main(int argc, char *argv[]) {
     g_context.consoleMode = args.contains("--console") || args.contains("-c");
     g_context.debugMode   = args.contains("--debug");
 
+    const qsizetype captureIndex = args.indexOf("--capture");
+    if (captureIndex >= 0 && captureIndex + 1 < args.size()) {
+        g_context.captureFile = args.at(captureIndex + 1);
+    }
+
     // On Windows, if we don't force console mode, we assume we should try to run as a Service
     g_context.isService   = !g_context.consoleMode;
 
-    // 3. Install the custom logger
-    qInstallMessageHandler(myMessageHandler);
+    // Logging category rules, e.g. --log-rules "lightups.driver.frames.debug=true;lightups.ipc.debug=true"
+    const qsizetype rulesIndex = args.indexOf("--log-rules");
+    if (rulesIndex >= 0 && rulesIndex + 1 < args.size()) {
+        QLoggingCategory::setFilterRules(args.at(rulesIndex + 1).split(';').join('\n'));
+    }
+
+    // Registry on Windows, /etc/andhoo/LightUps.conf elsewhere
+    AppConstants::initSettingsBackend();
+
+    // 3. Install the asynchronous logger (formatting and I/O happen on the shared task pool)
+    AsyncLogger::instance().setDebugEnabled(g_context.debugMode);
+    AsyncLogger::instance().start();
 
     if (g_context.isService) {
         // --- SERVICE MODE ---
@@ -100,18 +86,29 @@ int main(int argc, char *argv[]) {
         UpsMonitorCore monitorService(&a);
         UpsIpcServer ipcServer(&upsCore, &a);
 
-        // Connect components
-        QObject::connect(&ipcServer, &UpsIpcServer::settingsChanged,
-                         &monitorService, &UpsMonitorCore::loadSettings);
-
+        // Connect components (settings reach each of them through ConfigStore)
         QObject::connect(&upsCore, &Ups_api_library::upsReportAvailable,
                          &monitorService, &UpsMonitorCore::handleUpsReport);
 
+        QObject::connect(&upsCore, &Ups_api_library::autoDetectFinished,
+                         &a, [](bool found, const QString& driverFileName, const QString& port) {
+            WindowsService::logEvent(found ? QString("UPS auto-detected: %1 on %2.").arg(driverFileName, port)
+                                           : QString("UPS auto-detection found no UPS."),
+                                     EVENTLOG_INFORMATION_TYPE);
+        });
+
+        QObject::connect(&upsCore, &Ups_api_library::reactorHang,
+                         &a, [](const ReactorHangReport& report) {
+            WindowsService::logEvent(QString("Driver thread hang, restarting its drivers: %1").arg(report.toString()),
+                                     EVENTLOG_WARNING_TYPE);
+        });
+
         // Start the IPC server for communication with the GUI client
         if (!ipcServer.startServer()) {
             WindowsService::logEvent("Critical failure: Could not start IPC server.", EVENTLOG_ERROR_TYPE);
             return -1;
         }
+        upsCore.setCaptureFile(g_context.captureFile);
         upsCore.startService();
 
         return a.exec();
@@ -20,23 +20,118 @@
 #include <QDataStream>
 #include <QDebug>
 #include <QCoreApplication>
-#include <QSettings>
+#include <QStandardPaths>
+#include <QElapsedTimer>
 #include "ipc_constants.h"
 #include "constants.h"
+#include "async_logger.h"
+#include "ups_clock.h"
+#include "task_pool.h"
+#include <QLoggingCategory>
+#include <limits>
 
 #ifdef Q_OS_WIN
 #include <windows.h>
 #include <sddl.h>
 #include <accctrl.h>
 #include <aclapi.h>
+#else
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
 #endif
 
+namespace {
+#ifdef Q_OS_WIN
+/**
+ * @brief The TOKEN_USER of @p token (empty if it cannot be read).
+ */
+QByteArray tokenUser(HANDLE token)
+{
+    DWORD size = 0;
+    GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+    QByteArray buffer(static_cast<qsizetype>(size), '\0');
+    if (size == 0 || !GetTokenInformation(token, TokenUser, buffer.data(), size, &size)) return QByteArray();
+    return buffer;
+}
+#endif
+
+/**
+ * @brief Whether the process at the other end of @p socket may change the service's configuration:
+ * an elevated administrator, or a process running under the service's own account.
+ */
+bool isPrivilegedClient(QLocalSocket* socket)
+{
+#ifdef Q_OS_WIN
+    ULONG pid = 0;
+    if (!GetNamedPipeClientProcessId(reinterpret_cast<HANDLE>(socket->socketDescriptor()), &pid)) return false;
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) return false;
+    HANDLE primary = nullptr;
+    HANDLE token = nullptr;     // CheckTokenMembership() needs an impersonation token
+    bool privileged = false;
+    if (OpenProcessToken(process, TOKEN_QUERY | TOKEN_DUPLICATE, &primary)
+        && DuplicateToken(primary, SecurityIdentification, &token)) {
+        // A filtered (non-elevated) admin token carries Administrators as deny-only, so this fails
+        BYTE adminSid[SECURITY_MAX_SID_SIZE];
+        DWORD adminSize = sizeof(adminSid);
+        BOOL member = FALSE;
+        privileged = CreateWellKnownSid(WinBuiltinAdministratorsSid, nullptr, adminSid, &adminSize)
+                     && CheckTokenMembership(token, adminSid, &member) && member;
+
+        HANDLE ownToken = nullptr;
+        if (!privileged && OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &ownToken)) {
+            const QByteArray own = tokenUser(ownToken);
+            const QByteArray client = tokenUser(token);
+            privileged = !own.isEmpty() && !client.isEmpty()
+                         && EqualSid(reinterpret_cast<const TOKEN_USER*>(own.constData())->User.Sid,
+                                     reinterpret_cast<const TOKEN_USER*>(client.constData())->User.Sid);
+            CloseHandle(ownToken);
+        }
+    }
+    if (token) CloseHandle(token);
+    if (primary) CloseHandle(primary);
+    CloseHandle(process);
+    return privileged;
+#else
+    uid_t uid = static_cast<uid_t>(-1);
+#ifdef Q_OS_LINUX
+    ucred credentials{};
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(static_cast<int>(socket->socketDescriptor()), SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0) {
+        uid = credentials.uid;
+    }
+#else
+    gid_t gid = 0;
+    if (getpeereid(static_cast<int>(socket->socketDescriptor()), &uid, &gid) != 0) {
+        uid = static_cast<uid_t>(-1);
+    }
+#endif
+    return uid == 0 || uid == geteuid();
+#endif
+}
+} // namespace
+
 UpsIpcServer::UpsIpcServer(Ups_api_library* upsCore, QObject *parent)
     : QObject(parent), m_server(new QLocalServer(this))
 {
     // Connect the UPS API layer signal to the IPC server's transmission slot.
     connect(upsCore, &Ups_api_library::upsReportAvailable,
             this, &UpsIpcServer::sendReportToClients);
+    // Every forwarded report goes into the history, also when no client is connected
+    connect(upsCore, &Ups_api_library::upsReportAvailable, this, [this](const UpsReport& report) {
+        m_history.record(report);
+        m_historyFile.append(report.deviceId, report.data);
+    });
+
+    // Samples reach the disk in batches; HistoryFile syncs state transitions itself.
+    // The flushes wait for the disk on the shared pool, in order, instead of on this thread.
+    static const quint64 historyFlushAffinity = TaskPool::affinityKey("HistoryFile");
+    m_historyFile.setFlushExecutor([](std::function<void()> flush) {
+        TaskPool::global().submit(historyFlushAffinity, std::move(flush));
+    });
+    m_historySyncTimer.setInterval(30000);
+    connect(&m_historySyncTimer, &QTimer::timeout, this, [this]() { m_historyFile.sync(); });
     connect(m_server, &QLocalServer::newConnection, this, &UpsIpcServer::newConnection);
 }
 
@@ -51,6 +146,12 @@ UpsIpcServer::~UpsIpcServer()
         socket->deleteLater();
     }
     m_clients.clear();
+    m_blockSizes.clear();
+    m_typedClients.clear();
+    m_privilegedClients.clear();
+
+    m_historySyncTimer.stop();
+    m_historyFile.close();
 }
 
 bool UpsIpcServer::startServer()
@@ -82,15 +183,38 @@ bool UpsIpcServer::startServer()
     }
 #endif
     qDebug() << "IPC Server: Listening started on" << IPC_SERVER_NAME;
+    openHistoryFile();
     return true;
 }
 
+void UpsIpcServer::openHistoryFile()
+{
+    QString path = ConfigStore::instance().snapshot()->historyFile;
+    if (path == "off") return;
+    if (path.isEmpty()) {
+        path = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/history.lhf";
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!m_historyFile.open(path)) {
+        qWarning() << "IPC Server: History file" << path << "unavailable:" << m_historyFile.errorString();
+        return;
+    }
+    qInfo() << "IPC Server: History file" << path << "opened with" << m_historyFile.count() << "records in"
+            << timer.elapsed() << "ms";
+    m_historySyncTimer.start();
+}
+
 void UpsIpcServer::newConnection()
 {
     QLocalSocket* socket = m_server->nextPendingConnection();
     if (socket) {
         qDebug() << "IPC Server: New client connected.";
         m_clients.append(socket);
+        if (isPrivilegedClient(socket)) {
+            m_privilegedClients.insert(socket);
+        }
 
         // Ensure we know when the client disconnects
         connect(socket, &QLocalSocket::disconnected, this, &UpsIpcServer::socketDisconnected);
@@ -106,85 +230,194 @@ void UpsIpcServer::socketDisconnected()
     if (socket) {
         qDebug() << "IPC Server: Client disconnected.";
         m_clients.removeOne(socket);
+        m_blockSizes.remove(socket);
+        m_typedClients.remove(socket);
+        m_binaryClients.remove(socket);
+        m_privilegedClients.remove(socket);
         socket->deleteLater();
     }
 }
 
 void UpsIpcServer::sendReportToClients(const UpsReport& report)
 {
+    // The encoder sends strings only when they change, so it has to see every report
+    QByteArray binaryPacket;
+    if (m_binaryClients.isEmpty()) {
+        m_wireEncoder.track(report);
+    } else {
+        m_wireEncoder.encode(report, binaryPacket);
+    }
     if (m_clients.isEmpty()) return;
-    QByteArray packet;
-    QDataStream out(&packet, QIODevice::WriteOnly);
-    out.setVersion(QDataStream::Qt_6_0);
-
-    // Reserve space for the size (placeholder)
-    out << (quint32)0;
-
-    // Serialize the data directly into the same buffer
-    out << report;
-
-    // Go back to the beginning to write the actual size
-    out.device()->seek(0);
-    out << (quint32)(packet.size() - sizeof(quint32));
 
-    // Send in one go
+    // Each encoding is built at most once per report, then sent in one go.
+    // QDataStream only serves clients that predate the binary format.
+    QByteArray payload;
+    QByteArray legacyPacket;
+    QByteArray typedPacket;
     for (QLocalSocket* socket : std::as_const(m_clients)) {
-        if (socket->state() == QLocalSocket::ConnectedState) {
-            socket->write(packet);
+        if (socket->state() != QLocalSocket::ConnectedState) continue;
+        if (m_binaryClients.contains(socket)) {
+            socket->write(binaryPacket);
+            continue;
+        }
+        if (payload.isEmpty()) {
+            QDataStream out(&payload, QIODevice::WriteOnly);
+            out.setVersion(QDataStream::Qt_6_0);
+            out << report;
+        }
+        if (m_typedClients.contains(socket)) {
+            if (typedPacket.isEmpty()) typedPacket = typedFrame(IpcFrame::Report, payload);
+            socket->write(typedPacket);
+        } else {
+            if (legacyPacket.isEmpty()) legacyPacket = frame(payload);
+            socket->write(legacyPacket);
         }
     }
 }
 
-// De implementatie van readyRead:
+QByteArray UpsIpcServer::frame(const QByteArray& payload)
+{
+    QByteArray packet;
+    QDataStream out(&packet, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << (quint32)payload.size();
+    packet.append(payload);
+    return packet;
+}
+
+QByteArray UpsIpcServer::typedFrame(quint8 type, const QByteArray& payload)
+{
+    QByteArray packet;
+    QDataStream out(&packet, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << (quint32)(payload.size() + sizeof(quint8)) << type;
+    packet.append(payload);
+    return packet;
+}
+
 void UpsIpcServer::readyRead() {
     QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
     if (!socket) return;
     QDataStream in(socket);
     in.setVersion(QDataStream::Qt_6_0);
 
-    // 1. First read the size of the packet (the quint32 sent by the GUI)
-    static quint32 blockSize = 0;
-    if (blockSize == 0) {
-        if (socket->bytesAvailable() < sizeof(quint32))
-            return; // Wait for more data to be able to read the header
-        in >> blockSize;
-    }
+    // A client may send several commands at once (e.g. HELLO followed by HISTORY)
+    quint32& blockSize = m_blockSizes[socket];
+    forever {
+        // 1. First read the size of the packet (the quint32 sent by the client)
+        if (blockSize == 0) {
+            if (socket->bytesAvailable() < (qint64)sizeof(quint32))
+                return; // Wait for more data to be able to read the header
+            in >> blockSize;
+        }
 
-    // 2. Check if the full payload (the QMap) has arrived
-    if (socket->bytesAvailable() < blockSize) {
-        return; // Wait until the entire packet is present
-    }
+        // 2. Check if the full payload (the QMap) has arrived
+        if (socket->bytesAvailable() < blockSize) {
+            return; // Wait until the entire packet is present
+        }
 
-    // Reset blockSize for the next command
-    blockSize = 0;
+        // Reset blockSize for the next command
+        blockSize = 0;
 
-    // 3. Now we can safely read the QMap
-    QMap<QString, QString> commandData;
-    in >> commandData;
-    if (in.status() == QDataStream::Ok) {
-        processCommand(commandData);
+        // 3. Now we can safely read the QMap
+        QMap<QString, QString> commandData;
+        in >> commandData;
+        if (in.status() != QDataStream::Ok) {
+            in.resetStatus();
+            continue;
+        }
+        processCommand(socket, commandData);
     }
 }
 
 // Helper method to keep the logic clean
-void UpsIpcServer::processCommand(const QMap<QString, QString>& data) {
+void UpsIpcServer::processCommand(QLocalSocket* socket, const QMap<QString, QString>& data) {
     QString command = data.value("COMMAND");
-    if (command == "CONFIG_UPDATE") {
+    if ((command == "CONFIG_UPDATE" || command == "LOG_RULES") && !m_privilegedClients.contains(socket)) {
+        // The pipe is open to everyone; changing the service is reserved for administrators
+        qWarning() << "IPC Server:" << command << "rejected: the client is not an administrator.";
+        return;
+    }
+    if (command == "HELLO") {
+        // Capability negotiation: only clients that ask for typed frames or the binary format get them
+        const QString frames = data.value("FRAMES");
+        if (frames == "binary") {
+            m_typedClients.remove(socket);
+            m_binaryClients.insert(socket);
+            // Reports refer to the strings of their unit, so those come first
+            socket->write(m_wireEncoder.stringTable());
+            qDebug() << "IPC Server: Client switched to the binary wire format, version" << IpcWire::VERSION;
+        } else if (frames == "typed") {
+            m_binaryClients.remove(socket);
+            m_typedClients.insert(socket);
+            qDebug() << "IPC Server: Client switched to typed frames.";
+        }
+    }
+    else if (command == "HISTORY") {
+        sendHistory(socket, data);
+    }
+    else if (command == "CONFIG_UPDATE") {
         qDebug() << "IPC Server: Config update received.";
-        QSettings settings(AppConstants::SETTINGS_SCOPE,
-                           AppConstants::APP_ORGANIZATION_NAME,
-                           AppConstants::APP_APPLICATION_NAME);
 
         // We iterate through the map and ignore the "COMMAND" key
+        QVariantMap changes;
         for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
             if (it.key() == "COMMAND") continue;
-            settings.setValue(it.key(), it.value());
+            changes.insert(it.key(), it.value());
             qDebug() << "Registry: " << it.key() << " changed to " << it.value();
-            qDebug() << "Registry modified via scope:" << AppConstants::SETTINGS_SCOPE
-                     << "Key:" << it.key();
         }
-        settings.sync();
-        emit settingsChanged(); // Tell the rest of the app that the data is fresh
-        qDebug() << "IPC Server: Signal settingsChanged emitted.";
+
+        // One new version, and only the components whose fields changed are told
+        if (ConfigStore::instance().apply(changes)) {
+            qDebug() << "IPC Server: Configuration version" << ConfigStore::instance().version() << "active.";
+        } else {
+            qWarning() << "IPC Server: Config update could not be stored.";
+        }
+    }
+    else if (command == "LOG_RULES") {
+        // Runtime logging control: RULES uses QLoggingCategory syntax (lines or ';'-separated),
+        // DEBUG switches debug output on/off, RATE_LIMIT sets messages per second per category.
+        if (data.contains("RULES")) {
+            QLoggingCategory::setFilterRules(data.value("RULES").split(';').join('\n'));
+        }
+        if (data.contains("DEBUG")) {
+            AsyncLogger::instance().setDebugEnabled(data.value("DEBUG") == "1");
+        }
+        if (data.contains("RATE_LIMIT")) {
+            AsyncLogger::instance().setRateLimit(data.value("RATE_LIMIT").toInt());
+        }
+        qInfo() << "IPC Server: Logging configuration updated.";
     }
 }
+
+void UpsIpcServer::sendHistory(QLocalSocket* socket, const QMap<QString, QString>& data)
+{
+    // A legacy client would take the reply for a UpsReport
+    const bool binary = m_binaryClients.contains(socket);
+    if (!binary && !m_typedClients.contains(socket)) {
+        qWarning() << "IPC Server: HISTORY requested without typed frames; ignored.";
+        return;
+    }
+
+    const QString tierName = data.value("TIER", "raw");
+    const UpsHistory::Tier tier = tierName == "hour"   ? UpsHistory::Tier::Hour
+                                : tierName == "minute" ? UpsHistory::Tier::Minute
+                                                       : UpsHistory::Tier::Raw;
+    bool fromOk = false;
+    bool toOk = false;
+    qint64 fromNs = data.value("FROM_NS").toLongLong(&fromOk);
+    qint64 toNs = data.value("TO_NS").toLongLong(&toOk);
+    if (!fromOk) fromNs = 0;
+    if (!toOk) toNs = std::numeric_limits<qint64>::max();
+
+    // Without DEVICE the primary UPS is meant, like in the reports of older services
+    const QString deviceId = data.value("DEVICE", AppConstants::PRIMARY_DEVICE_ID);
+
+    const UpsHistory::Series series = m_history.query(deviceId, tier, fromNs, toNs);
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << series;
+    socket->write(binary ? m_wireEncoder.message(IpcWire::History, payload) : typedFrame(IpcFrame::History, payload));
+    qDebug() << "IPC Server: Sent" << series.size() << "history rows for" << deviceId;
+}
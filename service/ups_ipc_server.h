@@ -22,7 +22,13 @@
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QList>
+#include <QHash>
+#include <QSet>
 #include "lightups_api.h"
+#include "history_store.h"
+#include "history_file.h"
+#include "ipc_wire.h"
+#include <QTimer>
 /**
  * @brief Beheert de lokale server en het verzenden van UpsReport via IPC.
  */
@@ -45,8 +51,17 @@ private slots:
 private:
     QLocalServer *m_server;
     QList<QLocalSocket*> m_clients;
-    void processCommand(const QMap<QString, QString>& data);
-
-signals:
-    void settingsChanged();
+    QHash<QLocalSocket*, quint32> m_blockSizes;    // Pending command size per client (0 = reading the header)
+    QSet<QLocalSocket*> m_typedClients;             // Clients that negotiated typed frames (IpcFrame)
+    QSet<QLocalSocket*> m_binaryClients;            // Clients that negotiated the binary wire format (IpcWire)
+    QSet<QLocalSocket*> m_privilegedClients;        // Administrators and the service's own account (CONFIG_UPDATE, LOG_RULES)
+    IpcWire::Encoder m_wireEncoder;                 // Shared by all binary clients: strings go out once per change
+    HistoryStore m_history;
+    HistoryFile m_historyFile;
+    QTimer m_historySyncTimer;
+    void openHistoryFile();
+    void processCommand(QLocalSocket* socket, const QMap<QString, QString>& data);
+    void sendHistory(QLocalSocket* socket, const QMap<QString, QString>& data);
+    static QByteArray frame(const QByteArray& payload);
+    static QByteArray typedFrame(quint8 type, const QByteArray& payload);
 };
@@ -38,18 +38,21 @@ UpsMonitorCore::UpsMonitorCore(QObject *parent)
     // 1. Initialize the registry (creates the keys and keywords)
     initializeRegistry();
 
-    // 2. Load the values we just created (or that were already there)
-    loadSettings();
-
-    // 3. Other timer setup
+    // 2. Timer setup (the shutdown interval follows the configured delay)
     m_shutdownTimer->setSingleShot(true);
-    m_shutdownTimer->setInterval(30000);
     connect(m_shutdownTimer, &QTimer::timeout, this, &UpsMonitorCore::executeShutdown);
 
     m_cpuRecoveryTimer->setSingleShot(true);
     m_cpuRecoveryTimer->setInterval(10000);
     connect(m_cpuRecoveryTimer, &QTimer::timeout, this, &UpsMonitorCore::restoreCpuSpeed);
 
+    // 3. Take the values we just created (or that were already there), then follow our own fields only
+    ConfigStore &config = ConfigStore::instance();
+    config.reload();
+    applySettings(*config.snapshot());
+    config.subscribe(UpsConfig::Field::ShutdownDelay | UpsConfig::Field::PowerSafe | UpsConfig::Field::RuntimeMargin,
+                     this, [this](const ConfigDiff &diff) { applySettings(*diff.current); });
+
     // --- PROPOSAL: Direct check upon startup ----
     checkAndFixPowerProfile();
 }
@@ -79,6 +82,11 @@ void UpsMonitorCore::handleUpsReport(const UpsReport &report)
 {
     using namespace UpsMonitor;
 
+    // Power management and shutdown follow the primary UPS (the one powering this machine)
+    if (report.deviceId != AppConstants::PRIMARY_DEVICE_ID) {
+        return;
+    }
+
     // --- THE GATEKEEPER ---
     // When communication is lost (e.g., when changing drivers):
     if (!report.serviceStatus.dataCommunicationActive) {
@@ -97,6 +105,9 @@ void UpsMonitorCore::handleUpsReport(const UpsReport &report)
     // 1. Ignore Unknown (already handled by the gatekeeper above)
     if (currentState == UpsState::Unknown) return;
 
+    // Runtime-based shutdown is evaluated on every report, not only on state changes
+    if (checkRuntimeMargin(report)) return;
+
     // 2. Only take action on an actual state change
     if (currentState == m_lastState) {
         return;
@@ -167,6 +178,9 @@ void UpsMonitorCore::handleUpsReport(const UpsReport &report)
     }
     // Situation: Power restored
     else if (currentState == UpsState::OnlineFull || currentState == UpsState::OnlineCharging) {
+        m_runtimeShutdownIssued = false;
+        m_runtimeBelowMarginReports = 0;
+
         // Cancel the shutdown if it was scheduled
         if (m_isTimerRunning) {
             m_shutdownTimer->stop();
@@ -181,6 +195,42 @@ void UpsMonitorCore::handleUpsReport(const UpsReport &report)
     }
 }
 
+bool UpsMonitorCore::checkRuntimeMargin(const UpsReport &report)
+{
+    using namespace UpsMonitor;
+    const UpsState state = report.data.state;
+    const int runtime = report.data.runtimeRemainingSeconds;
+    // A shutdown delay of 0 disables every automatic shutdown, this one included
+    if (m_runtimeMargin <= 0 || m_shutdownDelay <= 0 || m_runtimeShutdownIssued || runtime < 0
+        || (state != UpsState::OnBattery && state != UpsState::BatteryCritical)) {
+        m_runtimeBelowMarginReports = 0;
+        return false;
+    }
+    if (runtime > m_runtimeMargin) {
+        m_runtimeBelowMarginReports = 0;
+        return false;
+    }
+    // The estimate dips when the load first hits the battery (voltage sag): only act once it stays low
+    if (++m_runtimeBelowMarginReports < RUNTIME_MARGIN_CONFIRMATIONS) {
+        qDebug() << "Estimated runtime" << runtime << "s under the margin (" << m_runtimeBelowMarginReports
+                 << "of" << RUNTIME_MARGIN_CONFIRMATIONS << "reports)";
+        return false;
+    }
+
+    m_runtimeShutdownIssued = true;
+    m_shutdownTimer->stop();
+    m_isTimerRunning = false;
+    const QString logMsg = tr("Estimated battery runtime (%1 s) reached the margin of %2 s: shutting down.")
+                               .arg(runtime).arg(m_runtimeMargin);
+#ifdef Q_OS_WIN
+    WindowsService::logEvent(logMsg, EVENTLOG_ERROR_TYPE, UpsEvents::ID_BATT_CRITICAL);
+#else
+    qDebug() << logMsg;
+#endif
+    executeShutdown();
+    return true;
+}
+
 void UpsMonitorCore::setPowerMode(bool batteryMode)
 {
     // Prevent duplicate calls if the state is already correct
@@ -213,14 +263,12 @@ void UpsMonitorCore::executeShutdown()
 #endif
 }
 
-void UpsMonitorCore::loadSettings() {
-    QSettings settings(AppConstants::SETTINGS_SCOPE,
-                       AppConstants::APP_ORGANIZATION_NAME,
-                       AppConstants::APP_APPLICATION_NAME);
+void UpsMonitorCore::applySettings(const UpsConfig &config) {
     int oldDelay = m_shutdownDelay;
     bool oldPowerSafe = m_powerSafeEnabled;
-    m_shutdownDelay = settings.value(AppConstants::REG_KEY_SHUTDOWN_DELAY, 30).toInt();
-    m_powerSafeEnabled = settings.value(AppConstants::REG_KEY_POWER_SAFE_ENABLED, false).toBool();
+    m_shutdownDelay = config.shutdownDelaySeconds;
+    m_powerSafeEnabled = config.powerSafeEnabled;
+    m_runtimeMargin = config.runtimeMarginSeconds;
 
     // 1. UPDATE DELAY ON-THE-FLY
     m_shutdownTimer->setInterval(m_shutdownDelay * 1000);
@@ -251,9 +299,10 @@ void UpsMonitorCore::loadSettings() {
 
     // Clear log upon start/update
     qDebug() << "-----------------------------------------------";
-    qDebug() << "UPS Monitor Service Configuration loaded:";
+    qDebug() << "UPS Monitor Service Configuration loaded (version" << config.version << "):";
     qDebug() << " - Shutdown Delay: " << m_shutdownDelay << (m_shutdownDelay <= 0 ? " (DISABLED)" : " s");
     qDebug() << " - PowerSafe Mode: " << (m_powerSafeEnabled ? "ON" : "OFF");
+    qDebug() << " - Runtime Margin: " << m_runtimeMargin << (m_runtimeMargin <= 0 ? " (DISABLED)" : " s");
     qDebug() << "-----------------------------------------------";
 }
 
@@ -268,6 +317,7 @@ void UpsMonitorCore::initializeRegistry() {
         qDebug() << "Registry: Creating default settings in HKLM...";
         settings.setValue(AppConstants::REG_KEY_SHUTDOWN_DELAY, 30);
         settings.setValue(AppConstants::REG_KEY_POWER_SAFE_ENABLED, false);
+        settings.setValue(AppConstants::REG_KEY_RUNTIME_MARGIN, 0); // Opt-in: the runtime is an estimate
         settings.setValue(AppConstants::REG_KEY_SELECTED_DRIVER_FILE, "template_driver.dll");
         settings.setValue(AppConstants::REG_KEY_SELECTED_COM_PORT, "COM1");
         settings.sync(); // Force write to Windows
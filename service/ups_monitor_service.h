@@ -21,6 +21,7 @@
 #include <QObject>
 #include <QTimer>
 #include "ups_report.h"
+#include "config_store.h"
 
 class UpsMonitorCore : public QObject
 {
@@ -30,7 +31,6 @@ public:
 
 public slots:
     void handleUpsReport(const UpsReport &report);
-    void loadSettings();
 
 private slots:
     void executeShutdown();
@@ -44,7 +44,13 @@ private:
     bool m_currentPowerModeIsBattery; // Keeps track of the current Windows state
     void setPowerMode(bool batteryMode);
     void checkAndFixPowerProfile();
-    int m_shutdownDelay;      // Stores the current delay
-    bool m_powerSafeEnabled;  // Stores the powersafe status
+    int m_shutdownDelay = 30; // Stores the current delay
+    int m_runtimeMargin = 0;  // Shut down when the estimated runtime drops to this many seconds (0 = off, the default)
+    bool m_runtimeShutdownIssued = false;
+    int m_runtimeBelowMarginReports = 0; // Consecutive battery reports with the runtime under the margin
+    static constexpr int RUNTIME_MARGIN_CONFIRMATIONS = 5;
+    bool checkRuntimeMargin(const UpsReport &report);
+    bool m_powerSafeEnabled = false; // Stores the powersafe status
     void initializeRegistry();
+    void applySettings(const UpsConfig &config);
 };
@@ -72,19 +72,30 @@ void WINAPI WindowsService::ServiceMain(DWORD argc, LPTSTR *argv) {
     UpsMonitorCore monitorService(m_app);
     UpsIpcServer ipcServer(&upsCore, m_app);
 
-    // 4. Connections
-    QObject::connect(&ipcServer, &UpsIpcServer::settingsChanged,
-                     &monitorService, &UpsMonitorCore::loadSettings);
-
+    // 4. Connections (settings reach each component through ConfigStore)
     QObject::connect(&upsCore, &Ups_api_library::upsReportAvailable,
                      &monitorService, &UpsMonitorCore::handleUpsReport);
 
+    QObject::connect(&upsCore, &Ups_api_library::autoDetectFinished,
+                     m_app, [](bool found, const QString& driverFileName, const QString& port) {
+        if (found) {
+            logEvent(QCoreApplication::translate("WindowsService", "UPS auto-detected: %1 on %2.").arg(driverFileName, port));
+        }
+    });
+
+    QObject::connect(&upsCore, &Ups_api_library::reactorHang,
+                     m_app, [](const ReactorHangReport& report) {
+        logEvent(QCoreApplication::translate("WindowsService", "Driver thread hang, restarting its drivers: %1").arg(report.toString()),
+                 EVENTLOG_WARNING_TYPE);
+    });
+
     // 5. Start servers
     if (!ipcServer.startServer()) {
         logEvent(QCoreApplication::translate("WindowsService", "Critical: IPC Server could not start."), EVENTLOG_ERROR_TYPE);
         updateStatus(SERVICE_STOPPED);
         return;
     }
+    upsCore.setCaptureFile(g_context.captureFile);
     upsCore.startService();
 
     // 6. Success Log
@@ -0,0 +1,497 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * @brief Unit tests for the NHS codec: framing, resynchronization, the ring buffer and payload decoding.
+ *
+ * Every stream test runs the hand-written FrameDecoder and the generated ProtocolFrame parser
+ * side by side, so both framing implementations are held to the same behaviour.
+ *
+ * Usage: nhs_codec_test (exit code 1 if any group fails)
+ */
+
+#include "nhs_codec.h"
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+using namespace NhsCodec;
+using UpsMonitor::UpsState;
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++g_failures; \
+        } \
+    } while (0)
+
+// A known realtime status: 230 V in, 229 V out, 12.0 V battery, 40 C, 45 % load, 210..240 V window
+constexpr nhs_data_payload_t KNOWN_DATA{
+    .vacinrms_low = 0xE6, .vacinrms_high = 0x00,
+    .vdcmed_low = 0x78, .vdcmed_high = 0x00,
+    .potrms = 45,
+    .vacinrmsmin_low = 0xD2, .vacinrmsmin_high = 0x00,
+    .vacinrmsmax_low = 0xF0, .vacinrmsmax_high = 0x00,
+    .vacoutrms_low = 0xE5, .vacoutrms_high = 0x00,
+    .tempmed_low = 0x28, .tempmed_high = 0x00,
+    .icarregrms = 3,
+    .statusval = 0x90, // Mains present (bit 4) and charging current (bit 7)
+    .unknown_status = 0,
+};
+
+// A known hardware reply: 220 V under/over voltage thresholds 190 V and 245 V
+constexpr nhs_hardware_payload_t KNOWN_HARDWARE{
+    .unknown_id_byte_1 = 1, .unknown_id_byte_2 = 2, .unknown_id_byte_3 = 3,
+    .unknown_id_byte_4 = 4, .unknown_id_byte_5 = 5,
+    .undervoltage_127V_byte = 100, .overvoltage_127V_byte = 140,
+    .undervoltage_220V_byte = 190, .overvoltage_220V_byte = 245,
+    .output_voltage_byte = 220, .input_voltage_byte = 220,
+    .unknown_byte_6 = 0, .unknown_byte_7 = 0,
+};
+
+std::vector<quint8> dataFrame(nhs_data_payload_t payload)
+{
+    std::vector<quint8> frame(PACKET_LEN_D);
+    encodeData(payload, frame);
+    return frame;
+}
+
+std::vector<quint8> hardwareFrame()
+{
+    std::vector<quint8> frame(PACKET_LEN_S);
+    encodeHardware(KNOWN_HARDWARE, frame);
+    return frame;
+}
+
+// A payload whose input voltage carries a sequence number, to check order and completeness
+nhs_data_payload_t numbered(quint16 sequence)
+{
+    nhs_data_payload_t payload = KNOWN_DATA;
+    payload.vacinrms_low = static_cast<quint8>(sequence & 0xFF);
+    payload.vacinrms_high = static_cast<quint8>(sequence >> 8);
+    return payload;
+}
+
+/**
+ * @brief Feeds a stream in fixed-size chunks through both framing implementations.
+ */
+struct StreamResult {
+    std::vector<quint16> decoderInputs;   // input_voltage_v of every D frame, FrameDecoder
+    std::vector<quint16> parserInputs;    // input_voltage_v of every D frame, generated parser
+    int decoderHardware = 0;
+    int parserHardware = 0;
+    DecoderStats decoderStats;
+    ProtocolFrame::ParserStats parserStats;
+};
+
+StreamResult runStream(const std::vector<quint8>& stream, size_t chunk)
+{
+    StreamResult result;
+    FrameDecoder decoder;
+    Parser parser;
+    pkt_data_t raw{};
+
+    for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+        const std::span<const quint8> bytes(stream.data() + pos, std::min(chunk, stream.size() - pos));
+
+        decoder.feed(bytes, [&](const Frame& frame) {
+            pkt_data_t decoded{};
+            if (frame.type == FrameType::Data) {
+                decodeData(toDataPayload(frame.payload.first<sizeof(nhs_data_payload_t)>()), decoded);
+                result.decoderInputs.push_back(decoded.input_voltage_v);
+            } else {
+                ++result.decoderHardware;
+            }
+        });
+
+        parser.feed(bytes, raw, [&](auto frame) {
+            if constexpr (std::is_same_v<decltype(frame), DataFrame>) {
+                result.parserInputs.push_back(raw.input_voltage_v);
+            } else {
+                ++result.parserHardware;
+            }
+        });
+    }
+    result.decoderStats = decoder.stats();
+    result.parserStats = parser.stats();
+    return result;
+}
+
+// Both implementations must agree on what they saw
+void checkSameAsParser(const StreamResult& r)
+{
+    CHECK(r.decoderInputs == r.parserInputs);
+    CHECK(r.decoderHardware == r.parserHardware);
+    CHECK(r.decoderStats.framesDecoded == r.parserStats.framesDecoded);
+    CHECK(r.decoderStats.checksumFailures == r.parserStats.checksumFailures);
+    CHECK(r.decoderStats.resyncBytesDiscarded == r.parserStats.resyncBytesDiscarded);
+    CHECK(r.decoderStats.bufferOverruns == r.parserStats.bufferOverruns);
+}
+
+// ----------------------------------------------------
+// --- TEST GROUPS ---
+// ----------------------------------------------------
+
+void testEncoding()
+{
+    const std::span<const quint8> handshake = handshakeCommand();
+    const std::vector<quint8> expected{ 0xFF, 0x09, 0x53, 0x03, 0x00, 0x00, 0x00, 0x5F, 0xFE };
+    CHECK(std::vector<quint8>(handshake.begin(), handshake.end()) == expected);
+
+    const std::vector<quint8> frame = dataFrame(KNOWN_DATA);
+    CHECK(frame[0] == 0xFF);
+    CHECK(frame[1] == PACKET_LEN_D);
+    CHECK(frame[2] == TYPE_DATA);
+    CHECK(frame[PACKET_LEN_D - 1] == 0xFE);
+
+    // Output buffer too small
+    quint8 small[PACKET_LEN_D - 1];
+    CHECK(encodeData(KNOWN_DATA, small) == 0);
+}
+
+void testDecodeData()
+{
+    const std::vector<quint8> frame = dataFrame(KNOWN_DATA);
+    const StreamResult r = runStream(frame, frame.size());
+    CHECK(r.decoderInputs.size() == 1);
+    checkSameAsParser(r);
+
+    pkt_data_t out{};
+    decodeData(toDataPayload(std::span<const quint8, sizeof(nhs_data_payload_t)>(frame.data() + HEADER_LEN, sizeof(nhs_data_payload_t))), out);
+    CHECK(out.input_voltage_v == 230);
+    CHECK(out.output_voltage_v == 229);
+    CHECK(out.battery_voltage_v == 12.0f);
+    CHECK(out.temperature_c == 40);
+    CHECK(out.power_rms_percent == 45);
+    CHECK(out.input_voltage_min_v == 210);
+    CHECK(out.input_voltage_max_v == 240);
+    CHECK(out.state == UpsState::OnlineCharging);
+    CHECK(!out.s_battery_mode);
+    CHECK(!out.s_battery_low);
+    CHECK(!out.s_network_failure);
+    CHECK(!out.s_fast_network_failure);
+    CHECK(out.s_220_in);
+    CHECK(!out.s_220_out);
+    CHECK(!out.s_bypass_on);
+    CHECK(out.s_charger_on);
+
+    // Both bytes of the little-endian fields count
+    nhs_data_payload_t wide = KNOWN_DATA;
+    wide.vdcmed_low = 0x04;
+    wide.vdcmed_high = 0x01; // 260 -> 26.0 V
+    wide.tempmed_low = 0x2C;
+    wide.tempmed_high = 0x01; // 300
+    decodeData(wide, out);
+    CHECK(out.battery_voltage_v == 26.0f);
+    CHECK(out.temperature_c == 300);
+
+    // The generated parser produces the same fields from the same frame
+    Parser parser;
+    pkt_data_t generated{};
+    CHECK(parser.feed(frame, generated, [](auto) {}) == 1);
+    decodeData(KNOWN_DATA, out);
+    CHECK(generated.input_voltage_v == out.input_voltage_v);
+    CHECK(generated.output_voltage_v == out.output_voltage_v);
+    CHECK(generated.battery_voltage_v == out.battery_voltage_v);
+    CHECK(generated.temperature_c == out.temperature_c);
+    CHECK(generated.power_rms_percent == out.power_rms_percent);
+    CHECK(generated.input_voltage_min_v == out.input_voltage_min_v);
+    CHECK(generated.input_voltage_max_v == out.input_voltage_max_v);
+    CHECK(generated.state == out.state);
+    CHECK(generated.s_220_in == out.s_220_in);
+    CHECK(generated.s_charger_on == out.s_charger_on);
+
+    // toUpsData converts to the report units
+    const UpsData data = toUpsData(out, 42);
+    CHECK(data.timestampNs == 42);
+    CHECK(data.inputMillivolts == 230000);
+    CHECK(data.outputMillivolts == 229000);
+    CHECK(data.batteryMillivolts == 12000);
+    CHECK(data.temperatureDeci == 400);
+    CHECK(data.state == UpsState::OnlineCharging);
+
+    // Out-of-range temperatures saturate instead of wrapping
+    pkt_data_t hot = out;
+    hot.temperature_c = 0xFFFF;
+    CHECK(toUpsData(hot, 42).temperatureDeci == std::numeric_limits<qint16>::max());
+}
+
+void testDecodeHardware()
+{
+    const std::vector<quint8> frame = hardwareFrame();
+    const StreamResult r = runStream(frame, frame.size());
+    CHECK(r.decoderHardware == 1);
+    CHECK(r.decoderInputs.empty());
+    checkSameAsParser(r);
+
+    pkt_data_t out{};
+    decodeHardware(toHardwarePayload(std::span<const quint8, sizeof(nhs_hardware_payload_t)>(frame.data() + HEADER_LEN, sizeof(nhs_hardware_payload_t))), out);
+    CHECK(out.uv_220v == 190);
+    CHECK(out.ov_220v == 245);
+    CHECK(out.hardware_payload.undervoltage_127V_byte == 100);
+    CHECK(out.hardware_payload.unknown_id_byte_5 == 5);
+
+    Parser parser;
+    pkt_data_t generated{};
+    CHECK(parser.feed(frame, generated, [](auto) {}) == 1);
+    CHECK(generated.uv_220v == 190);
+    CHECK(generated.ov_220v == 245);
+}
+
+void testStatusTable()
+{
+    // Independent restatement of the priority rules in stateFromStatusByte()
+    int counts[5] = {};
+    for (int status = 0; status < 256; ++status) {
+        UpsState expected;
+        if (status & 0x02) expected = UpsState::BatteryCritical;
+        else if (!(status & 0x10)) expected = UpsState::OnBattery;
+        else if (status & 0x01) expected = UpsState::OnlineFault;
+        else if (status & 0x80) expected = UpsState::OnlineCharging;
+        else expected = UpsState::OnlineFull;
+
+        CHECK(STATUS_STATE_TABLE[status] == expected);
+        switch (STATUS_STATE_TABLE[status]) {
+        case UpsState::BatteryCritical: ++counts[0]; break;
+        case UpsState::OnBattery: ++counts[1]; break;
+        case UpsState::OnlineFault: ++counts[2]; break;
+        case UpsState::OnlineCharging: ++counts[3]; break;
+        case UpsState::OnlineFull: ++counts[4]; break;
+        default: CHECK(false); break;
+        }
+
+        // decodeData uses the table and exposes every bit as a flag
+        nhs_data_payload_t payload = KNOWN_DATA;
+        payload.statusval = static_cast<quint8>(status);
+        pkt_data_t out{};
+        decodeData(payload, out);
+        CHECK(out.state == expected);
+        CHECK(out.s_battery_mode == bool(status & 0x01));
+        CHECK(out.s_battery_low == bool(status & 0x02));
+        CHECK(out.s_network_failure == bool(status & 0x04));
+        CHECK(out.s_fast_network_failure == bool(status & 0x08));
+        CHECK(out.s_220_in == bool(status & 0x10));
+        CHECK(out.s_220_out == bool(status & 0x20));
+        CHECK(out.s_bypass_on == bool(status & 0x40));
+        CHECK(out.s_charger_on == bool(status & 0x80));
+
+        // The generated Mapped<> field goes through the same table
+        Parser parser;
+        pkt_data_t generated{};
+        parser.feed(dataFrame(payload), generated, [](auto) {});
+        CHECK(generated.state == expected);
+    }
+    // Bit 1 set: 128; bit 1 and 4 clear: 64; bit 4 and 0: 32; bit 4 and 7 without 0: 16; the rest: 16
+    CHECK(counts[0] == 128);
+    CHECK(counts[1] == 64);
+    CHECK(counts[2] == 32);
+    CHECK(counts[3] == 16);
+    CHECK(counts[4] == 16);
+}
+
+void testChecksumMismatch()
+{
+    std::vector<quint8> bad = dataFrame(numbered(1));
+    bad[PACKET_LEN_D - 2] ^= 0x01; // Wrong checksum
+    std::vector<quint8> badEnd = dataFrame(numbered(2));
+    badEnd[PACKET_LEN_D - 1] = 0x00; // Wrong end marker
+    const std::vector<quint8> good = dataFrame(numbered(3));
+
+    std::vector<quint8> stream = bad;
+    stream.insert(stream.end(), badEnd.begin(), badEnd.end());
+    stream.insert(stream.end(), good.begin(), good.end());
+
+    const StreamResult r = runStream(stream, stream.size());
+    CHECK(r.decoderInputs == std::vector<quint16>{ 3 });
+    CHECK(r.decoderStats.checksumFailures == 2);
+    CHECK(r.decoderStats.framesDecoded == 1);
+    // Each failure only drops the false start marker, the rest is rescanned
+    CHECK(r.decoderStats.resyncBytesDiscarded == 2 * PACKET_LEN_D);
+    checkSameAsParser(r);
+
+    // A valid checksum with an unknown type/length pair is counted, not delivered
+    std::vector<quint8> unknown = dataFrame(numbered(4));
+    unknown[2] = 'X';
+    unknown[PACKET_LEN_D - 2] = NhsRingBuffer::checksum(unknown.data(), PACKET_LEN_D - 3);
+    FrameDecoder decoder;
+    CHECK(decoder.feed(unknown, [](const Frame&) {}) == 0);
+    CHECK(decoder.stats().unknownFrames == 1);
+    CHECK(decoder.stats().checksumFailures == 0);
+}
+
+void testResyncAfterGarbage()
+{
+    // Garbage with false start markers, a false start followed by a valid length byte,
+    // and a real frame that starts inside the length of that false frame
+    std::vector<quint8> stream{ 0x00, 0x13, 0xFE, 0xFF, 0x00, 0xFF, 0xFF, 0x07, 0x44 };
+    stream.push_back(0xFF);
+    stream.push_back(PACKET_LEN_D);
+    stream.push_back(0x01);
+    const std::vector<quint8> first = dataFrame(numbered(10));
+    stream.insert(stream.end(), first.begin(), first.end());
+    const std::vector<quint8> hardware = hardwareFrame();
+    stream.insert(stream.end(), hardware.begin(), hardware.end());
+    const std::vector<quint8> second = dataFrame(numbered(11));
+    stream.insert(stream.end(), second.begin(), second.end());
+
+    for (size_t chunk : { size_t(1), size_t(5), stream.size() }) {
+        const StreamResult r = runStream(stream, chunk);
+        CHECK((r.decoderInputs == std::vector<quint16>{ 10, 11 }));
+        CHECK(r.decoderHardware == 1);
+        CHECK(r.decoderStats.resyncBytesDiscarded == 12);
+        checkSameAsParser(r);
+    }
+}
+
+void testSplitFrame()
+{
+    const std::vector<quint8> frame = dataFrame(numbered(7));
+
+    // Every split point of a frame over two feed() calls
+    for (int split = 1; split < PACKET_LEN_D; ++split) {
+        FrameDecoder decoder;
+        Parser parser;
+        pkt_data_t raw{};
+        int frames = 0;
+        int parsed = 0;
+        const std::span<const quint8> head(frame.data(), split);
+        const std::span<const quint8> tail(frame.data() + split, PACKET_LEN_D - split);
+
+        frames += decoder.feed(head, [](const Frame&) {});
+        parsed += parser.feed(head, raw, [](auto) {});
+        CHECK(frames == 0);
+        CHECK(parsed == 0);
+        frames += decoder.feed(tail, [](const Frame&) {});
+        parsed += parser.feed(tail, raw, [](auto) {});
+        CHECK(frames == 1);
+        CHECK(parsed == 1);
+        CHECK(raw.input_voltage_v == 7);
+        CHECK(decoder.stats().resyncBytesDiscarded == 0);
+    }
+
+    // Byte by byte
+    const StreamResult r = runStream(frame, 1);
+    CHECK(r.decoderInputs == std::vector<quint16>{ 7 });
+    checkSameAsParser(r);
+}
+
+void testRingWrapAround()
+{
+    // Frames of both sizes with 0..6 garbage bytes in between, so frame starts land on every
+    // ring offset, including frames that straddle the end of the ring (the mirrored region)
+    std::vector<quint8> stream;
+    std::vector<quint16> expected;
+    for (quint16 i = 0; i < 500; ++i) {
+        for (int g = 0; g < i % 7; ++g) stream.push_back(static_cast<quint8>(0x20 + g));
+        const std::vector<quint8> frame = (i % 5 == 4) ? hardwareFrame() : dataFrame(numbered(i));
+        if (i % 5 != 4) expected.push_back(i);
+        stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+
+    for (size_t chunk : { size_t(1), size_t(13), size_t(NhsRingBuffer::BUFFER_SIZE - 1), stream.size() }) {
+        const StreamResult r = runStream(stream, chunk);
+        CHECK(r.decoderInputs == expected);
+        CHECK(r.decoderHardware == 100);
+        CHECK(r.decoderStats.checksumFailures == 0);
+        CHECK(r.decoderStats.bufferOverruns == 0);
+        CHECK(r.decoderStats.bytesIn == stream.size());
+        checkSameAsParser(r);
+    }
+}
+
+void testRingOverrun()
+{
+    // The ring keeps one slot free: a write larger than the free space is truncated
+    NhsRingBuffer ring;
+    std::vector<quint8> garbage(NhsRingBuffer::BUFFER_SIZE * 2, 0x11);
+    CHECK(ring.write(garbage.data(), static_cast<int>(garbage.size())) == NhsRingBuffer::BUFFER_MASK);
+    CHECK(ring.size() == NhsRingBuffer::BUFFER_MASK);
+    CHECK(ring.freeSpace() == 0);
+    CHECK(ring.write(garbage.data(), 1) == 0);
+
+    // Extraction frees the ring again; garbage without a start marker is dropped entirely
+    int frames = 0;
+    const int skipped = ring.extractFrames([&](const quint8*, int) { ++frames; }, [] {});
+    CHECK(frames == 0);
+    CHECK(skipped == NhsRingBuffer::BUFFER_MASK);
+    CHECK(ring.size() == 0);
+
+    // A wrapped frame written after the ring was full is still one contiguous span
+    const std::vector<quint8> frame = dataFrame(numbered(99));
+    CHECK(ring.write(frame.data(), PACKET_LEN_D) == PACKET_LEN_D);
+    ring.extractFrames([&](const quint8* f, int length) {
+        ++frames;
+        CHECK(length == PACKET_LEN_D);
+        CHECK(std::equal(f, f + length, frame.begin()));
+    }, [] { CHECK(false); });
+    CHECK(frames == 1);
+
+    // A single feed() far larger than the ring is ingested in batches without losing frames
+    std::vector<quint8> burst;
+    for (quint16 i = 0; i < 64; ++i) {
+        const std::vector<quint8> f = dataFrame(numbered(i));
+        burst.insert(burst.end(), f.begin(), f.end());
+    }
+    const StreamResult r = runStream(burst, burst.size());
+    CHECK(r.decoderInputs.size() == 64);
+    CHECK(r.decoderInputs.back() == 63);
+    CHECK(r.decoderStats.bufferOverruns == 0);
+    checkSameAsParser(r);
+
+    // A burst of pure garbage larger than the ring is discarded completely
+    const StreamResult g = runStream(garbage, garbage.size());
+    CHECK(g.decoderInputs.empty());
+    CHECK(g.decoderStats.resyncBytesDiscarded == garbage.size());
+    checkSameAsParser(g);
+}
+
+} // namespace
+
+int main()
+{
+    const struct {
+        const char* name;
+        void (*run)();
+    } groups[] = {
+        { "encoding", testEncoding },
+        { "decodeData", testDecodeData },
+        { "decodeHardware", testDecodeHardware },
+        { "statusTable", testStatusTable },
+        { "checksumMismatch", testChecksumMismatch },
+        { "resyncAfterGarbage", testResyncAfterGarbage },
+        { "splitFrame", testSplitFrame },
+        { "ringWrapAround", testRingWrapAround },
+        { "ringOverrun", testRingOverrun },
+    };
+
+    int failedGroups = 0;
+    for (const auto& group : groups) {
+        const int before = g_failures;
+        group.run();
+        const bool passed = g_failures == before;
+        std::printf("%-20s %s\n", group.name, passed ? "PASS" : "FAIL");
+        if (!passed) ++failedGroups;
+    }
+    std::printf("%d of %zu groups failed\n", failedGroups, std::size(groups));
+    return failedGroups == 0 ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * lightups-history: fetches the sample history of a running LightUpsService and prints it as CSV.
+ *
+ *   lightups-history                                  (raw samples of the primary UPS, last 10 minutes)
+ *   lightups-history --tier minute --last 86400       (1-minute rollups of the last day)
+ *   lightups-history --device ups2 --tier hour        (everything the hour tier still holds)
+ *   lightups-history --file history.lhf --last 0      (the service's history file, also while it runs)
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QMap>
+#include <QElapsedTimer>
+#include <cstdio>
+#include "ipc_constants.h"
+#include "constants.h"
+#include "ups_history.h"
+#include "ups_clock.h"
+#include "history_file.h"
+
+namespace {
+
+bool sendCommand(QLocalSocket& socket, const QMap<QString, QString>& command)
+{
+    QByteArray packet;
+    QDataStream out(&packet, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << (quint32)0 << command;
+    out.device()->seek(0);
+    out << (quint32)(packet.size() - sizeof(quint32));
+    return socket.write(packet) == packet.size();
+}
+
+/**
+ * @brief Reads typed frames until the History frame arrives; reports pushed in between are skipped.
+ */
+bool readHistory(QLocalSocket& socket, UpsHistory::Series& series, int timeoutMs)
+{
+    QDataStream in(&socket);
+    in.setVersion(QDataStream::Qt_6_0);
+    forever {
+        while (socket.bytesAvailable() < (qint64)sizeof(quint32)) {
+            if (!socket.waitForReadyRead(timeoutMs)) return false;
+        }
+        quint32 size = 0;
+        in >> size;
+        while (socket.bytesAvailable() < size) {
+            if (!socket.waitForReadyRead(timeoutMs)) return false;
+        }
+        const QByteArray frame = socket.read(size);
+        if (frame.isEmpty() || (quint8)frame.at(0) != IpcFrame::History) continue;
+
+        QDataStream payload(frame.mid(1));
+        payload.setVersion(QDataStream::Qt_6_0);
+        payload >> series;
+        return payload.status() == QDataStream::Ok;
+    }
+}
+
+/**
+ * @brief Prints the records of a history file as CSV, straight from the mapping.
+ */
+int printHistoryFile(const QString& path, const QString& deviceId, qint64 lastSeconds)
+{
+    QElapsedTimer timer;
+    timer.start();
+    HistoryFile file;
+    if (!file.open(path, true)) {
+        std::fprintf(stderr, "Cannot open %s: %s\n", qPrintable(path), qPrintable(file.errorString()));
+        return 1;
+    }
+    const qint64 openMs = timer.elapsed();
+
+    int device = -1;
+    for (int i = 0; i < file.deviceCount(); ++i) {
+        if (file.deviceId(i) == deviceId) device = i;
+    }
+    const qint64 first = lastSeconds > 0 ? file.lowerBound(QDateTime::currentMSecsSinceEpoch() - lastSeconds * 1000) : 0;
+
+    std::printf("time,kind,state,status,flags");
+    for (int field = 0; field < UpsHistory::FIELD_COUNT; ++field) {
+        std::printf(",%s", UpsHistory::fieldName(field));
+    }
+    std::printf("\n");
+    qint64 rows = 0;
+    for (qint64 i = first; i < file.count(); ++i) {
+        const HistoryFile::Record& record = file.at(i);
+        if (record.device != device) continue;
+        std::printf("%s,%s,%u,%u,%u", qPrintable(QDateTime::fromMSecsSinceEpoch(record.wallMs).toString(Qt::ISODateWithMs)),
+                    record.kind == HistoryFile::Transition ? "transition" : "sample",
+                    record.state, record.statusCode, record.flags);
+        for (int field = 0; field < UpsHistory::FIELD_COUNT; ++field) {
+            std::printf(",%d", record.fields[field]);
+        }
+        std::printf("\n");
+        ++rows;
+    }
+    std::fprintf(stderr, "%lld rows for %s (%lld records in the file, opened in %lld ms)\n", (long long)rows,
+                 qPrintable(deviceId), (long long)file.count(), (long long)openMs);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lightups-history");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Prints the sample history kept by the LightUps service.");
+    parser.addHelpOption();
+    QCommandLineOption deviceOption("device", "Device id (default: the primary UPS).", "id");
+    QCommandLineOption tierOption("tier", "raw, minute or hour.", "tier", "raw");
+    QCommandLineOption lastOption("last", "Only rows of the last N seconds (0 = all).", "seconds", "600");
+    QCommandLineOption timeoutOption("timeout-ms", "How long to wait for the service.", "ms", "3000");
+    QCommandLineOption fileOption("file", "Read this history file instead of asking the service.", "path");
+    parser.addOptions({ deviceOption, tierOption, lastOption, timeoutOption, fileOption });
+    parser.process(app);
+
+    if (parser.isSet(fileOption)) {
+        return printHistoryFile(parser.value(fileOption),
+                                parser.isSet(deviceOption) ? parser.value(deviceOption) : AppConstants::PRIMARY_DEVICE_ID,
+                                parser.value(lastOption).toLongLong());
+    }
+
+    const QString tier = parser.value(tierOption);
+    if (tier != "raw" && tier != "minute" && tier != "hour") {
+        std::fprintf(stderr, "Unknown tier '%s'\n", qPrintable(tier));
+        return 1;
+    }
+    const int timeoutMs = parser.value(timeoutOption).toInt();
+
+    QLocalSocket socket;
+    socket.connectToServer(IPC_SERVER_NAME);
+    if (!socket.waitForConnected(timeoutMs)) {
+        std::fprintf(stderr, "Cannot connect to the service: %s\n", qPrintable(socket.errorString()));
+        return 1;
+    }
+
+    // Both clocks are system-wide monotonic clocks, so the service understands our stamps
+    QMap<QString, QString> query{ { "COMMAND", "HISTORY" }, { "TIER", tier } };
+    if (parser.isSet(deviceOption)) {
+        query.insert("DEVICE", parser.value(deviceOption));
+    }
+    const qint64 lastSeconds = parser.value(lastOption).toLongLong();
+    if (lastSeconds > 0) {
+        query.insert("FROM_NS", QString::number(UpsClock::nowNs() - lastSeconds * 1000000000LL));
+    }
+
+    if (!sendCommand(socket, { { "COMMAND", "HELLO" }, { "FRAMES", "typed" } }) || !sendCommand(socket, query)) {
+        std::fprintf(stderr, "Cannot send the query: %s\n", qPrintable(socket.errorString()));
+        return 1;
+    }
+    socket.flush();
+
+    UpsHistory::Series series;
+    if (!readHistory(socket, series, timeoutMs)) {
+        std::fprintf(stderr, "No history received (older service?)\n");
+        return 1;
+    }
+
+    // CSV: one line per row; raw rows only have a value per field, rollups have min/mean/max
+    const bool raw = series.tier == UpsHistory::Tier::Raw;
+    std::printf("time,samples,state_mask");
+    for (int field = 0; field < UpsHistory::FIELD_COUNT; ++field) {
+        const char* name = UpsHistory::fieldName(field);
+        if (raw) {
+            std::printf(",%s", name);
+        } else {
+            std::printf(",%s_min,%s_mean,%s_max", name, name, name);
+        }
+    }
+    std::printf("\n");
+    for (qsizetype row = 0; row < series.size(); ++row) {
+        std::printf("%s,%u,0x%02x", qPrintable(UpsClock::toDateTime(series.startNs[row]).toString(Qt::ISODateWithMs)),
+                    series.samples[row], series.stateMask[row]);
+        for (int field = 0; field < UpsHistory::FIELD_COUNT; ++field) {
+            if (raw) {
+                std::printf(",%d", series.mean[field][row]);
+            } else {
+                std::printf(",%d,%d,%d", series.min[field][row], series.mean[field][row], series.max[field][row]);
+            }
+        }
+        std::printf("\n");
+    }
+    std::fprintf(stderr, "%lld rows for %s\n", (long long)series.size(), qPrintable(series.deviceId));
+    return 0;
+}
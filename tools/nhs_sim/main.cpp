@@ -0,0 +1,232 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * lightups-nhs-sim: simulated NHS UPS units behind Linux pseudo-terminals.
+ *
+ *   lightups-nhs-sim                                  (one unit, 1 D record/s)
+ *   lightups-nhs-sim --units 32 --rate 10 --link-dir /tmp/nhs
+ *   lightups-nhs-sim --scenario outage
+ *   lightups-nhs-sim --event noise@0 --event unplug@20+5 --loop 60
+ *
+ * Each unit prints its port; point Nhs_driver at it (COM port setting, or startDriver()).
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+
+#include <csignal>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <poll.h>
+#include <vector>
+
+#include "sim_scenario.h"
+#include "sim_unit.h"
+
+using namespace NhsSim;
+
+namespace {
+
+volatile std::sig_atomic_t g_stopRequested = 0;
+
+void onSignal(int)
+{
+    g_stopRequested = 1;
+}
+
+qint64 monotonicNs()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+constexpr qint64 RECHECK_NS = 100 * 1000000LL;   // How often a disconnected PTY is polled for a client
+
+void printStats(const std::vector<std::unique_ptr<SimUnit>>& units, const SimStats& previous, double seconds, quint32 active)
+{
+    SimStats total;
+    int connected = 0;
+    for (const auto& unit : units) {
+        total += unit->stats();
+        if (unit->isClientConnected()) ++connected;
+    }
+
+    std::printf("[sim] %d/%zu connected | %.0f frames/s | %.1f KB/s | handshakes %llu | corrupted %llu | drops %llu | events:",
+                connected, units.size(),
+                (total.framesSent - previous.framesSent) / seconds,
+                (total.bytesSent - previous.bytesSent) / seconds / 1024.0,
+                static_cast<unsigned long long>(total.handshakesAnswered),
+                static_cast<unsigned long long>(total.corruptedFrames),
+                static_cast<unsigned long long>(total.writeDrops));
+    if (active == EventNone) std::printf(" none");
+    for (quint32 bit = 1; bit <= EventUnplug; bit <<= 1) {
+        if (active & bit) std::printf(" %s", SimScenario::eventName(static_cast<SimEvent>(bit)));
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lightups-nhs-sim");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulates NHS UPS units on Linux pseudo-terminals.");
+    parser.addHelpOption();
+    QCommandLineOption unitsOption("units", "Number of simulated units.", "n", "1");
+    QCommandLineOption rateOption("rate", "D records per second per unit.", "hz", "1");
+    QCommandLineOption linkDirOption("link-dir", "Create stable ttyNHS<n> symlinks in this directory.", "dir");
+    QCommandLineOption scenarioOption("scenario", QString("Preset scenario: %1.").arg(SimScenario::presetHelp()), "name");
+    QCommandLineOption eventOption("event", "Add an event: <mains-loss|battery-critical|noise|silence|unplug>@<start s>[+<duration s>].", "spec");
+    QCommandLineOption loopOption("loop", "Repeat the event timeline every N seconds.", "s", "0");
+    QCommandLineOption noiseOption("noise", "Per-frame corruption probability while noise is active.", "p", "0.2");
+    QCommandLineOption waitOption("wait-handshake", "Only stream D records after the S command was received.");
+    QCommandLineOption durationOption("duration", "Stop after N seconds (0 = until interrupted).", "s", "0");
+    QCommandLineOption statsOption("stats", "Print aggregate statistics every N seconds (0 = off).", "s", "5");
+    QCommandLineOption seedOption("seed", "Random seed for jitter and noise.", "n", "1");
+    parser.addOptions({ unitsOption, rateOption, linkDirOption, scenarioOption, eventOption, loopOption,
+                        noiseOption, waitOption, durationOption, statsOption, seedOption });
+    parser.process(app);
+
+    SimConfig config;
+    config.rateHz = parser.value(rateOption).toDouble();
+    config.noiseProbability = parser.value(noiseOption).toDouble();
+    config.streamBeforeHandshake = !parser.isSet(waitOption);
+    config.seed = parser.value(seedOption).toUInt();
+    const int unitCount = parser.value(unitsOption).toInt();
+    if (unitCount <= 0 || config.rateHz <= 0.0) {
+        std::fprintf(stderr, "--units and --rate must be positive\n");
+        return 1;
+    }
+    if (parser.isSet(linkDirOption)) {
+        const QString linkDir = QDir(parser.value(linkDirOption)).absolutePath();
+        QDir().mkpath(linkDir);
+        config.linkDir = linkDir.toStdString();
+    }
+
+    SimScenario scenario;
+    std::string error;
+    for (const QString& preset : parser.values(scenarioOption)) {
+        if (!scenario.addPreset(preset.toStdString(), error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    for (const QString& spec : parser.values(eventOption)) {
+        if (!scenario.addEvent(spec.toStdString(), error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    scenario.setLoopPeriod(static_cast<qint64>(parser.value(loopOption).toDouble() * 1000.0));
+
+    // 1. Create the units
+    std::vector<std::unique_ptr<SimUnit>> units;
+    units.reserve(unitCount);
+    for (int i = 0; i < unitCount; ++i) {
+        auto unit = std::make_unique<SimUnit>(i, config);
+        if (!unit->open(error)) {
+            std::fprintf(stderr, "unit %d: %s\n", i, error.c_str());
+            return 1;
+        }
+        std::printf("unit %d: %s\n", i, unit->portPath().c_str());
+        units.push_back(std::move(unit));
+    }
+    std::fflush(stdout);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    // 2. Event loop: one poll() over all masters, timed by the earliest due record
+    const qint64 startNs = monotonicNs();
+    const qint64 durationNs = static_cast<qint64>(parser.value(durationOption).toDouble() * 1e9);
+    const qint64 statsIntervalNs = static_cast<qint64>(parser.value(statsOption).toDouble() * 1e9);
+    qint64 nextStatsNs = startNs + statsIntervalNs;
+    SimStats previousTotal;
+    std::vector<qint64> nextRecheckNs(units.size(), 0);
+    std::vector<pollfd> fds(units.size());
+
+    while (!g_stopRequested) {
+        qint64 nowNs = monotonicNs();
+        if (durationNs > 0 && nowNs - startNs >= durationNs) break;
+        const quint32 active = scenario.activeAt((nowNs - startNs) / 1000000);
+
+        qint64 wakeNs = nowNs + RECHECK_NS;
+        for (size_t i = 0; i < units.size(); ++i) {
+            SimUnit& unit = *units[i];
+            fds[i] = { -1, POLLIN, 0 };
+
+            // Unplug closes the master (the client sees an I/O error), replug creates a fresh PTY
+            if ((active & EventUnplug) && unit.isOpen()) {
+                unit.close();
+            } else if (!(active & EventUnplug) && !unit.isOpen()) {
+                if (!unit.open(error)) {
+                    std::fprintf(stderr, "unit %zu: %s\n", i, error.c_str());
+                    continue;
+                }
+                std::printf("unit %zu: replugged as %s\n", i, unit.slavePath().c_str());
+                std::fflush(stdout);
+            }
+            if (!unit.isOpen()) continue;
+
+            // A master with no client reports POLLHUP permanently, so only poll it now and then
+            if (unit.isClientConnected() || nowNs >= nextRecheckNs[i]) {
+                fds[i].fd = unit.masterFd();
+            }
+            wakeNs = std::min(wakeNs, unit.service(nowNs, active));
+        }
+
+        const int timeoutMs = static_cast<int>(std::max<qint64>(0, (wakeNs - nowNs + 999999) / 1000000));
+        const int ready = ::poll(fds.data(), fds.size(), timeoutMs);
+        if (ready < 0 && errno != EINTR) {
+            std::perror("poll");
+            break;
+        }
+
+        nowNs = monotonicNs();
+        for (size_t i = 0; i < units.size(); ++i) {
+            if (fds[i].fd < 0) continue;
+            SimUnit& unit = *units[i];
+            const bool hungUp = fds[i].revents & POLLHUP;
+            unit.setClientConnected(!hungUp);
+            if (hungUp) {
+                nextRecheckNs[i] = nowNs + RECHECK_NS;
+            } else if (fds[i].revents & POLLIN) {
+                unit.handleReadable(active);
+            }
+        }
+
+        if (statsIntervalNs > 0 && nowNs >= nextStatsNs) {
+            SimStats total;
+            for (const auto& unit : units) total += unit->stats();
+            printStats(units, previousTotal, (nowNs - nextStatsNs + statsIntervalNs) / 1e9, active);
+            previousTotal = total;
+            nextStatsNs = nowNs + statsIntervalNs;
+        }
+    }
+
+    units.clear(); // Closes masters and removes symlinks
+    return 0;
+}
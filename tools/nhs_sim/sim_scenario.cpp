@@ -0,0 +1,133 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sim_scenario.h"
+#include <cstdlib>
+
+namespace NhsSim {
+
+namespace {
+
+struct EventName {
+    const char* name;
+    SimEvent event;
+};
+
+constexpr EventName EVENT_NAMES[] = {
+    { "mains-loss", EventMainsLoss },
+    { "battery-critical", EventBatteryCritical },
+    { "noise", EventNoise },
+    { "silence", EventSilence },
+    { "unplug", EventUnplug },
+};
+
+bool parseSeconds(const std::string& text, qint64& outMs)
+{
+    if (text.empty()) return false;
+    char* end = nullptr;
+    const double seconds = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size() || seconds < 0.0) return false;
+    outMs = static_cast<qint64>(seconds * 1000.0);
+    return true;
+}
+
+} // namespace
+
+bool SimScenario::addEvent(const std::string& spec, std::string& error)
+{
+    const size_t at = spec.find('@');
+    const std::string kind = spec.substr(0, at);
+
+    Entry entry;
+    for (const EventName& candidate : EVENT_NAMES) {
+        if (kind == candidate.name) entry.event = candidate.event;
+    }
+    if (entry.event == EventNone) {
+        error = "unknown event '" + kind + "'";
+        return false;
+    }
+
+    if (at != std::string::npos) {
+        const std::string timing = spec.substr(at + 1);
+        const size_t plus = timing.find('+');
+        if (!parseSeconds(timing.substr(0, plus), entry.startMs)) {
+            error = "invalid start time in '" + spec + "'";
+            return false;
+        }
+        if (plus != std::string::npos && !parseSeconds(timing.substr(plus + 1), entry.durationMs)) {
+            error = "invalid duration in '" + spec + "'";
+            return false;
+        }
+    }
+
+    m_entries.push_back(entry);
+    return true;
+}
+
+bool SimScenario::addPreset(const std::string& name, std::string& error)
+{
+    // Durations are chosen around the driver's 5 s monitor timeout and 1.5 s handshake retry
+    if (name == "outage") {
+        return addEvent("mains-loss@10+40", error) && addEvent("battery-critical@40+10", error);
+    }
+    if (name == "flaky") {
+        return addEvent("noise@5+20", error) && addEvent("silence@30+8", error);
+    }
+    if (name == "unplug") {
+        return addEvent("unplug@10+5", error);
+    }
+    if (name == "soak") {
+        // Everything, once a minute; combine with --loop 60
+        return addEvent("noise@5+5", error) && addEvent("mains-loss@15+20", error)
+               && addEvent("battery-critical@30+5", error) && addEvent("silence@40+7", error)
+               && addEvent("unplug@50+4", error);
+    }
+    error = "unknown scenario '" + name + "'";
+    return false;
+}
+
+quint32 SimScenario::activeAt(qint64 elapsedMs) const
+{
+    if (m_loopPeriodMs > 0) {
+        elapsedMs %= m_loopPeriodMs;
+    }
+
+    quint32 active = EventNone;
+    for (const Entry& entry : m_entries) {
+        if (elapsedMs < entry.startMs) continue;
+        if (entry.durationMs >= 0 && elapsedMs >= entry.startMs + entry.durationMs) continue;
+        active |= entry.event;
+    }
+    return active;
+}
+
+const char* SimScenario::eventName(SimEvent event)
+{
+    for (const EventName& candidate : EVENT_NAMES) {
+        if (candidate.event == event) return candidate.name;
+    }
+    return "none";
+}
+
+const char* SimScenario::presetHelp()
+{
+    return "outage (mains loss, then battery critical), flaky (noise, then silence), "
+           "unplug (cable pulled for 5 s), soak (all of them within 60 s, use with --loop 60)";
+}
+
+} // namespace NhsSim
@@ -0,0 +1,88 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIM_SCENARIO_H
+#define SIM_SCENARIO_H
+
+#include <QtGlobal>
+#include <string>
+#include <vector>
+
+namespace NhsSim {
+
+/**
+ * @brief Conditions a simulated unit can be put into. Values are bit flags so several can overlap.
+ */
+enum SimEvent : quint32 {
+    EventNone            = 0,
+    EventMainsLoss       = 1 << 0,  // Inverter active, battery draining
+    EventBatteryCritical = 1 << 1,  // On battery with the low-battery bit set
+    EventNoise           = 1 << 2,  // Corrupted checksums and garbage bytes between frames
+    EventSilence         = 1 << 3,  // Line stays open but nothing is sent or answered
+    EventUnplug          = 1 << 4   // PTY master closed, as if the cable was pulled
+};
+
+/**
+ * @brief A timeline of events, optionally repeating.
+ *
+ * Events are written as "<kind>@<start>[+<duration>]" with times in seconds, e.g. "mains-loss@10+30".
+ * Without a duration the event lasts until the end of the run (or the end of the loop period).
+ */
+class SimScenario
+{
+public:
+    struct Entry {
+        SimEvent event = EventNone;
+        qint64 startMs = 0;
+        qint64 durationMs = -1;   // -1: open-ended
+    };
+
+    /**
+     * @brief Parses one event specification and adds it to the timeline.
+     * @return false (and fills @p error) if the specification is invalid.
+     */
+    bool addEvent(const std::string& spec, std::string& error);
+
+    /**
+     * @brief Adds the events of a named preset ("outage", "flaky", "unplug", "soak").
+     */
+    bool addPreset(const std::string& name, std::string& error);
+
+    /**
+     * @brief Repeats the timeline every @p periodMs milliseconds (0 = no repeat).
+     */
+    void setLoopPeriod(qint64 periodMs) { m_loopPeriodMs = periodMs; }
+
+    /**
+     * @brief Returns the OR of all events active @p elapsedMs after the start.
+     */
+    quint32 activeAt(qint64 elapsedMs) const;
+
+    const std::vector<Entry>& entries() const { return m_entries; }
+
+    static const char* eventName(SimEvent event);
+    static const char* presetHelp();
+
+private:
+    std::vector<Entry> m_entries;
+    qint64 m_loopPeriodMs = 0;
+};
+
+} // namespace NhsSim
+
+#endif // SIM_SCENARIO_H
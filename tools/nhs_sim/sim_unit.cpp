@@ -0,0 +1,296 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "sim_unit.h"
+#include "sim_scenario.h"
+#include "nhs_codec.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace NhsSim {
+
+namespace {
+constexpr double BATTERY_FULL_V = 13.6;
+constexpr double BATTERY_EMPTY_V = 10.5;
+constexpr double DRAIN_V_PER_S = 0.03;
+constexpr double CHARGE_V_PER_S = 0.05;
+constexpr double CHARGED_THRESHOLD_V = 13.4;
+}
+
+SimStats& SimStats::operator+=(const SimStats& other)
+{
+    framesSent += other.framesSent;
+    bytesSent += other.bytesSent;
+    handshakesAnswered += other.handshakesAnswered;
+    corruptedFrames += other.corruptedFrames;
+    writeDrops += other.writeDrops;
+    reconnects += other.reconnects;
+    return *this;
+}
+
+SimUnit::SimUnit(int index, const SimConfig& config)
+    : m_index(index)
+    , m_config(config)
+    , m_rng(config.seed + static_cast<quint32>(index) * 7919u)
+{
+    m_periodNs = static_cast<qint64>(1e9 / std::max(0.001, config.rateHz));
+}
+
+SimUnit::~SimUnit()
+{
+    close();
+}
+
+bool SimUnit::open(std::string& error)
+{
+    m_masterFd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (m_masterFd < 0 || grantpt(m_masterFd) != 0 || unlockpt(m_masterFd) != 0) {
+        error = std::string("posix_openpt failed: ") + std::strerror(errno);
+        close();
+        return false;
+    }
+
+    char name[128] = {};
+    if (ptsname_r(m_masterFd, name, sizeof(name)) != 0) {
+        error = std::string("ptsname failed: ") + std::strerror(errno);
+        close();
+        return false;
+    }
+    m_slavePath = name;
+
+    // A master whose slave was never opened does not report POLLHUP; open and close it once
+    // so "no client" looks the same before the first connection as after a disconnect.
+    const int slaveFd = ::open(m_slavePath.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (slaveFd >= 0) {
+        ::close(slaveFd);
+    }
+
+    // Raw line discipline: no echo, no CR/LF translation, 0xFF passes untouched
+    termios tio{};
+    if (tcgetattr(m_masterFd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, B2400);
+        cfsetospeed(&tio, B2400);
+        tcsetattr(m_masterFd, TCSANOW, &tio);
+    }
+
+    if (!m_config.linkDir.empty()) {
+        m_linkPath = m_config.linkDir + "/ttyNHS" + std::to_string(m_index);
+        ::unlink(m_linkPath.c_str());
+        if (::symlink(m_slavePath.c_str(), m_linkPath.c_str()) != 0) {
+            error = "symlink " + m_linkPath + " failed: " + std::strerror(errno);
+            close();
+            return false;
+        }
+    }
+
+    m_clientConnected = false;
+    m_handshakeSeen = false;
+    m_commandBuffer.clear();
+    return true;
+}
+
+void SimUnit::close()
+{
+    if (!m_linkPath.empty()) {
+        ::unlink(m_linkPath.c_str());
+    }
+    if (m_masterFd >= 0) {
+        ::close(m_masterFd);
+        m_masterFd = -1;
+    }
+    m_clientConnected = false;
+}
+
+void SimUnit::setClientConnected(bool connected)
+{
+    if (connected && !m_clientConnected) {
+        ++m_stats.reconnects;
+        m_handshakeSeen = false;
+        m_commandBuffer.clear();
+    }
+    m_clientConnected = connected;
+}
+
+void SimUnit::handleReadable(quint32 activeEvents)
+{
+    quint8 buffer[256];
+    for (;;) {
+        const ssize_t n = ::read(m_masterFd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        m_commandBuffer.insert(m_commandBuffer.end(), buffer, buffer + n);
+    }
+
+    const std::span<const quint8> command = NhsCodec::handshakeCommand();
+    for (;;) {
+        const auto hit = std::search(m_commandBuffer.begin(), m_commandBuffer.end(), command.begin(), command.end());
+        if (hit == m_commandBuffer.end()) break;
+        m_commandBuffer.erase(m_commandBuffer.begin(), hit + command.size());
+        m_handshakeSeen = true;
+        if (!(activeEvents & EventSilence)) {
+            sendHardware(activeEvents);
+        }
+    }
+
+    // Keep only a possible partial command
+    if (m_commandBuffer.size() > command.size()) {
+        m_commandBuffer.erase(m_commandBuffer.begin(), m_commandBuffer.end() - static_cast<std::ptrdiff_t>(command.size()));
+    }
+}
+
+qint64 SimUnit::service(qint64 nowNs, quint32 activeEvents)
+{
+    updateModel(nowNs, activeEvents);
+
+    if (m_nextDueNs == 0) {
+        // Spread the units over one period so they do not all fire in the same poll() wakeup
+        m_nextDueNs = nowNs + (m_periodNs * m_index) / 64 % m_periodNs;
+    }
+
+    while (m_nextDueNs <= nowNs) {
+        const bool streaming = m_config.streamBeforeHandshake || m_handshakeSeen;
+        if (m_clientConnected && streaming && !(activeEvents & EventSilence)) {
+            sendData(activeEvents);
+        }
+        m_nextDueNs += m_periodNs;
+        if (nowNs - m_nextDueNs > m_periodNs * 4) {
+            // We fell far behind (suspended, or an absurd rate): skip instead of bursting
+            m_nextDueNs = nowNs + m_periodNs;
+        }
+    }
+    return m_nextDueNs;
+}
+
+void SimUnit::updateModel(qint64 nowNs, quint32 activeEvents)
+{
+    const double dt = m_lastModelNs ? (nowNs - m_lastModelNs) / 1e9 : 0.0;
+    m_lastModelNs = nowNs;
+
+    std::uniform_real_distribution<double> jitter(-1.0, 1.0);
+    if (activeEvents & (EventMainsLoss | EventBatteryCritical)) {
+        m_inputVoltage = 0.0;
+        m_batteryVoltage = std::max(BATTERY_EMPTY_V, m_batteryVoltage - DRAIN_V_PER_S * dt);
+        m_loadPercent = 35;
+    } else {
+        m_inputVoltage = 220.0 + 2.0 * jitter(m_rng);
+        m_batteryVoltage = std::min(BATTERY_FULL_V, m_batteryVoltage + CHARGE_V_PER_S * dt);
+        m_loadPercent = 25;
+    }
+    m_temperature = std::clamp(m_temperature + 0.05 * jitter(m_rng), 28.0, 40.0);
+}
+
+void SimUnit::sendData(quint32 activeEvents)
+{
+    NhsCodec::nhs_data_payload_t payload{};
+    const quint16 vin = static_cast<quint16>(m_inputVoltage);
+    const quint16 vout = 220;
+    const quint16 vbat = static_cast<quint16>(
+        (activeEvents & EventBatteryCritical) ? BATTERY_EMPTY_V * 10.0 : m_batteryVoltage * 10.0);
+    const quint16 temp = static_cast<quint16>(m_temperature);
+    const quint16 vinMin = vin ? vin - 3 : 0;
+    const quint16 vinMax = vin ? vin + 3 : 0;
+
+    payload.vacinrms_low = vin & 0xFF;
+    payload.vacinrms_high = vin >> 8;
+    payload.vdcmed_low = vbat & 0xFF;
+    payload.vdcmed_high = vbat >> 8;
+    payload.potrms = static_cast<quint8>(m_loadPercent);
+    payload.vacinrmsmin_low = vinMin & 0xFF;
+    payload.vacinrmsmin_high = vinMin >> 8;
+    payload.vacinrmsmax_low = vinMax & 0xFF;
+    payload.vacinrmsmax_high = vinMax >> 8;
+    payload.vacoutrms_low = vout & 0xFF;
+    payload.vacoutrms_high = vout >> 8;
+    payload.tempmed_low = temp & 0xFF;
+    payload.tempmed_high = temp >> 8;
+
+    using namespace NhsCodec::StatusBits;
+    if (activeEvents & EventBatteryCritical) {
+        payload.statusval = BATTERY_LOW_CRITICAL | INVERTER_ACTIVE | BATTERY_FLOW_ACTIVE;
+    } else if (activeEvents & EventMainsLoss) {
+        payload.statusval = INVERTER_ACTIVE | BATTERY_FLOW_ACTIVE;
+    } else if (m_batteryVoltage < CHARGED_THRESHOLD_V) {
+        payload.statusval = BATTERY_CHARGING | BATTERY_FLOW_ACTIVE;
+    } else {
+        payload.statusval = BATTERY_CHARGING;
+    }
+    payload.icarregrms = (payload.statusval & BATTERY_CHARGING) && (payload.statusval & BATTERY_FLOW_ACTIVE) ? 2 : 0;
+
+    quint8 frame[NhsCodec::PACKET_LEN_D];
+    const size_t length = NhsCodec::encodeData(payload, frame);
+    sendFrame(frame, length, activeEvents);
+}
+
+void SimUnit::sendHardware(quint32 activeEvents)
+{
+    NhsCodec::nhs_hardware_payload_t payload{};
+    payload.unknown_id_byte_1 = 0x01;
+    payload.unknown_id_byte_2 = static_cast<quint8>(m_index & 0xFF);
+    payload.undervoltage_127V_byte = 100;
+    payload.overvoltage_127V_byte = 140;
+    payload.undervoltage_220V_byte = 190;
+    payload.overvoltage_220V_byte = 245;
+    payload.output_voltage_byte = 220;
+    payload.input_voltage_byte = 220;
+
+    quint8 frame[NhsCodec::PACKET_LEN_S];
+    const size_t length = NhsCodec::encodeHardware(payload, frame);
+    sendFrame(frame, length, activeEvents);
+    ++m_stats.handshakesAnswered;
+}
+
+void SimUnit::sendFrame(const quint8* frame, size_t length, quint32 activeEvents)
+{
+    quint8 out[64];
+    size_t total = 0;
+
+    if (activeEvents & EventNoise) {
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+        std::uniform_int_distribution<int> byteValue(0, 255);
+        if (chance(m_rng) < m_config.noiseProbability) {
+            // Line garbage before the frame; the decoder has to resync past it
+            const int garbage = 1 + byteValue(m_rng) % 8;
+            for (int i = 0; i < garbage; ++i) out[total++] = static_cast<quint8>(byteValue(m_rng));
+        }
+        std::memcpy(out + total, frame, length);
+        if (chance(m_rng) < m_config.noiseProbability) {
+            out[total + length - 2] ^= 0x5A; // Break the checksum
+            ++m_stats.corruptedFrames;
+        }
+        total += length;
+    } else {
+        std::memcpy(out, frame, length);
+        total = length;
+    }
+
+    const ssize_t written = ::write(m_masterFd, out, total);
+    if (written != static_cast<ssize_t>(total)) {
+        // EAGAIN: the client stopped reading and the PTY buffer is full
+        ++m_stats.writeDrops;
+        return;
+    }
+    ++m_stats.framesSent;
+    m_stats.bytesSent += total;
+}
+
+} // namespace NhsSim
@@ -0,0 +1,137 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIM_UNIT_H
+#define SIM_UNIT_H
+
+#include <QtGlobal>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace NhsSim {
+
+/**
+ * @brief Settings shared by all simulated units.
+ */
+struct SimConfig {
+    double rateHz = 1.0;               // D records per second per unit
+    double noiseProbability = 0.2;     // Per-frame chance of corruption while EventNoise is active
+    bool streamBeforeHandshake = true; // Real units stream D records without being asked
+    std::string linkDir;               // Optional directory for stable ttyNHS<n> symlinks
+    quint32 seed = 1;
+};
+
+/**
+ * @brief Counters for one unit (or summed over all units).
+ */
+struct SimStats {
+    quint64 framesSent = 0;
+    quint64 bytesSent = 0;
+    quint64 handshakesAnswered = 0;
+    quint64 corruptedFrames = 0;
+    quint64 writeDrops = 0;     // Frames dropped because the reader did not keep up
+    quint64 reconnects = 0;     // Slave side (re)opened by a client
+
+    SimStats& operator+=(const SimStats& other);
+};
+
+/**
+ * @brief One simulated NHS UPS behind a Linux pseudo-terminal.
+ *
+ * The driver opens the slave side (/dev/pts/N, or the symlink in SimConfig::linkDir) like a COM port.
+ * The unit answers the S command with an S record and streams D records at SimConfig::rateHz,
+ * shaped by the scenario events that are currently active.
+ */
+class SimUnit
+{
+public:
+    SimUnit(int index, const SimConfig& config);
+    ~SimUnit();
+
+    SimUnit(const SimUnit&) = delete;
+    SimUnit& operator=(const SimUnit&) = delete;
+
+    /**
+     * @brief Creates the PTY pair (and symlink). Returns false and fills @p error on failure.
+     */
+    bool open(std::string& error);
+    void close();
+
+    bool isOpen() const { return m_masterFd >= 0; }
+    int masterFd() const { return m_masterFd; }
+    const std::string& slavePath() const { return m_slavePath; }
+    const std::string& linkPath() const { return m_linkPath; }
+
+    /**
+     * @brief Path a driver should use: the symlink if there is one, otherwise the slave device.
+     */
+    const std::string& portPath() const { return m_linkPath.empty() ? m_slavePath : m_linkPath; }
+
+    /**
+     * @brief Records the poll() result for the master fd: POLLHUP means no client has the slave open.
+     */
+    void setClientConnected(bool connected);
+    bool isClientConnected() const { return m_clientConnected; }
+
+    /**
+     * @brief Reads pending commands from the client and answers S commands.
+     */
+    void handleReadable(quint32 activeEvents);
+
+    /**
+     * @brief Advances the simulation to @p nowNs and sends every D record that is due.
+     * @return The monotonic time at which the next record is due.
+     */
+    qint64 service(qint64 nowNs, quint32 activeEvents);
+
+    const SimStats& stats() const { return m_stats; }
+
+private:
+    void updateModel(qint64 nowNs, quint32 activeEvents);
+    void sendData(quint32 activeEvents);
+    void sendHardware(quint32 activeEvents);
+    void sendFrame(const quint8* frame, size_t length, quint32 activeEvents);
+
+    const int m_index;
+    const SimConfig& m_config;
+    std::minstd_rand m_rng;
+
+    int m_masterFd = -1;
+    std::string m_slavePath;
+    std::string m_linkPath;
+    bool m_clientConnected = false;
+    bool m_handshakeSeen = false;
+
+    std::vector<quint8> m_commandBuffer;
+    qint64 m_periodNs = 0;
+    qint64 m_nextDueNs = 0;
+    qint64 m_lastModelNs = 0;
+
+    // Electrical model
+    double m_batteryVoltage = 13.6;
+    double m_inputVoltage = 220.0;
+    double m_temperature = 32.0;
+    int m_loadPercent = 25;
+
+    SimStats m_stats;
+};
+
+} // namespace NhsSim
+
+#endif // SIM_UNIT_H
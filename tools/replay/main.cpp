@@ -0,0 +1,137 @@
+/*
+ * LightUps: A lightweight Qt-based UPS monitoring service and client for Windows.
+ * Copyright (C) 2026 Andreas Hoogendoorn (@andhoo)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * lightups-replay: replays a capture recorded with "LightUpsService --console --capture <file>"
+ * into a driver plugin and reports what came out of the Ups_api_library pipeline.
+ *
+ *   lightups-replay capture.bin                       (1x, original timing)
+ *   lightups-replay capture.bin --speed 20            (20x faster)
+ *   lightups-replay capture.bin --speed max           (throughput benchmark)
+ *   lightups-replay capture.bin --driver path/to/libnhs_driver.so
+ */
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QDebug>
+#include <cstdio>
+#include "lightups_api.h"
+#include "serial_capture.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("lightups-replay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a raw LightUps serial capture into a UPS driver.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("capture", "Capture file recorded with --capture.");
+#ifdef Q_OS_WIN
+    const QString defaultDriver = "nhs_driver.dll";
+#else
+    const QString defaultDriver = "libnhs_driver.so";
+#endif
+    QCommandLineOption driverOption("driver", "Driver plugin file name or path.", "plugin", defaultDriver);
+    QCommandLineOption speedOption("speed", "Replay speed: 1 (real time), N (N times faster) or max.", "speed", "1");
+    QCommandLineOption idleOption("idle-ms", "Stop after this many milliseconds without reports.", "ms", "0");
+    parser.addOptions({ driverOption, speedOption, idleOption });
+    parser.process(app);
+
+    if (parser.positionalArguments().size() != 1) {
+        parser.showHelp(1);
+    }
+    const QString capturePath = parser.positionalArguments().first();
+    const QString speed = parser.value(speedOption);
+
+    // 1. Scan the capture so we know what we are about to feed
+    CaptureReader reader;
+    if (!reader.open(capturePath)) {
+        std::fprintf(stderr, "Cannot open capture %s: %s\n", qPrintable(capturePath), qPrintable(reader.errorString()));
+        return 1;
+    }
+    qint64 chunkCount = 0;
+    qint64 byteCount = 0;
+    qint64 durationNs = 0;
+    SerialCapture::Chunk chunk;
+    while (reader.next(chunk)) {
+        ++chunkCount;
+        byteCount += chunk.data.size();
+        durationNs = chunk.offsetNs;
+    }
+    reader.close();
+    std::printf("Capture: %lld chunks, %lld bytes, %.1f s recorded\n",
+                static_cast<long long>(chunkCount), static_cast<long long>(byteCount), durationNs / 1e9);
+
+    // 2. Wire up the pipeline and count what comes out of it
+    Ups_api_library upsCore(&app);
+    QElapsedTimer clock;
+    qint64 firstDataNs = -1;
+    qint64 lastDataNs = -1;
+    qint64 reports = 0;
+    qint64 dataReports = 0;
+    qint64 stateChanges = 0;
+    UpsMonitor::UpsState lastState = UpsMonitor::UpsState::Unknown;
+
+    QTimer idleTimer;
+    idleTimer.setSingleShot(true);
+    const bool maxSpeed = (speed == "max");
+    int idleMs = parser.value(idleOption).toInt();
+    if (idleMs <= 0) {
+        // At max speed the driver keeps no gaps; at real time allow for the monitor timeout
+        idleMs = maxSpeed ? 1500 : 5000;
+    }
+    idleTimer.setInterval(idleMs);
+    QObject::connect(&idleTimer, &QTimer::timeout, &app, &QCoreApplication::quit);
+
+    QObject::connect(&upsCore, &Ups_api_library::upsReportAvailable, &app, [&](const UpsReport& report) {
+        ++reports;
+        if (report.serviceStatus.dataCommunicationActive) {
+            ++dataReports;
+            lastDataNs = clock.nsecsElapsed();
+            if (firstDataNs < 0) firstDataNs = lastDataNs;
+            if (report.data.state != lastState) {
+                ++stateChanges;
+                lastState = report.data.state;
+            }
+        }
+        idleTimer.start();
+    });
+
+    const QString connectionInfo = QString("replay:%1?speed=%2").arg(capturePath, speed);
+    clock.start();
+    idleTimer.start();
+    if (!upsCore.startDriver(parser.value(driverOption), connectionInfo)) {
+        std::fprintf(stderr, "Cannot start driver %s\n", qPrintable(parser.value(driverOption)));
+        return 1;
+    }
+
+    app.exec();
+
+    // 3. Results
+    const double activeSeconds = (firstDataNs >= 0 && lastDataNs > firstDataNs) ? (lastDataNs - firstDataNs) / 1e9 : 0.0;
+    std::printf("Reports: %lld total, %lld with data, %lld state changes\n",
+                static_cast<long long>(reports), static_cast<long long>(dataReports), static_cast<long long>(stateChanges));
+    if (activeSeconds > 0.0) {
+        std::printf("Pipeline: %.0f reports/s, %.1f KB/s over %.3f s\n",
+                    dataReports / activeSeconds, byteCount / activeSeconds / 1024.0, activeSeconds);
+    }
+    return dataReports > 0 ? 0 : 2;
+}